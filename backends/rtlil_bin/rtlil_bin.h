@@ -0,0 +1,162 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// Binary RTLIL checkpoint format (write_rtlil_bin / read_rtlil_bin)
+//
+// All integers are unsigned LEB128 varints unless noted otherwise, signed
+// values (wire and memory offsets) are zigzag encoded. A file consists of:
+//
+//   header:        "YSRTLBIN", version (u32 le), autoidx (u32 le),
+//                  string table offset (u64 le), module table offset (u64 le)
+//   module blobs:  one self-contained blob per module (see below)
+//   string table:  count, then length + bytes for each string. strings are
+//                  referenced by index and hold all IdStrings in the file.
+//   module table:  count, then name, blob offset and blob size per module
+//
+// A module blob contains the module attributes, the avail_parameters, and
+// then the wires, memories, cells, connections and processes, each list
+// prefixed with its size. SigSpecs are stored as a list of chunks, where a
+// chunk is either a wire reference (1 + index of the wire in the blob, offset,
+// width) or a constant (0, Const). Consts are stored as flags, width and the
+// bit planes of the state values: a single plane when all bits are 0 or 1,
+// three planes otherwise.
+//
+// All containers are stored in insertion order and the design is not sorted
+// before writing, so a design read from the file iterates its modules, wires,
+// cells, etc. in the same order as the design that was written.
+//
+// The module table allows a reader to materialize only some of the modules
+// without parsing the others.
+
+#ifndef RTLIL_BIN_H
+#define RTLIL_BIN_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace RTLIL_BIN
+{
+	static const char magic[8] = { 'Y', 'S', 'R', 'T', 'L', 'B', 'I', 'N' };
+	static const uint32_t version = 1;
+	static const int header_size = 32;
+
+	enum WireFlags : unsigned char {
+		WIRE_INPUT = 1,
+		WIRE_OUTPUT = 2,
+		WIRE_UPTO = 4
+	};
+
+	struct Writer
+	{
+		std::string buffer;
+
+		void u8(unsigned char v) {
+			buffer.push_back(v);
+		}
+
+		void uint(uint64_t v) {
+			while (v >= 0x80) {
+				buffer.push_back((v & 0x7f) | 0x80);
+				v >>= 7;
+			}
+			buffer.push_back(v);
+		}
+
+		void sint(int64_t v) {
+			uint((uint64_t(v) << 1) ^ uint64_t(v >> 63));
+		}
+
+		void fixed(uint64_t v, int bytes) {
+			for (int i = 0; i < bytes; i++)
+				buffer.push_back((v >> (8*i)) & 0xff);
+		}
+
+		void bytes(const char *p, size_t n) {
+			buffer.append(p, n);
+		}
+	};
+
+	struct Reader
+	{
+		const unsigned char *begin, *ptr, *end;
+
+		Reader(const unsigned char *begin, const unsigned char *end) : begin(begin), ptr(begin), end(end) { }
+
+		void need(size_t n) {
+			if (size_t(end - ptr) < n)
+				log_error("Unexpected end of binary RTLIL data at offset %lld.\n", (long long)(ptr - begin));
+		}
+
+		unsigned char u8() {
+			need(1);
+			return *(ptr++);
+		}
+
+		uint64_t uint() {
+			uint64_t v = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				unsigned char c = u8();
+				v |= uint64_t(c & 0x7f) << shift;
+				if ((c & 0x80) == 0)
+					return v;
+			}
+			log_error("Malformed varint in binary RTLIL data at offset %lld.\n", (long long)(ptr - begin));
+		}
+
+		int64_t sint() {
+			uint64_t v = uint();
+			return int64_t(v >> 1) ^ -int64_t(v & 1);
+		}
+
+		int integer() {
+			uint64_t v = uint();
+			if (v > uint64_t(INT_MAX))
+				log_error("Integer out of range in binary RTLIL data at offset %lld.\n", (long long)(ptr - begin));
+			return v;
+		}
+
+		// number of elements in a list, each of them takes at least one byte
+		int count() {
+			uint64_t v = uint();
+			if (v > uint64_t(end - begin))
+				log_error("Invalid element count in binary RTLIL data at offset %lld.\n", (long long)(ptr - begin));
+			return v;
+		}
+
+		uint64_t fixed(int bytes) {
+			need(bytes);
+			uint64_t v = 0;
+			for (int i = 0; i < bytes; i++)
+				v |= uint64_t(*(ptr++)) << (8*i);
+			return v;
+		}
+
+		const char *bytes(size_t n) {
+			need(n);
+			const char *p = (const char*)ptr;
+			ptr += n;
+			return p;
+		}
+	};
+}
+
+YOSYS_NAMESPACE_END
+
+#endif
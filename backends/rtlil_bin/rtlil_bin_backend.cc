@@ -0,0 +1,335 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  A binary serialization of RTLIL for fast checkpointing of large designs.
+ *  See rtlil_bin.h for a description of the file format.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "backends/rtlil_bin/rtlil_bin.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+using namespace RTLIL_BIN;
+
+// hashlib containers iterate in reverse insertion order. the writer stores
+// the elements in insertion order, so that the reader recreates containers
+// with the same order as in the saved design.
+
+template<typename K, typename T, typename OPS>
+std::vector<const std::pair<K, T>*> insertion_order(const dict<K, T, OPS> &container)
+{
+	std::vector<const std::pair<K, T>*> items;
+	items.reserve(GetSize(container));
+	for (auto &it : container)
+		items.push_back(&it);
+	std::reverse(items.begin(), items.end());
+	return items;
+}
+
+template<typename K, typename OPS>
+std::vector<const K*> insertion_order(const pool<K, OPS> &container)
+{
+	std::vector<const K*> items;
+	items.reserve(GetSize(container));
+	for (auto &it : container)
+		items.push_back(&it);
+	std::reverse(items.begin(), items.end());
+	return items;
+}
+
+struct RtlilBinWriter
+{
+	Writer w;
+	dict<RTLIL::IdString, int> string_ids;
+	std::vector<RTLIL::IdString> strings;
+	dict<RTLIL::Wire*, int> wire_ids;
+
+	struct ModuleEntry {
+		int name;
+		size_t offset, size;
+	};
+	std::vector<ModuleEntry> module_table;
+
+	int id(RTLIL::IdString str)
+	{
+		auto it = string_ids.find(str);
+		if (it != string_ids.end())
+			return it->second;
+		int idx = GetSize(strings);
+		string_ids[str] = idx;
+		strings.push_back(str);
+		return idx;
+	}
+
+	void write_id(RTLIL::IdString str)
+	{
+		w.uint(id(str));
+	}
+
+	void write_const(const RTLIL::Const &value)
+	{
+		int width = GetSize(value.bits);
+		w.uint(value.flags);
+		w.uint(width);
+
+		bool only_01 = true;
+		for (auto bit : value.bits)
+			if (bit != RTLIL::State::S0 && bit != RTLIL::State::S1) {
+				only_01 = false;
+				break;
+			}
+
+		int num_planes = only_01 ? 1 : 3;
+		w.u8(num_planes);
+
+		for (int plane = 0; plane < num_planes; plane++)
+			for (int i = 0; i < width; i += 8) {
+				unsigned char byte = 0;
+				for (int j = 0; j < 8 && i+j < width; j++)
+					if ((value.bits[i+j] >> plane) & 1)
+						byte |= 1 << j;
+				w.u8(byte);
+			}
+	}
+
+	void write_sig(const RTLIL::SigSpec &sig)
+	{
+		auto &chunks = sig.chunks();
+		w.uint(GetSize(chunks));
+		for (auto &chunk : chunks) {
+			if (chunk.wire == nullptr) {
+				w.uint(0);
+				write_const(chunk.data);
+			} else {
+				w.uint(wire_ids.at(chunk.wire) + 1);
+				w.uint(chunk.offset);
+				w.uint(chunk.width);
+			}
+		}
+	}
+
+	void write_attrs(const dict<RTLIL::IdString, RTLIL::Const> &attrs)
+	{
+		w.uint(GetSize(attrs));
+		for (auto it : insertion_order(attrs)) {
+			write_id(it->first);
+			write_const(it->second);
+		}
+	}
+
+	void write_actions(const std::vector<RTLIL::SigSig> &actions)
+	{
+		w.uint(GetSize(actions));
+		for (auto &it : actions) {
+			write_sig(it.first);
+			write_sig(it.second);
+		}
+	}
+
+	void write_case(const RTLIL::CaseRule *cs)
+	{
+		w.uint(GetSize(cs->compare));
+		for (auto &sig : cs->compare)
+			write_sig(sig);
+		write_actions(cs->actions);
+		w.uint(GetSize(cs->switches));
+		for (auto sw : cs->switches) {
+			write_attrs(sw->attributes);
+			write_sig(sw->signal);
+			w.uint(GetSize(sw->cases));
+			for (auto child : sw->cases)
+				write_case(child);
+		}
+	}
+
+	void write_module(RTLIL::Module *module)
+	{
+		ModuleEntry entry;
+		entry.name = id(module->name);
+		entry.offset = GetSize(w.buffer);
+
+		wire_ids.clear();
+
+		write_attrs(module->attributes);
+
+		w.uint(GetSize(module->avail_parameters));
+		for (auto param : insertion_order(module->avail_parameters))
+			write_id(*param);
+
+		w.uint(GetSize(module->wires_));
+		for (auto it : insertion_order(module->wires_)) {
+			RTLIL::Wire *wire = it->second;
+			int idx = GetSize(wire_ids);
+			wire_ids[wire] = idx;
+			write_id(wire->name);
+			write_attrs(wire->attributes);
+			w.uint(wire->width);
+			w.sint(wire->start_offset);
+			w.uint(wire->port_id);
+			w.u8((wire->port_input ? WIRE_INPUT : 0) | (wire->port_output ? WIRE_OUTPUT : 0) | (wire->upto ? WIRE_UPTO : 0));
+		}
+
+		w.uint(GetSize(module->memories));
+		for (auto it : insertion_order(module->memories)) {
+			RTLIL::Memory *memory = it->second;
+			write_id(memory->name);
+			write_attrs(memory->attributes);
+			w.uint(memory->width);
+			w.sint(memory->start_offset);
+			w.uint(memory->size);
+		}
+
+		w.uint(GetSize(module->cells_));
+		for (auto it : insertion_order(module->cells_)) {
+			RTLIL::Cell *cell = it->second;
+			write_id(cell->name);
+			write_id(cell->type);
+			write_attrs(cell->attributes);
+			w.uint(GetSize(cell->parameters));
+			for (auto param : insertion_order(cell->parameters)) {
+				write_id(param->first);
+				write_const(param->second);
+			}
+			w.uint(GetSize(cell->connections()));
+			for (auto conn : insertion_order(cell->connections())) {
+				write_id(conn->first);
+				write_sig(conn->second);
+			}
+		}
+
+		write_actions(module->connections());
+
+		w.uint(GetSize(module->processes));
+		for (auto it : insertion_order(module->processes)) {
+			RTLIL::Process *proc = it->second;
+			write_id(proc->name);
+			write_attrs(proc->attributes);
+			write_case(&proc->root_case);
+			w.uint(GetSize(proc->syncs));
+			for (auto sync : proc->syncs) {
+				w.u8(sync->type);
+				write_sig(sync->signal);
+				write_actions(sync->actions);
+			}
+		}
+
+		entry.size = GetSize(w.buffer) - entry.offset;
+		module_table.push_back(entry);
+	}
+
+	void write_design(RTLIL::Design *design, bool selected)
+	{
+		w.bytes(magic, sizeof(magic));
+		w.fixed(version, 4);
+		w.fixed(autoidx, 4);
+		w.fixed(0, 8);
+		w.fixed(0, 8);
+		log_assert(GetSize(w.buffer) == header_size);
+
+		for (auto it : insertion_order(design->modules_)) {
+			RTLIL::Module *module = it->second;
+			if (selected && !design->selected_whole_module(module->name)) {
+				if (design->selected_module(module->name))
+					log_cmd_error("Can't handle partially selected module %s!\n", log_id(module->name));
+				continue;
+			}
+			write_module(module);
+		}
+
+		size_t strings_offset = GetSize(w.buffer);
+		w.uint(GetSize(strings));
+		for (auto &str : strings) {
+			const char *p = str.c_str();
+			size_t len = strlen(p);
+			w.uint(len);
+			w.bytes(p, len);
+		}
+
+		size_t modules_offset = GetSize(w.buffer);
+		w.uint(GetSize(module_table));
+		for (auto &entry : module_table) {
+			w.uint(entry.name);
+			w.uint(entry.offset);
+			w.uint(entry.size);
+		}
+
+		for (int i = 0; i < 8; i++) {
+			w.buffer[16+i] = (strings_offset >> (8*i)) & 0xff;
+			w.buffer[24+i] = (modules_offset >> (8*i)) & 0xff;
+		}
+	}
+};
+
+struct RtlilBinBackend : public Backend {
+	RtlilBinBackend() : Backend("rtlil_bin", "write design to binary RTLIL file") { readonly_modules = true; }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    write_rtlil_bin [options] [filename]\n");
+		log("\n");
+		log("Write the current design to a binary RTLIL file. This format holds the same\n");
+		log("information as an 'ilang' file, but is much faster to write and read, and it\n");
+		log("allows read_rtlil_bin to load only some of the modules in the file. It is meant\n");
+		log("for checkpointing large designs between runs of the same yosys version.\n");
+		log("Unlike write_ilang, this command does not sort the design. read_rtlil_bin\n");
+		log("restores modules, wires, cells, etc. in the order they have in the design.\n");
+		log("\n");
+		log("    -selected\n");
+		log("        only write selected modules. partially selected modules are not\n");
+		log("        supported.\n");
+		log("\n");
+	}
+	virtual void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design)
+	{
+		bool selected = false;
+
+		log_header(design, "Executing binary RTLIL backend.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (arg == "-selected") {
+				selected = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(f, filename, args, argidx);
+
+		log("Output filename: %s\n", filename.c_str());
+
+		PerformanceTimer timer;
+		timer.begin();
+
+		RtlilBinWriter writer;
+		writer.write_design(design, selected);
+		f->write(writer.w.buffer.data(), GetSize(writer.w.buffer));
+
+		timer.end();
+		double sec = timer.sec();
+		log("Wrote %d modules and %d strings, %.2f MB in %.2f seconds (%.1f MB/s).\n", GetSize(writer.module_table), GetSize(writer.strings),
+				GetSize(writer.w.buffer) * 1e-6, sec, sec > 0 ? GetSize(writer.w.buffer) * 1e-6 / sec : 0.0);
+	}
+} RtlilBinBackend;
+
+PRIVATE_NAMESPACE_END
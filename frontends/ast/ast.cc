@@ -37,7 +37,7 @@ using namespace AST_INTERNAL;
 
 // instanciate global variables (public API)
 namespace AST {
-	std::string current_filename;
+	thread_local std::string current_filename;
 	void (*set_line_num)(int) = NULL;
 	int (*get_line_num)() = NULL;
 }
@@ -53,6 +53,7 @@ namespace AST_INTERNAL {
 	AstNode *current_always, *current_top_block, *current_block, *current_block_child;
 	AstModule *current_module;
 	bool current_always_clocked;
+	dict<std::string, std::pair<RTLIL::Const, bool>> *current_const_func_cache = NULL;
 }
 
 // convert node types to string
@@ -181,7 +182,7 @@ bool AstNode::get_bool_attribute(RTLIL::IdString id)
 // (the optional child arguments make it easier to create AST trees)
 AstNode::AstNode(AstNodeType type, AstNode *child1, AstNode *child2, AstNode *child3)
 {
-	static unsigned int hashidx_count = 123456789;
+	static thread_local unsigned int hashidx_count = 123456789;
 	hashidx_count = mkhash_xorshift(hashidx_count);
 	hashidx_ = hashidx_count;
 
@@ -1050,7 +1051,10 @@ void AST::process(RTLIL::Design *design, AstNode *ast, bool dump_ast1, bool dump
 				continue;
 			}
 
+			dict<std::string, std::pair<RTLIL::Const, bool>> const_func_cache;
+			current_const_func_cache = &const_func_cache;
 			design->add(process_module(*it, defer));
+			current_const_func_cache = NULL;
 		}
 		else if ((*it)->type == AST_PACKAGE)
 			design->verilog_packages.push_back((*it)->clone());
@@ -1090,13 +1094,19 @@ RTLIL::IdString AstModule::derive(RTLIL::Design *design, dict<RTLIL::IdString, R
 	flag_autowire = autowire;
 	use_internal_line_num();
 
+	PerformanceTimer timer;
+	timer.begin();
+
+	// first only determine the name of the derived module, so that we don't
+	// need to copy the AST when the module has already been derived with the
+	// same parameters
 	std::string para_info;
-	AstNode *new_ast = ast->clone();
+	std::vector<std::pair<int, RTLIL::Const>> rewrite_parameters;
 
 	int para_counter = 0;
 	int orig_parameters_n = parameters.size();
-	for (auto it = new_ast->children.begin(); it != new_ast->children.end(); it++) {
-		AstNode *child = *it;
+	for (int i = 0; i < GetSize(ast->children); i++) {
+		AstNode *child = ast->children[i];
 		if (child->type != AST_PARAMETER)
 			continue;
 		para_counter++;
@@ -1105,11 +1115,7 @@ RTLIL::IdString AstModule::derive(RTLIL::Design *design, dict<RTLIL::IdString, R
 			log("Parameter %s = %s\n", child->str.c_str(), log_signal(RTLIL::SigSpec(parameters[child->str])));
 	rewrite_parameter:
 			para_info += stringf("%s=%s", child->str.c_str(), log_signal(RTLIL::SigSpec(parameters[para_id])));
-			delete child->children.at(0);
-			if ((parameters[para_id].flags & RTLIL::CONST_FLAG_STRING) != 0)
-				child->children[0] = AstNode::mkconst_str(parameters[para_id].decode_string());
-			else
-				child->children[0] = AstNode::mkconst_bits(parameters[para_id].bits, (parameters[para_id].flags & RTLIL::CONST_FLAG_SIGNED) != 0);
+			rewrite_parameters.push_back(std::pair<int, RTLIL::Const>(i, parameters[para_id]));
 			parameters.erase(para_id);
 			continue;
 		}
@@ -1120,16 +1126,6 @@ RTLIL::IdString AstModule::derive(RTLIL::Design *design, dict<RTLIL::IdString, R
 		}
 	}
 
-	for (auto param : parameters) {
-		AstNode *defparam = new AstNode(AST_DEFPARAM, new AstNode(AST_IDENTIFIER));
-		defparam->children[0]->str = param.first.str();
-		if ((param.second.flags & RTLIL::CONST_FLAG_STRING) != 0)
-			defparam->children.push_back(AstNode::mkconst_str(param.second.decode_string()));
-		else
-			defparam->children.push_back(AstNode::mkconst_bits(param.second.bits, (param.second.flags & RTLIL::CONST_FLAG_SIGNED) != 0));
-		new_ast->children.push_back(defparam);
-	}
-
 	std::string modname;
 
 	if (orig_parameters_n == 0)
@@ -1139,15 +1135,50 @@ RTLIL::IdString AstModule::derive(RTLIL::Design *design, dict<RTLIL::IdString, R
 	else
 		modname = "$paramod" + stripped_name + para_info;
 
-	if (!design->has(modname)) {
-		new_ast->str = modname;
-		design->add(process_module(new_ast, false));
-		design->module(modname)->check();
-	} else {
+	if (design->has(modname)) {
 		log("Found cached RTLIL representation for module `%s'.\n", modname.c_str());
+		derive_cache_hits++;
+		return modname;
+	}
+
+	AstNode *new_ast = ast->clone();
+
+	for (auto &it : rewrite_parameters) {
+		AstNode *child = new_ast->children.at(it.first);
+		const RTLIL::Const &value = it.second;
+		delete child->children.at(0);
+		if ((value.flags & RTLIL::CONST_FLAG_STRING) != 0)
+			child->children[0] = AstNode::mkconst_str(value.decode_string());
+		else
+			child->children[0] = AstNode::mkconst_bits(value.bits, (value.flags & RTLIL::CONST_FLAG_SIGNED) != 0);
 	}
 
+	for (auto param : parameters) {
+		AstNode *defparam = new AstNode(AST_DEFPARAM, new AstNode(AST_IDENTIFIER));
+		defparam->children[0]->str = param.first.str();
+		if ((param.second.flags & RTLIL::CONST_FLAG_STRING) != 0)
+			defparam->children.push_back(AstNode::mkconst_str(param.second.decode_string()));
+		else
+			defparam->children.push_back(AstNode::mkconst_bits(param.second.bits, (param.second.flags & RTLIL::CONST_FLAG_SIGNED) != 0));
+		new_ast->children.push_back(defparam);
+	}
+
+	current_const_func_cache = &const_func_cache;
+
+	new_ast->str = modname;
+	design->add(process_module(new_ast, false));
+	design->module(modname)->check();
+
+	current_const_func_cache = NULL;
 	delete new_ast;
+
+	timer.end();
+	derive_count++;
+	derive_sec += timer.sec();
+
+	log("Derived module `%s' in %.2f seconds (%d derived and %d cached instances of `%s' so far, %.2f seconds in total).\n",
+			modname.c_str(), timer.sec(), derive_count, derive_cache_hits, stripped_name.c_str(), derive_sec);
+
 	return modname;
 }
 
@@ -282,6 +282,12 @@ namespace AST
 	struct AstModule : RTLIL::Module {
 		AstNode *ast;
 		bool nolatches, nomeminit, nomem2reg, mem2reg, lib, noopt, icells, autowire;
+		// results of parameter independent constant function calls, shared by all
+		// modules derived from this one, and statistics for derive()
+		dict<std::string, std::pair<RTLIL::Const, bool>> const_func_cache;
+		int derive_count, derive_cache_hits;
+		double derive_sec;
+		AstModule() : derive_count(0), derive_cache_hits(0), derive_sec(0) { }
 		virtual ~AstModule();
 		virtual RTLIL::IdString derive(RTLIL::Design *design, dict<RTLIL::IdString, RTLIL::Const> parameters, bool mayfail);
 		virtual RTLIL::Module *clone() const;
@@ -290,7 +296,9 @@ namespace AST
 	// this must be set by the language frontend before parsing the sources
 	// the AstNode constructor then uses current_filename and get_line_num()
 	// to initialize the filename and linenum properties of new nodes
-	extern std::string current_filename;
+	// (current_filename is per thread, so a frontend can parse several files
+	// in parallel with each thread setting its own filename)
+	extern thread_local std::string current_filename;
 	extern void (*set_line_num)(int);
 	extern int (*get_line_num)();
 
@@ -314,6 +322,7 @@ namespace AST_INTERNAL
 	extern AST::AstNode *current_always, *current_top_block, *current_block, *current_block_child;
 	extern AST::AstModule *current_module;
 	extern bool current_always_clocked;
+	extern dict<std::string, std::pair<RTLIL::Const, bool>> *current_const_func_cache;
 	struct ProcessGenerator;
 }
 
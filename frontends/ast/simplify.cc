@@ -41,6 +41,42 @@ YOSYS_NAMESPACE_BEGIN
 using namespace AST;
 using namespace AST_INTERNAL;
 
+// helper functions for the constant function cache: the result of a constant
+// function only depends on its arguments if the function only references its
+// own arguments and variables and only calls system functions. such results
+// can be shared between all modules derived from the same parametric module.
+static void collect_function_locals(AstNode *node, pool<std::string> &locals)
+{
+	if (node->type == AST_WIRE)
+		locals.insert(node->str);
+	for (auto child : node->children)
+		collect_function_locals(child, locals);
+}
+
+static bool function_is_self_contained(AstNode *node, const pool<std::string> &locals)
+{
+	if (node->type == AST_IDENTIFIER && locals.count(node->str) == 0)
+		return false;
+	if ((node->type == AST_FCALL || node->type == AST_TCALL) && node->str.substr(0, 2) != "\\$")
+		return false;
+	for (auto child : node->children)
+		if (!function_is_self_contained(child, locals))
+			return false;
+	return true;
+}
+
+// the cache key describes the complete function body, so that different functions
+// with the same name and source location (e.g. from macro expansions) never alias
+static void append_function_key(AstNode *node, std::string &key)
+{
+	key += stringf("(%d,%d:%s,%s,%d%d%d%d,%d:%d,%u", int(node->type), GetSize(node->str), node->str.c_str(),
+			RTLIL::Const(node->bits).as_string().c_str(), node->is_signed, node->is_reg, node->is_input,
+			node->is_output, node->range_left, node->range_right, node->integer);
+	for (auto child : node->children)
+		append_function_key(child, key);
+	key += ")";
+}
+
 // convert the AST into a simpler AST that has all parameters substituted by their
 // values, unrolled for-loops, expanded generate blocks, etc. when this function
 // is done with an AST it can be converted into RTLIL using genRTLIL().
@@ -2127,9 +2163,26 @@ skip_dynamic_range_lvalue_expansion:;
 			}
 
 			if (all_args_const) {
+				std::string cache_key;
+				if (current_const_func_cache != NULL) {
+					pool<std::string> locals;
+					collect_function_locals(decl, locals);
+					if (function_is_self_contained(decl, locals)) {
+						append_function_key(decl, cache_key);
+						for (auto child : children)
+							cache_key += stringf(":%s%s", child->is_signed ? "s" : "u", RTLIL::Const(child->bits).as_string().c_str());
+						auto it = current_const_func_cache->find(cache_key);
+						if (it != current_const_func_cache->end()) {
+							newNode = mkconst_bits(it->second.first.bits, it->second.second);
+							goto apply_newNode;
+						}
+					}
+				}
 				AstNode *func_workspace = current_scope[str]->clone();
 				newNode = func_workspace->eval_const_function(this);
 				delete func_workspace;
+				if (!cache_key.empty())
+					(*current_const_func_cache)[cache_key] = std::pair<RTLIL::Const, bool>(RTLIL::Const(newNode->bits), newNode->is_signed);
 				goto apply_newNode;
 			}
 
@@ -34,7 +34,7 @@ void rtlil_frontend_ilang_yyerror(char const *s)
 YOSYS_NAMESPACE_BEGIN
 
 struct IlangFrontend : public Frontend {
-	IlangFrontend() : Frontend("ilang", "read modules from ilang file") { }
+	IlangFrontend() : Frontend("ilang", "read modules from ilang file") { readonly_modules = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
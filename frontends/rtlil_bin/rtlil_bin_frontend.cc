@@ -0,0 +1,445 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Reader for the binary RTLIL files created by write_rtlil_bin. See
+ *  backends/rtlil_bin/rtlil_bin.h for a description of the file format.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "backends/rtlil_bin/rtlil_bin.h"
+
+#ifndef _WIN32
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+using namespace RTLIL_BIN;
+
+// the file contents, either mapped into memory or copied into a buffer
+struct RtlilBinData
+{
+	const unsigned char *data;
+	size_t size;
+	std::string buffer;
+	bool mapped;
+
+	RtlilBinData() : data(nullptr), size(0), mapped(false) { }
+
+	~RtlilBinData()
+	{
+#ifndef _WIN32
+		if (mapped)
+			munmap((void*)data, size);
+#endif
+	}
+
+	void load(std::istream *f, std::string filename)
+	{
+#ifndef _WIN32
+		if (dynamic_cast<std::ifstream*>(f) != nullptr) {
+			int fd = open(filename.c_str(), O_RDONLY);
+			struct stat st;
+			if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+				void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (p != MAP_FAILED) {
+					data = (const unsigned char*)p;
+					size = st.st_size;
+					mapped = true;
+				}
+			}
+			if (fd >= 0)
+				close(fd);
+			if (mapped)
+				return;
+		}
+#endif
+		std::stringstream ss;
+		ss << f->rdbuf();
+		buffer = ss.str();
+		data = (const unsigned char*)buffer.data();
+		size = buffer.size();
+	}
+};
+
+struct RtlilBinReader
+{
+	const unsigned char *data;
+	size_t size;
+	int file_autoidx;
+
+	// string offsets and lengths are scanned once, IdStrings are only
+	// created when a module using them is materialized
+	std::vector<std::pair<size_t, size_t>> string_spans;
+	std::vector<RTLIL::IdString> strings;
+	std::vector<bool> string_valid;
+
+	struct ModuleEntry {
+		int name;
+		size_t offset, size;
+	};
+	std::vector<ModuleEntry> module_table;
+
+	RTLIL::Module *module;
+	std::vector<RTLIL::Wire*> wires;
+
+	RtlilBinReader(const unsigned char *data, size_t size) : data(data), size(size), module(nullptr)
+	{
+		Reader r(data, data + size);
+		if (size < size_t(header_size) || memcmp(r.bytes(sizeof(magic)), magic, sizeof(magic)))
+			log_error("Input is not a binary RTLIL file.\n");
+
+		uint32_t file_version = r.fixed(4);
+		if (file_version != version)
+			log_error("Unsupported binary RTLIL version %u (expected %u).\n", file_version, version);
+
+		file_autoidx = r.fixed(4);
+		uint64_t strings_offset = r.fixed(8);
+		uint64_t modules_offset = r.fixed(8);
+		if (strings_offset > size || modules_offset > size)
+			log_error("Invalid table offsets in binary RTLIL file.\n");
+
+		r.ptr = data + strings_offset;
+		int num_strings = r.count();
+		string_spans.reserve(num_strings);
+		for (int i = 0; i < num_strings; i++) {
+			size_t len = r.count();
+			size_t offset = r.ptr - data;
+			r.bytes(len);
+			string_spans.push_back(std::make_pair(offset, len));
+		}
+		strings.resize(num_strings);
+		string_valid.resize(num_strings);
+
+		r.ptr = data + modules_offset;
+		int num_modules = r.count();
+		for (int i = 0; i < num_modules; i++) {
+			ModuleEntry entry;
+			entry.name = r.integer();
+			entry.offset = r.uint();
+			entry.size = r.uint();
+			if (entry.name >= num_strings || entry.offset > size || entry.size > size - entry.offset)
+				log_error("Invalid module table in binary RTLIL file.\n");
+			module_table.push_back(entry);
+		}
+	}
+
+	RTLIL::IdString id(int idx)
+	{
+		if (idx < 0 || idx >= GetSize(strings))
+			log_error("Invalid string index %d in binary RTLIL file.\n", idx);
+		if (!string_valid[idx]) {
+			auto &span = string_spans[idx];
+			strings[idx] = std::string((const char*)data + span.first, span.second);
+			string_valid[idx] = true;
+		}
+		return strings[idx];
+	}
+
+	RTLIL::IdString read_id(Reader &r)
+	{
+		return id(r.integer());
+	}
+
+	RTLIL::Const read_const(Reader &r)
+	{
+		RTLIL::Const value;
+		value.flags = r.uint();
+		int width = r.integer();
+		int num_planes = r.u8();
+		if (num_planes != 1 && num_planes != 3)
+			log_error("Invalid constant encoding in binary RTLIL file.\n");
+
+		int num_bytes = (width + 7) / 8;
+		value.bits.resize(width, RTLIL::State::S0);
+		for (int plane = 0; plane < num_planes; plane++) {
+			const unsigned char *p = (const unsigned char*)r.bytes(num_bytes);
+			for (int i = 0; i < width; i++)
+				if ((p[i >> 3] >> (i & 7)) & 1)
+					value.bits[i] = RTLIL::State(value.bits[i] | (1 << plane));
+		}
+		return value;
+	}
+
+	RTLIL::SigSpec read_sig(Reader &r)
+	{
+		int num_chunks = r.count();
+		if (num_chunks == 1)
+			return read_chunk(r);
+		std::vector<RTLIL::SigChunk> chunks;
+		chunks.reserve(num_chunks);
+		for (int i = 0; i < num_chunks; i++)
+			chunks.push_back(read_chunk(r));
+		return chunks;
+	}
+
+	RTLIL::SigChunk read_chunk(Reader &r)
+	{
+		uint64_t tag = r.uint();
+		if (tag == 0)
+			return read_const(r);
+		if (tag > uint64_t(GetSize(wires)))
+			log_error("Invalid wire reference in binary RTLIL file.\n");
+		RTLIL::Wire *wire = wires[tag-1];
+		int offset = r.integer();
+		int width = r.integer();
+		if (int64_t(offset) + width > wire->width)
+			log_error("Out of range reference to wire %s in binary RTLIL file.\n", log_id(wire));
+		return RTLIL::SigChunk(wire, offset, width);
+	}
+
+	void read_attrs(Reader &r, dict<RTLIL::IdString, RTLIL::Const> &attrs)
+	{
+		int num_attrs = r.count();
+		for (int i = 0; i < num_attrs; i++) {
+			RTLIL::IdString name = read_id(r);
+			attrs[name] = read_const(r);
+		}
+	}
+
+	void read_actions(Reader &r, std::vector<RTLIL::SigSig> &actions)
+	{
+		int num_actions = r.count();
+		actions.reserve(num_actions);
+		for (int i = 0; i < num_actions; i++) {
+			RTLIL::SigSpec lhs = read_sig(r);
+			RTLIL::SigSpec rhs = read_sig(r);
+			if (GetSize(lhs) != GetSize(rhs))
+				log_error("Width mismatch in connection in module %s in binary RTLIL file.\n", log_id(module));
+			actions.push_back(RTLIL::SigSig(lhs, rhs));
+		}
+	}
+
+	void read_case(Reader &r, RTLIL::CaseRule *cs)
+	{
+		int num_compare = r.count();
+		for (int i = 0; i < num_compare; i++)
+			cs->compare.push_back(read_sig(r));
+		read_actions(r, cs->actions);
+		int num_switches = r.count();
+		for (int i = 0; i < num_switches; i++) {
+			RTLIL::SwitchRule *sw = new RTLIL::SwitchRule;
+			cs->switches.push_back(sw);
+			read_attrs(r, sw->attributes);
+			sw->signal = read_sig(r);
+			int num_cases = r.count();
+			for (int j = 0; j < num_cases; j++) {
+				RTLIL::CaseRule *child = new RTLIL::CaseRule;
+				sw->cases.push_back(child);
+				read_case(r, child);
+			}
+		}
+	}
+
+	void read_module(RTLIL::Design *design, const ModuleEntry &entry)
+	{
+		RTLIL::IdString name = id(entry.name);
+		if (design->has(name))
+			log_error("Binary RTLIL error: redefinition of module %s.\n", log_id(name));
+
+		Reader r(data + entry.offset, data + entry.offset + entry.size);
+
+		module = new RTLIL::Module;
+		module->name = name;
+		read_attrs(r, module->attributes);
+		design->add(module);
+
+		int num_params = r.count();
+		for (int i = 0; i < num_params; i++)
+			module->avail_parameters.insert(read_id(r));
+
+		int num_wires = r.count();
+		wires.clear();
+		wires.reserve(num_wires);
+		for (int i = 0; i < num_wires; i++) {
+			RTLIL::IdString wire_name = read_id(r);
+			if (module->wires_.count(wire_name) != 0)
+				log_error("Binary RTLIL error: redefinition of wire %s.\n", log_id(wire_name));
+			RTLIL::Wire *wire = module->addWire(wire_name);
+			read_attrs(r, wire->attributes);
+			wire->width = r.integer();
+			wire->start_offset = r.sint();
+			wire->port_id = r.integer();
+			int flags = r.u8();
+			wire->port_input = (flags & WIRE_INPUT) != 0;
+			wire->port_output = (flags & WIRE_OUTPUT) != 0;
+			wire->upto = (flags & WIRE_UPTO) != 0;
+			wires.push_back(wire);
+		}
+
+		int num_memories = r.count();
+		for (int i = 0; i < num_memories; i++) {
+			RTLIL::Memory *memory = new RTLIL::Memory;
+			memory->name = read_id(r);
+			if (module->memories.count(memory->name) != 0)
+				log_error("Binary RTLIL error: redefinition of memory %s.\n", log_id(memory->name));
+			module->memories[memory->name] = memory;
+			read_attrs(r, memory->attributes);
+			memory->width = r.integer();
+			memory->start_offset = r.sint();
+			memory->size = r.integer();
+		}
+
+		int num_cells = r.count();
+		for (int i = 0; i < num_cells; i++) {
+			RTLIL::IdString cell_name = read_id(r);
+			RTLIL::IdString cell_type = read_id(r);
+			if (module->cells_.count(cell_name) != 0)
+				log_error("Binary RTLIL error: redefinition of cell %s.\n", log_id(cell_name));
+			RTLIL::Cell *cell = module->addCell(cell_name, cell_type);
+			read_attrs(r, cell->attributes);
+			int num_cell_params = r.count();
+			for (int j = 0; j < num_cell_params; j++) {
+				RTLIL::IdString param_name = read_id(r);
+				cell->parameters[param_name] = read_const(r);
+			}
+			int num_ports = r.count();
+			for (int j = 0; j < num_ports; j++) {
+				RTLIL::IdString port_name = read_id(r);
+				cell->setPort(port_name, read_sig(r));
+			}
+		}
+
+		std::vector<RTLIL::SigSig> connections;
+		read_actions(r, connections);
+		module->new_connections(connections);
+
+		int num_processes = r.count();
+		for (int i = 0; i < num_processes; i++) {
+			RTLIL::Process *proc = new RTLIL::Process;
+			proc->name = read_id(r);
+			if (module->processes.count(proc->name) != 0)
+				log_error("Binary RTLIL error: redefinition of process %s.\n", log_id(proc->name));
+			module->processes[proc->name] = proc;
+			read_attrs(r, proc->attributes);
+			read_case(r, &proc->root_case);
+			int num_syncs = r.count();
+			for (int j = 0; j < num_syncs; j++) {
+				RTLIL::SyncRule *sync = new RTLIL::SyncRule;
+				proc->syncs.push_back(sync);
+				sync->type = RTLIL::SyncType(r.u8());
+				if (sync->type > RTLIL::STi)
+					log_error("Invalid sync rule type in binary RTLIL file.\n");
+				sync->signal = read_sig(r);
+				read_actions(r, sync->actions);
+			}
+		}
+
+		if (r.ptr != r.end)
+			log_error("Trailing data after module %s in binary RTLIL file.\n", log_id(module));
+
+		module->fixup_ports();
+		module = nullptr;
+		wires.clear();
+	}
+};
+
+struct RtlilBinFrontend : public Frontend {
+	RtlilBinFrontend() : Frontend("rtlil_bin", "read modules from binary RTLIL file") { readonly_modules = true; }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    read_rtlil_bin [options] [filename]\n");
+		log("\n");
+		log("Load modules from a binary RTLIL file (as written by write_rtlil_bin) to the\n");
+		log("current design. Regular files are mapped into memory and only the modules that\n");
+		log("are loaded are decoded.\n");
+		log("\n");
+		log("    -module <name>\n");
+		log("        only load the specified module. this option can be used multiple\n");
+		log("        times. the other modules in the file are skipped without decoding.\n");
+		log("\n");
+		log("    -list\n");
+		log("        only print the names and sizes of the modules in the file.\n");
+		log("\n");
+	}
+	virtual void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design)
+	{
+		pool<RTLIL::IdString> only_modules;
+		bool list_mode = false;
+
+		log_header(design, "Executing binary RTLIL frontend.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (arg == "-module" && argidx+1 < args.size()) {
+				only_modules.insert(RTLIL::escape_id(args[++argidx]));
+				continue;
+			}
+			if (arg == "-list") {
+				list_mode = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(f, filename, args, argidx);
+
+		log("Input filename: %s\n", filename.c_str());
+
+		PerformanceTimer timer;
+		timer.begin();
+
+		RtlilBinData file;
+		file.load(f, filename);
+
+		RtlilBinReader reader(file.data, file.size);
+
+		if (list_mode) {
+			for (auto &entry : reader.module_table)
+				log("  %-40s %12lld bytes\n", log_id(reader.id(entry.name)), (long long)entry.size);
+			return;
+		}
+
+		int num_modules = 0;
+		size_t num_bytes = 0;
+		pool<RTLIL::IdString> found_modules;
+
+		for (auto &entry : reader.module_table) {
+			if (!only_modules.empty()) {
+				RTLIL::IdString name = reader.id(entry.name);
+				if (only_modules.count(name) == 0)
+					continue;
+				found_modules.insert(name);
+			}
+			reader.read_module(design, entry);
+			num_modules++;
+			num_bytes += entry.size;
+		}
+
+		for (auto name : only_modules)
+			if (found_modules.count(name) == 0)
+				log_error("Module %s not found in binary RTLIL file.\n", log_id(name));
+
+		autoidx = max(autoidx, reader.file_autoidx);
+
+		timer.end();
+		double sec = timer.sec();
+		log("Loaded %d of %d modules, %.2f MB of %.2f MB in %.2f seconds (%.1f MB/s, %s).\n", num_modules, GetSize(reader.module_table),
+				num_bytes * 1e-6, file.size * 1e-6, sec, sec > 0 ? num_bytes * 1e-6 / sec : 0.0, file.mapped ? "mapped" : "buffered");
+	}
+} RtlilBinFrontend;
+
+PRIVATE_NAMESPACE_END
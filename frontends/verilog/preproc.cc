@@ -38,44 +38,114 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifndef _WIN32
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
 YOSYS_NAMESPACE_BEGIN
 using namespace VERILOG_FRONTEND;
 
-static std::list<std::string> output_code;
-static std::list<std::string> input_buffer;
-static size_t input_buffer_charp;
+// an input file, mapped into memory if possible
+struct PreprocFile
+{
+	const char *data;
+	size_t size;
+	std::string buffer;
+	bool mapped;
 
-static void return_char(char ch)
+	PreprocFile(std::istream &f, std::string filename) : data(nullptr), size(0), mapped(false)
+	{
+#ifndef _WIN32
+		if (dynamic_cast<std::ifstream*>(&f) != nullptr) {
+			int fd = open(filename.c_str(), O_RDONLY);
+			struct stat st;
+			if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+				void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (p != MAP_FAILED) {
+					data = (const char*)p;
+					size = st.st_size;
+					mapped = true;
+				}
+			}
+			if (fd >= 0)
+				close(fd);
+			if (mapped)
+				return;
+		}
+#endif
+		std::stringstream ss;
+		ss << f.rdbuf();
+		buffer = ss.str();
+		data = buffer.data();
+		size = buffer.size();
+	}
+
+	~PreprocFile()
+	{
+#ifndef _WIN32
+		if (mapped)
+			munmap((void*)data, size);
+#endif
+	}
+};
+
+// the input is a stack of frames, the last frame is read first. a frame is
+// one contiguous buffer: an input file, the body of an expanded macro, or
+// characters pushed back by the tokenizer.
+struct PreprocFrame
 {
-	if (input_buffer_charp == 0)
-		input_buffer.push_front(std::string() + ch);
-	else
-		input_buffer.front()[--input_buffer_charp] = ch;
-}
+	std::string text;
+	const char *ext_data;
+	size_t pos, size;
+
+	const char *data() const { return ext_data ? ext_data : text.data(); }
+};
+
+static std::string output_code;
+static std::vector<PreprocFrame> input_frames;
+static std::vector<PreprocFile*> input_files;
 
 static void insert_input(std::string str)
 {
-	if (input_buffer_charp != 0) {
-		input_buffer.front() = input_buffer.front().substr(input_buffer_charp);
-		input_buffer_charp = 0;
+	input_frames.push_back(PreprocFrame());
+	PreprocFrame &frame = input_frames.back();
+	frame.text.swap(str);
+	frame.ext_data = nullptr;
+	frame.pos = 0;
+	frame.size = frame.text.size();
+}
+
+static void return_char(char ch)
+{
+	// usually this is the character that has just been read
+	if (!input_frames.empty()) {
+		PreprocFrame &frame = input_frames.back();
+		if (frame.pos > 0 && frame.data()[frame.pos-1] == ch) {
+			frame.pos--;
+			return;
+		}
 	}
-	input_buffer.push_front(str);
+	insert_input(std::string(1, ch));
 }
 
 static char next_char()
 {
-	if (input_buffer.empty())
-		return 0;
-
-	log_assert(input_buffer_charp <= input_buffer.front().size());
-	if (input_buffer_charp == input_buffer.front().size()) {
-		input_buffer_charp = 0;
-		input_buffer.pop_front();
-		return next_char();
-	}
+	while (!input_frames.empty())
+	{
+		PreprocFrame &frame = input_frames.back();
+		if (frame.pos == frame.size) {
+			input_frames.pop_back();
+			continue;
+		}
 
-	char ch = input_buffer.front()[input_buffer_charp++];
-	return ch == '\r' ? next_char() : ch;
+		char ch = frame.data()[frame.pos++];
+		if (ch != '\r')
+			return ch;
+	}
+	return 0;
 }
 
 static std::string skip_spaces()
@@ -105,7 +175,7 @@ static std::string next_token(bool pass_newline = false)
 	token += ch;
 	if (ch == '\n') {
 		if (pass_newline) {
-			output_code.push_back(token);
+			output_code += token;
 			return "";
 		}
 		return token;
@@ -200,20 +270,62 @@ static std::string next_token(bool pass_newline = false)
 
 static void input_file(std::istream &f, std::string filename)
 {
-	char buffer[513];
-	int rc;
+	PreprocFile *file = new PreprocFile(f, filename);
+	input_files.push_back(file);
 
-	insert_input("");
-	auto it = input_buffer.begin();
+	insert_input("\n`file_pop\n");
 
-	input_buffer.insert(it, "`file_push \"" + filename + "\"\n");
-	while ((rc = readsome(f, buffer, sizeof(buffer)-1)) > 0) {
-		buffer[rc] = 0;
-		input_buffer.insert(it, buffer);
-	}
-	input_buffer.insert(it, "\n`file_pop\n");
+	input_frames.push_back(PreprocFrame());
+	PreprocFrame &frame = input_frames.back();
+	frame.ext_data = file->data;
+	frame.pos = 0;
+	frame.size = file->size;
+
+	insert_input("`file_push \"" + filename + "\"\n");
 }
 
+// characters that next_token() returns as part of an identifier token (this
+// includes '\0', like in the strchr() call in next_token())
+static bool is_ident_char(char ch)
+{
+	return ch == 0 || ch == '_' || ch == '$' || ('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z') || ('0' <= ch && ch <= '9');
+}
+
+// copy text from the current frame to the output that next_token() would
+// return unchanged and that can't contain a directive or a macro: spaces,
+// newlines, identifiers, numbers and most punctuation. returns false if there
+// is no such text at the current position.
+static bool copy_plain_text()
+{
+	if (input_frames.empty())
+		return false;
+
+	PreprocFrame &frame = input_frames.back();
+	const char *begin = frame.data() + frame.pos;
+	const char *end = frame.data() + frame.size;
+	const char *p = begin;
+
+	while (p != end && *p != '`' && *p != '"' && *p != '/' && *p != '\r' && *p != 0)
+		p++;
+
+	// leave identifiers that might continue in the next frame, and identifiers
+	// followed by '\0', to next_token(). a single character identifier directly
+	// followed by a quote is a token of its own in next_token().
+	if (p == end || *p == 0) {
+		while (p != begin && is_ident_char(p[-1]))
+			p--;
+	} else if (*p == '"' && p != begin && is_ident_char(p[-1])) {
+		if (p-1 == begin || !is_ident_char(p[-2]))
+			p--;
+	}
+
+	if (p == begin)
+		return false;
+
+	output_code.append(begin, p - begin);
+	frame.pos += p - begin;
+	return true;
+}
 
 static bool try_expand_macro(std::set<std::string> &defines_with_args,
 			     std::map<std::string, std::string> &defines_map,
@@ -223,7 +335,7 @@ static bool try_expand_macro(std::set<std::string> &defines_with_args,
 	if (tok == "`\"") {
 		std::string literal("\"");
 		// Expand string literal
-		while (!input_buffer.empty()) {
+		while (!input_frames.empty()) {
 			std::string ntok = next_token();
 			if (ntok == "`\"") {
 				insert_input(literal+"\"");
@@ -277,8 +389,7 @@ std::string frontend_verilog_preproc(std::istream &f, std::string filename, cons
 	bool in_elseif = false;
 
 	output_code.clear();
-	input_buffer.clear();
-	input_buffer_charp = 0;
+	input_frames.clear();
 
 	input_file(f, filename);
 
@@ -294,8 +405,11 @@ std::string frontend_verilog_preproc(std::istream &f, std::string filename, cons
 		defines_map[it.first] = it.second.first;
 	}
 
-	while (!input_buffer.empty())
+	while (!input_frames.empty())
 	{
+		if (ifdef_fail_level == 0 && copy_plain_text())
+			continue;
+
 		std::string tok = next_token();
 		// printf("token: >>%s<<\n", tok != "\n" ? tok.c_str() : "NEWLINE");
 
@@ -343,7 +457,7 @@ std::string frontend_verilog_preproc(std::istream &f, std::string filename, cons
 
 		if (ifdef_fail_level > 0) {
 			if (tok == "\n")
-				output_code.push_back(tok);
+				output_code += tok;
 			continue;
 		}
 
@@ -401,7 +515,7 @@ std::string frontend_verilog_preproc(std::istream &f, std::string filename, cons
 				}
 			}
 			if (ff.fail()) {
-				output_code.push_back("`file_notfound " + fn);
+				output_code += "`file_notfound " + fn;
 			} else {
 				input_file(ff, fixed_fn);
 				yosys_input_files.insert(fixed_fn);
@@ -414,14 +528,14 @@ std::string frontend_verilog_preproc(std::istream &f, std::string filename, cons
 			std::string fn = next_token(true);
 			if (!fn.empty() && fn.front() == '"' && fn.back() == '"')
 				fn = fn.substr(1, fn.size()-2);
-			output_code.push_back(tok + " \"" + fn + "\"");
+			output_code += tok + " \"" + fn + "\"";
 			filename_stack.push_back(filename);
 			filename = fn;
 			continue;
 		}
 
 		if (tok == "`file_pop") {
-			output_code.push_back(tok);
+			output_code += tok;
 			filename = filename_stack.back();
 			filename_stack.pop_back();
 			continue;
@@ -525,16 +639,16 @@ std::string frontend_verilog_preproc(std::istream &f, std::string filename, cons
 		if (try_expand_macro(defines_with_args, defines_map, tok))
 			continue;
 
-		output_code.push_back(tok);
+		output_code += tok;
 	}
 
 	std::string output;
-	for (auto &str : output_code)
-		output += str;
+	output.swap(output_code);
 
-	output_code.clear();
-	input_buffer.clear();
-	input_buffer_charp = 0;
+	input_frames.clear();
+	for (auto file : input_files)
+		delete file;
+	input_files.clear();
 
 	return output;
 }
@@ -36,9 +36,13 @@ using namespace VERILOG_FRONTEND;
 
 // use the Verilog bison/flex parser to generate an AST and use AST::process() to convert it to RTLIL
 
-static std::vector<std::string> verilog_defaults;
+std::vector<std::string> verilog_defaults;
 static std::list<std::vector<std::string>> verilog_defaults_stack;
 
+namespace VERILOG_FRONTEND {
+	thread_local bool found_synopsys_translate_off, found_synopsys_full_case, found_synopsys_parallel_case;
+}
+
 static void error_on_dpi_function(AST::AstNode *node)
 {
 	if (node->type == AST::AST_DPI_FUNCTION)
@@ -47,6 +51,60 @@ static void error_on_dpi_function(AST::AstNode *node)
 		error_on_dpi_function(child);
 }
 
+// line number callbacks for the AST library, using the scanner of the calling thread
+static void verilog_set_line_num(int line_number)
+{
+	frontend_verilog_yyset_lineno(line_number, lexscanner);
+}
+
+static int verilog_get_line_num()
+{
+	return frontend_verilog_yyget_lineno(lexscanner);
+}
+
+// print the warnings about synopsys comments once per run, for the first
+// file (in command line order) that contains them
+static void warn_synopsys_comments(bool translate_off, bool full_case, bool parallel_case)
+{
+	static bool printed_translate_off = false, printed_full_case = false, printed_parallel_case = false;
+
+	if (translate_off && !printed_translate_off) {
+		log_warning("Found one of those horrible `(synopsys|synthesis) translate_off' comments.\n"
+				"Yosys does support them but it is recommended to use `ifdef constructs instead!\n");
+		printed_translate_off = true;
+	}
+	if (full_case && !printed_full_case) {
+		log_warning("Found one of those horrible `(synopsys|synthesis) full_case' comments.\n"
+				"Yosys does support them but it is recommended to use Verilog `full_case' attributes instead!\n");
+		printed_full_case = true;
+	}
+	if (parallel_case && !printed_parallel_case) {
+		log_warning("Found one of those horrible `(synopsys|synthesis) parallel_case' comments.\n"
+				"Yosys does support them but it is recommended to use Verilog `parallel_case' attributes instead!\n");
+		printed_parallel_case = true;
+	}
+}
+
+// lexer input stream reading the output of the pre-processor in place
+struct PreprocStream : std::streambuf, std::istream
+{
+	PreprocStream(std::string &code) : std::istream(this)
+	{
+		setg(&code[0], &code[0], &code[0] + code.size());
+	}
+};
+
+// one input file of a read_verilog command
+struct VerilogInput
+{
+	std::string filename;
+	std::istream *f, *lexin;
+	std::string code_after_preproc;
+	AST::AstNode *ast;
+	bool default_nettype_wire;
+	bool found_translate_off, found_full_case, found_parallel_case;
+};
+
 struct VerilogFrontend : public Frontend {
 	VerilogFrontend() : Frontend("verilog", "read modules from Verilog file") { }
 	virtual void help()
@@ -160,6 +218,14 @@ struct VerilogFrontend : public Frontend {
 		log("        add 'dir' to the directories which are used when searching include\n");
 		log("        files\n");
 		log("\n");
+		log("    -j <threads>\n");
+		log("        when more than one file is given, parse up to <threads> files in\n");
+		log("        parallel. the files are still pre-processed one after another (so\n");
+		log("        `define's carry over from one file to the next as usual) and the\n");
+		log("        modules are added to the design in the order of the files on the\n");
+		log("        command line, so the result is the same as for a serial run. only\n");
+		log("        the log output is grouped differently. (default: value of 'yosys -j')\n");
+		log("\n");
 		log("The command 'verilog_defaults' can be used to register default options for\n");
 		log("subsequent calls to 'read_verilog'.\n");
 		log("\n");
@@ -193,6 +259,7 @@ struct VerilogFrontend : public Frontend {
 		bool flag_icells = false;
 		bool flag_ignore_redef = false;
 		bool flag_defer = false;
+		int num_threads = 0;
 		std::map<std::string, std::string> defines_map;
 		std::list<std::string> include_dirs;
 		std::list<std::string> attributes;
@@ -324,6 +391,10 @@ struct VerilogFrontend : public Frontend {
 				defines_map[name] = value;
 				continue;
 			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				num_threads = atoi(args[++argidx].c_str());
+				continue;
+			}
 			if (arg == "-I" && argidx+1 < args.size()) {
 				include_dirs.push_back(args[++argidx]);
 				continue;
@@ -336,48 +407,97 @@ struct VerilogFrontend : public Frontend {
 		}
 		extra_args(f, filename, args, argidx);
 
-		log("Parsing %s%s input from `%s' to AST representation.\n",
-				formal_mode ? "formal " : "", sv_mode ? "SystemVerilog" : "Verilog", filename.c_str());
-
-		AST::current_filename = filename;
-		AST::set_line_num = &frontend_verilog_yyset_lineno;
-		AST::get_line_num = &frontend_verilog_yyget_lineno;
+		if (num_threads <= 0)
+			num_threads = yosys_threads;
+
+		std::vector<VerilogInput> inputs(1);
+		inputs.front().filename = filename;
+		inputs.front().f = f;
+
+		// in parallel mode all remaining files of the command are handled by
+		// this call, instead of one call to execute() for each file
+		while (num_threads > 1 && !next_args.empty()) {
+			std::vector<std::string> file_args = next_args;
+			VerilogInput input;
+			input.f = NULL;
+			extra_args(input.f, input.filename, file_args, argidx);
+			inputs.push_back(input);
+		}
 
-		current_ast = new AST::AstNode(AST::AST_DESIGN);
+		for (auto &input : inputs)
+		{
+			log("Parsing %s%s input from `%s' to AST representation.\n",
+					formal_mode ? "formal " : "", sv_mode ? "SystemVerilog" : "Verilog", input.filename.c_str());
 
-		lexin = f;
-		std::string code_after_preproc;
+			input.lexin = input.f;
 
-		if (!flag_nopp) {
-			code_after_preproc = frontend_verilog_preproc(*f, filename, defines_map, design->verilog_defines, include_dirs);
-			if (flag_ppdump)
-				log("-- Verilog code after preprocessor --\n%s-- END OF DUMP --\n", code_after_preproc.c_str());
-			lexin = new std::istringstream(code_after_preproc);
+			if (!flag_nopp) {
+				input.code_after_preproc = frontend_verilog_preproc(*input.f, input.filename, defines_map, design->verilog_defines, include_dirs);
+				if (flag_ppdump)
+					log("-- Verilog code after preprocessor --\n%s-- END OF DUMP --\n", input.code_after_preproc.c_str());
+				input.lexin = new PreprocStream(input.code_after_preproc);
+			}
 		}
 
-		frontend_verilog_yyset_lineno(1);
-		frontend_verilog_yyrestart(NULL);
-		frontend_verilog_yyparse();
-		frontend_verilog_yylex_destroy();
-
-		for (auto &child : current_ast->children) {
-			if (child->type == AST::AST_MODULE)
-				for (auto &attr : attributes)
-					if (child->attributes.count(attr) == 0)
-						child->attributes[attr] = AST::AstNode::mkconst_int(1, false);
+		AST::set_line_num = &verilog_set_line_num;
+		AST::get_line_num = &verilog_get_line_num;
+
+		// the parser state is thread-local, so each job can run the bison
+		// parser for one file. everything that touches the design is done
+		// afterwards in the original file order.
+		bool initial_nettype_wire = default_nettype_wire;
+		parallel_for(GetSize(inputs), [&](int i) {
+			VerilogInput &input = inputs[i];
+			AST::current_filename = input.filename;
+			default_nettype_wire = initial_nettype_wire;
+			lexin = input.lexin;
+			found_synopsys_translate_off = false;
+			found_synopsys_full_case = false;
+			found_synopsys_parallel_case = false;
+
+			frontend_verilog_yylex_init(&lexscanner);
+			frontend_verilog_yyrestart(NULL, lexscanner);
+			frontend_verilog_yyset_lineno(1, lexscanner);
+
+			current_ast = new AST::AstNode(AST::AST_DESIGN);
+			frontend_verilog_yyparse();
+			input.ast = current_ast;
+			input.default_nettype_wire = default_nettype_wire;
+			input.found_translate_off = found_synopsys_translate_off;
+			input.found_full_case = found_synopsys_full_case;
+			input.found_parallel_case = found_synopsys_parallel_case;
+			current_ast = NULL;
+
+			frontend_verilog_yylex_destroy(lexscanner);
+			lexscanner = NULL;
+		}, num_threads);
+
+		AST::use_internal_line_num();
+
+		for (auto &input : inputs)
+		{
+			warn_synopsys_comments(input.found_translate_off, input.found_full_case, input.found_parallel_case);
+
+			for (auto &child : input.ast->children) {
+				if (child->type == AST::AST_MODULE)
+					for (auto &attr : attributes)
+						if (child->attributes.count(attr) == 0)
+							child->attributes[attr] = AST::AstNode::mkconst_int(1, false);
+			}
+
+			if (flag_nodpi)
+				error_on_dpi_function(input.ast);
+
+			AST::current_filename = input.filename;
+			AST::process(design, input.ast, flag_dump_ast1, flag_dump_ast2, flag_dump_vlog, flag_dump_rtlil, flag_nolatches, flag_nomeminit, flag_nomem2reg, flag_mem2reg, lib_mode, flag_noopt, flag_icells, flag_ignore_redef, flag_defer, input.default_nettype_wire);
+
+			if (input.lexin != input.f)
+				delete input.lexin;
+			if (input.f != f)
+				delete input.f;
+			delete input.ast;
 		}
 
-		if (flag_nodpi)
-			error_on_dpi_function(current_ast);
-
-		AST::process(design, current_ast, flag_dump_ast1, flag_dump_ast2, flag_dump_vlog, flag_dump_rtlil, flag_nolatches, flag_nomeminit, flag_nomem2reg, flag_mem2reg, lib_mode, flag_noopt, flag_icells, flag_ignore_redef, flag_defer, default_nettype_wire);
-
-		if (!flag_nopp)
-			delete lexin;
-
-		delete current_ast;
-		current_ast = NULL;
-
 		log("Successfully finished Verilog frontend.\n");
 	}
 } VerilogFrontend;
@@ -505,11 +625,13 @@ YOSYS_NAMESPACE_END
 // the yyerror function used by bison to report parser errors
 void frontend_verilog_yyerror(char const *fmt, ...)
 {
+	// when several files are parsed in parallel, parallel_for() reports the
+	// error of the first file (in command line order) that has one
 	va_list ap;
 	char buffer[1024];
 	char *p = buffer;
 	p += snprintf(p, buffer + sizeof(buffer) - p, "Parser error in line %s:%d: ",
-			YOSYS_NAMESPACE_PREFIX AST::current_filename.c_str(), frontend_verilog_yyget_lineno());
+			YOSYS_NAMESPACE_PREFIX AST::current_filename.c_str(), frontend_verilog_yyget_lineno(YOSYS_NAMESPACE_PREFIX VERILOG_FRONTEND::lexscanner));
 	va_start(ap, fmt);
 	p += vsnprintf(p, buffer + sizeof(buffer) - p, fmt, ap);
 	va_end(ap);
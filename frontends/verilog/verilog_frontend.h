@@ -40,13 +40,13 @@ YOSYS_NAMESPACE_BEGIN
 namespace VERILOG_FRONTEND
 {
 	// this variable is set to a new AST_DESIGN node and then filled with the AST by the bison parser
-	extern struct AST::AstNode *current_ast;
+	extern thread_local struct AST::AstNode *current_ast;
 
 	// this function converts a Verilog constant to an AST_CONSTANT node
 	AST::AstNode *const2ast(std::string code, char case_type = 0, bool warn_z = false);
 
 	// state of `default_nettype
-	extern bool default_nettype_wire;
+	extern thread_local bool default_nettype_wire;
 
 	// running in SystemVerilog mode
 	extern bool sv_mode;
@@ -64,7 +64,15 @@ namespace VERILOG_FRONTEND
 	extern bool lib_mode;
 
 	// lexer input stream
-	extern std::istream *lexin;
+	extern thread_local std::istream *lexin;
+
+	// the (reentrant) flex scanner used by the parser in this thread
+	extern thread_local void *lexscanner;
+
+	// set by the scanner in this thread when it finds a synopsys translate_off,
+	// full_case or parallel_case comment (the warnings are printed afterwards,
+	// in file order)
+	extern thread_local bool found_synopsys_translate_off, found_synopsys_full_case, found_synopsys_parallel_case;
 }
 
 // the pre-processor
@@ -73,14 +81,15 @@ std::string frontend_verilog_preproc(std::istream &f, std::string filename, cons
 
 YOSYS_NAMESPACE_END
 
-// the usual bison/flex stuff
+// the usual bison/flex stuff (the parser and the scanner are reentrant, the
+// scanner state is passed as a void pointer, i.e. flex' yyscan_t)
 extern int frontend_verilog_yydebug;
-int frontend_verilog_yylex(void);
 void frontend_verilog_yyerror(char const *fmt, ...);
-void frontend_verilog_yyrestart(FILE *f);
+int frontend_verilog_yylex_init(void **scanner);
+void frontend_verilog_yyrestart(FILE *f, void *scanner);
 int frontend_verilog_yyparse(void);
-int frontend_verilog_yylex_destroy(void);
-int frontend_verilog_yyget_lineno(void);
-void frontend_verilog_yyset_lineno (int);
+int frontend_verilog_yylex_destroy(void *scanner);
+int frontend_verilog_yyget_lineno(void *scanner);
+void frontend_verilog_yyset_lineno(int line_number, void *scanner);
 
 #endif
@@ -28,8 +28,9 @@
  *
  *  This is the actual bison parser for Verilog code. The AST ist created directly
  *  from the bison reduce functions here. Note that this code uses a few global
- *  variables to hold the state of the AST generator and therefore this parser is
- *  not reentrant.
+ *  variables to hold the state of the AST generator. They are thread-local, so
+ *  different threads can parse different files at the same time, but the parser
+ *  is not reentrant within one thread.
  *
  */
 
@@ -45,22 +46,23 @@ using namespace VERILOG_FRONTEND;
 
 YOSYS_NAMESPACE_BEGIN
 namespace VERILOG_FRONTEND {
-	int port_counter;
-	std::map<std::string, int> port_stubs;
-	std::map<std::string, AstNode*> attr_list, default_attr_list;
-	std::map<std::string, AstNode*> *albuf;
-	std::vector<AstNode*> ast_stack;
-	struct AstNode *astbuf1, *astbuf2, *astbuf3;
-	struct AstNode *current_function_or_task;
-	struct AstNode *current_ast, *current_ast_mod;
-	int current_function_or_task_port_id;
-	std::vector<char> case_type_stack;
-	bool do_not_require_port_stubs;
-	bool default_nettype_wire;
+	thread_local int port_counter;
+	thread_local std::map<std::string, int> port_stubs;
+	thread_local std::map<std::string, AstNode*> attr_list, default_attr_list;
+	thread_local std::map<std::string, AstNode*> *albuf;
+	thread_local std::vector<AstNode*> ast_stack;
+	thread_local struct AstNode *astbuf1, *astbuf2, *astbuf3;
+	thread_local struct AstNode *current_function_or_task;
+	thread_local struct AstNode *current_ast, *current_ast_mod;
+	thread_local int current_function_or_task_port_id;
+	thread_local std::vector<char> case_type_stack;
+	thread_local bool do_not_require_port_stubs;
+	thread_local bool default_nettype_wire;
+	thread_local bool current_wire_rand, current_wire_const;
+	thread_local std::istream *lexin;
+	thread_local void *lexscanner;
 	bool sv_mode, formal_mode, lib_mode;
 	bool norestrict_mode, assume_asserts_mode;
-	bool current_wire_rand, current_wire_const;
-	std::istream *lexin;
 }
 YOSYS_NAMESPACE_END
 
@@ -93,6 +95,8 @@ static void free_attr(std::map<std::string, AstNode*> *al)
 %}
 
 %name-prefix "frontend_verilog_yy"
+%define api.pure
+%lex-param { lexscanner }
 
 %union {
 	std::string *string;
@@ -119,6 +123,10 @@ static void free_attr(std::map<std::string, AstNode*> *al)
 %token TOK_RAND TOK_CONST TOK_CHECKER TOK_ENDCHECKER TOK_EVENTUALLY
 %token TOK_INCREMENT TOK_DECREMENT TOK_UNIQUE TOK_PRIORITY
 
+%{
+int frontend_verilog_yylex(YYSTYPE *yylval_param, void *yyscanner);
+%}
+
 %type <ast> range range_or_multirange  non_opt_range non_opt_multirange range_or_signed_int
 %type <ast> wire_type expr basic_expr concat_list rvalue lvalue lvalue_concat_list
 %type <string> opt_label tok_prim_wrapper hierarchical_id
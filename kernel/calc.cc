@@ -97,6 +97,137 @@ static RTLIL::Const big2const(const BigInteger &val, int result_len, int undef_b
 	return result;
 }
 
+// Fast path for const2big(): Returns false if the value does not fit into an
+// int64_t (more than 63 bits unsigned or 64 bits signed).
+static bool const2int(const RTLIL::Const &val, bool as_signed, int64_t &result, int &undef_bit_pos)
+{
+	int num_bits = GetSize(val.bits);
+
+	if (num_bits > (as_signed ? 64 : 63))
+		return false;
+
+	uint64_t mag = 0;
+	for (int i = 0; i < num_bits; i++)
+		if (val.bits[i] == RTLIL::State::S1)
+			mag |= uint64_t(1) << i;
+		else if (val.bits[i] != RTLIL::State::S0 && undef_bit_pos < 0)
+			undef_bit_pos = i;
+
+	if (as_signed && num_bits && val.bits[num_bits-1] == RTLIL::State::S1)
+		mag |= ~uint64_t(0) << (num_bits-1);
+
+	result = mag;
+	return true;
+}
+
+// Counterpart of big2const() for the fast path, only for result_len <= 64
+static RTLIL::Const int2const(uint64_t val, int result_len, int undef_bit_pos)
+{
+	if (undef_bit_pos >= 0)
+		return RTLIL::Const(RTLIL::State::Sx, result_len);
+
+	RTLIL::Const result;
+	result.bits.resize(result_len);
+	for (int i = 0; i < result_len; i++)
+		result.bits[i] = (val >> i) & 1 ? RTLIL::State::S1 : RTLIL::State::S0;
+	return result;
+}
+
+// Both arguments fit into an int64_t and the result fits into 64 bits
+static bool use_int_path(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int &result_len,
+		int64_t &a, int64_t &b, int &undef_bit_pos)
+{
+	if (result_len < 0)
+		result_len = max(arg1.bits.size(), arg2.bits.size());
+	if (result_len > 64)
+		return false;
+	return const2int(arg1, signed1, a, undef_bit_pos) && const2int(arg2, signed2, b, undef_bit_pos);
+}
+
+// A constant stored as two bit-planes of 64-bit words: 'def' has a bit set for
+// each S0 or S1 and 'val' has a bit set for each S1. All other states are
+// undefined for the bitwise operations below. Constants of up to 128 bits are
+// stored in the object itself, so that packing them does not allocate memory.
+struct PackedConst
+{
+	int width;
+	uint64_t *val, *def;
+
+	PackedConst(int width) : width(width)
+	{
+		int n = words();
+		if (n <= 2) {
+			val = inline_words;
+			def = inline_words + 2;
+		} else {
+			heap_words.resize(2*n);
+			val = heap_words.data();
+			def = val + n;
+		}
+		for (int i = 0; i < n; i++)
+			val[i] = 0, def[i] = 0;
+	}
+
+	// same as extend_u0(arg, width, is_signed) followed by packing
+	PackedConst(const RTLIL::Const &arg, int width, bool is_signed) : PackedConst(width)
+	{
+		RTLIL::State padding = RTLIL::State::S0;
+		if (arg.bits.size() > 0 && is_signed)
+			padding = arg.bits.back();
+
+		int arg_width = GetSize(arg.bits);
+		for (int i = 0; i < words(); i++) {
+			uint64_t v = 0, d = 0;
+			for (int j = 0, k = 64*i; j < 64 && k < width; j++, k++) {
+				RTLIL::State bit = k < arg_width ? arg.bits[k] : padding;
+				if (bit == RTLIL::State::S1)
+					v |= uint64_t(1) << j, d |= uint64_t(1) << j;
+				else if (bit == RTLIL::State::S0)
+					d |= uint64_t(1) << j;
+			}
+			val[i] = v, def[i] = d;
+		}
+	}
+
+	PackedConst(const PackedConst&) = delete;
+	PackedConst &operator=(const PackedConst&) = delete;
+
+	int words() const {
+		return (width + 63) / 64;
+	}
+
+	RTLIL::Const as_const() const
+	{
+		RTLIL::Const result;
+		result.bits.resize(width);
+		for (int i = 0; i < width; i++) {
+			uint64_t m = uint64_t(1) << (i % 64);
+			if (def[i / 64] & m)
+				result.bits[i] = (val[i / 64] & m) ? RTLIL::State::S1 : RTLIL::State::S0;
+			else
+				result.bits[i] = RTLIL::State::Sx;
+		}
+		return result;
+	}
+
+private:
+	uint64_t inline_words[4];
+	std::vector<uint64_t> heap_words;
+};
+
+// The value of a constant as used by the logic (not bool) operators:
+// S1 if it has a set bit, Sx if it has undefined bits and S0 otherwise.
+static RTLIL::State const2bool(const RTLIL::Const &arg)
+{
+	RTLIL::State result = RTLIL::State::S0;
+	for (auto bit : arg.bits)
+		if (bit == RTLIL::State::S1)
+			return RTLIL::State::S1;
+		else if (bit != RTLIL::State::S0)
+			result = RTLIL::State::Sx;
+	return result;
+}
+
 static RTLIL::State logic_and(RTLIL::State a, RTLIL::State b)
 {
 	if (a == RTLIL::State::S0) return RTLIL::State::S0;
@@ -115,86 +246,117 @@ static RTLIL::State logic_or(RTLIL::State a, RTLIL::State b)
 	return RTLIL::State::S0;
 }
 
-static RTLIL::State logic_xor(RTLIL::State a, RTLIL::State b)
-{
-	if (a != RTLIL::State::S0 && a != RTLIL::State::S1) return RTLIL::State::Sx;
-	if (b != RTLIL::State::S0 && b != RTLIL::State::S1) return RTLIL::State::Sx;
-	return a != b ? RTLIL::State::S1 : RTLIL::State::S0;
-}
-
-static RTLIL::State logic_xnor(RTLIL::State a, RTLIL::State b)
-{
-	if (a != RTLIL::State::S0 && a != RTLIL::State::S1) return RTLIL::State::Sx;
-	if (b != RTLIL::State::S0 && b != RTLIL::State::S1) return RTLIL::State::Sx;
-	return a == b ? RTLIL::State::S1 : RTLIL::State::S0;
-}
-
 RTLIL::Const RTLIL::const_not(const RTLIL::Const &arg1, const RTLIL::Const&, bool signed1, bool, int result_len)
 {
 	if (result_len < 0)
 		result_len = arg1.bits.size();
 
-	RTLIL::Const arg1_ext = arg1;
-	extend_u0(arg1_ext, result_len, signed1);
-
-	RTLIL::Const result(RTLIL::State::Sx, result_len);
-	for (size_t i = 0; i < size_t(result_len); i++) {
-		if (i >= arg1_ext.bits.size())
-			result.bits[i] = RTLIL::State::S0;
-		else if (arg1_ext.bits[i] == RTLIL::State::S0)
-			result.bits[i] = RTLIL::State::S1;
-		else if (arg1_ext.bits[i] == RTLIL::State::S1)
-			result.bits[i] = RTLIL::State::S0;
-	}
+	PackedConst a(arg1, result_len, signed1);
+	for (int i = 0; i < a.words(); i++)
+		a.val[i] = ~a.val[i] & a.def[i];
 
-	return result;
+	return a.as_const();
 }
 
-static RTLIL::Const logic_wrapper(RTLIL::State(*logic_func)(RTLIL::State, RTLIL::State),
-		RTLIL::Const arg1, RTLIL::Const arg2, bool signed1, bool signed2, int result_len = -1)
+enum LogicOp { LOGIC_AND, LOGIC_OR, LOGIC_XOR, LOGIC_XNOR };
+
+static RTLIL::Const logic_wrapper(LogicOp op, const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len = -1)
 {
 	if (result_len < 0)
 		result_len = max(arg1.bits.size(), arg2.bits.size());
 
-	extend_u0(arg1, result_len, signed1);
-	extend_u0(arg2, result_len, signed2);
+	PackedConst a(arg1, result_len, signed1);
+	PackedConst b(arg2, result_len, signed2);
+	PackedConst y(result_len);
 
-	RTLIL::Const result(RTLIL::State::Sx, result_len);
-	for (size_t i = 0; i < size_t(result_len); i++) {
-		RTLIL::State a = i < arg1.bits.size() ? arg1.bits[i] : RTLIL::State::S0;
-		RTLIL::State b = i < arg2.bits.size() ? arg2.bits[i] : RTLIL::State::S0;
-		result.bits[i] = logic_func(a, b);
+	for (int i = 0; i < y.words(); i++)
+	{
+		uint64_t av = a.val[i], ad = a.def[i];
+		uint64_t bv = b.val[i], bd = b.def[i];
+
+		switch (op)
+		{
+		case LOGIC_AND:
+			// a 0 on either side dominates undefined bits
+			y.def[i] = (ad & bd) | (ad & ~av) | (bd & ~bv);
+			y.val[i] = av & bv;
+			break;
+		case LOGIC_OR:
+			// a 1 on either side dominates undefined bits
+			y.def[i] = (ad & bd) | av | bv;
+			y.val[i] = av | bv;
+			break;
+		case LOGIC_XOR:
+			y.def[i] = ad & bd;
+			y.val[i] = (av ^ bv) & y.def[i];
+			break;
+		case LOGIC_XNOR:
+			y.def[i] = ad & bd;
+			y.val[i] = ~(av ^ bv) & y.def[i];
+			break;
+		}
 	}
 
-	return result;
+	return y.as_const();
 }
 
 RTLIL::Const RTLIL::const_and(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_and, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper(LOGIC_AND, arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_or(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_or, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper(LOGIC_OR, arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_xor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_xor, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper(LOGIC_XOR, arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_xnor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_xnor, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper(LOGIC_XNOR, arg1, arg2, signed1, signed2, result_len);
 }
 
-static RTLIL::Const logic_reduce_wrapper(RTLIL::State initial, RTLIL::State(*logic_func)(RTLIL::State, RTLIL::State), const RTLIL::Const &arg1, int result_len)
+// The reduce operators look at the bits directly (without packing them), so
+// that reduce_and and reduce_or can stop at the first S0 or S1 bit.
+static RTLIL::Const logic_reduce_wrapper(LogicOp op, const RTLIL::Const &arg1, int result_len)
 {
-	RTLIL::State temp = initial;
+	RTLIL::State temp = RTLIL::State::S0;
 
-	for (size_t i = 0; i < arg1.bits.size(); i++)
-		temp = logic_func(temp, arg1.bits[i]);
+	switch (op)
+	{
+	case LOGIC_AND:
+		temp = RTLIL::State::S1;
+		for (auto bit : arg1.bits)
+			if (bit == RTLIL::State::S0) {
+				temp = RTLIL::State::S0;
+				break;
+			} else if (bit != RTLIL::State::S1)
+				temp = RTLIL::State::Sx;
+		break;
+	case LOGIC_OR:
+		temp = const2bool(arg1);
+		break;
+	case LOGIC_XOR:
+	case LOGIC_XNOR:
+		{
+			bool parity = op == LOGIC_XNOR;
+			temp = RTLIL::State::S0;
+			for (auto bit : arg1.bits)
+				if (bit == RTLIL::State::S1)
+					parity = !parity;
+				else if (bit != RTLIL::State::S0) {
+					temp = RTLIL::State::Sx;
+					break;
+				}
+			if (temp != RTLIL::State::Sx)
+				temp = parity ? RTLIL::State::S1 : RTLIL::State::S0;
+		}
+		break;
+	}
 
 	RTLIL::Const result(temp);
 	while (int(result.bits.size()) < result_len)
@@ -204,71 +366,51 @@ static RTLIL::Const logic_reduce_wrapper(RTLIL::State initial, RTLIL::State(*log
 
 RTLIL::Const RTLIL::const_reduce_and(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int result_len)
 {
-	return logic_reduce_wrapper(RTLIL::State::S1, logic_and, arg1, result_len);
+	return logic_reduce_wrapper(LOGIC_AND, arg1, result_len);
 }
 
 RTLIL::Const RTLIL::const_reduce_or(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int result_len)
 {
-	return logic_reduce_wrapper(RTLIL::State::S0, logic_or, arg1, result_len);
+	return logic_reduce_wrapper(LOGIC_OR, arg1, result_len);
 }
 
 RTLIL::Const RTLIL::const_reduce_xor(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int result_len)
 {
-	return logic_reduce_wrapper(RTLIL::State::S0, logic_xor, arg1, result_len);
+	return logic_reduce_wrapper(LOGIC_XOR, arg1, result_len);
 }
 
 RTLIL::Const RTLIL::const_reduce_xnor(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int result_len)
 {
-	RTLIL::Const buffer = logic_reduce_wrapper(RTLIL::State::S0, logic_xor, arg1, result_len);
-	if (!buffer.bits.empty()) {
-		if (buffer.bits.front() == RTLIL::State::S0)
-			buffer.bits.front() = RTLIL::State::S1;
-		else if (buffer.bits.front() == RTLIL::State::S1)
-			buffer.bits.front() = RTLIL::State::S0;
-	}
-	return buffer;
+	return logic_reduce_wrapper(LOGIC_XNOR, arg1, result_len);
 }
 
 RTLIL::Const RTLIL::const_reduce_bool(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int result_len)
 {
-	return logic_reduce_wrapper(RTLIL::State::S0, logic_or, arg1, result_len);
+	return logic_reduce_wrapper(LOGIC_OR, arg1, result_len);
 }
 
-RTLIL::Const RTLIL::const_logic_not(const RTLIL::Const &arg1, const RTLIL::Const&, bool signed1, bool, int result_len)
+RTLIL::Const RTLIL::const_logic_not(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int result_len)
 {
-	int undef_bit_pos_a = -1;
-	BigInteger a = const2big(arg1, signed1, undef_bit_pos_a);
-	RTLIL::Const result(a.isZero() ? undef_bit_pos_a >= 0 ? RTLIL::State::Sx : RTLIL::State::S1 : RTLIL::State::S0);
+	RTLIL::State bit_a = const2bool(arg1);
+	RTLIL::Const result(bit_a == RTLIL::State::S0 ? RTLIL::State::S1 : bit_a == RTLIL::State::S1 ? RTLIL::State::S0 : RTLIL::State::Sx);
 
 	while (int(result.bits.size()) < result_len)
 		result.bits.push_back(RTLIL::State::S0);
 	return result;
 }
 
-RTLIL::Const RTLIL::const_logic_and(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
+RTLIL::Const RTLIL::const_logic_and(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool, bool, int result_len)
 {
-	int undef_bit_pos_a = -1, undef_bit_pos_b = -1;
-	BigInteger a = const2big(arg1, signed1, undef_bit_pos_a);
-	BigInteger b = const2big(arg2, signed2, undef_bit_pos_b);
-
-	RTLIL::State bit_a = a.isZero() ? undef_bit_pos_a >= 0 ? RTLIL::State::Sx : RTLIL::State::S0 : RTLIL::State::S1;
-	RTLIL::State bit_b = b.isZero() ? undef_bit_pos_b >= 0 ? RTLIL::State::Sx : RTLIL::State::S0 : RTLIL::State::S1;
-	RTLIL::Const result(logic_and(bit_a, bit_b));
+	RTLIL::Const result(logic_and(const2bool(arg1), const2bool(arg2)));
 
 	while (int(result.bits.size()) < result_len)
 		result.bits.push_back(RTLIL::State::S0);
 	return result;
 }
 
-RTLIL::Const RTLIL::const_logic_or(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
+RTLIL::Const RTLIL::const_logic_or(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool, bool, int result_len)
 {
-	int undef_bit_pos_a = -1, undef_bit_pos_b = -1;
-	BigInteger a = const2big(arg1, signed1, undef_bit_pos_a);
-	BigInteger b = const2big(arg2, signed2, undef_bit_pos_b);
-
-	RTLIL::State bit_a = a.isZero() ? undef_bit_pos_a >= 0 ? RTLIL::State::Sx : RTLIL::State::S0 : RTLIL::State::S1;
-	RTLIL::State bit_b = b.isZero() ? undef_bit_pos_b >= 0 ? RTLIL::State::Sx : RTLIL::State::S0 : RTLIL::State::S1;
-	RTLIL::Const result(logic_or(bit_a, bit_b));
+	RTLIL::Const result(logic_or(const2bool(arg1), const2bool(arg2)));
 
 	while (int(result.bits.size()) < result_len)
 		result.bits.push_back(RTLIL::State::S0);
@@ -278,11 +420,35 @@ RTLIL::Const RTLIL::const_logic_or(const RTLIL::Const &arg1, const RTLIL::Const
 static RTLIL::Const const_shift_worker(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool sign_ext, int direction, int result_len)
 {
 	int undef_bit_pos = -1;
-	BigInteger offset = const2big(arg2, false, undef_bit_pos) * direction;
+	int64_t int_offset;
 
 	if (result_len < 0)
 		result_len = arg1.bits.size();
 
+	if (const2int(arg2, false, int_offset, undef_bit_pos))
+	{
+		RTLIL::Const result(RTLIL::State::Sx, result_len);
+		if (undef_bit_pos >= 0)
+			return result;
+
+		// larger offsets shift out all bits anyway
+		int_offset = min(int_offset, int64_t(1) << 40) * direction;
+
+		for (int i = 0; i < result_len; i++) {
+			int64_t pos = i + int_offset;
+			if (pos < 0)
+				result.bits[i] = RTLIL::State::S0;
+			else if (pos >= GetSize(arg1.bits))
+				result.bits[i] = sign_ext ? arg1.bits.back() : RTLIL::State::S0;
+			else
+				result.bits[i] = arg1.bits[pos];
+		}
+
+		return result;
+	}
+
+	BigInteger offset = const2big(arg2, false, undef_bit_pos) * direction;
+
 	RTLIL::Const result(RTLIL::State::Sx, result_len);
 	if (undef_bit_pos >= 0)
 		return result;
@@ -331,11 +497,33 @@ RTLIL::Const RTLIL::const_sshr(const RTLIL::Const &arg1, const RTLIL::Const &arg
 static RTLIL::Const const_shift_shiftx(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool, bool signed2, int result_len, RTLIL::State other_bits)
 {
 	int undef_bit_pos = -1;
-	BigInteger offset = const2big(arg2, signed2, undef_bit_pos);
+	int64_t int_offset;
 
 	if (result_len < 0)
 		result_len = arg1.bits.size();
 
+	if (const2int(arg2, signed2, int_offset, undef_bit_pos))
+	{
+		RTLIL::Const result(RTLIL::State::Sx, result_len);
+		if (undef_bit_pos >= 0)
+			return result;
+
+		// larger offsets shift out all bits anyway
+		int_offset = max(min(int_offset, int64_t(1) << 40), -(int64_t(1) << 40));
+
+		for (int i = 0; i < result_len; i++) {
+			int64_t pos = i + int_offset;
+			if (pos < 0 || pos >= GetSize(arg1.bits))
+				result.bits[i] = other_bits;
+			else
+				result.bits[i] = arg1.bits[pos];
+		}
+
+		return result;
+	}
+
+	BigInteger offset = const2big(arg2, signed2, undef_bit_pos);
+
 	RTLIL::Const result(RTLIL::State::Sx, result_len);
 	if (undef_bit_pos >= 0)
 		return result;
@@ -364,7 +552,13 @@ RTLIL::Const RTLIL::const_shiftx(const RTLIL::Const &arg1, const RTLIL::Const &a
 RTLIL::Const RTLIL::const_lt(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
 	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) < const2big(arg2, signed2, undef_bit_pos);
+	int64_t a, b;
+	bool y;
+
+	if (const2int(arg1, signed1, a, undef_bit_pos) && const2int(arg2, signed2, b, undef_bit_pos))
+		y = a < b;
+	else
+		y = const2big(arg1, signed1, undef_bit_pos) < const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
 
 	while (int(result.bits.size()) < result_len)
@@ -375,7 +569,13 @@ RTLIL::Const RTLIL::const_lt(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 RTLIL::Const RTLIL::const_le(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
 	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) <= const2big(arg2, signed2, undef_bit_pos);
+	int64_t a, b;
+	bool y;
+
+	if (const2int(arg1, signed1, a, undef_bit_pos) && const2int(arg2, signed2, b, undef_bit_pos))
+		y = a <= b;
+	else
+		y = const2big(arg1, signed1, undef_bit_pos) <= const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
 
 	while (int(result.bits.size()) < result_len)
@@ -385,22 +585,22 @@ RTLIL::Const RTLIL::const_le(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 
 RTLIL::Const RTLIL::const_eq(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	RTLIL::Const arg1_ext = arg1;
-	RTLIL::Const arg2_ext = arg2;
 	RTLIL::Const result(RTLIL::State::S0, result_len);
 
-	int width = max(arg1_ext.bits.size(), arg2_ext.bits.size());
-	extend_u0(arg1_ext, width, signed1 && signed2);
-	extend_u0(arg2_ext, width, signed1 && signed2);
+	// compare bit by bit, so that the first defined mismatch ends the loop
+	int width1 = GetSize(arg1.bits), width2 = GetSize(arg2.bits);
+	int width = max(width1, width2);
+	RTLIL::State padding1 = width1 > 0 && signed1 && signed2 ? arg1.bits.back() : RTLIL::State::S0;
+	RTLIL::State padding2 = width2 > 0 && signed1 && signed2 ? arg2.bits.back() : RTLIL::State::S0;
 
 	RTLIL::State matched_status = RTLIL::State::S1;
-	for (size_t i = 0; i < arg1_ext.bits.size(); i++) {
-		if (arg1_ext.bits.at(i) == RTLIL::State::S0 && arg2_ext.bits.at(i) == RTLIL::State::S1)
-			return result;
-		if (arg1_ext.bits.at(i) == RTLIL::State::S1 && arg2_ext.bits.at(i) == RTLIL::State::S0)
-			return result;
-		if (arg1_ext.bits.at(i) > RTLIL::State::S1 || arg2_ext.bits.at(i) > RTLIL::State::S1)
+	for (int i = 0; i < width; i++) {
+		RTLIL::State bit1 = i < width1 ? arg1.bits[i] : padding1;
+		RTLIL::State bit2 = i < width2 ? arg2.bits[i] : padding2;
+		if (bit1 > RTLIL::State::S1 || bit2 > RTLIL::State::S1)
 			matched_status = RTLIL::State::Sx;
+		else if (bit1 != bit2)
+			return result;
 	}
 
 	result.bits.front() = matched_status;
@@ -449,7 +649,13 @@ RTLIL::Const RTLIL::const_nex(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 RTLIL::Const RTLIL::const_ge(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
 	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) >= const2big(arg2, signed2, undef_bit_pos);
+	int64_t a, b;
+	bool y;
+
+	if (const2int(arg1, signed1, a, undef_bit_pos) && const2int(arg2, signed2, b, undef_bit_pos))
+		y = a >= b;
+	else
+		y = const2big(arg1, signed1, undef_bit_pos) >= const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
 
 	while (int(result.bits.size()) < result_len)
@@ -460,7 +666,13 @@ RTLIL::Const RTLIL::const_ge(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 RTLIL::Const RTLIL::const_gt(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
 	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) > const2big(arg2, signed2, undef_bit_pos);
+	int64_t a, b;
+	bool y;
+
+	if (const2int(arg1, signed1, a, undef_bit_pos) && const2int(arg2, signed2, b, undef_bit_pos))
+		y = a > b;
+	else
+		y = const2big(arg1, signed1, undef_bit_pos) > const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
 
 	while (int(result.bits.size()) < result_len)
@@ -471,6 +683,11 @@ RTLIL::Const RTLIL::const_gt(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 RTLIL::Const RTLIL::const_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
 	int undef_bit_pos = -1;
+	int64_t a, b;
+
+	if (use_int_path(arg1, arg2, signed1, signed2, result_len, a, b, undef_bit_pos))
+		return int2const(uint64_t(a) + uint64_t(b), result_len, undef_bit_pos);
+
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) + const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : max(arg1.bits.size(), arg2.bits.size()), undef_bit_pos);
 }
@@ -478,6 +695,11 @@ RTLIL::Const RTLIL::const_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 RTLIL::Const RTLIL::const_sub(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
 	int undef_bit_pos = -1;
+	int64_t a, b;
+
+	if (use_int_path(arg1, arg2, signed1, signed2, result_len, a, b, undef_bit_pos))
+		return int2const(uint64_t(a) - uint64_t(b), result_len, undef_bit_pos);
+
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) - const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : max(arg1.bits.size(), arg2.bits.size()), undef_bit_pos);
 }
@@ -485,6 +707,11 @@ RTLIL::Const RTLIL::const_sub(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 RTLIL::Const RTLIL::const_mul(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
 	int undef_bit_pos = -1;
+	int64_t a, b;
+
+	if (use_int_path(arg1, arg2, signed1, signed2, result_len, a, b, undef_bit_pos))
+		return int2const(uint64_t(a) * uint64_t(b), result_len, min(undef_bit_pos, 0));
+
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) * const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : max(arg1.bits.size(), arg2.bits.size()), min(undef_bit_pos, 0));
 }
@@ -492,6 +719,20 @@ RTLIL::Const RTLIL::const_mul(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 RTLIL::Const RTLIL::const_div(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
 	int undef_bit_pos = -1;
+	int int_result_len = result_len;
+	int64_t int_a, int_b;
+
+	if (use_int_path(arg1, arg2, signed1, signed2, int_result_len, int_a, int_b, undef_bit_pos)) {
+		if (int_b == 0)
+			return RTLIL::Const(RTLIL::State::Sx, result_len);
+		bool result_neg = (int_a < 0) != (int_b < 0);
+		uint64_t mag_a = int_a < 0 ? -uint64_t(int_a) : int_a;
+		uint64_t mag_b = int_b < 0 ? -uint64_t(int_b) : int_b;
+		uint64_t y = mag_a / mag_b;
+		return int2const(result_neg ? -y : y, int_result_len, min(undef_bit_pos, 0));
+	}
+
+	undef_bit_pos = -1;
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
 	BigInteger b = const2big(arg2, signed2, undef_bit_pos);
 	if (b.isZero())
@@ -505,6 +746,20 @@ RTLIL::Const RTLIL::const_div(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 RTLIL::Const RTLIL::const_mod(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
 	int undef_bit_pos = -1;
+	int int_result_len = result_len;
+	int64_t int_a, int_b;
+
+	if (use_int_path(arg1, arg2, signed1, signed2, int_result_len, int_a, int_b, undef_bit_pos)) {
+		if (int_b == 0)
+			return RTLIL::Const(RTLIL::State::Sx, result_len);
+		bool result_neg = int_a < 0;
+		uint64_t mag_a = int_a < 0 ? -uint64_t(int_a) : int_a;
+		uint64_t mag_b = int_b < 0 ? -uint64_t(int_b) : int_b;
+		uint64_t y = mag_a % mag_b;
+		return int2const(result_neg ? -y : y, int_result_len, min(undef_bit_pos, 0));
+	}
+
+	undef_bit_pos = -1;
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
 	BigInteger b = const2big(arg2, signed2, undef_bit_pos);
 	if (b.isZero())
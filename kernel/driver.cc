@@ -161,6 +161,7 @@ int main(int argc, char **argv)
 	std::string output_filename = "";
 	std::string scriptfile = "";
 	std::string depsfile = "";
+	std::string profilefile = "";
 	bool scriptfile_tcl = false;
 	bool got_output_filename = false;
 	bool print_banner = true;
@@ -203,6 +204,16 @@ int main(int argc, char **argv)
 		printf("    -d\n");
 		printf("        print more detailed timing stats at exit\n");
 		printf("\n");
+		printf("    -j <threads>\n");
+		printf("        default number of threads for commands that support parallel\n");
+		printf("        execution (e.g. opt_expr, opt_merge, opt_clean). the result of\n");
+		printf("        these commands does not depend on the number of threads.\n");
+		printf("\n");
+		printf("    -I\n");
+		printf("        never free the names created by frontends. this makes copying\n");
+		printf("        them cheaper, at the cost of not reclaiming names that are no\n");
+		printf("        longer used\n");
+		printf("\n");
 		printf("    -l logfile\n");
 		printf("        write log messages to the specified file\n");
 		printf("\n");
@@ -260,6 +271,10 @@ int main(int argc, char **argv)
 		printf("    -E <depsfile>\n");
 		printf("        write a Makefile dependencies file with in- and output file names\n");
 		printf("\n");
+		printf("    -P <profile.json>\n");
+		printf("        write a hierarchical profile of all executed commands (wall and CPU\n");
+		printf("        time, peak memory, number of cells and wires) in JSON format\n");
+		printf("\n");
 		printf("    -V\n");
 		printf("        print version information and exit\n");
 		printf("\n");
@@ -280,7 +295,7 @@ int main(int argc, char **argv)
 	}
 
 	int opt;
-	while ((opt = getopt(argc, argv, "MXAQTVSm:f:Hh:b:o:p:l:L:qv:tds:c:W:w:D:E:")) != -1)
+	while ((opt = getopt(argc, argv, "MXAQTVSIm:f:Hh:b:o:p:l:L:qv:tdj:s:c:W:w:D:E:P:")) != -1)
 	{
 		switch (opt)
 		{
@@ -354,6 +369,16 @@ int main(int argc, char **argv)
 		case 'd':
 			timing_details = true;
 			break;
+		case 'j':
+			yosys_threads = atoi(optarg);
+			if (yosys_threads < 1) {
+				fprintf(stderr, "Invalid number of threads for -j: %s\n", optarg);
+				exit(1);
+			}
+			break;
+		case 'I':
+			Frontend::immortal_ids = true;
+			break;
 		case 's':
 			scriptfile = optarg;
 			scriptfile_tcl = false;
@@ -399,6 +424,9 @@ int main(int argc, char **argv)
 		case 'E':
 			depsfile = optarg;
 			break;
+		case 'P':
+			profilefile = optarg;
+			break;
 		default:
 			fprintf(stderr, "Run '%s -h' for help.\n", argv[0]);
 			exit(1);
@@ -419,6 +447,9 @@ int main(int argc, char **argv)
 	yosys_setup();
 	log_error_atexit = yosys_atexit;
 
+	if (!profilefile.empty())
+		pass_profile = new PassProfile;
+
 	for (auto &fn : plugin_filenames)
 		load_plugin(fn, {});
 
@@ -467,6 +498,17 @@ int main(int argc, char **argv)
 		fprintf(f, "\n");
 	}
 
+	if (!profilefile.empty())
+	{
+		FILE *f = fopen(profilefile.c_str(), "wt");
+		if (f == nullptr)
+			log_error("Can't open profile file for writing: %s\n", strerror(errno));
+		pass_profile->write_json(f);
+		fclose(f);
+		delete pass_profile;
+		pass_profile = nullptr;
+	}
+
 	if (print_stats)
 	{
 		std::string hash = log_hasher->final().substr(0, 10);
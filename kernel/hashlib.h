@@ -78,6 +78,12 @@ template<> struct hash_ops<int64_t> : hash_int_ops
 		return mkhash((unsigned int)(a), (unsigned int)(a >> 32));
 	}
 };
+template<> struct hash_ops<uint64_t> : hash_int_ops
+{
+	static inline unsigned int hash(uint64_t a) {
+		return mkhash((unsigned int)(a), (unsigned int)(a >> 32));
+	}
+};
 
 template<> struct hash_ops<std::string> {
 	static inline bool cmp(const std::string &a, const std::string &b) {
@@ -242,6 +248,17 @@ class dict
 		}
 	}
 
+	// the hashtable is grown on insert (and not lazily on lookup) so that
+	// const lookups never modify the container. this makes it safe to read
+	// from the same dict/pool in several threads.
+	void do_grow(int &hash, const K &key)
+	{
+		if (entries.size() * hashtable_size_trigger > hashtable.size()) {
+			do_rehash();
+			hash = do_hash(key);
+		}
+	}
+
 	int do_erase(int index, int hash)
 	{
 		do_assert(index < int(entries.size()));
@@ -296,11 +313,6 @@ class dict
 		if (hashtable.empty())
 			return -1;
 
-		if (entries.size() * hashtable_size_trigger > hashtable.size()) {
-			((dict*)this)->do_rehash();
-			hash = do_hash(key);
-		}
-
 		int index = hashtable[hash];
 
 		while (index >= 0 && !ops.cmp(entries[index].udata.first, key)) {
@@ -320,6 +332,7 @@ class dict
 		} else {
 			entries.push_back(entry_t(std::pair<K, T>(key, T()), hashtable[hash]));
 			hashtable[hash] = entries.size() - 1;
+			do_grow(hash, key);
 		}
 		return entries.size() - 1;
 	}
@@ -333,6 +346,7 @@ class dict
 		} else {
 			entries.push_back(entry_t(value, hashtable[hash]));
 			hashtable[hash] = entries.size() - 1;
+			do_grow(hash, value.first);
 		}
 		return entries.size() - 1;
 	}
@@ -530,6 +544,18 @@ public:
 		do_rehash();
 	}
 
+	void reverse()
+	{
+		std::reverse(entries.begin(), entries.end());
+		do_rehash();
+	}
+
+	// rebuild the hashtable, e.g. after the hash values of the keys have changed
+	void rehash()
+	{
+		do_rehash();
+	}
+
 	void swap(dict &other)
 	{
 		hashtable.swap(other.hashtable);
@@ -611,6 +637,14 @@ protected:
 		}
 	}
 
+	void do_grow(int &hash, const K &key)
+	{
+		if (entries.size() * hashtable_size_trigger > hashtable.size()) {
+			do_rehash();
+			hash = do_hash(key);
+		}
+	}
+
 	int do_erase(int index, int hash)
 	{
 		do_assert(index < int(entries.size()));
@@ -661,11 +695,6 @@ protected:
 		if (hashtable.empty())
 			return -1;
 
-		if (entries.size() * hashtable_size_trigger > hashtable.size()) {
-			((pool*)this)->do_rehash();
-			hash = do_hash(key);
-		}
-
 		int index = hashtable[hash];
 
 		while (index >= 0 && !ops.cmp(entries[index].udata, key)) {
@@ -685,6 +714,7 @@ protected:
 		} else {
 			entries.push_back(entry_t(value, hashtable[hash]));
 			hashtable[hash] = entries.size() - 1;
+			do_grow(hash, value);
 		}
 		return entries.size() - 1;
 	}
@@ -849,6 +879,12 @@ public:
 		return ret;
 	}
 
+	// rebuild the hashtable, e.g. after the hash values of the keys have changed
+	void rehash()
+	{
+		do_rehash();
+	}
+
 	void swap(pool &other)
 	{
 		hashtable.swap(other.hashtable);
@@ -941,6 +977,11 @@ public:
 		return database.entries.at(index - offset).udata;
 	}
 
+	void rehash()
+	{
+		database.rehash();
+	}
+
 	void swap(idict &other)
 	{
 		database.swap(other.database);
@@ -1039,6 +1080,11 @@ public:
 			ipromote(i);
 	}
 
+	void rehash()
+	{
+		database.rehash();
+	}
+
 	void swap(mfp &other)
 	{
 		database.swap(other.database);
@@ -36,6 +36,10 @@
 #include <vector>
 #include <list>
 
+#ifdef YOSYS_ENABLE_THREADS
+#  include <mutex>
+#endif
+
 YOSYS_NAMESPACE_BEGIN
 
 std::vector<FILE*> log_files;
@@ -55,9 +59,14 @@ string log_last_error;
 void (*log_error_atexit)() = NULL;
 
 vector<int> header_count;
-pool<RTLIL::IdString> log_id_cache;
-vector<shared_str> string_buf;
-int string_buf_index = -1;
+thread_local pool<RTLIL::IdString> log_id_cache;
+thread_local vector<shared_str> string_buf;
+thread_local int string_buf_index = -1;
+thread_local LogCapture *log_capture = nullptr;
+
+#ifdef YOSYS_ENABLE_THREADS
+static std::mutex log_capture_mutex;
+#endif
 
 static struct timeval initial_tv = { 0, 0 };
 static bool next_print_log = false;
@@ -83,18 +92,8 @@ int gettimeofday(struct timeval *tv, struct timezone *tz)
 }
 #endif
 
-void logv(const char *format, va_list ap)
+static void log_write(const std::string &str, bool eol)
 {
-	while (format[0] == '\n' && format[1] != 0) {
-		log("\n");
-		format++;
-	}
-
-	std::string str = vstringf(format, ap);
-
-	if (str.empty())
-		return;
-
 	size_t nnl_pos = str.find_last_not_of('\n');
 	if (nnl_pos == std::string::npos)
 		log_newline_count += GetSize(str);
@@ -123,7 +122,7 @@ void logv(const char *format, va_list ap)
 			time_str += stringf("[%05d.%06d] ", int(tv.tv_sec), int(tv.tv_usec));
 		}
 
-		if (format[0] && format[strlen(format)-1] == '\n')
+		if (eol)
 			next_print_log = true;
 
 		for (auto f : log_files)
@@ -166,6 +165,28 @@ void logv(const char *format, va_list ap)
 	}
 }
 
+void logv(const char *format, va_list ap)
+{
+	while (format[0] == '\n' && format[1] != 0) {
+		log("\n");
+		format++;
+	}
+
+	std::string str = vstringf(format, ap);
+
+	if (str.empty())
+		return;
+
+	bool eol = format[0] && format[strlen(format)-1] == '\n';
+
+	if (log_capture != nullptr) {
+		log_capture->messages.push_back(std::make_pair(eol ? LogCapture::LOG_EOL : LogCapture::LOG, str));
+		return;
+	}
+
+	log_write(str, eol);
+}
+
 void logv_header(RTLIL::Design *design, const char *format, va_list ap)
 {
 	bool pop_errfile = false;
@@ -206,6 +227,11 @@ void logv_warning(const char *format, va_list ap)
 	std::string message = vstringf(format, ap);
 	bool suppressed = false;
 
+	if (log_capture != nullptr) {
+		log_capture->messages.push_back(std::make_pair(LogCapture::WARNING, message));
+		return;
+	}
+
 	for (auto &re : log_nowarn_regexes)
 		if (std::regex_search(message, re))
 			suppressed = true;
@@ -232,6 +258,11 @@ void logv_warning_noprefix(const char *format, va_list ap)
 	std::string message = vstringf(format, ap);
 	bool suppressed = false;
 
+	if (log_capture != nullptr) {
+		log_capture->messages.push_back(std::make_pair(LogCapture::WARNING_NOPREFIX, message));
+		return;
+	}
+
 	for (auto &re : log_nowarn_regexes)
 		if (std::regex_search(message, re))
 			suppressed = true;
@@ -255,6 +286,17 @@ void logv_warning_noprefix(const char *format, va_list ap)
 
 void logv_error(const char *format, va_list ap)
 {
+	// errors in a parallel_for() job are reported by the main thread, after
+	// the log output of all jobs before this one
+	if (log_capture != nullptr) {
+		log_capture->error = vstringf(format, ap);
+		throw log_job_error_exception();
+	}
+
+	// make sure buffered messages written to stdout are not lost when
+	// stdout is replaced by stderr below
+	log_flush();
+
 #ifdef EMSCRIPTEN
 	auto backup_log_files = log_files;
 #endif
@@ -338,6 +380,28 @@ void log_cmd_error(const char *format, ...)
 	logv_error(format, ap);
 }
 
+void LogCapture::replay()
+{
+#ifdef YOSYS_ENABLE_THREADS
+	std::lock_guard<std::mutex> lock(log_capture_mutex);
+#endif
+	for (auto &msg : messages)
+		switch (msg.first)
+		{
+		case LOG:
+		case LOG_EOL:
+			log_write(msg.second, msg.first == LOG_EOL);
+			break;
+		case WARNING:
+			log_warning("%s", msg.second.c_str());
+			break;
+		case WARNING_NOPREFIX:
+			log_warning_noprefix("%s", msg.second.c_str());
+			break;
+		}
+	messages.clear();
+}
+
 void log_spacer()
 {
 	if (log_newline_count < 2) log("\n");
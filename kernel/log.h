@@ -91,6 +91,22 @@ template<typename T> static inline const char *log_id(T *obj) {
 	return log_id(obj->name);
 }
 
+// buffered log output of a parallel_for() job, see kernel/yosys.cc
+
+struct LogCapture
+{
+	enum kind_t { LOG, LOG_EOL, WARNING, WARNING_NOPREFIX };
+	std::vector<std::pair<kind_t, std::string>> messages;
+	std::string error;
+	void replay();
+};
+
+// thrown by log_error() in a parallel_for() job, the error is then
+// reported by the main thread (see LogCapture::error)
+struct log_job_error_exception { };
+
+extern thread_local LogCapture *log_capture;
+
 void log_module(RTLIL::Module *module, std::string indent = "");
 void log_cell(RTLIL::Cell *cell, std::string indent = "");
 void log_wire(RTLIL::Wire *wire, std::string indent = "");
@@ -49,7 +49,7 @@ struct ModIndex : public RTLIL::Monitor
 		}
 
 		unsigned int hash() const {
-			return mkhash_add(mkhash(cell->name.hash(), port.hash()), offset);
+			return mkhash_add(mkhash(cell->hash(), port.hash()), offset);
 		}
 	};
 
@@ -72,11 +72,19 @@ struct ModIndex : public RTLIL::Monitor
 		}
 	};
 
+	// the database is only built from scratch when it is first queried. all
+	// changes to the module are applied incrementally. notify_blackout() is
+	// sent when wires are renamed, which changes the hash values of their bits,
+	// so the hashtables are rebuilt from the existing entries before the next
+	// access. note that changes to the module may invalidate pointers and
+	// references returned by query() and query_ports().
+
 	SigMap sigmap;
 	RTLIL::Module *module;
-	std::map<RTLIL::SigBit, SigBitInfo> database;
+	dict<RTLIL::SigBit, SigBitInfo> database;
 	int auto_reload_counter;
 	bool auto_reload_module;
+	bool rehash_pending;
 
 	void port_add(RTLIL::Cell *cell, RTLIL::IdString port, const RTLIL::SigSpec &sig)
 	{
@@ -91,13 +99,111 @@ struct ModIndex : public RTLIL::Monitor
 	{
 		for (int i = 0; i < GetSize(sig); i++) {
 			RTLIL::SigBit bit = sigmap(sig[i]);
-			if (bit.wire)
-				database[bit].ports.erase(PortInfo(cell, port, i));
+			auto it = database.find(bit);
+			if (it == database.end())
+				continue;
+			it->second.ports.erase(PortInfo(cell, port, i));
+			if (it->second.ports.empty() && !it->second.is_input && !it->second.is_output)
+				database.erase(it);
+		}
+	}
+
+	void remove_connections(const std::vector<RTLIL::SigSig> &kept_conns, const std::vector<RTLIL::SigSig> &removed_conns)
+	{
+		// the old representatives of the groups of connected bits that might
+		// be split by removing the connections
+		pool<RTLIL::SigBit> split_bits;
+		for (auto &conn : removed_conns) {
+			for (auto bit : sigmap(conn.first))
+				split_bits.insert(bit);
+			for (auto bit : sigmap(conn.second))
+				split_bits.insert(bit);
+		}
+
+		// a union-find structure can not be split, so the SigMap is rebuilt
+		// from the remaining connections. the old representatives are kept for
+		// all groups that have not been split, so that their entries in the
+		// database can stay where they are.
+		pool<RTLIL::SigBit> split_members, keep_bits;
+		int bitcount = 0;
+
+		for (auto &conn : kept_conns) {
+			for (int i = 0; i < GetSize(conn.first); i++) {
+				RTLIL::SigBit mapped_bit = sigmap(conn.first[i]);
+				if (split_bits.count(mapped_bit)) {
+					split_members.insert(conn.first[i]);
+					split_members.insert(conn.second[i]);
+				} else
+					keep_bits.insert(mapped_bit);
+			}
+			bitcount += GetSize(conn.first);
+		}
+
+		for (auto &conn : removed_conns) {
+			for (auto bit : conn.first)
+				split_members.insert(bit);
+			for (auto bit : conn.second)
+				split_members.insert(bit);
+		}
+
+		SigMap new_sigmap;
+		new_sigmap.database.reserve(bitcount);
+		for (auto &conn : kept_conns)
+			new_sigmap.add(conn.first, conn.second);
+		for (auto &bit : keep_bits)
+			new_sigmap.database.promote(bit);
+		sigmap.swap(new_sigmap);
+
+		for (auto &bit : split_bits)
+			if (bit.wire == nullptr) {
+				// the ports connected to bits that were driven by a constant
+				// are not in the database
+				reload_module(false);
+				return;
+			}
+
+		// only the entries of the split groups need to be moved. the ports
+		// are sorted using the cell ports, the port wires using the members
+		// of the old groups.
+		std::vector<SigBitInfo> moved_entries;
+		for (auto &bit : split_bits) {
+			auto it = database.find(bit);
+			if (it != database.end()) {
+				moved_entries.push_back(std::move(it->second));
+				database.erase(it);
+			}
+		}
+
+		for (auto &entry : moved_entries)
+			for (auto &port : entry.ports) {
+				RTLIL::SigBit bit = sigmap(port.cell->getPort(port.port)[port.offset]);
+				if (bit.wire)
+					database[bit].ports.insert(port);
+			}
+
+		for (auto &bit : split_members) {
+			if (bit.wire == nullptr || !(bit.wire->port_input || bit.wire->port_output))
+				continue;
+			RTLIL::SigBit mapped_bit = sigmap(bit);
+			if (mapped_bit.wire && bit.wire->port_input)
+				database[mapped_bit].is_input = true;
+			if (mapped_bit.wire && bit.wire->port_output)
+				database[mapped_bit].is_output = true;
+		}
+	}
+
+	void apply_rehash()
+	{
+		if (rehash_pending) {
+			database.rehash();
+			sigmap.database.rehash();
+			rehash_pending = false;
 		}
 	}
 
 	const SigBitInfo &info(RTLIL::SigBit bit)
 	{
+		apply_rehash();
 		return database[sigmap(bit)];
 	}
 
@@ -106,9 +212,12 @@ struct ModIndex : public RTLIL::Monitor
 		if (reset_sigmap) {
 			sigmap.clear();
 			sigmap.set(module);
-		}
+		} else if (rehash_pending)
+			sigmap.database.rehash();
 
+		rehash_pending = false;
 		database.clear();
+		database.reserve(GetSize(module->wires_));
 		for (auto wire : module->wires())
 			if (wire->port_input || wire->port_output)
 				for (int i = 0; i < GetSize(wire); i++) {
@@ -135,6 +244,8 @@ struct ModIndex : public RTLIL::Monitor
 		if (auto_reload_module)
 			return;
 
+		apply_rehash();
+
 		for (auto it : database)
 			log_assert(it.first == sigmap(it.first));
 
@@ -165,6 +276,7 @@ struct ModIndex : public RTLIL::Monitor
 		if (auto_reload_module)
 			return;
 
+		apply_rehash();
 		port_del(cell, port, old_sig);
 		port_add(cell, port, sig);
 	}
@@ -176,6 +288,8 @@ struct ModIndex : public RTLIL::Monitor
 		if (auto_reload_module)
 			return;
 
+		apply_rehash();
+
 		for (int i = 0; i < GetSize(sigsig.first); i++)
 		{
 			RTLIL::SigBit lhs = sigmap(sigsig.first[i]);
@@ -214,22 +328,64 @@ struct ModIndex : public RTLIL::Monitor
 		}
 	}
 
-	virtual void notify_connect(RTLIL::Module *mod YS_ATTRIBUTE(unused), const std::vector<RTLIL::SigSig>&) YS_OVERRIDE
+	virtual void notify_connect(RTLIL::Module *mod YS_ATTRIBUTE(unused), const std::vector<RTLIL::SigSig> &new_conns) YS_OVERRIDE
 	{
 		log_assert(module == mod);
-		auto_reload_module = true;
+
+		if (auto_reload_module)
+			return;
+
+		apply_rehash();
+
+		const std::vector<RTLIL::SigSig> &old_conns = module->connections();
+
+		if (GetSize(new_conns) >= GetSize(old_conns) && std::equal(old_conns.begin(), old_conns.end(), new_conns.begin())) {
+			for (int i = GetSize(old_conns); i < GetSize(new_conns); i++)
+				notify_connect(module, new_conns[i]);
+			return;
+		}
+
+		// split the change into removed and added connections
+		dict<RTLIL::SigSig, int> new_count;
+		for (auto &conn : new_conns)
+			new_count[conn]++;
+
+		std::vector<RTLIL::SigSig> kept_conns, removed_conns, added_conns;
+		for (auto &conn : old_conns) {
+			auto it = new_count.find(conn);
+			if (it != new_count.end() && it->second > 0) {
+				it->second--;
+				kept_conns.push_back(conn);
+			} else
+				removed_conns.push_back(conn);
+		}
+
+		for (auto &conn : new_conns) {
+			auto it = new_count.find(conn);
+			if (it->second > 0) {
+				it->second--;
+				added_conns.push_back(conn);
+			}
+		}
+
+		if (!removed_conns.empty())
+			remove_connections(kept_conns, removed_conns);
+
+		for (auto &conn : added_conns)
+			notify_connect(module, conn);
 	}
 
 	virtual void notify_blackout(RTLIL::Module *mod YS_ATTRIBUTE(unused)) YS_OVERRIDE
 	{
 		log_assert(module == mod);
-		auto_reload_module = true;
+		rehash_pending = true;
 	}
 
 	ModIndex(RTLIL::Module *_m) : sigmap(_m), module(_m)
 	{
 		auto_reload_counter = 0;
 		auto_reload_module = true;
+		rehash_pending = false;
 		module->monitors.insert(this);
 	}
 
@@ -243,6 +399,8 @@ struct ModIndex : public RTLIL::Monitor
 		if (auto_reload_module)
 			reload_module();
 
+		apply_rehash();
+
 		auto it = database.find(sigmap(bit));
 		if (it == database.end())
 			return nullptr;
@@ -284,6 +442,8 @@ struct ModIndex : public RTLIL::Monitor
 			reload_module();
 		}
 
+		apply_rehash();
+
 		for (auto &it : database) {
 			log("BIT %s:\n", log_signal(it.first));
 			if (it.second.is_input)
@@ -0,0 +1,704 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef RANDSIM_H
+#define RANDSIM_H
+
+#include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
+#include "kernel/celltypes.h"
+#include "kernel/utils.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Bit-parallel random simulation, used to find counterexamples for candidate
+// equivalences before they are sent to the SAT solver. Like 'sim -compiled',
+// the module is levelized once and lowered to a list of instructions over nets
+// that hold 64 simulation lanes in two bit-planes ('def' is set for lanes with
+// a defined value, 'val' is set for lanes with value 1).
+//
+// A lane is only marked as defined if every SatGen model of the module with
+// the same input values has the same value in it. So the undefined states are
+// handled like in ConstEval (e.g. a mux with an undefined select input is only
+// defined where both data inputs agree) and cells without a lowering drive
+// undefined values. Random values are only assigned to module inputs, undriven
+// nets and the outputs of cells that are unknown to yosys. The $ff, $dff,
+// $_FF_ and $_DFF_[NP]_ cells are unrolled like in SatGen: Their outputs are
+// random in the first time step and follow the D input of the previous time
+// step in all later time steps.
+//
+// SatGen with model_undef set makes all outputs of most cells undefined if any
+// of their inputs is undefined. With strict_undef set, this is done for all
+// simulated cells, so that a lane that is defined in the simulation is also
+// defined in that SAT model.
+//
+// The netlist is read-only after construction. All simulation values are kept
+// in a separate State, so that several threads can simulate at once.
+
+struct RandomSim
+{
+	enum op_t {
+		OP_BUF, OP_NOT, OP_AND, OP_NAND, OP_OR, OP_NOR, OP_XOR, OP_XNOR,
+		OP_ANDNOT, OP_ORNOT, OP_PMUX, OP_GENERIC, OP_DEFAND, OP_DEFMASK
+	};
+
+	// constant nets
+	enum { NET_S0, NET_S1, NET_SX, NET_FIRST };
+
+	// what drives a net
+	enum { SRC_LOGIC, SRC_INPUT, SRC_REG, SRC_UNDEF };
+
+	// OP_PMUX: the (S, B) net pairs are pmux_args[b .. b+2*s-1]
+	// OP_GENERIC: s is the index in generics
+	// OP_DEFAND: the value of Y is the value of A in lanes where B is defined
+	// OP_DEFMASK: Y is made undefined in lanes where the value of A is 0
+	struct insn_t {
+		op_t op;
+		int y, a, b, s;
+	};
+
+	// cells without a lowering are evaluated lane by lane with CellTypes::eval()
+	struct generic_t {
+		RTLIL::Cell *cell;
+		std::vector<int> a, b, y;
+	};
+
+	struct State {
+		std::vector<uint64_t> val, def;
+	};
+
+	RTLIL::Module *module;
+	int num_steps, num_nets;
+	bool strict_undef;
+
+	dict<RTLIL::SigBit, int> net_index;
+	std::vector<int> net_source;
+	std::vector<std::pair<int, int>> registers;
+
+	std::vector<insn_t> insns;
+	std::vector<int> pmux_args;
+	std::vector<generic_t> generics;
+
+	static bool is_register(RTLIL::IdString type)
+	{
+		return type.in("$ff", "$dff", "$_FF_", "$_DFF_N_", "$_DFF_P_");
+	}
+
+	static bool can_lower(RTLIL::IdString type)
+	{
+		return type.in("$_BUF_", "$_NOT_", "$_AND_", "$_NAND_", "$_OR_", "$_NOR_", "$_XOR_", "$_XNOR_",
+				"$_ANDNOT_", "$_ORNOT_", "$_MUX_", "$_AOI3_", "$_OAI3_", "$_AOI4_", "$_OAI4_") ||
+				type.in("$equiv", "$not", "$pos", "$and", "$or", "$xor", "$xnor", "$reduce_and", "$reduce_or",
+				"$reduce_xor", "$reduce_xnor", "$reduce_bool", "$logic_not", "$logic_and", "$logic_or",
+				"$eq", "$ne", "$eqx", "$nex", "$mux", "$pmux", "$add", "$sub", "$alu", "$fa", "$lcu") ||
+				is_generic(type);
+	}
+
+	static bool is_generic(RTLIL::IdString type)
+	{
+		return type.in("$neg", "$shl", "$shr", "$sshl", "$sshr", "$shift", "$shiftx", "$lt", "$le", "$ge", "$gt",
+				"$mul", "$div", "$mod", "$pow", "$slice", "$concat", "$lut", "$sop");
+	}
+
+	RandomSim(RTLIL::Module *module, SigMap &sigmap, int num_steps = 1, bool strict_undef = false) :
+			module(module), num_steps(num_steps), num_nets(NET_FIRST), strict_undef(strict_undef)
+	{
+		net_source.resize(NET_FIRST, SRC_LOGIC);
+
+		for (auto wire : module->wires())
+			for (auto bit : sigmap(wire))
+				net(bit);
+
+		// bits with more than one driver are undefined
+		dict<RTLIL::SigBit, RTLIL::Cell*> driver_cells;
+		pool<RTLIL::SigBit> multi_driven;
+
+		for (auto cell : module->cells())
+			for (auto &conn : cell->connections())
+				if (yosys_celltypes.cell_output(cell->type, conn.first))
+					for (auto bit : sigmap(conn.second))
+						if (bit.wire != nullptr) {
+							if (driver_cells.count(bit))
+								multi_driven.insert(bit);
+							driver_cells[bit] = cell;
+						}
+
+		for (auto bit : multi_driven)
+			net_source[net_index.at(bit)] = SRC_UNDEF;
+
+		TopoSort<RTLIL::Cell*, RTLIL::IdString::compare_ptr_by_name<RTLIL::Cell>> toposort;
+
+		for (auto cell : module->cells())
+		{
+			if (is_register(cell->type)) {
+				RTLIL::SigSpec sig_d = sigmap(cell->getPort("\\D"));
+				RTLIL::SigSpec sig_q = sigmap(cell->getPort("\\Q"));
+				for (int i = 0; i < GetSize(sig_q) && i < GetSize(sig_d); i++)
+					if (sig_q[i].wire != nullptr && net_source[net(sig_q[i])] == SRC_INPUT) {
+						net_source[net(sig_q[i])] = SRC_REG;
+						registers.push_back(std::pair<int, int>(net(sig_q[i]), net(sig_d[i])));
+					}
+				continue;
+			}
+
+			if (can_lower(cell->type)) {
+				toposort.node(cell);
+				continue;
+			}
+
+			if (yosys_celltypes.cell_known(cell->type))
+				set_undef(sigmap, cell);
+		}
+
+		for (auto &it : toposort.database)
+			for (auto &conn : it.first->connections())
+				if (yosys_celltypes.cell_input(it.first->type, conn.first))
+					for (auto bit : sigmap(conn.second))
+						if (driver_cells.count(bit) && toposort.database.count(driver_cells.at(bit)))
+							toposort.edge(driver_cells.at(bit), it.first);
+
+		toposort.sort();
+
+		// cells in logic loops are not simulated. TopoSort::sort() puts all
+		// other cells after the cells that drive their inputs.
+		pool<RTLIL::Cell*> loop_cells;
+		for (auto &loop : toposort.loops)
+			loop_cells.insert(loop.begin(), loop.end());
+
+		for (auto cell : toposort.sorted)
+			if (loop_cells.count(cell))
+				set_undef(sigmap, cell);
+
+		for (auto cell : toposort.sorted)
+			if (!loop_cells.count(cell)) {
+				lower_cell(sigmap, cell);
+				if (strict_undef)
+					mask_undef(sigmap, cell);
+			}
+	}
+
+	int net(RTLIL::SigBit bit)
+	{
+		if (bit.wire == nullptr)
+			return bit == RTLIL::State::S0 ? NET_S0 : bit == RTLIL::State::S1 ? NET_S1 : NET_SX;
+		auto it = net_index.find(bit);
+		if (it != net_index.end())
+			return it->second;
+		net_index[bit] = num_nets;
+		net_source.push_back(SRC_INPUT);
+		return num_nets++;
+	}
+
+	int new_net()
+	{
+		net_source.push_back(SRC_LOGIC);
+		return num_nets++;
+	}
+
+	// like net(), but returns a scratch net if the bit is constant or has more than one driver
+	int out_net(RTLIL::SigBit bit)
+	{
+		int n = net(bit);
+		if (n < NET_FIRST || net_source[n] != SRC_INPUT)
+			return new_net();
+		net_source[n] = SRC_LOGIC;
+		return n;
+	}
+
+	void set_undef(SigMap &sigmap, RTLIL::Cell *cell)
+	{
+		for (auto &conn : cell->connections())
+			if (yosys_celltypes.cell_output(cell->type, conn.first))
+				for (auto bit : sigmap(conn.second))
+					if (bit.wire != nullptr)
+						net_source[net(bit)] = SRC_UNDEF;
+	}
+
+	// make all outputs of the cell undefined in lanes where one of its inputs is undefined
+	void mask_undef(SigMap &sigmap, RTLIL::Cell *cell)
+	{
+		int all_def = NET_S1;
+		for (auto &conn : cell->connections())
+			if (yosys_celltypes.cell_input(cell->type, conn.first))
+				for (auto bit : sigmap(conn.second))
+					all_def = emit_temp(OP_DEFAND, all_def, net(bit));
+
+		for (auto &conn : cell->connections())
+			if (yosys_celltypes.cell_output(cell->type, conn.first))
+				for (auto bit : sigmap(conn.second))
+					if (bit.wire != nullptr && net_source[net(bit)] == SRC_LOGIC)
+						emit(OP_DEFMASK, net(bit), all_def);
+	}
+
+	// same as extend_u0() in kernel/calc.cc
+	std::vector<int> nets(const RTLIL::SigSpec &sig, int width, bool is_signed)
+	{
+		std::vector<int> result;
+		int padding = is_signed && GetSize(sig) > 0 ? net(sig[GetSize(sig)-1]) : NET_S0;
+		for (int i = 0; i < width; i++)
+			result.push_back(i < GetSize(sig) ? net(sig[i]) : padding);
+		return result;
+	}
+
+	void emit(op_t op, int y, int a, int b = NET_SX, int s = NET_SX)
+	{
+		insn_t insn;
+		insn.op = op;
+		insn.y = y;
+		insn.a = a;
+		insn.b = b;
+		insn.s = s;
+		insns.push_back(insn);
+	}
+
+	int emit_temp(op_t op, int a, int b = NET_SX)
+	{
+		int y = new_net();
+		emit(op, y, a, b);
+		return y;
+	}
+
+	int emit_reduce(op_t op, const std::vector<int> &bits, int initial)
+	{
+		int y = initial;
+		for (int bit : bits)
+			y = emit_temp(op, y, bit);
+		return y;
+	}
+
+	void emit_pmux(int y, int a, const std::vector<int> &s, const std::vector<int> &b)
+	{
+		emit(OP_PMUX, y, a, GetSize(pmux_args), GetSize(s));
+		for (int i = 0; i < GetSize(s); i++) {
+			pmux_args.push_back(s[i]);
+			pmux_args.push_back(b[i]);
+		}
+	}
+
+	// single-bit result in Y[0], the other bits of Y are zero
+	void emit_bool(const RTLIL::SigSpec &sig_y, op_t op, int a, int b = NET_SX)
+	{
+		for (int i = 0; i < GetSize(sig_y); i++)
+			if (i == 0)
+				emit(op, out_net(sig_y[i]), a, b);
+			else
+				emit(OP_BUF, out_net(sig_y[i]), NET_S0);
+	}
+
+	// Y = A + (B ^ BI) + CI, with optional X and CO outputs like $alu
+	void emit_adder(const std::vector<int> &a, const std::vector<int> &b, int bi, int ci,
+			const RTLIL::SigSpec &sig_y, const RTLIL::SigSpec *sig_x = nullptr, const RTLIL::SigSpec *sig_co = nullptr)
+	{
+		int carry = ci;
+		for (int i = 0; i < GetSize(sig_y); i++) {
+			int bb = bi == NET_S0 ? b[i] : emit_temp(OP_XOR, b[i], bi);
+			int x = sig_x ? out_net((*sig_x)[i]) : new_net();
+			int co = sig_co ? out_net((*sig_co)[i]) : new_net();
+			emit(OP_XOR, x, a[i], bb);
+			emit(OP_XOR, out_net(sig_y[i]), x, carry);
+			emit(OP_OR, co, emit_temp(OP_AND, a[i], bb), emit_temp(OP_AND, carry, x));
+			carry = co;
+		}
+	}
+
+	void lower_cell(SigMap &sigmap, RTLIL::Cell *cell)
+	{
+		RTLIL::IdString type = cell->type;
+		dict<RTLIL::IdString, RTLIL::SigSpec> ports;
+		for (auto &conn : cell->connections())
+			ports[conn.first] = sigmap(conn.second);
+
+		if (type.in("$_BUF_", "$_NOT_", "$_AND_", "$_NAND_", "$_OR_", "$_NOR_", "$_XOR_", "$_XNOR_", "$_ANDNOT_", "$_ORNOT_", "$equiv"))
+		{
+			int y = out_net(ports.at("\\Y"));
+			int a = net(ports.at("\\A"));
+			int b = type.in("$_BUF_", "$_NOT_", "$equiv") ? NET_SX : net(ports.at("\\B"));
+
+			if (type.in("$_BUF_", "$equiv")) emit(OP_BUF, y, a);
+			if (type == "$_NOT_") emit(OP_NOT, y, a);
+			if (type == "$_AND_") emit(OP_AND, y, a, b);
+			if (type == "$_NAND_") emit(OP_NAND, y, a, b);
+			if (type == "$_OR_") emit(OP_OR, y, a, b);
+			if (type == "$_NOR_") emit(OP_NOR, y, a, b);
+			if (type == "$_XOR_") emit(OP_XOR, y, a, b);
+			if (type == "$_XNOR_") emit(OP_XNOR, y, a, b);
+			if (type == "$_ANDNOT_") emit(OP_ANDNOT, y, a, b);
+			if (type == "$_ORNOT_") emit(OP_ORNOT, y, a, b);
+			return;
+		}
+
+		if (type == "$_MUX_") {
+			emit_pmux(out_net(ports.at("\\Y")), net(ports.at("\\A")), {net(ports.at("\\S"))}, {net(ports.at("\\B"))});
+			return;
+		}
+
+		if (type.in("$_AOI3_", "$_OAI3_", "$_AOI4_", "$_OAI4_"))
+		{
+			int y = out_net(ports.at("\\Y"));
+			int a = net(ports.at("\\A"));
+			int b = net(ports.at("\\B"));
+			int c = net(ports.at("\\C"));
+
+			if (type == "$_AOI3_")
+				emit(OP_NOR, y, emit_temp(OP_AND, a, b), c);
+			if (type == "$_OAI3_")
+				emit(OP_NAND, y, emit_temp(OP_OR, a, b), c);
+			if (type == "$_AOI4_")
+				emit(OP_NOR, y, emit_temp(OP_AND, a, b), emit_temp(OP_AND, c, net(ports.at("\\D"))));
+			if (type == "$_OAI4_")
+				emit(OP_NAND, y, emit_temp(OP_OR, a, b), emit_temp(OP_OR, c, net(ports.at("\\D"))));
+			return;
+		}
+
+		bool signed_a = cell->parameters.count("\\A_SIGNED") > 0 && cell->parameters.at("\\A_SIGNED").as_bool();
+		bool signed_b = cell->parameters.count("\\B_SIGNED") > 0 && cell->parameters.at("\\B_SIGNED").as_bool();
+
+		if (type == "$alu")
+		{
+			RTLIL::SigSpec sig_y = ports.at("\\Y");
+			std::vector<int> a = nets(ports.at("\\A"), GetSize(sig_y), signed_a);
+			std::vector<int> b = nets(ports.at("\\B"), GetSize(sig_y), signed_b);
+			emit_adder(a, b, net(ports.at("\\BI")), net(ports.at("\\CI")), sig_y, &ports.at("\\X"), &ports.at("\\CO"));
+			return;
+		}
+
+		if (type == "$fa")
+		{
+			RTLIL::SigSpec sig_c = ports.at("\\C");
+			for (int i = 0; i < GetSize(sig_c); i++) {
+				int a = net(ports.at("\\A")[i]), b = net(ports.at("\\B")[i]), c = net(sig_c[i]);
+				int t = emit_temp(OP_XOR, a, b);
+				emit(OP_XOR, out_net(ports.at("\\Y")[i]), t, c);
+				emit(OP_OR, out_net(ports.at("\\X")[i]), emit_temp(OP_AND, a, b), emit_temp(OP_AND, c, t));
+			}
+			return;
+		}
+
+		if (type == "$lcu")
+		{
+			RTLIL::SigSpec sig_co = ports.at("\\CO");
+			int carry = net(ports.at("\\CI"));
+			for (int i = 0; i < GetSize(sig_co); i++) {
+				int co = out_net(sig_co[i]);
+				emit(OP_OR, co, net(ports.at("\\G")[i]), emit_temp(OP_AND, net(ports.at("\\P")[i]), carry));
+				carry = co;
+			}
+			return;
+		}
+
+		if (type.in("$not", "$pos"))
+		{
+			RTLIL::SigSpec sig_y = ports.at("\\Y");
+			std::vector<int> a = nets(ports.at("\\A"), GetSize(sig_y), signed_a);
+			for (int i = 0; i < GetSize(sig_y); i++)
+				emit(type == "$not" ? OP_NOT : OP_BUF, out_net(sig_y[i]), a[i]);
+			return;
+		}
+
+		if (type.in("$mux", "$pmux"))
+		{
+			RTLIL::SigSpec sig_a = ports.at("\\A");
+			RTLIL::SigSpec sig_b = ports.at("\\B");
+			RTLIL::SigSpec sig_s = ports.at("\\S");
+			RTLIL::SigSpec sig_y = ports.at("\\Y");
+
+			std::vector<int> s = nets(sig_s, GetSize(sig_s), false);
+			for (int i = 0; i < GetSize(sig_y); i++) {
+				std::vector<int> b;
+				for (int j = 0; j < GetSize(sig_s); j++)
+					b.push_back(net(sig_b[j*GetSize(sig_y) + i]));
+				emit_pmux(out_net(sig_y[i]), net(sig_a[i]), s, b);
+			}
+			return;
+		}
+
+		if (is_generic(type))
+		{
+			generic_t g;
+			g.cell = cell;
+			if (ports.count("\\A"))
+				g.a = nets(ports.at("\\A"), GetSize(ports.at("\\A")), false);
+			if (ports.count("\\B"))
+				g.b = nets(ports.at("\\B"), GetSize(ports.at("\\B")), false);
+			for (auto bit : ports.at("\\Y"))
+				g.y.push_back(out_net(bit));
+			emit(OP_GENERIC, NET_SX, NET_SX, NET_SX, GetSize(generics));
+			generics.push_back(g);
+			return;
+		}
+
+		// see CellTypes::eval()
+		if (!signed_a || !signed_b)
+			signed_a = false, signed_b = false;
+
+		if (type.in("$and", "$or", "$xor", "$xnor"))
+		{
+			op_t op = type == "$and" ? OP_AND : type == "$or" ? OP_OR : type == "$xor" ? OP_XOR : OP_XNOR;
+			RTLIL::SigSpec sig_y = ports.at("\\Y");
+			std::vector<int> a = nets(ports.at("\\A"), GetSize(sig_y), signed_a);
+			std::vector<int> b = nets(ports.at("\\B"), GetSize(sig_y), signed_b);
+			for (int i = 0; i < GetSize(sig_y); i++)
+				emit(op, out_net(sig_y[i]), a[i], b[i]);
+			return;
+		}
+
+		if (type.in("$add", "$sub"))
+		{
+			RTLIL::SigSpec sig_y = ports.at("\\Y");
+			std::vector<int> a = nets(ports.at("\\A"), GetSize(sig_y), signed_a);
+			std::vector<int> b = nets(ports.at("\\B"), GetSize(sig_y), signed_b);
+			int inv = type == "$sub" ? NET_S1 : NET_S0;
+			emit_adder(a, b, inv, inv, sig_y);
+			return;
+		}
+
+		if (type.in("$reduce_and", "$reduce_or", "$reduce_xor", "$reduce_xnor", "$reduce_bool", "$logic_not"))
+		{
+			RTLIL::SigSpec sig_a = ports.at("\\A");
+			std::vector<int> a = nets(sig_a, GetSize(sig_a), false);
+
+			if (type == "$reduce_and")
+				emit_bool(ports.at("\\Y"), OP_BUF, emit_reduce(OP_AND, a, NET_S1));
+			if (type.in("$reduce_or", "$reduce_bool"))
+				emit_bool(ports.at("\\Y"), OP_BUF, emit_reduce(OP_OR, a, NET_S0));
+			if (type == "$reduce_xor")
+				emit_bool(ports.at("\\Y"), OP_BUF, emit_reduce(OP_XOR, a, NET_S0));
+			if (type == "$reduce_xnor")
+				emit_bool(ports.at("\\Y"), OP_NOT, emit_reduce(OP_XOR, a, NET_S0));
+			if (type == "$logic_not")
+				emit_bool(ports.at("\\Y"), OP_NOT, emit_reduce(OP_OR, a, NET_S0));
+			return;
+		}
+
+		if (type.in("$logic_and", "$logic_or"))
+		{
+			RTLIL::SigSpec sig_a = ports.at("\\A");
+			RTLIL::SigSpec sig_b = ports.at("\\B");
+			int a = emit_reduce(OP_OR, nets(sig_a, GetSize(sig_a), false), NET_S0);
+			int b = emit_reduce(OP_OR, nets(sig_b, GetSize(sig_b), false), NET_S0);
+			emit_bool(ports.at("\\Y"), type == "$logic_and" ? OP_AND : OP_OR, a, b);
+			return;
+		}
+
+		if (type.in("$eq", "$ne", "$eqx", "$nex"))
+		{
+			// $eqx and $nex are the same as $eq and $ne for defined inputs
+			RTLIL::SigSpec sig_a = ports.at("\\A");
+			RTLIL::SigSpec sig_b = ports.at("\\B");
+			int width = max(GetSize(sig_a), GetSize(sig_b));
+			std::vector<int> a = nets(sig_a, width, signed_a);
+			std::vector<int> b = nets(sig_b, width, signed_b);
+
+			std::vector<int> eq_bits;
+			for (int i = 0; i < width; i++)
+				eq_bits.push_back(emit_temp(OP_XNOR, a[i], b[i]));
+
+			emit_bool(ports.at("\\Y"), type.in("$eq", "$eqx") ? OP_BUF : OP_NOT, emit_reduce(OP_AND, eq_bits, NET_S1));
+			return;
+		}
+
+		log_abort();
+	}
+
+	// fill the state with new random input values
+	void init(State &state, uint64_t seed) const
+	{
+		state.val.assign(num_steps * num_nets, 0);
+		state.def.assign(num_steps * num_nets, 0);
+
+		// xorshift64*
+		uint64_t x = seed * 0x9E3779B97F4A7C15ull + 1;
+		for (int step = 0; step < num_steps; step++)
+		{
+			uint64_t *v = state.val.data() + step * num_nets;
+			uint64_t *d = state.def.data() + step * num_nets;
+
+			v[NET_S1] = d[NET_S1] = ~uint64_t(0);
+			d[NET_S0] = ~uint64_t(0);
+
+			for (int n = NET_FIRST; n < num_nets; n++)
+				if (net_source[n] == SRC_INPUT || (net_source[n] == SRC_REG && step == 0)) {
+					x ^= x >> 12, x ^= x << 25, x ^= x >> 27;
+					v[n] = x * 0x2545F4914F6CDD1Dull;
+					d[n] = ~uint64_t(0);
+				}
+		}
+	}
+
+	// true if the value of the (sigmapped) bit in this time step is set by init() and set()
+	bool is_input(RTLIL::SigBit bit, int step) const
+	{
+		auto it = net_index.find(bit);
+		if (it == net_index.end())
+			return false;
+		int src = net_source[it->second];
+		return src == SRC_INPUT || (src == SRC_REG && step == 0);
+	}
+
+	void set(State &state, RTLIL::SigBit bit, int step, int lane, bool value) const
+	{
+		log_assert(is_input(bit, step));
+		int idx = step * num_nets + net_index.at(bit);
+		uint64_t mask = uint64_t(1) << lane;
+		state.val[idx] = value ? state.val[idx] | mask : state.val[idx] & ~mask;
+	}
+
+	void run(State &state) const
+	{
+		for (int step = 0; step < num_steps; step++)
+		{
+			uint64_t *v = state.val.data() + step * num_nets;
+			uint64_t *d = state.def.data() + step * num_nets;
+
+			if (step > 0)
+				for (auto &it : registers)
+					v[it.first] = v[it.second - num_nets], d[it.first] = d[it.second - num_nets];
+
+			for (auto &insn : insns)
+			{
+				uint64_t av = v[insn.a], ad = d[insn.a];
+				uint64_t bv = v[insn.b], bd = d[insn.b];
+
+				// lanes with a defined 0 or 1 in each argument
+				uint64_t a0 = ad & ~av, a1 = ad & av;
+				uint64_t b0 = bd & ~bv, b1 = bd & bv;
+
+				switch (insn.op)
+				{
+				case OP_BUF:
+					v[insn.y] = a1, d[insn.y] = ad;
+					break;
+				case OP_NOT:
+					v[insn.y] = a0, d[insn.y] = ad;
+					break;
+				case OP_AND:
+					v[insn.y] = a1 & b1, d[insn.y] = (a1 & b1) | a0 | b0;
+					break;
+				case OP_NAND:
+					v[insn.y] = a0 | b0, d[insn.y] = (a1 & b1) | a0 | b0;
+					break;
+				case OP_OR:
+					v[insn.y] = a1 | b1, d[insn.y] = a1 | b1 | (a0 & b0);
+					break;
+				case OP_NOR:
+					v[insn.y] = a0 & b0, d[insn.y] = a1 | b1 | (a0 & b0);
+					break;
+				case OP_XOR:
+					d[insn.y] = ad & bd, v[insn.y] = (av ^ bv) & ad & bd;
+					break;
+				case OP_XNOR:
+					d[insn.y] = ad & bd, v[insn.y] = ~(av ^ bv) & ad & bd;
+					break;
+				case OP_ANDNOT:
+					v[insn.y] = a1 & b0, d[insn.y] = (a1 & b0) | a0 | b1;
+					break;
+				case OP_ORNOT:
+					v[insn.y] = a1 | b0, d[insn.y] = a1 | b0 | (a0 & b1);
+					break;
+				case OP_PMUX: {
+					// like ConstEval: all inputs that are selected by a 1 or x in S (or A
+					// if no S bit is 1) are candidates. Y is defined where they all agree.
+					uint64_t any_set = 0, all_def = ~uint64_t(0), and_val = ~uint64_t(0), or_val = 0;
+					for (int i = 0; i < insn.s; i++) {
+						int s = pmux_args[insn.b + 2*i], b = pmux_args[insn.b + 2*i + 1];
+						uint64_t cand = v[s] | ~d[s];
+						any_set |= v[s] & d[s];
+						all_def &= ~cand | d[b];
+						and_val &= ~cand | v[b];
+						or_val |= cand & v[b];
+					}
+					all_def &= any_set | ad;
+					and_val &= any_set | av;
+					or_val |= ~any_set & av;
+					d[insn.y] = all_def & ~(and_val ^ or_val);
+					v[insn.y] = or_val & d[insn.y];
+					break;
+				}
+				case OP_GENERIC:
+					eval_generic(generics[insn.s], v, d);
+					break;
+				case OP_DEFAND:
+					v[insn.y] = av & bd, d[insn.y] = ~uint64_t(0);
+					break;
+				case OP_DEFMASK:
+					v[insn.y] &= av, d[insn.y] &= av;
+					break;
+				}
+			}
+		}
+	}
+
+	void eval_generic(const generic_t &g, uint64_t *v, uint64_t *d) const
+	{
+		uint64_t all_def = ~uint64_t(0);
+		for (int n : g.a)
+			all_def &= d[n];
+		for (int n : g.b)
+			all_def &= d[n];
+
+		for (int n : g.y)
+			v[n] = 0, d[n] = 0;
+
+		for (int lane = 0; lane < 64; lane++)
+		{
+			if (((all_def >> lane) & 1) == 0)
+				continue;
+
+			RTLIL::Const a, b;
+			for (int n : g.a)
+				a.bits.push_back((v[n] >> lane) & 1 ? RTLIL::State::S1 : RTLIL::State::S0);
+			for (int n : g.b)
+				b.bits.push_back((v[n] >> lane) & 1 ? RTLIL::State::S1 : RTLIL::State::S0);
+
+			RTLIL::Const y = CellTypes::eval(g.cell, a, b);
+			if (GetSize(y) != GetSize(g.y))
+				continue;
+
+			for (int i = 0; i < GetSize(g.y); i++) {
+				uint64_t mask = uint64_t(1) << lane;
+				if (y.bits[i] == RTLIL::State::S0 || y.bits[i] == RTLIL::State::S1)
+					d[g.y[i]] |= mask;
+				if (y.bits[i] == RTLIL::State::S1)
+					v[g.y[i]] |= mask;
+			}
+		}
+	}
+
+	// value of a (sigmapped) bit in all 64 lanes
+	void get(const State &state, RTLIL::SigBit bit, int step, uint64_t &val, uint64_t &def) const
+	{
+		int n = bit.wire == nullptr ? (bit == RTLIL::State::S0 ? NET_S0 : bit == RTLIL::State::S1 ? NET_S1 : NET_SX) :
+				net_index.count(bit) ? net_index.at(bit) : NET_SX;
+		val = state.val[step * num_nets + n];
+		def = state.def[step * num_nets + n];
+	}
+
+	// lanes in which the two (sigmapped) bits have different defined values
+	uint64_t diff(const State &state, RTLIL::SigBit a, RTLIL::SigBit b, int step) const
+	{
+		uint64_t av, ad, bv, bd;
+		get(state, a, step, av, ad);
+		get(state, b, step, bv, bd);
+		return ad & bd & (av ^ bv);
+	}
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
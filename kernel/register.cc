@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
+#include <chrono>
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -45,6 +46,7 @@ Pass::Pass(std::string name, std::string short_help) : pass_name(name), short_he
 	first_queued_pass = this;
 	call_counter = 0;
 	runtime_ns = 0;
+	readonly_modules = false;
 }
 
 void Pass::run_register()
@@ -79,6 +81,13 @@ Pass::pre_post_exec_state_t Pass::pre_execute()
 	call_counter++;
 	state.begin_ns = PerformanceTimer::query();
 	state.parent_pass = current_pass;
+	state.profile_node = -1;
+	if (pass_profile != nullptr && state.parent_pass != this) {
+		// a command that failed in interactive mode never reaches post_execute()
+		if (state.parent_pass == nullptr)
+			pass_profile->current_node = 0;
+		state.profile_node = pass_profile->enter(pass_name);
+	}
 	current_pass = this;
 	clear_flags();
 	return state;
@@ -91,6 +100,177 @@ void Pass::post_execute(Pass::pre_post_exec_state_t state)
 	current_pass = state.parent_pass;
 	if (current_pass)
 		current_pass->runtime_ns -= time_ns;
+	if (pass_profile != nullptr && state.profile_node >= 0)
+		pass_profile->leave(state.profile_node);
+}
+
+PassProfile *pass_profile = nullptr;
+
+static void profile_count_design(int &cells, int &wires)
+{
+	RTLIL::Design *design = yosys_get_design();
+	cells = 0, wires = 0;
+	if (design != nullptr)
+		for (auto &it : design->modules_.base()) {
+			cells += GetSize(it.second->cells_);
+			wires += GetSize(it.second->wires_);
+		}
+}
+
+PassProfile::PassProfile()
+{
+	nodes.push_back(node_t());
+	node_t &root = nodes.back();
+	root.parent = -1;
+	root.call_counter = 1;
+	root.wall_ns = 0;
+	root.cpu_ns = 0;
+	root.peak_rss_delta_kb = 0;
+	root.begin_wall_ns = wall_time_ns();
+	root.begin_cpu_ns = PerformanceTimer::query();
+	root.begin_peak_rss_kb = peak_rss_kb();
+	profile_count_design(root.cells_before, root.wires_before);
+	root.cells_after = root.cells_before;
+	root.wires_after = root.wires_before;
+	current_node = 0;
+}
+
+int PassProfile::enter(const std::string &name)
+{
+	int node = -1;
+
+	for (int child : nodes[current_node].children)
+		if (nodes[child].name == name) {
+			node = child;
+			break;
+		}
+
+	if (node < 0) {
+		node = GetSize(nodes);
+		nodes.push_back(node_t());
+		nodes.back().name = name;
+		nodes.back().parent = current_node;
+		nodes.back().call_counter = 0;
+		nodes.back().wall_ns = 0;
+		nodes.back().cpu_ns = 0;
+		nodes.back().peak_rss_delta_kb = 0;
+		profile_count_design(nodes.back().cells_before, nodes.back().wires_before);
+		nodes[current_node].children.push_back(node);
+	}
+
+	node_t &n = nodes[node];
+	n.call_counter++;
+	n.begin_wall_ns = wall_time_ns();
+	n.begin_cpu_ns = PerformanceTimer::query();
+	n.begin_peak_rss_kb = peak_rss_kb();
+	current_node = node;
+	return node;
+}
+
+void PassProfile::leave(int node)
+{
+	node_t &n = nodes[node];
+	n.wall_ns += wall_time_ns() - n.begin_wall_ns;
+	n.cpu_ns += PerformanceTimer::query() - n.begin_cpu_ns;
+	n.peak_rss_delta_kb += peak_rss_kb() - n.begin_peak_rss_kb;
+	profile_count_design(n.cells_after, n.wires_after);
+	current_node = n.parent;
+}
+
+int64_t PassProfile::wall_time_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t PassProfile::peak_rss_kb()
+{
+#ifdef _WIN32
+	return 0;
+#else
+	struct rusage ru_buffer;
+	getrusage(RUSAGE_SELF, &ru_buffer);
+#  ifdef __APPLE__
+	return ru_buffer.ru_maxrss / 1024;
+#  else
+	return ru_buffer.ru_maxrss;
+#  endif
+#endif
+}
+
+static void profile_update_root(PassProfile *profile)
+{
+	PassProfile::node_t &root = profile->nodes[0];
+	root.wall_ns = PassProfile::wall_time_ns() - root.begin_wall_ns;
+	root.cpu_ns = PerformanceTimer::query() - root.begin_cpu_ns;
+	root.peak_rss_delta_kb = PassProfile::peak_rss_kb() - root.begin_peak_rss_kb;
+	profile_count_design(root.cells_after, root.wires_after);
+}
+
+static void profile_log_node(PassProfile *profile, int node, int indent)
+{
+	const PassProfile::node_t &n = profile->nodes[node];
+	log("%7d %10.3f %10.3f %+9.1f %7d -> %-7d %7d -> %-7d %*s%s\n", n.call_counter, n.wall_ns * 1e-9, n.cpu_ns * 1e-9,
+			n.peak_rss_delta_kb / 1024.0, n.cells_before, n.cells_after, n.wires_before, n.wires_after, 2*indent, "", n.name.c_str());
+	for (int child : n.children)
+		profile_log_node(profile, child, indent+1);
+}
+
+void PassProfile::log_report(int node)
+{
+	log("  calls    wall[s]     cpu[s]  RSS[MB]   cells             wires             command\n");
+	for (int child : nodes[node].children)
+		profile_log_node(this, child, 0);
+}
+
+static void profile_json_node(PassProfile *profile, FILE *f, int node, int indent)
+{
+	const PassProfile::node_t &n = profile->nodes[node];
+	fprintf(f, "%*s{\n", indent, "");
+	fprintf(f, "%*s  \"name\": \"%s\",\n", indent, "", n.name.c_str());
+	fprintf(f, "%*s  \"calls\": %d,\n", indent, "", n.call_counter);
+	fprintf(f, "%*s  \"wall_sec\": %.6f,\n", indent, "", n.wall_ns * 1e-9);
+	fprintf(f, "%*s  \"cpu_sec\": %.6f,\n", indent, "", n.cpu_ns * 1e-9);
+	fprintf(f, "%*s  \"peak_rss_delta_kb\": %lld,\n", indent, "", (long long)n.peak_rss_delta_kb);
+	fprintf(f, "%*s  \"cells_before\": %d,\n", indent, "", n.cells_before);
+	fprintf(f, "%*s  \"cells_after\": %d,\n", indent, "", n.cells_after);
+	fprintf(f, "%*s  \"wires_before\": %d,\n", indent, "", n.wires_before);
+	fprintf(f, "%*s  \"wires_after\": %d,\n", indent, "", n.wires_after);
+	fprintf(f, "%*s  \"children\": [", indent, "");
+	for (int i = 0; i < GetSize(n.children); i++) {
+		fprintf(f, "%s\n", i ? "," : "");
+		profile_json_node(profile, f, n.children[i], indent+4);
+	}
+	fprintf(f, "%s]\n", n.children.empty() ? "" : stringf("\n%*s  ", indent, "").c_str());
+	fprintf(f, "%*s}", indent, "");
+}
+
+void PassProfile::write_json(FILE *f, int node)
+{
+	int64_t wall_ns = 0, cpu_ns = 0;
+
+	if (node == 0) {
+		profile_update_root(this);
+		wall_ns = nodes[0].wall_ns;
+		cpu_ns = nodes[0].cpu_ns;
+	} else {
+		for (int child : nodes[node].children) {
+			wall_ns += nodes[child].wall_ns;
+			cpu_ns += nodes[child].cpu_ns;
+		}
+	}
+
+	fprintf(f, "{\n");
+	fprintf(f, "  \"creator\": \"%s\",\n", yosys_version_str);
+	fprintf(f, "  \"wall_sec\": %.6f,\n", wall_ns * 1e-9);
+	fprintf(f, "  \"cpu_sec\": %.6f,\n", cpu_ns * 1e-9);
+	fprintf(f, "  \"peak_rss_kb\": %lld,\n", (long long)peak_rss_kb());
+	fprintf(f, "  \"passes\": [");
+	for (int i = 0; i < GetSize(nodes[node].children); i++) {
+		fprintf(f, "%s\n", i ? "," : "");
+		profile_json_node(this, f, nodes[node].children[i], 4);
+	}
+	fprintf(f, "%s]\n", nodes[node].children.empty() ? "" : "\n  ");
+	fprintf(f, "}\n");
 }
 
 void Pass::help()
@@ -212,6 +392,25 @@ void Pass::call(RTLIL::Design *design, std::string command)
 	call(design, args);
 }
 
+// while a command with readonly_modules runs, the modules shared with saved
+// designs are not copied when the command accesses them
+struct readonly_modules_scope_t
+{
+	RTLIL::Design *design;
+	bool old_readonly_modules;
+
+	readonly_modules_scope_t(RTLIL::Design *design, bool readonly_modules) : design(design)
+	{
+		old_readonly_modules = design->readonly_modules_;
+		design->readonly_modules_ = readonly_modules;
+	}
+
+	~readonly_modules_scope_t()
+	{
+		design->readonly_modules_ = old_readonly_modules;
+	}
+};
+
 void Pass::call(RTLIL::Design *design, std::vector<std::string> args)
 {
 	if (args.size() == 0 || args[0][0] == '#' || args[0][0] == ':')
@@ -227,6 +426,8 @@ void Pass::call(RTLIL::Design *design, std::vector<std::string> args)
 	if (pass_register.count(args[0]) == 0)
 		log_cmd_error("No such command: %s (type 'help' for a command overview)\n", args[0].c_str());
 
+	readonly_modules_scope_t readonly_scope(design, pass_register[args[0]]->readonly_modules);
+
 	size_t orig_sel_stack_pos = design->selection_stack.size();
 	auto state = pass_register[args[0]]->pre_execute();
 	pass_register[args[0]]->execute(args, design);
@@ -363,6 +564,7 @@ Frontend::~Frontend()
 void Frontend::execute(std::vector<std::string> args, RTLIL::Design *design)
 {
 	log_assert(next_args.empty());
+	RTLIL::IdString::immortal_scope_t immortal_scope(immortal_ids);
 	do {
 		std::istream *f = NULL;
 		next_args.clear();
@@ -376,6 +578,7 @@ void Frontend::execute(std::vector<std::string> args, RTLIL::Design *design)
 
 FILE *Frontend::current_script_file = NULL;
 std::string Frontend::last_here_document;
+bool Frontend::immortal_ids = false;
 
 void Frontend::extra_args(std::istream *&f, std::string &filename, std::vector<std::string> args, size_t argidx)
 {
@@ -475,6 +678,10 @@ void Frontend::frontend_call(RTLIL::Design *design, std::istream *f, std::string
 	if (frontend_register.count(args[0]) == 0)
 		log_cmd_error("No such frontend: %s\n", args[0].c_str());
 
+	RTLIL::IdString::immortal_scope_t immortal_scope(immortal_ids);
+
+	readonly_modules_scope_t readonly_scope(design, frontend_register[args[0]]->readonly_modules);
+
 	if (f != NULL) {
 		auto state = frontend_register[args[0]]->pre_execute();
 		frontend_register[args[0]]->execute(f, filename, args, design);
@@ -580,6 +787,8 @@ void Backend::backend_call(RTLIL::Design *design, std::ostream *f, std::string f
 	if (backend_register.count(args[0]) == 0)
 		log_cmd_error("No such backend: %s\n", args[0].c_str());
 
+	readonly_modules_scope_t readonly_scope(design, backend_register[args[0]]->readonly_modules);
+
 	size_t orig_sel_stack_pos = design->selection_stack.size();
 
 	if (f != NULL) {
@@ -614,7 +823,7 @@ static struct CellHelpMessages {
 } cell_help_messages;
 
 struct HelpPass : public Pass {
-	HelpPass() : Pass("help", "display help messages") { }
+	HelpPass() : Pass("help", "display help messages") { readonly_modules = true; }
 	virtual void help()
 	{
 		log("\n");
@@ -767,7 +976,7 @@ struct HelpPass : public Pass {
 } HelpPass;
 
 struct EchoPass : public Pass {
-	EchoPass() : Pass("echo", "turning echoing back of commands on and off") { }
+	EchoPass() : Pass("echo", "turning echoing back of commands on and off") { readonly_modules = true; }
 	virtual void help()
 	{
 		log("\n");
@@ -24,6 +24,36 @@
 
 YOSYS_NAMESPACE_BEGIN
 
+// hierarchical profile of the executed passes (see 'profile' command and 'yosys -P')
+struct PassProfile
+{
+	struct node_t {
+		std::string name;
+		int parent, call_counter;
+		int64_t wall_ns, cpu_ns, peak_rss_delta_kb;
+		int cells_before, wires_before, cells_after, wires_after;
+		int64_t begin_wall_ns, begin_cpu_ns, begin_peak_rss_kb;
+		std::vector<int> children;
+	};
+
+	// nodes[0] is the root node, repeated calls to the same pass from the
+	// same parent node are merged into one node
+	std::vector<node_t> nodes;
+	int current_node;
+
+	PassProfile();
+	int enter(const std::string &name);
+	void leave(int node);
+
+	void log_report(int node = 0);
+	void write_json(FILE *f, int node = 0);
+
+	static int64_t wall_time_ns();
+	static int64_t peak_rss_kb();
+};
+
+extern PassProfile *pass_profile;
+
 struct Pass
 {
 	std::string pass_name, short_help;
@@ -37,9 +67,14 @@ struct Pass
 	int call_counter;
 	int64_t runtime_ns;
 
+	// set by commands that never modify existing modules. modules shared with
+	// saved designs are not copied when such a command accesses them.
+	bool readonly_modules;
+
 	struct pre_post_exec_state_t {
 		Pass *parent_pass;
 		int64_t begin_ns;
+		int profile_node;
 	};
 
 	pre_post_exec_state_t pre_execute();
@@ -86,6 +121,9 @@ struct Frontend : Pass
 	static FILE *current_script_file;
 	static std::string last_here_document;
 
+	// make all ids created by frontends immortal (see RTLIL::IdString::immortal_scope_t)
+	static bool immortal_ids;
+
 	std::string frontend_name;
 	Frontend(std::string name, std::string short_help = "** document me **");
 	virtual void run_register() YS_OVERRIDE;
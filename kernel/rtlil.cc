@@ -20,6 +20,7 @@
 #include "kernel/yosys.h"
 #include "kernel/macc.h"
 #include "kernel/celltypes.h"
+#include "kernel/sigtools.h"
 #include "frontends/verilog/verilog_frontend.h"
 #include "backends/ilang/ilang_backend.h"
 
@@ -29,10 +30,106 @@
 YOSYS_NAMESPACE_BEGIN
 
 RTLIL::IdString::destruct_guard_t RTLIL::IdString::destruct_guard;
-std::vector<int> RTLIL::IdString::global_refcount_storage_;
-std::vector<char*> RTLIL::IdString::global_id_storage_;
-dict<char*, int, hash_cstr_ops> RTLIL::IdString::global_id_index_;
+std::atomic<RTLIL::IdString::storage_dir_t*> RTLIL::IdString::global_storage_dirs_[RTLIL::IdString::storage_max_dirs];
+std::atomic<int> RTLIL::IdString::global_storage_size_(0);
+RTLIL::IdString::shard_t RTLIL::IdString::global_shards_[RTLIL::IdString::num_shards];
 std::vector<int> RTLIL::IdString::global_free_idx_list_;
+thread_local int RTLIL::IdString::immortal_depth = 0;
+bool RTLIL::IdString::multi_threaded = false;
+std::vector<int> RTLIL::IdString::global_pending_free_list_;
+#ifdef YOSYS_ENABLE_THREADS
+std::mutex RTLIL::IdString::global_pending_free_mutex_;
+#endif
+thread_local RTLIL::IdString::job_ids_t *RTLIL::IdString::job_ids_ = nullptr;
+int RTLIL::IdString::job_first_index_ = 0;
+
+bool SigMapStats::enabled = false;
+bool SigMapStats::cache_enabled = true;
+std::atomic<int64_t> SigMapStats::set_count(0);
+std::atomic<int64_t> SigMapStats::set_ns(0);
+std::atomic<int64_t> SigMapStats::set_bits(0);
+std::atomic<int64_t> SigMapStats::cache_builds(0);
+std::atomic<int64_t> SigMapStats::cache_updates(0);
+std::atomic<int64_t> SigMapStats::cache_invalidations(0);
+
+int RTLIL::IdString::alloc_index()
+{
+	// free indices are only re-used outside of parallel_for() jobs, so that
+	// global_free_idx_list_ is never accessed concurrently. a re-used index
+	// keeps its order key.
+	if (!multi_threaded && !job_ids_ && !global_free_idx_list_.empty()) {
+		int idx = global_free_idx_list_.back();
+		global_free_idx_list_.pop_back();
+		return idx;
+	}
+
+	int idx = global_storage_size_.fetch_add(1);
+	log_assert(idx < 0x40000000);
+
+	std::atomic<storage_dir_t*> &dir = global_storage_dirs_[idx >> (storage_chunk_bits + storage_dir_bits)];
+	if (dir.load(std::memory_order_acquire) == nullptr) {
+		storage_dir_t *new_dir = new storage_dir_t[1];
+		for (int i = 0; i < storage_dir_size; i++)
+			(*new_dir)[i].store(nullptr, std::memory_order_relaxed);
+		storage_dir_t *expected = nullptr;
+		if (!dir.compare_exchange_strong(expected, new_dir, std::memory_order_acq_rel))
+			delete[] new_dir;
+	}
+
+	std::atomic<storage_entry_t*> &chunk = (*dir.load(std::memory_order_acquire))[(idx >> storage_chunk_bits) & (storage_dir_size-1)];
+	if (chunk.load(std::memory_order_acquire) == nullptr) {
+		storage_entry_t *new_chunk = new storage_entry_t[storage_chunk_size];
+		for (int i = 0; i < storage_chunk_size; i++) {
+			new_chunk[i].str.store(nullptr, std::memory_order_relaxed);
+			new_chunk[i].refcount.store(0, std::memory_order_relaxed);
+		}
+		storage_entry_t *expected = nullptr;
+		if (!chunk.compare_exchange_strong(expected, new_chunk, std::memory_order_acq_rel))
+			delete[] new_chunk;
+	}
+
+	global_entry(idx).order.store(idx, std::memory_order_relaxed);
+	return idx;
+}
+
+void RTLIL::IdString::commit_job_ids(const std::vector<job_ids_t*> &jobs)
+{
+	log_assert(!multi_threaded);
+
+	// the indices from job_first_index_ on belong to the ids created while the
+	// jobs were running. give them the keys of a serial run: in job order, and
+	// in the order in which each job first used them. ids that were not created
+	// by a job come last.
+	int next_order = job_first_index_;
+	pool<int> done;
+
+	for (auto job : jobs)
+		for (int idx : job->indices)
+			if (done.insert(idx).second)
+				global_entry(idx).order.store(next_order++, std::memory_order_relaxed);
+
+	for (int idx = job_first_index_; idx < global_storage_size_.load(); idx++)
+		if (done.count(idx) == 0)
+			global_entry(idx).order.store(next_order++, std::memory_order_relaxed);
+}
+
+void RTLIL::IdString::flush_free_list()
+{
+	log_assert(!multi_threaded);
+
+	// free the ids in the order of their keys, so that the order in which the
+	// indices are re-used does not depend on the timing of the threads
+	std::sort(global_pending_free_list_.begin(), global_pending_free_list_.end(), [](int a, int b) {
+		return global_entry(a).order.load(std::memory_order_relaxed) < global_entry(b).order.load(std::memory_order_relaxed);
+	});
+	global_pending_free_list_.erase(std::unique(global_pending_free_list_.begin(), global_pending_free_list_.end()), global_pending_free_list_.end());
+
+	for (int idx : global_pending_free_list_)
+		if (global_entry(idx).refcount.load(std::memory_order_relaxed) == 0)
+			free_reference(idx);
+
+	global_pending_free_list_.clear();
+}
 
 RTLIL::Const::Const()
 {
@@ -322,7 +419,7 @@ void RTLIL::Selection::optimize(RTLIL::Design *design)
 	for (auto &it : selected_members) {
 		del_list.clear();
 		for (auto memb_name : it.second)
-			if (design->modules_[it.first]->count_id(memb_name) == 0)
+			if (design->modules_.base().at(it.first)->count_id(memb_name) == 0)
 				del_list.push_back(memb_name);
 		for (auto memb_name : del_list)
 			it.second.erase(memb_name);
@@ -333,8 +430,8 @@ void RTLIL::Selection::optimize(RTLIL::Design *design)
 	for (auto &it : selected_members)
 		if (it.second.size() == 0)
 			del_list.push_back(it.first);
-		else if (it.second.size() == design->modules_[it.first]->wires_.size() + design->modules_[it.first]->memories.size() +
-				design->modules_[it.first]->cells_.size() + design->modules_[it.first]->processes.size())
+		else if (it.second.size() == design->modules_.base().at(it.first)->wires_.size() + design->modules_.base().at(it.first)->memories.size() +
+				design->modules_.base().at(it.first)->cells_.size() + design->modules_.base().at(it.first)->processes.size())
 			add_list.push_back(it.first);
 	for (auto mod_name : del_list)
 		selected_members.erase(mod_name);
@@ -350,20 +447,21 @@ void RTLIL::Selection::optimize(RTLIL::Design *design)
 	}
 }
 
-RTLIL::Design::Design()
+RTLIL::Design::Design() : modules_(this)
 {
 	static unsigned int hashidx_count = 123456789;
 	hashidx_count = mkhash_xorshift(hashidx_count);
 	hashidx_ = hashidx_count;
 
 	refcount_modules_ = 0;
+	readonly_modules_ = false;
 	selection_stack.push_back(RTLIL::Selection());
 }
 
 RTLIL::Design::~Design()
 {
-	for (auto it = modules_.begin(); it != modules_.end(); ++it)
-		delete it->second;
+	for (auto &it : modules_.base())
+		release(it.second);
 	for (auto n : verilog_packages)
 		delete n;
 	for (auto n : verilog_globals)
@@ -372,12 +470,14 @@ RTLIL::Design::~Design()
 
 RTLIL::ObjRange<RTLIL::Module*> RTLIL::Design::modules()
 {
-	return RTLIL::ObjRange<RTLIL::Module*>(&modules_, &refcount_modules_);
+	unshare_modules();
+	return RTLIL::ObjRange<RTLIL::Module*>(&modules_.base(), &refcount_modules_);
 }
 
 RTLIL::Module *RTLIL::Design::module(RTLIL::IdString name)
 {
-	return modules_.count(name) ? modules_.at(name) : NULL;
+	auto it = modules_.find(name);
+	return it != modules_.end() ? it->second : NULL;
 }
 
 RTLIL::Module *RTLIL::Design::top_module()
@@ -503,9 +603,59 @@ void RTLIL::Design::remove(RTLIL::Module *module)
 		log_backtrace("-X- ", yosys_xtrace-1);
 	}
 
-	log_assert(modules_.at(module->name) == module);
+	log_assert(modules_.base().at(module->name) == module);
 	modules_.erase(module->name);
-	delete module;
+	release(module);
+}
+
+void RTLIL::Design::share(RTLIL::Module *module)
+{
+	log_assert(modules_.count(module->name) == 0);
+	log_assert(refcount_modules_ == 0);
+	modules_[module->name] = module;
+	module->refcount_shared_++;
+
+	for (auto mon : monitors)
+		mon->notify_module_add(module);
+}
+
+void RTLIL::Design::unshare_module(RTLIL::Module *&module)
+{
+	if (module == nullptr || module->refcount_shared_ == 0 || readonly_modules_)
+		return;
+
+	log_assert(refcount_modules_ == 0);
+
+	RTLIL::Module *shared = module;
+	for (auto mon : monitors)
+		mon->notify_module_del(shared);
+	module = shared->clone_ordered();
+	module->design = this;
+	release(shared);
+	for (auto mon : monitors)
+		mon->notify_module_add(module);
+}
+
+void RTLIL::Design::unshare_modules()
+{
+	if (readonly_modules_)
+		return;
+	for (auto &it : modules_.base())
+		unshare_module(it.second);
+}
+
+void RTLIL::Design::release(RTLIL::Module *module)
+{
+	if (module->refcount_shared_ == 0) {
+		delete module;
+		return;
+	}
+	module->refcount_shared_--;
+	if (module->design == this) {
+		// the module is only kept by saved designs now, free its caches
+		module->design = nullptr;
+		module->invalidate_sigmap();
+	}
 }
 
 void RTLIL::Design::rename(RTLIL::Module *module, RTLIL::IdString new_name)
@@ -519,14 +669,15 @@ void RTLIL::Design::sort()
 {
 	scratchpad.sort();
 	modules_.sort(sort_by_id_str());
-	for (auto &it : modules_)
-		it.second->sort();
+	for (auto &it : modules_.base())
+		if (it.second->refcount_shared_ == 0)
+			it.second->sort();
 }
 
 void RTLIL::Design::check()
 {
 #ifndef NDEBUG
-	for (auto &it : modules_) {
+	for (auto &it : modules_.base()) {
 		log_assert(this == it.second->design);
 		log_assert(it.first == it.second->name);
 		log_assert(!it.first.empty());
@@ -537,8 +688,10 @@ void RTLIL::Design::check()
 
 void RTLIL::Design::optimize()
 {
-	for (auto &it : modules_)
-		it.second->optimize();
+	// shared modules are left alone, they have not changed since they were shared
+	for (auto &it : modules_.base())
+		if (it.second->refcount_shared_ == 0)
+			it.second->optimize();
 	for (auto &it : selection_stack)
 		it.optimize(this);
 	for (auto &it : selection_vars)
@@ -584,38 +737,75 @@ bool RTLIL::Design::selected_whole_module(RTLIL::Module *mod) const
 
 std::vector<RTLIL::Module*> RTLIL::Design::selected_modules() const
 {
+	// the returned modules may be modified, so shared modules are copied
+	RTLIL::Design *self = const_cast<RTLIL::Design*>(this);
 	std::vector<RTLIL::Module*> result;
 	result.reserve(modules_.size());
-	for (auto &it : modules_)
-		if (selected_module(it.first) && !it.second->get_bool_attribute("\\blackbox"))
+	for (auto &it : self->modules_.base())
+		if (selected_module(it.first) && !it.second->get_bool_attribute("\\blackbox")) {
+			self->unshare_module(it.second);
 			result.push_back(it.second);
+		}
 	return result;
 }
 
 std::vector<RTLIL::Module*> RTLIL::Design::selected_whole_modules() const
 {
+	RTLIL::Design *self = const_cast<RTLIL::Design*>(this);
 	std::vector<RTLIL::Module*> result;
 	result.reserve(modules_.size());
-	for (auto &it : modules_)
-		if (selected_whole_module(it.first) && !it.second->get_bool_attribute("\\blackbox"))
+	for (auto &it : self->modules_.base())
+		if (selected_whole_module(it.first) && !it.second->get_bool_attribute("\\blackbox")) {
+			self->unshare_module(it.second);
 			result.push_back(it.second);
+		}
 	return result;
 }
 
 std::vector<RTLIL::Module*> RTLIL::Design::selected_whole_modules_warn() const
 {
+	RTLIL::Design *self = const_cast<RTLIL::Design*>(this);
 	std::vector<RTLIL::Module*> result;
 	result.reserve(modules_.size());
-	for (auto &it : modules_)
+	for (auto &it : self->modules_.base())
 		if (it.second->get_bool_attribute("\\blackbox"))
 			continue;
-		else if (selected_whole_module(it.first))
+		else if (selected_whole_module(it.first)) {
+			self->unshare_module(it.second);
 			result.push_back(it.second);
-		else if (selected_module(it.first))
+		} else if (selected_module(it.first))
 			log_warning("Ignoring partially selected module %s.\n", log_id(it.first));
 	return result;
 }
 
+RTLIL::ModuleDict::iterator RTLIL::ModuleDict::begin()
+{
+	design->unshare_modules();
+	return base_t::begin();
+}
+
+RTLIL::ModuleDict::iterator RTLIL::ModuleDict::find(const RTLIL::IdString &key)
+{
+	auto it = base_t::find(key);
+	if (it != end())
+		design->unshare_module(it->second);
+	return it;
+}
+
+RTLIL::Module *&RTLIL::ModuleDict::at(const RTLIL::IdString &key)
+{
+	RTLIL::Module *&module = base_t::at(key);
+	design->unshare_module(module);
+	return module;
+}
+
+RTLIL::Module *&RTLIL::ModuleDict::operator[](const RTLIL::IdString &key)
+{
+	RTLIL::Module *&module = base_t::operator[](key);
+	design->unshare_module(module);
+	return module;
+}
+
 RTLIL::Module::Module()
 {
 	static unsigned int hashidx_count = 123456789;
@@ -625,10 +815,13 @@ RTLIL::Module::Module()
 	design = nullptr;
 	refcount_wires_ = 0;
 	refcount_cells_ = 0;
+	refcount_shared_ = 0;
+	sigmap_ = nullptr;
 }
 
 RTLIL::Module::~Module()
 {
+	delete sigmap_;
 	for (auto it = wires_.begin(); it != wires_.end(); ++it)
 		delete it->second;
 	for (auto it = memories.begin(); it != memories.end(); ++it)
@@ -1329,6 +1522,19 @@ RTLIL::Module *RTLIL::Module::clone() const
 	return new_mod;
 }
 
+RTLIL::Module *RTLIL::Module::clone_ordered() const
+{
+	// cloneInto() inserts the elements of each container in iteration order,
+	// which is the reverse of the insertion order of the original container
+	RTLIL::Module *new_mod = clone();
+	new_mod->attributes.reverse();
+	new_mod->wires_.reverse();
+	new_mod->memories.reverse();
+	new_mod->cells_.reverse();
+	new_mod->processes.reverse();
+	return new_mod;
+}
+
 bool RTLIL::Module::has_memories() const
 {
 	return !memories.empty();
@@ -1436,10 +1642,26 @@ void RTLIL::Module::remove(RTLIL::Cell *cell)
 	delete cell;
 }
 
+// SigBit hashes depend on the wire name, so all hash tables with SigBit keys
+// (the cached SigMap and the databases of monitors like ModIndex) must be
+// rebuilt when a wire is renamed
+void RTLIL::Module::notify_rename_wires()
+{
+	invalidate_sigmap();
+
+	for (auto mon : monitors)
+		mon->notify_blackout(this);
+
+	if (design)
+		for (auto mon : design->monitors)
+			mon->notify_blackout(this);
+}
+
 void RTLIL::Module::rename(RTLIL::Wire *wire, RTLIL::IdString new_name)
 {
 	log_assert(wires_[wire->name] == wire);
 	log_assert(refcount_wires_ == 0);
+	notify_rename_wires();
 	wires_.erase(wire->name);
 	wire->name = new_name;
 	add(wire);
@@ -1470,6 +1692,7 @@ void RTLIL::Module::swap_names(RTLIL::Wire *w1, RTLIL::Wire *w2)
 	log_assert(wires_[w1->name] == w1);
 	log_assert(wires_[w2->name] == w2);
 	log_assert(refcount_wires_ == 0);
+	notify_rename_wires();
 
 	wires_.erase(w1->name);
 	wires_.erase(w2->name);
@@ -1558,6 +1781,12 @@ void RTLIL::Module::connect(const RTLIL::SigSig &conn)
 
 	log_assert(GetSize(conn.first) == GetSize(conn.second));
 	connections_.push_back(conn);
+
+	if (sigmap_ != nullptr) {
+		sigmap_->add(conn.first, conn.second);
+		if (SigMapStats::enabled)
+			SigMapStats::cache_updates++;
+	}
 }
 
 void RTLIL::Module::connect(const RTLIL::SigSpec &lhs, const RTLIL::SigSpec &rhs)
@@ -1581,6 +1810,17 @@ void RTLIL::Module::new_connections(const std::vector<RTLIL::SigSig> &new_conn)
 		log_backtrace("-X- ", yosys_xtrace-1);
 	}
 
+	// keep the cached SigMap if the new connections only append to the old ones
+	if (sigmap_ != nullptr) {
+		if (GetSize(new_conn) >= GetSize(connections_) && std::equal(connections_.begin(), connections_.end(), new_conn.begin())) {
+			for (int i = GetSize(connections_); i < GetSize(new_conn); i++)
+				sigmap_->add(new_conn[i].first, new_conn[i].second);
+			if (SigMapStats::enabled)
+				SigMapStats::cache_updates++;
+		} else
+			invalidate_sigmap();
+	}
+
 	connections_ = new_conn;
 }
 
@@ -1589,6 +1829,28 @@ const std::vector<RTLIL::SigSig> &RTLIL::Module::connections() const
 	return connections_;
 }
 
+const SigMap &RTLIL::Module::sigmap()
+{
+	log_assert(!RTLIL::IdString::multi_threaded);
+	if (sigmap_ == nullptr) {
+		sigmap_ = new SigMap;
+		sigmap_->build(this);
+		if (SigMapStats::enabled)
+			SigMapStats::cache_builds++;
+	}
+	return *sigmap_;
+}
+
+void RTLIL::Module::invalidate_sigmap()
+{
+	if (sigmap_ != nullptr) {
+		delete sigmap_;
+		sigmap_ = nullptr;
+		if (SigMapStats::enabled)
+			SigMapStats::cache_invalidations++;
+	}
+}
+
 void RTLIL::Module::fixup_ports()
 {
 	std::vector<RTLIL::Wire*> all_ports;
@@ -2174,11 +2436,28 @@ RTLIL::SigSpec RTLIL::Module::Initstate(RTLIL::IdString name, const std::string
 	return sig;
 }
 
+#ifdef YOSYS_ENABLE_THREADS
+// the memhasher is global state that is shared by the parallel_for() workers
+static std::mutex memhasher_mutex;
+#endif
+
+// objects that are created by a parallel_for() job take their hash index from
+// the sequence of the job, so that it does not depend on the other jobs
+static inline unsigned int next_hashidx(unsigned int &hashidx_count)
+{
+	ParallelForJob *job = ParallelForJob::current;
+	if (job != nullptr) {
+		job->hashidx = mkhash_xorshift(job->hashidx);
+		return job->hashidx;
+	}
+	hashidx_count = mkhash_xorshift(hashidx_count);
+	return hashidx_count;
+}
+
 RTLIL::Wire::Wire()
 {
 	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	hashidx_ = next_hashidx(hashidx_count);
 
 	module = nullptr;
 	width = 1;
@@ -2192,8 +2471,7 @@ RTLIL::Wire::Wire()
 RTLIL::Memory::Memory()
 {
 	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	hashidx_ = next_hashidx(hashidx_count);
 
 	width = 1;
 	start_offset = 0;
@@ -2203,11 +2481,15 @@ RTLIL::Memory::Memory()
 RTLIL::Cell::Cell() : module(nullptr)
 {
 	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	hashidx_ = next_hashidx(hashidx_count);
 
 	// log("#memtrace# %p\n", this);
-	memhasher();
+	if (memhasher_active) {
+#ifdef YOSYS_ENABLE_THREADS
+		std::lock_guard<std::mutex> lock(memhasher_mutex);
+#endif
+		memhasher_do();
+	}
 }
 
 bool RTLIL::Cell::hasPort(RTLIL::IdString portname) const
@@ -24,6 +24,8 @@
 
 YOSYS_NAMESPACE_BEGIN
 
+struct SigMap;
+
 namespace RTLIL
 {
 	enum State : unsigned char {
@@ -57,6 +59,7 @@ namespace RTLIL
 	struct AttrObject;
 	struct Selection;
 	struct Monitor;
+	struct ModuleDict;
 	struct Design;
 	struct Module;
 	struct Wire;
@@ -84,14 +87,143 @@ namespace RTLIL
 			~destruct_guard_t() { ok = false; }
 		} destruct_guard;
 
-		static std::vector<int> global_refcount_storage_;
-		static std::vector<char*> global_id_storage_;
-		static dict<char*, int, hash_cstr_ops> global_id_index_;
+		// The strings and reference counts are stored in fixed-size chunks that are
+		// allocated on demand and never moved, so c_str() and the reference counting
+		// never need a lock. The string -> index map is split in shards. While
+		// parallel_for() is running worker threads, each shard is protected by its
+		// own lock, reference counts are updated atomically and ids that drop to a
+		// refcount of zero are only freed when the workers are finished (see
+		// flush_free_list()).
+		//
+		// operator<() compares the order keys of the ids. The key of a new id is
+		// its index, and a re-used index keeps its key. The indices of the ids
+		// that are created by parallel_for() jobs depend on the timing of the
+		// threads, so when the jobs are finished these ids get the keys they
+		// would have got if the jobs had run one after another (see job_ids_t and
+		// commit_job_ids()). While the jobs are still running, two such ids
+		// compare by index, so a job must not make its result depend on the
+		// order of the ids it shares with other jobs. hash() uses the index,
+		// which does not change the iteration order of the hashlib containers.
+		//
+		// The chunks are found via a two-level table: global_storage_dirs_ has one
+		// entry for each storage_dir_size chunks and the directories are also
+		// allocated on demand, so that the table only takes a few kB until many
+		// ids are actually used.
+
+		struct storage_entry_t {
+			std::atomic<char*> str;
+			std::atomic<int> refcount;
+			std::atomic<int> order;
+		};
+
+		struct shard_t {
+			dict<char*, int, hash_cstr_ops> index;
+#ifdef YOSYS_ENABLE_THREADS
+			std::mutex mutex;
+#endif
+		};
+
+		enum {
+			storage_chunk_bits = 12,
+			storage_chunk_size = 1 << storage_chunk_bits,
+			storage_dir_bits = 10,
+			storage_dir_size = 1 << storage_dir_bits,
+			storage_max_dirs = 0x40000000 >> (storage_chunk_bits + storage_dir_bits),
+			num_shards = 16,
+			// refcount values at or above this are immortal ids (see immortal_scope_t)
+			immortal_refcount = 0x40000000,
+			immortal_threshold = 0x20000000
+		};
+
+		typedef std::atomic<storage_entry_t*> storage_dir_t[storage_dir_size];
+
+		static std::atomic<storage_dir_t*> global_storage_dirs_[storage_max_dirs];
+		static std::atomic<int> global_storage_size_;
+		static shard_t global_shards_[num_shards];
 		static std::vector<int> global_free_idx_list_;
 
+		static bool multi_threaded;
+		static std::vector<int> global_pending_free_list_;
+#ifdef YOSYS_ENABLE_THREADS
+		static std::mutex global_pending_free_mutex_;
+#endif
+
+		// the ids that did not exist before the parallel_for() jobs were started
+		// and that are created or used by the job of the current thread, in the
+		// order in which the job first uses them. while jobs are running, free
+		// indices are not re-used and ids are freed in flush_free_list().
+
+		struct job_ids_t {
+			pool<int> seen;
+			std::vector<int> indices;
+
+			void add(int idx) {
+				if (seen.insert(idx).second)
+					indices.push_back(idx);
+			}
+		};
+
+		static thread_local job_ids_t *job_ids_;
+		static int job_first_index_;
+
+		// Ids that are created or looked up by a thread while an immortal_scope_t
+		// object exists in that thread are never freed and copying them does not
+		// touch the reference count. This is used for the names created by frontends.
+
+		static thread_local int immortal_depth;
+
+		struct immortal_scope_t {
+			bool enabled;
+			immortal_scope_t(bool enabled = true) : enabled(enabled) { if (enabled) immortal_depth++; }
+			~immortal_scope_t() { if (enabled) immortal_depth--; }
+		};
+
+		static inline storage_entry_t &global_entry(int idx)
+		{
+			storage_dir_t *dir = global_storage_dirs_[idx >> (storage_chunk_bits + storage_dir_bits)].load(std::memory_order_acquire);
+			storage_entry_t *chunk = (*dir)[(idx >> storage_chunk_bits) & (storage_dir_size-1)].load(std::memory_order_acquire);
+			return chunk[idx & (storage_chunk_size-1)];
+		}
+
+		static inline shard_t &global_shard(const char *p)
+		{
+			// only look at the length and two characters of the string here, so
+			// that the full string is only hashed once (by the dict of the shard)
+			size_t len = strlen(p);
+			if (len == 0)
+				return global_shards_[0];
+			unsigned int h = len * 31 + (unsigned char)p[len-1] * 7 + (unsigned char)p[len/2];
+			return global_shards_[h % num_shards];
+		}
+
+		struct shard_lock_t {
+#ifdef YOSYS_ENABLE_THREADS
+			std::mutex *mutex;
+			shard_lock_t(shard_t &shard) : mutex(multi_threaded ? &shard.mutex : nullptr) { if (mutex) mutex->lock(); }
+			~shard_lock_t() { if (mutex) mutex->unlock(); }
+#else
+			shard_lock_t(shard_t&) { }
+#endif
+		};
+
+		static int alloc_index();
+
+		static inline void inc_refcount(storage_entry_t &entry)
+		{
+			int refcount = entry.refcount.load(std::memory_order_relaxed);
+			if (refcount >= immortal_threshold)
+				return;
+			if (multi_threaded)
+				entry.refcount.fetch_add(1, std::memory_order_relaxed);
+			else
+				entry.refcount.store(refcount + 1, std::memory_order_relaxed);
+		}
+
 		static inline int get_reference(int idx)
 		{
-			global_refcount_storage_.at(idx)++;
+			inc_refcount(global_entry(idx));
+			if (job_ids_ && idx >= job_first_index_)
+				job_ids_->add(idx);
 			return idx;
 		}
 
@@ -104,30 +236,36 @@ namespace RTLIL
 				log_assert(p[0] == '$' || p[0] == '\\');
 			}
 
-			auto it = global_id_index_.find((char*)p);
-			if (it != global_id_index_.end()) {
-				global_refcount_storage_.at(it->second)++;
+			shard_t &shard = global_shard(p);
+			shard_lock_t lock(shard);
+
+			auto it = shard.index.find((char*)p);
+			if (it != shard.index.end()) {
+				storage_entry_t &entry = global_entry(it->second);
+				if (immortal_depth && entry.refcount.load(std::memory_order_relaxed) < immortal_threshold)
+					entry.refcount.fetch_add(immortal_refcount, std::memory_order_relaxed);
+				inc_refcount(entry);
+				if (job_ids_ && it->second >= job_first_index_)
+					job_ids_->add(it->second);
 				return it->second;
 			}
 
-			if (global_free_idx_list_.empty()) {
-				log_assert(global_id_storage_.size() < 0x40000000);
-				global_free_idx_list_.push_back(global_id_storage_.size());
-				global_id_storage_.push_back(nullptr);
-				global_refcount_storage_.push_back(0);
-			}
+			int idx = alloc_index();
+			storage_entry_t &entry = global_entry(idx);
+			entry.str.store(strdup(p), std::memory_order_relaxed);
+			entry.refcount.store(immortal_depth ? immortal_refcount : 1, std::memory_order_relaxed);
+			shard.index[entry.str.load(std::memory_order_relaxed)] = idx;
 
-			int idx = global_free_idx_list_.back();
-			global_free_idx_list_.pop_back();
-			global_id_storage_.at(idx) = strdup(p);
-			global_id_index_[global_id_storage_.at(idx)] = idx;
-			global_refcount_storage_.at(idx)++;
+			if (job_ids_)
+				job_ids_->add(idx);
 
 			// Avoid Create->Delete->Create pattern
-			static IdString last_created_id;
-			put_reference(last_created_id.index_);
-			last_created_id.index_ = idx;
-			get_reference(last_created_id.index_);
+			if (!multi_threaded && !job_ids_ && !immortal_depth) {
+				static IdString last_created_id;
+				put_reference(last_created_id.index_);
+				last_created_id.index_ = idx;
+				get_reference(last_created_id.index_);
+			}
 
 			if (yosys_xtrace) {
 				log("#X# New IdString '%s' with index %d.\n", p, idx);
@@ -140,26 +278,52 @@ namespace RTLIL
 		static inline void put_reference(int idx)
 		{
 			// put_reference() may be called from destructors after the destructor of
-			// global_refcount_storage_ has been run. in this case we simply do nothing.
+			// global_shards_ has been run. in this case we simply do nothing.
 			if (!destruct_guard.ok)
 				return;
 
-			log_assert(global_refcount_storage_.at(idx) > 0);
+			storage_entry_t &entry = global_entry(idx);
+			int refcount = entry.refcount.load(std::memory_order_relaxed);
+
+			if (refcount >= immortal_threshold)
+				return;
+
+			log_assert(refcount > 0);
 
-			if (--global_refcount_storage_.at(idx) != 0)
+			if (multi_threaded || job_ids_) {
+				if (entry.refcount.fetch_sub(1, std::memory_order_relaxed) == 1) {
+#ifdef YOSYS_ENABLE_THREADS
+					std::lock_guard<std::mutex> lock(global_pending_free_mutex_);
+#endif
+					global_pending_free_list_.push_back(idx);
+				}
 				return;
+			}
+
+			entry.refcount.store(refcount - 1, std::memory_order_relaxed);
+			if (refcount == 1)
+				free_reference(idx);
+		}
+
+		static inline void free_reference(int idx)
+		{
+			storage_entry_t &entry = global_entry(idx);
+			char *p = entry.str.load(std::memory_order_relaxed);
 
 			if (yosys_xtrace) {
-				log("#X# Removed IdString '%s' with index %d.\n", global_id_storage_.at(idx), idx);
+				log("#X# Removed IdString '%s' with index %d.\n", p, idx);
 				log_backtrace("-X- ", yosys_xtrace-1);
 			}
 
-			global_id_index_.erase(global_id_storage_.at(idx));
-			free(global_id_storage_.at(idx));
-			global_id_storage_.at(idx) = nullptr;
+			global_shard(p).index.erase(p);
+			entry.str.store(nullptr, std::memory_order_relaxed);
+			free(p);
 			global_free_idx_list_.push_back(idx);
 		}
 
+		static void commit_job_ids(const std::vector<job_ids_t*> &jobs);
+		static void flush_free_list();
+
 		// the actual IdString object is just is a single int
 
 		int index_;
@@ -186,15 +350,16 @@ namespace RTLIL
 		}
 
 		const char *c_str() const {
-			return global_id_storage_.at(index_);
+			return global_entry(index_).str.load(std::memory_order_relaxed);
 		}
 
 		std::string str() const {
-			return std::string(global_id_storage_.at(index_));
+			return std::string(c_str());
 		}
 
 		bool operator<(const IdString &rhs) const {
-			return index_ < rhs.index_;
+			return global_entry(index_).order.load(std::memory_order_relaxed) <
+					global_entry(rhs.index_).order.load(std::memory_order_relaxed);
 		}
 
 		bool operator==(const IdString &rhs) const { return index_ == rhs.index_; }
@@ -793,6 +958,33 @@ struct RTLIL::Monitor
 	virtual void notify_blackout(RTLIL::Module*) { }
 };
 
+// The modules of a design. A module can be shared by several designs (see
+// "design -save"). The non-const accessors below replace a shared module with
+// a private copy before they hand it out, see RTLIL::Design::unshare_module().
+// base() gives access to the modules without copying them.
+struct RTLIL::ModuleDict : public dict<RTLIL::IdString, RTLIL::Module*>
+{
+	typedef dict<RTLIL::IdString, RTLIL::Module*> base_t;
+	RTLIL::Design *design;
+
+	ModuleDict(RTLIL::Design *design) : design(design) { }
+
+	base_t &base() { return *this; }
+	const base_t &base() const { return *this; }
+
+	iterator begin();
+	const_iterator begin() const { return base_t::begin(); }
+
+	iterator find(const RTLIL::IdString &key);
+	const_iterator find(const RTLIL::IdString &key) const { return base_t::find(key); }
+
+	RTLIL::Module *&at(const RTLIL::IdString &key);
+	RTLIL::Module *const &at(const RTLIL::IdString &key) const { return base_t::at(key); }
+	RTLIL::Module *at(const RTLIL::IdString &key, RTLIL::Module *defval) const { return base_t::at(key, defval); }
+
+	RTLIL::Module *&operator[](const RTLIL::IdString &key);
+};
+
 struct RTLIL::Design
 {
 	unsigned int hashidx_;
@@ -802,7 +994,13 @@ struct RTLIL::Design
 	dict<std::string, std::string> scratchpad;
 
 	int refcount_modules_;
-	dict<RTLIL::IdString, RTLIL::Module*> modules_;
+	RTLIL::ModuleDict modules_;
+
+	// set while a command with Pass::readonly_modules runs on the design (and
+	// for the designs kept by the "design" command): shared modules are then
+	// handed out without copying them
+	bool readonly_modules_;
+
 	std::vector<AST::AstNode*> verilog_packages, verilog_globals;
 	dict<std::string, std::pair<std::string, bool>> verilog_defines;
 
@@ -826,6 +1024,18 @@ struct RTLIL::Design
 	void remove(RTLIL::Module *module);
 	void rename(RTLIL::Module *module, RTLIL::IdString new_name);
 
+	// a module can be shared by several designs (see "design -save"). shared
+	// modules must not be modified, so modules(), module(), selected_modules()
+	// and the non-const accessors of modules_ call unshare_module() to replace
+	// a shared module with a private copy when they hand it out. only the
+	// modules a command actually gets hold of are copied. release() drops the
+	// reference of this design to a module (that has already been removed
+	// from modules_) and deletes it if it is unused.
+	void share(RTLIL::Module *module);
+	void unshare_module(RTLIL::Module *&module);
+	void unshare_modules();
+	void release(RTLIL::Module *module);
+
 	void scratchpad_unset(std::string varname);
 
 	void scratchpad_set_int(std::string varname, int value);
@@ -895,10 +1105,18 @@ public:
 	int refcount_wires_;
 	int refcount_cells_;
 
+	// number of designs using this module in addition to the first one
+	int refcount_shared_;
+
 	dict<RTLIL::IdString, RTLIL::Wire*> wires_;
 	dict<RTLIL::IdString, RTLIL::Cell*> cells_;
 	std::vector<RTLIL::SigSig> connections_;
 
+	// cached SigMap for connections_, see sigmap() below. code that modifies
+	// connections_ directly must call invalidate_sigmap(), code that renames
+	// wires without rename() or swap_names() must call notify_rename_wires().
+	SigMap *sigmap_;
+
 	RTLIL::IdString name;
 	pool<RTLIL::IdString> avail_parameters;
 	dict<RTLIL::IdString, RTLIL::Memory*> memories;
@@ -918,12 +1136,23 @@ public:
 	void new_connections(const std::vector<RTLIL::SigSig> &new_conn);
 	const std::vector<RTLIL::SigSig> &connections() const;
 
+	// the canonical SigMap for the module connections. it is built on first
+	// use and kept up to date by connect() and new_connections(). the returned
+	// reference becomes invalid when the connections are replaced, wires are
+	// removed or renamed, or rewrite_sigspecs() is called. building it is not
+	// thread-safe, so it must not be called from parallel_for() workers.
+	const SigMap &sigmap();
+	void invalidate_sigmap();
+	void notify_rename_wires();
+
 	std::vector<RTLIL::IdString> ports;
 	void fixup_ports();
 
 	template<typename T> void rewrite_sigspecs(T &functor);
 	void cloneInto(RTLIL::Module *new_mod) const;
 	virtual RTLIL::Module *clone() const;
+	// like clone(), but the copy iterates wires, cells, etc. in the same order
+	RTLIL::Module *clone_ordered() const;
 
 	bool has_memories() const;
 	bool has_processes() const;
@@ -1309,6 +1538,7 @@ inline RTLIL::SigBit::SigBit(const RTLIL::SigSpec &sig) {
 template<typename T>
 void RTLIL::Module::rewrite_sigspecs(T &functor)
 {
+	invalidate_sigmap();
 	for (auto &it : cells_)
 		it.second->rewrite_sigspecs(functor);
 	for (auto &it : processes)
@@ -57,8 +57,99 @@ struct SatSolver
 	}
 };
 
+// returns nullptr if there is no solver with this name (see 'help satsolver')
+static inline SatSolver *find_satsolver(const string &name)
+{
+	for (auto solver = yosys_satsolver_list; solver != nullptr; solver = solver->next)
+		if (solver->name == name)
+			return solver;
+	return nullptr;
+}
+
 struct ezSatPtr : public std::unique_ptr<ezSAT> {
-	ezSatPtr() : unique_ptr<ezSAT>(yosys_satsolver->create()) { }
+	ezSatPtr(SatSolver *solver = nullptr) : unique_ptr<ezSAT>((solver ? solver : yosys_satsolver)->create()) { }
+};
+
+// Resource limits for each SAT solver query of a pass, set with the -timeout,
+// -conflict-limit and -propagation-limit options, and the resources used by
+// the queries so far. A query that runs out of budget returns false, so the
+// passes must check out_of_budget() before treating that as a proof.
+struct SatBudget
+{
+	ezSAT::SolverBudget limits, total;
+	int queries, failed_queries;
+
+	SatBudget() : queries(0), failed_queries(0) { }
+
+	bool parse_arg(const std::vector<std::string> &args, size_t &argidx)
+	{
+		if (args[argidx] == "-timeout" && argidx+1 < args.size()) {
+			limits.seconds = atof(args[++argidx].c_str());
+			return true;
+		}
+		if (args[argidx] == "-conflict-limit" && argidx+1 < args.size()) {
+			limits.conflicts = atoll(args[++argidx].c_str());
+			return true;
+		}
+		if (args[argidx] == "-propagation-limit" && argidx+1 < args.size()) {
+			limits.propagations = atoll(args[++argidx].c_str());
+			return true;
+		}
+		return false;
+	}
+
+	bool limited() const {
+		return limits.seconds > 0 || limits.conflicts > 0 || limits.propagations > 0;
+	}
+
+	void setup(ezSAT *ez) const {
+		ez->setSolverBudget(limits);
+	}
+
+	// call after each query, returns true if the query ran out of budget
+	bool out_of_budget(ezSAT *ez)
+	{
+		const ezSAT::SolverBudget &used = ez->getSolverUsage();
+		total.seconds += used.seconds;
+		total.conflicts += used.conflicts;
+		total.propagations += used.propagations;
+		queries++;
+		if (!ez->getSolverTimoutStatus())
+			return false;
+		failed_queries++;
+		return true;
+	}
+
+	void merge(const SatBudget &other)
+	{
+		total.seconds += other.total.seconds;
+		total.conflicts += other.total.conflicts;
+		total.propagations += other.total.propagations;
+		queries += other.queries;
+		failed_queries += other.failed_queries;
+	}
+
+	// resources used by the last query, e.g. "0.12 of 10.00 sec, 1234 conflicts, 56789 propagations"
+	std::string usage(ezSAT *ez) const
+	{
+		const ezSAT::SolverBudget &used = ez->getSolverUsage();
+		std::string str = stringf("%.2f", used.seconds);
+		if (limits.seconds > 0)
+			str += stringf(" of %.2f", limits.seconds);
+		str += stringf(" sec, %lld", (long long)used.conflicts);
+		if (limits.conflicts > 0)
+			str += stringf(" of %lld", (long long)limits.conflicts);
+		str += stringf(" conflicts, %lld", (long long)used.propagations);
+		if (limits.propagations > 0)
+			str += stringf(" of %lld", (long long)limits.propagations);
+		return str + " propagations";
+	}
+
+	void log_stats(const char *prefix) const
+	{
+		log("%s%d SAT queries (%d out of budget), %.2f sec, %lld conflicts, %lld propagations.\n", prefix, queries,
+				failed_queries, total.seconds, (long long)total.conflicts, (long long)total.propagations);
+	}
 };
 
 struct SatGen
@@ -69,7 +160,7 @@ struct SatGen
 	SigPool initial_state;
 	std::map<std::string, RTLIL::SigSpec> asserts_a, asserts_en;
 	std::map<std::string, RTLIL::SigSpec> assumes_a, assumes_en;
-	std::map<std::string, std::map<RTLIL::SigBit, int>> imported_signals;
+	std::map<std::string, dict<RTLIL::SigBit, int>> imported_signals;
 	std::map<std::pair<std::string, int>, bool> initstates;
 	bool ignore_div_by_zero;
 	bool model_undef;
@@ -93,6 +184,10 @@ struct SatGen
 		std::vector<int> vec;
 		vec.reserve(GetSize(sig));
 
+		// signals that have been imported before are looked up by SigBit, so
+		// that the literal name only needs to be created once
+		dict<RTLIL::SigBit, int> &imported = imported_signals[pf];
+
 		for (auto &bit : sig)
 			if (bit.wire == NULL) {
 				if (model_undef && dup_undef && bit == RTLIL::State::Sx)
@@ -100,9 +195,14 @@ struct SatGen
 				else
 					vec.push_back(bit == (undef_mode ? RTLIL::State::Sx : RTLIL::State::S1) ? ez->CONST_TRUE : ez->CONST_FALSE);
 			} else {
+				auto it = imported.find(bit);
+				if (it != imported.end()) {
+					vec.push_back(it->second);
+					continue;
+				}
 				std::string name = pf + (bit.wire->width == 1 ? stringf("%s", log_id(bit.wire)) : stringf("%s [%d]", log_id(bit.wire->name), bit.offset));
 				vec.push_back(ez->frozen_literal(name));
-				imported_signals[pf][bit] = vec.back();
+				imported[bit] = vec.back();
 			}
 		return vec;
 	}
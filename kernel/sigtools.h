@@ -220,6 +220,16 @@ struct SigSet
 	}
 };
 
+// Counters for SigMap::set() and the per-module SigMap cache (see
+// RTLIL::Module::sigmap() and "test_sigmap -stats"). They are only
+// updated while 'enabled' is set.
+struct SigMapStats
+{
+	static bool enabled, cache_enabled;
+	static std::atomic<int64_t> set_count, set_ns, set_bits;
+	static std::atomic<int64_t> cache_builds, cache_updates, cache_invalidations;
+};
+
 struct SigMap
 {
 	mfp<SigBit> database;
@@ -240,7 +250,30 @@ struct SigMap
 		database.clear();
 	}
 
+	// copy the module's cached SigMap (or build a new one when the cache
+	// is disabled with "test_sigmap -nocache"). the cache is built lazily,
+	// so it is not used while parallel_for() is running worker threads.
 	void set(RTLIL::Module *module)
+	{
+		if (SigMapStats::enabled) {
+			int64_t begin_ns = PerformanceTimer::query();
+			set_worker(module);
+			SigMapStats::set_count++;
+			SigMapStats::set_ns += PerformanceTimer::query() - begin_ns;
+			SigMapStats::set_bits += database.size();
+		} else
+			set_worker(module);
+	}
+
+	void set_worker(RTLIL::Module *module)
+	{
+		if (SigMapStats::cache_enabled && !RTLIL::IdString::multi_threaded)
+			*this = module->sigmap();
+		else
+			build(module);
+	}
+
+	void build(RTLIL::Module *module)
 	{
 		int bitcount = 0;
 		for (auto &it : module->connections())
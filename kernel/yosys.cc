@@ -50,6 +50,13 @@
 #  include <glob.h>
 #endif
 
+#ifdef YOSYS_ENABLE_THREADS
+#  include <thread>
+#  include <mutex>
+#  include <condition_variable>
+#  include <exception>
+#endif
+
 #include <limits.h>
 #include <errno.h>
 
@@ -57,6 +64,7 @@ YOSYS_NAMESPACE_BEGIN
 
 int autoidx = 1;
 int yosys_xtrace = 0;
+int yosys_threads = 1;
 RTLIL::Design *yosys_design = NULL;
 CellTypes yosys_celltypes;
 
@@ -527,9 +535,191 @@ RTLIL::IdString new_id(std::string file, int line, std::string func)
 	if (pos != std::string::npos)
 		func = func.substr(pos+1);
 
+	ParallelForJob *job = ParallelForJob::current;
+	if (job != nullptr)
+		return stringf("$auto$%s:%d:%s$%d.%d", file.c_str(), line, func.c_str(), job->autoidx, job->next_id++);
+
 	return stringf("$auto$%s:%d:%s$%d", file.c_str(), line, func.c_str(), autoidx++);
 }
 
+thread_local ParallelForJob *ParallelForJob::current = nullptr;
+
+struct ParallelForJobScope
+{
+	ParallelForJobScope(ParallelForJob *job) {
+		ParallelForJob::current = job;
+		RTLIL::IdString::job_ids_ = &job->ids;
+	}
+	~ParallelForJobScope() {
+		ParallelForJob::current = nullptr;
+		RTLIL::IdString::job_ids_ = nullptr;
+	}
+};
+
+static void parallel_for_commit(std::vector<ParallelForJob> &jobs)
+{
+	std::vector<RTLIL::IdString::job_ids_t*> job_ids;
+	for (auto &job : jobs)
+		job_ids.push_back(&job.ids);
+
+	RTLIL::IdString::commit_job_ids(job_ids);
+	RTLIL::IdString::flush_free_list();
+}
+
+#ifdef YOSYS_ENABLE_THREADS
+struct ParallelForState
+{
+	const std::function<void(int)> *worker;
+	std::vector<ParallelForJob> *jobs;
+	int num_jobs, next_job, done_prefix, running_threads;
+	bool failed;
+
+	std::vector<bool> done;
+	std::vector<LogCapture> captures;
+	std::vector<std::exception_ptr> exceptions;
+
+	std::mutex mutex;
+	std::condition_variable cond;
+};
+
+static void parallel_for_thread(ParallelForState *state)
+{
+	while (1)
+	{
+		int job;
+
+		{
+			std::lock_guard<std::mutex> lock(state->mutex);
+			if (state->failed || state->next_job == state->num_jobs)
+				break;
+			job = state->next_job++;
+		}
+
+		log_capture = &state->captures[job];
+
+		try {
+			ParallelForJobScope job_scope(&state->jobs->at(job));
+			(*state->worker)(job);
+		} catch (...) {
+			state->exceptions[job] = std::current_exception();
+		}
+
+		log_capture = nullptr;
+
+		std::lock_guard<std::mutex> lock(state->mutex);
+		if (state->exceptions[job])
+			state->failed = true;
+		state->done[job] = true;
+		while (state->done_prefix < state->num_jobs && state->done[state->done_prefix])
+			state->done_prefix++;
+		state->cond.notify_all();
+	}
+
+	std::lock_guard<std::mutex> lock(state->mutex);
+	state->running_threads--;
+	state->cond.notify_all();
+}
+#endif
+
+void parallel_for(int num_jobs, const std::function<void(int)> &worker, int num_threads)
+{
+	if (num_threads <= 0)
+		num_threads = yosys_threads;
+	num_threads = min(num_threads, num_jobs);
+
+	// nested calls simply run the jobs in the current thread, as part of the
+	// calling job. the log output of a nested call is buffered as part of the
+	// log output of the calling job.
+	if (num_jobs <= 1 || ParallelForJob::current != nullptr) {
+		for (int job = 0; job < num_jobs; job++)
+			worker(job);
+		return;
+	}
+
+	// the per-job sequences are also used for a serial run, so that the
+	// result is the same for any number of threads
+	std::vector<ParallelForJob> jobs(num_jobs);
+	for (int job = 0; job < num_jobs; job++) {
+		jobs[job].autoidx = autoidx++;
+		jobs[job].next_id = 1;
+		jobs[job].hashidx = mkhash_xorshift(mkhash(123456789, jobs[job].autoidx) | 1);
+	}
+	RTLIL::IdString::job_first_index_ = RTLIL::IdString::global_storage_size_.load();
+
+#ifdef YOSYS_ENABLE_THREADS
+	if (num_threads > 1)
+	{
+		ParallelForState state;
+		state.worker = &worker;
+		state.jobs = &jobs;
+		state.num_jobs = num_jobs;
+		state.next_job = 0;
+		state.done_prefix = 0;
+		state.running_threads = num_threads;
+		state.failed = false;
+		state.done.resize(num_jobs);
+		state.captures.resize(num_jobs);
+		state.exceptions.resize(num_jobs);
+
+		RTLIL::IdString::multi_threaded = true;
+
+		std::vector<std::thread> threads;
+		for (int i = 0; i < num_threads; i++)
+			threads.push_back(std::thread(parallel_for_thread, &state));
+
+		// jobs are replayed in order up to the first job that failed. later
+		// jobs have either not been started or their output is discarded.
+		std::exception_ptr exception;
+		std::string error;
+		int replayed = 0;
+
+		while (exception == nullptr)
+		{
+			int first = replayed, last;
+
+			{
+				std::unique_lock<std::mutex> lock(state.mutex);
+				state.cond.wait(lock, [&]() { return state.done_prefix > replayed || state.running_threads == 0; });
+				last = state.done_prefix;
+			}
+
+			if (first == last)
+				break;
+
+			for (int job = first; job < last && exception == nullptr; job++) {
+				state.captures[job].replay();
+				exception = state.exceptions[job];
+				error = state.captures[job].error;
+				replayed = job + 1;
+			}
+		}
+
+		for (auto &thread : threads)
+			thread.join();
+
+		RTLIL::IdString::multi_threaded = false;
+		parallel_for_commit(jobs);
+
+		if (!error.empty())
+			log_error("%s", error.c_str());
+		if (exception != nullptr)
+			std::rethrow_exception(exception);
+		return;
+	}
+#endif
+
+	try {
+		for (int job = 0; job < num_jobs; job++) {
+			ParallelForJobScope job_scope(&jobs[job]);
+			worker(job);
+		}
+	} catch (...) {
+		parallel_for_commit(jobs);
+		throw;
+	}
+	parallel_for_commit(jobs);
+}
+
 RTLIL::Design *yosys_get_design()
 {
 	return yosys_design;
@@ -979,14 +1169,14 @@ static char *readline_obj_generator(const char *text, int state)
 
 		if (design->selected_active_module.empty())
 		{
-			for (auto &it : design->modules_)
+			for (auto &it : design->modules_.base())
 				if (RTLIL::unescape_id(it.first).substr(0, len) == text)
 					obj_names.push_back(strdup(RTLIL::id2cstr(it.first)));
 		}
 		else
 		if (design->modules_.count(design->selected_active_module) > 0)
 		{
-			RTLIL::Module *module = design->modules_.at(design->selected_active_module);
+			RTLIL::Module *module = design->modules_.base().at(design->selected_active_module);
 
 			for (auto &it : module->wires_)
 				if (RTLIL::unescape_id(it.first).substr(0, len) == text)
@@ -1124,7 +1314,7 @@ struct ShellPass : public Pass {
 
 #if defined(YOSYS_ENABLE_READLINE) || defined(YOSYS_ENABLE_EDITLINE)
 struct HistoryPass : public Pass {
-	HistoryPass() : Pass("history", "show last interactive commands") { }
+	HistoryPass() : Pass("history", "show last interactive commands") { readonly_modules = true; }
 	virtual void help() {
 		log("\n");
 		log("    history\n");
@@ -1148,7 +1338,7 @@ struct HistoryPass : public Pass {
 #endif
 
 struct ScriptCmdPass : public Pass {
-	ScriptCmdPass() : Pass("script", "execute commands from script file") { }
+	ScriptCmdPass() : Pass("script", "execute commands from script file") { readonly_modules = true; }
 	virtual void help() {
 		log("\n");
 		log("    script <filename> [<from_label>:<to_label>]\n");
@@ -46,6 +46,7 @@
 #include <string>
 #include <algorithm>
 #include <functional>
+#include <atomic>
 #include <unordered_map>
 #include <unordered_set>
 #include <initializer_list>
@@ -59,6 +60,10 @@
 #include <ostream>
 #include <iostream>
 
+#ifdef YOSYS_ENABLE_THREADS
+#  include <mutex>
+#endif
+
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
@@ -258,6 +263,7 @@ int GetSize(RTLIL::Wire *wire);
 
 extern int autoidx;
 extern int yosys_xtrace;
+extern int yosys_threads;
 
 YOSYS_NAMESPACE_END
 
@@ -289,6 +295,30 @@ RTLIL::IdString new_id(std::string file, int line, std::string func);
 #define NEW_ID \
 	YOSYS_NAMESPACE_PREFIX new_id(__FILE__, __LINE__, __FUNCTION__)
 
+// Run worker(0) .. worker(num_jobs-1) on up to num_threads threads (0 means the
+// default set with "yosys -j"). The log output of each job is buffered and then
+// written in job order. An error (exception or log_error()) in a job stops all
+// jobs that have not been started yet and is reported after the log output of
+// the jobs before it, like in a serial run.
+//
+// With more than one job, the names created by NEW_ID and the hash indices of
+// new RTLIL objects are taken from per-job sequences (see ParallelForJob), so
+// that the result does not depend on the number of threads or on the order in
+// which the jobs are run.
+void parallel_for(int num_jobs, const std::function<void(int)> &worker, int num_threads = 0);
+
+// The parallel_for() job that is run by the current thread. NEW_ID names in job
+// <n> are "$auto$<file>:<line>:<func>$<autoidx>.<i>", with one autoidx value
+// reserved for each job and a counter <i> for the names created by the job.
+struct ParallelForJob
+{
+	int autoidx, next_id;
+	unsigned int hashidx;
+	RTLIL::IdString::job_ids_t ids;
+
+	static thread_local ParallelForJob *current;
+};
+
 #define ID(_str) \
 	([]() { static YOSYS_NAMESPACE_PREFIX RTLIL::IdString _id(_str); return _id; })()
 
@@ -0,0 +1,234 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Copyright (C) 2013  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "ezcmdline.h"
+
+#include <chrono>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <signal.h>
+#  include <sys/wait.h>
+#endif
+
+ezCmdlineSAT::ezCmdlineSAT(const std::string &command) : command(command)
+{
+	// the solver process gets the full CNF for each call
+	keep_cnf();
+}
+
+ezCmdlineSAT::~ezCmdlineSAT()
+{
+}
+
+#ifdef _WIN32
+bool ezCmdlineSAT::solver(const std::vector<int>&, std::vector<bool>&, const std::vector<int>&)
+{
+	preSolverCallback();
+	fprintf(stderr, "ezCmdlineSAT: running external SAT solvers is not supported on this platform.\n");
+	abort();
+}
+#else
+bool ezCmdlineSAT::solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions)
+{
+	preSolverCallback();
+
+	solverTimoutStatus = false;
+	solverUsage = SolverBudget();
+
+	std::vector<int> extraClauses, modelIdx;
+
+	for (auto id : assumptions)
+		extraClauses.push_back(bind(id));
+	for (auto id : modelExpressions)
+		modelIdx.push_back(bind(id));
+
+	std::vector<std::vector<int>> cnf;
+	getFullCnf(cnf);
+
+	// the CNF is written to an unlinked temporary file that becomes the stdin
+	// of the solver. unlike a pipe this can not block or raise SIGPIPE when the
+	// solver does not read all of its input.
+
+	char tmp_filename[] = "/tmp/ezsat-XXXXXX";
+	int cnf_fd = mkstemp(tmp_filename);
+	if (cnf_fd < 0) {
+		fprintf(stderr, "ezCmdlineSAT: can't create temporary file: %s\n", strerror(errno));
+		abort();
+	}
+	unlink(tmp_filename);
+
+	FILE *f = fdopen(cnf_fd, "w+");
+	fprintf(f, "p cnf %d %d\n", numCnfVariables(), int(cnf.size() + extraClauses.size()));
+	for (auto &clause : cnf) {
+		for (auto idx : clause)
+			fprintf(f, "%d ", idx);
+		fprintf(f, "0\n");
+	}
+	for (auto idx : extraClauses)
+		fprintf(f, "%d 0\n", idx);
+	fflush(f);
+	lseek(cnf_fd, 0, SEEK_SET);
+
+	int out_pipe[2];
+	if (pipe(out_pipe) < 0) {
+		fprintf(stderr, "ezCmdlineSAT: can't create pipe: %s\n", strerror(errno));
+		abort();
+	}
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		fprintf(stderr, "ezCmdlineSAT: can't fork: %s\n", strerror(errno));
+		abort();
+	}
+
+	if (pid == 0) {
+		// own process group, so that a timeout also kills the children of the shell
+		setpgid(0, 0);
+		dup2(cnf_fd, 0);
+		dup2(out_pipe[1], 1);
+		close(out_pipe[0]);
+		close(out_pipe[1]);
+		execl("/bin/sh", "sh", "-c", command.c_str(), (char*)NULL);
+		_exit(127);
+	}
+
+	fclose(f);
+	close(out_pipe[1]);
+
+	std::string output;
+	bool timeout = false;
+
+	while (1)
+	{
+		int timeout_ms = -1;
+		if (solverBudget.seconds > 0) {
+			double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+			if (elapsed >= solverBudget.seconds) {
+				timeout = true;
+				break;
+			}
+			timeout_ms = int(1000 * (solverBudget.seconds - elapsed)) + 1;
+		}
+
+		struct pollfd pfd;
+		pfd.fd = out_pipe[0];
+		pfd.events = POLLIN;
+		int ret = poll(&pfd, 1, timeout_ms);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret == 0)
+			continue;
+
+		char buffer[4096];
+		ssize_t n = ret < 0 ? -1 : read(out_pipe[0], buffer, sizeof(buffer));
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		output.append(buffer, n);
+	}
+
+	close(out_pipe[0]);
+	if (timeout)
+		kill(-pid, SIGKILL);
+
+	int status = 0;
+	while (waitpid(pid, &status, 0) < 0 && errno == EINTR) { }
+
+	solverUsage.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+	// parse the solver output. the exit codes 10 and 20 are the SAT competition
+	// convention for SAT and UNSAT and are used when there is no "s" line.
+
+	int result = 0;
+	bool found_model = false;
+	std::vector<int> model(numCnfVariables() + 1);
+
+	for (size_t pos = 0; pos < output.size();)
+	{
+		size_t eol = output.find('\n', pos);
+		if (eol == std::string::npos)
+			eol = output.size();
+		std::string line = output.substr(pos, eol - pos);
+		pos = eol + 1;
+
+		if (line.compare(0, 2, "s ") == 0) {
+			if (line.find("UNSATISFIABLE") != std::string::npos)
+				result = 20;
+			else if (line.find("SATISFIABLE") != std::string::npos)
+				result = 10;
+		}
+
+		if (line.compare(0, 2, "v ") == 0) {
+			found_model = true;
+			const char *p = line.c_str() + 1;
+			char *endptr;
+			for (long lit = strtol(p, &endptr, 10); endptr != p; lit = strtol(p, &endptr, 10)) {
+				if (lit != 0 && labs(lit) < long(model.size()))
+					model[labs(lit)] = lit > 0 ? 1 : -1;
+				p = endptr;
+			}
+		}
+	}
+
+	if (result == 0 && !timeout && WIFEXITED(status) && (WEXITSTATUS(status) == 10 || WEXITSTATUS(status) == 20))
+		result = WEXITSTATUS(status);
+
+	if (result == 0 && !timeout)
+		fprintf(stderr, "ezCmdlineSAT: no result from SAT solver `%s' (exit status %d).\n", command.c_str(),
+				WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+
+	if (result == 10 && !found_model && !modelIdx.empty()) {
+		fprintf(stderr, "ezCmdlineSAT: SAT solver `%s' did not print a model.\n", command.c_str());
+		result = 0;
+	}
+
+	if (result == 0) {
+		solverTimoutStatus = true;
+		return false;
+	}
+
+	if (result == 20)
+		return false;
+
+	modelValues.clear();
+	modelValues.resize(modelIdx.size());
+
+	for (size_t i = 0; i < modelIdx.size(); i++)
+	{
+		int idx = modelIdx[i];
+		bool refvalue = true;
+
+		if (idx < 0)
+			idx = -idx, refvalue = false;
+
+		modelValues[i] = (model.at(idx) > 0) == refvalue;
+	}
+
+	return true;
+}
+#endif
@@ -0,0 +1,46 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Copyright (C) 2013  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef EZCMDLINE_H
+#define EZCMDLINE_H
+
+#include "ezsat.h"
+
+// runs an external SAT solver binary for each call of solver(). the full CNF
+// (see getFullCnf()) is passed to the solver on stdin in DIMACS format, with
+// the assumptions as unit clauses, and the result is read from its stdout in
+// the format of the SAT competition ("s SATISFIABLE" and "v ..." lines). the
+// command is run using "/bin/sh -c", so it can contain options and arguments.
+//
+// only the time budget is supported (the solver process is killed when it
+// runs out of time). all answers other than SAT and UNSAT are reported as
+// timeouts, so they are never mistaken for a proof.
+
+class ezCmdlineSAT : public ezSAT
+{
+private:
+	std::string command;
+
+public:
+	ezCmdlineSAT(const std::string &command);
+	virtual ~ezCmdlineSAT();
+	virtual bool solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions);
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Copyright (C) 2013  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "ezipasir.h"
+
+#include <chrono>
+
+static double wall_time()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ezIpasirSAT::ezIpasirSAT(const ezIpasirFunctions &ipasir) : ipasir(ipasir), ipasirSolver(NULL), deadline(0)
+{
+}
+
+ezIpasirSAT::~ezIpasirSAT()
+{
+	if (ipasirSolver != NULL)
+		ipasir.release(ipasirSolver);
+}
+
+void ezIpasirSAT::clear()
+{
+	if (ipasirSolver != NULL) {
+		ipasir.release(ipasirSolver);
+		ipasirSolver = NULL;
+	}
+	ezSAT::clear();
+}
+
+int ezIpasirSAT::terminate_callback(void *data)
+{
+	ezIpasirSAT *that = (ezIpasirSAT*)data;
+	return that->deadline > 0 && wall_time() > that->deadline;
+}
+
+bool ezIpasirSAT::solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions)
+{
+	preSolverCallback();
+
+	solverTimoutStatus = false;
+	solverUsage = SolverBudget();
+
+	std::vector<int> extraClauses, modelIdx;
+
+	for (auto id : assumptions)
+		extraClauses.push_back(bind(id));
+	for (auto id : modelExpressions)
+		modelIdx.push_back(bind(id));
+
+	if (ipasirSolver == NULL) {
+		ipasirSolver = ipasir.init();
+		if (ipasir.set_terminate != NULL)
+			ipasir.set_terminate(ipasirSolver, this, terminate_callback);
+	}
+
+	std::vector<std::vector<int>> cnf;
+	consumeCnf(cnf);
+
+	for (auto &clause : cnf) {
+		for (auto idx : clause)
+			ipasir.add(ipasirSolver, idx);
+		ipasir.add(ipasirSolver, 0);
+	}
+
+	for (auto idx : extraClauses)
+		ipasir.assume(ipasirSolver, idx);
+
+	double start_time = wall_time();
+	deadline = solverBudget.seconds > 0 ? start_time + solverBudget.seconds : 0;
+	int result = ipasir.solve(ipasirSolver);
+	solverUsage.seconds = wall_time() - start_time;
+
+	if (result != 10) {
+		// 0 means that the solver was interrupted by the terminate callback
+		if (result != 20)
+			solverTimoutStatus = true;
+		return false;
+	}
+
+	modelValues.clear();
+	modelValues.resize(modelIdx.size());
+
+	for (size_t i = 0; i < modelIdx.size(); i++)
+	{
+		int idx = modelIdx[i];
+		bool refvalue = true;
+
+		if (idx < 0)
+			idx = -idx, refvalue = false;
+
+		modelValues[i] = (ipasir.val(ipasirSolver, idx) > 0) == refvalue;
+	}
+
+	return true;
+}
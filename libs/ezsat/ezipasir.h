@@ -0,0 +1,62 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Copyright (C) 2013  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef EZIPASIR_H
+#define EZIPASIR_H
+
+#include "ezsat.h"
+
+// the functions of the IPASIR interface for incremental SAT solvers (see the
+// SAT race 2015). ezIpasirSAT calls the solver through this table, so it works
+// with a solver that is linked into the program as well as with one that is
+// loaded from a shared library. set_terminate may be NULL.
+
+struct ezIpasirFunctions
+{
+	const char *(*signature)();
+	void *(*init)();
+	void (*release)(void *solver);
+	void (*add)(void *solver, int32_t lit_or_zero);
+	void (*assume)(void *solver, int32_t lit);
+	int (*solve)(void *solver);
+	int32_t (*val)(void *solver, int32_t lit);
+	void (*set_terminate)(void *solver, void *data, int (*terminate)(void *data));
+};
+
+// the ezSAT cnf variables are used as IPASIR variables and the clauses are
+// added incrementally. only the time budget is supported, using the terminate
+// callback of the solver.
+
+class ezIpasirSAT : public ezSAT
+{
+private:
+	const ezIpasirFunctions &ipasir;
+	void *ipasirSolver;
+	double deadline;
+
+	static int terminate_callback(void *data);
+
+public:
+	ezIpasirSAT(const ezIpasirFunctions &ipasir);
+	virtual ~ezIpasirSAT();
+	virtual void clear();
+	virtual bool solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions);
+};
+
+#endif
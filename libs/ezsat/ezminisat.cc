@@ -29,12 +29,8 @@
 
 #include <limits.h>
 #include <stdint.h>
-#include <csignal>
 #include <cinttypes>
-
-#ifndef _WIN32
-#  include <unistd.h>
-#endif
+#include <chrono>
 
 #include "../minisat/Solver.h"
 #include "../minisat/SimpSolver.h"
@@ -84,25 +80,12 @@ bool ezMiniSAT::eliminated(int idx)
 }
 #endif
 
-#ifndef _WIN32
-ezMiniSAT *ezMiniSAT::alarmHandlerThis = NULL;
-clock_t ezMiniSAT::alarmHandlerTimeout = 0;
-
-void ezMiniSAT::alarmHandler(int)
-{
-	if (clock() > alarmHandlerTimeout) {
-		alarmHandlerThis->minisatSolver->interrupt();
-		alarmHandlerTimeout = 0;
-	} else
-		alarm(1);
-}
-#endif
-
 bool ezMiniSAT::solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions)
 {
 	preSolverCallback();
 
 	solverTimoutStatus = false;
+	solverUsage = SolverBudget();
 
 	if (0) {
 contradiction:
@@ -183,34 +166,30 @@ contradiction:
 #endif
 	}
 
-#ifndef _WIN32
-	struct sigaction sig_action;
-	struct sigaction old_sig_action;
-	int old_alarm_timeout = 0;
-
-	if (solverTimeout > 0) {
-		sig_action.sa_handler = alarmHandler;
-		sigemptyset(&sig_action.sa_mask);
-		sig_action.sa_flags = SA_RESTART;
-		alarmHandlerThis = this;
-		alarmHandlerTimeout = clock() + solverTimeout*CLOCKS_PER_SEC;
-		old_alarm_timeout = alarm(0);
-		sigaction(SIGALRM, &sig_action, &old_sig_action);
-		alarm(1);
-	}
-#endif
-
-	bool foundSolution = minisatSolver->solve(assumps);
-
-#ifndef _WIN32
-	if (solverTimeout > 0) {
-		if (alarmHandlerTimeout == 0)
-			solverTimoutStatus = true;
-		alarm(0);
-		sigaction(SIGALRM, &old_sig_action, NULL);
-		alarm(old_alarm_timeout);
-	}
-#endif
+	// the budget is checked by minisat in its search loop. this does not need
+	// any signals or other process-wide state, so solvers in different threads
+	// can have different budgets.
+	minisatSolver->budgetOff();
+	if (solverBudget.conflicts > 0)
+		minisatSolver->setConfBudget(solverBudget.conflicts);
+	if (solverBudget.propagations > 0)
+		minisatSolver->setPropBudget(solverBudget.propagations);
+	if (solverBudget.seconds > 0)
+		minisatSolver->setTimeBudget(solverBudget.seconds);
+
+	uint64_t start_conflicts = minisatSolver->conflicts;
+	uint64_t start_propagations = minisatSolver->propagations;
+	auto start_time = std::chrono::steady_clock::now();
+
+	Minisat::lbool result = minisatSolver->solveLimited(assumps);
+
+	solverUsage.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	solverUsage.conflicts = minisatSolver->conflicts - start_conflicts;
+	solverUsage.propagations = minisatSolver->propagations - start_propagations;
+
+	bool foundSolution = (result == Minisat::lbool(true));
+	if (!foundSolution && result != Minisat::lbool(false))
+		solverTimoutStatus = true;
 
 	if (!foundSolution) {
 #if !EZMINISAT_INCREMENTAL
@@ -25,7 +25,6 @@
 #define EZMINISAT_INCREMENTAL 1
 
 #include "ezsat.h"
-#include <time.h>
 
 // minisat is using limit macros and format macros in their headers that
 // can be the source of some troubles when used from c++11. thefore we
@@ -51,12 +50,6 @@ private:
 	std::set<int> cnfFrozenVars;
 #endif
 
-#ifndef _WIN32
-	static ezMiniSAT *alarmHandlerThis;
-	static clock_t alarmHandlerTimeout;
-	static void alarmHandler(int);
-#endif
-
 public:
 	ezMiniSAT();
 	virtual ~ezMiniSAT();
@@ -53,9 +53,10 @@ ezSAT::ezSAT()
 	cnfVariableCount = 0;
 	cnfClausesCount = 0;
 
-	solverTimeout = 0;
 	solverTimoutStatus = false;
 
+	namedLiteralsCount = 0;
+
 	literal("CONST_TRUE");
 	literal("CONST_FALSE");
 
@@ -83,13 +84,49 @@ int ezSAT::literal()
 	return literals.size();
 }
 
+unsigned int ezSAT::hash_literal(const std::string &name)
+{
+	unsigned int h = 5381;
+	for (auto c : name)
+		h = ((h << 5) + h) ^ (unsigned char)c;
+	return h;
+}
+
+void ezSAT::rehash_literals()
+{
+	std::vector<int> oldCache;
+	oldCache.swap(literalsCache);
+	literalsCache.resize(oldCache.empty() ? 64 : 2*oldCache.size());
+	unsigned int mask = literalsCache.size() - 1;
+
+	for (int id : oldCache) {
+		if (id == 0)
+			continue;
+		unsigned int h = hash_literal(literals[id-1]) & mask;
+		while (literalsCache[h] != 0)
+			h = (h + 1) & mask;
+		literalsCache[h] = id;
+	}
+}
+
 int ezSAT::literal(const std::string &name)
 {
-	if (literalsCache.count(name) == 0) {
-		literals.push_back(name);
-		literalsCache[name] = literals.size();
+	if (2*(namedLiteralsCount+1) > int(literalsCache.size()))
+		rehash_literals();
+
+	unsigned int mask = literalsCache.size() - 1;
+	unsigned int h = hash_literal(name) & mask;
+
+	while (literalsCache[h] != 0) {
+		if (literals[literalsCache[h]-1] == name)
+			return literalsCache[h];
+		h = (h + 1) & mask;
 	}
-	return literalsCache.at(name);
+
+	literals.push_back(name);
+	literalsCache[h] = literals.size();
+	namedLiteralsCount++;
+	return literals.size();
 }
 
 int ezSAT::frozen_literal()
@@ -106,6 +143,31 @@ int ezSAT::frozen_literal(const std::string &name)
 	return id;
 }
 
+unsigned int ezSAT::hash_expression(OpId op, const std::vector<int> &args)
+{
+	// FNV-1a over the operands, followed by the murmur3 finalizer so that the
+	// low bits used for the table index depend on all operands
+	unsigned int h = 2166136261u ^ op;
+	for (auto arg : args)
+		h = (h ^ (unsigned int)arg) * 16777619u;
+	h ^= h >> 16, h *= 0x85ebca6b;
+	h ^= h >> 13, h *= 0xc2b2ae35;
+	return h ^ (h >> 16);
+}
+
+void ezSAT::rehash_expressions()
+{
+	expressionsCache.assign(expressionsCache.empty() ? 64 : 2*expressionsCache.size(), 0);
+	unsigned int mask = expressionsCache.size() - 1;
+
+	for (int i = 0; i < int(expressions.size()); i++) {
+		unsigned int h = hash_expression(expressions[i].first, expressions[i].second) & mask;
+		while (expressionsCache[h] != 0)
+			h = (h + 1) & mask;
+		expressionsCache[h] = -i-1;
+	}
+}
+
 int ezSAT::expression(OpId op, int a, int b, int c, int d, int e, int f)
 {
 	std::vector<int> args(6);
@@ -202,15 +264,26 @@ int ezSAT::expression(OpId op, const std::vector<int> &args)
 		abort();
 	}
 
-	std::pair<OpId, std::vector<int>> myExpr(op, myArgs);
+	if (2*(int(expressions.size())+1) > int(expressionsCache.size()))
+		rehash_expressions();
+
+	unsigned int mask = expressionsCache.size() - 1;
+	unsigned int h = hash_expression(op, myArgs) & mask;
 	int id = 0;
 
-	if (expressionsCache.count(myExpr) > 0) {
-		id = expressionsCache.at(myExpr);
-	} else {
+	while (expressionsCache[h] != 0) {
+		const std::pair<OpId, std::vector<int>> &expr = expressions[-expressionsCache[h]-1];
+		if (expr.first == op && expr.second == myArgs) {
+			id = expressionsCache[h];
+			break;
+		}
+		h = (h + 1) & mask;
+	}
+
+	if (id == 0) {
 		id = -(int(expressions.size()) + 1);
-		expressionsCache[myExpr] = id;
-		expressions.push_back(myExpr);
+		expressionsCache[h] = id;
+		expressions.push_back(std::pair<OpId, std::vector<int>>(op, myArgs));
 	}
 
 	if (xorRemovedOddTrues)
@@ -1302,16 +1375,18 @@ void ezSAT::printInternalState(FILE *f) const
 	fprintf(f, "--8<-- snip --8<--\n");
 
 	fprintf(f, "literalsCache:\n");
-	for (auto &it : literalsCache)
-		fprintf(f, "    `%s' -> %d\n", it.first.c_str(), it.second);
+	for (auto id : literalsCache)
+		if (id != 0)
+			fprintf(f, "    `%s' -> %d\n", literals[id-1].c_str(), id);
 
 	fprintf(f, "literals:\n");
 	for (int i = 0; i < int(literals.size()); i++)
 		fprintf(f, "    %d: `%s'\n", i+1, literals[i].c_str());
 
 	fprintf(f, "expressionsCache:\n");
-	for (auto &it : expressionsCache)
-		fprintf(f, "    `%s' -> %d\n", expression2str(it.first).c_str(), it.second);
+	for (auto id : expressionsCache)
+		if (id != 0)
+			fprintf(f, "    `%s' -> %d\n", expression2str(expressions[-id-1]).c_str(), id);
 
 	fprintf(f, "expressions:\n");
 	for (int i = 0; i < int(expressions.size()); i++)
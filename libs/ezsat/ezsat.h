@@ -54,12 +54,22 @@ private:
 
 	bool non_incremental_solve_used_up;
 
-	std::map<std::string, int> literalsCache;
+	// literalsCache and expressionsCache are open addressing hash tables
+	// with a power-of-two size. they hold the ids of the named literals and
+	// of all expressions, with zero marking an empty slot.
+
+	std::vector<int> literalsCache;
 	std::vector<std::string> literals;
+	int namedLiteralsCount;
 
-	std::map<std::pair<OpId, std::vector<int>>, int> expressionsCache;
+	std::vector<int> expressionsCache;
 	std::vector<std::pair<OpId, std::vector<int>>> expressions;
 
+	static unsigned int hash_literal(const std::string &name);
+	static unsigned int hash_expression(OpId op, const std::vector<int> &args);
+	void rehash_literals();
+	void rehash_expressions();
+
 	bool cnfConsumed;
 	int cnfVariableCount, cnfClausesCount;
 	std::vector<int> cnfLiteralVariables, cnfExpressionVariables;
@@ -77,7 +87,16 @@ protected:
 	void preSolverCallback();
 
 public:
-	int solverTimeout;
+	// resource limits for a single call of solver() (zero means no limit)
+	// and the resources used by the last call. the limits are checked by the
+	// solver backend in its search loop, so each instance has its own limits.
+	struct SolverBudget {
+		double seconds;
+		int64_t conflicts, propagations;
+		SolverBudget() : seconds(0), conflicts(0), propagations(0) { }
+	};
+
+	SolverBudget solverBudget, solverUsage;
 	bool solverTimoutStatus;
 
 	ezSAT();
@@ -150,9 +169,23 @@ public:
 	}
 
 	void setSolverTimeout(int newTimeoutSeconds) {
-		solverTimeout = newTimeoutSeconds;
+		solverBudget.seconds = newTimeoutSeconds;
+	}
+
+	void setSolverBudget(const SolverBudget &newBudget) {
+		solverBudget = newBudget;
+	}
+
+	const SolverBudget &getSolverBudget() const {
+		return solverBudget;
+	}
+
+	const SolverBudget &getSolverUsage() const {
+		return solverUsage;
 	}
 
+	// true if the last call of solver() ran out of budget. the result of
+	// that call is false and does not mean that there is no solution.
 	bool getSolverTimoutStatus() {
 		return solverTimoutStatus;
 	}
@@ -25,6 +25,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 **************************************************************************************************/
 
 #include <math.h>
+#include <chrono>
 
 #include "Alg.h"
 #include "Sort.h"
@@ -106,6 +107,9 @@ Solver::Solver() :
     //
   , conflict_budget    (-1)
   , propagation_budget (-1)
+  , time_budget        (-1)
+  , time_budget_checks (0)
+  , time_budget_exceeded (false)
   , asynch_interrupt   (false)
 {}
 
@@ -115,6 +119,21 @@ Solver::~Solver()
 }
 
 
+double Solver::wallTime()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// Reading the clock is much more expensive than a decision, so it is only done every 256 calls.
+bool Solver::withinTimeBudget() const
+{
+    if (!time_budget_exceeded && (++time_budget_checks & 255) == 0 && wallTime() >= time_budget)
+        time_budget_exceeded = true;
+    return !time_budget_exceeded;
+}
+
+
 //=================================================================================================
 // Minor methods:
 
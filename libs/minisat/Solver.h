@@ -107,6 +107,7 @@ public:
     //
     void    setConfBudget(int64_t x);
     void    setPropBudget(int64_t x);
+    void    setTimeBudget(double x);  // Wall-clock time in seconds, checked in the search loop.
     void    budgetOff();
     void    interrupt();          // Trigger a (potentially asynchronous) interruption of the solver.
     void    clearInterrupt();     // Clear interrupt indicator flag.
@@ -234,6 +235,9 @@ protected:
     //
     int64_t             conflict_budget;    // -1 means no budget.
     int64_t             propagation_budget; // -1 means no budget.
+    double              time_budget;        // -1 means no budget, otherwise the deadline (see wallTime()).
+    mutable uint64_t    time_budget_checks;
+    mutable bool        time_budget_exceeded;
     bool                asynch_interrupt;
 
     // Main internal methods:
@@ -279,11 +283,14 @@ protected:
     int      level            (Var x) const;
     double   progressEstimate ()      const; // DELETE THIS ?? IT'S NOT VERY USEFUL ...
     bool     withinBudget     ()      const;
+    bool     withinTimeBudget ()      const;
     void     relocAll         (ClauseAllocator& to);
 
     // Static helpers:
     //
 
+    static double wallTime();         // Wall-clock time in seconds, for the time budget.
+
     // Returns a random float 0 <= x < 1. Seed must never be 0.
     static inline double drand(double& seed) {
         seed *= 1389796;
@@ -370,11 +377,13 @@ inline void     Solver::setConfBudget(int64_t x){ conflict_budget    = conflicts
 inline void     Solver::setPropBudget(int64_t x){ propagation_budget = propagations + x; }
 inline void     Solver::interrupt(){ asynch_interrupt = true; }
 inline void     Solver::clearInterrupt(){ asynch_interrupt = false; }
-inline void     Solver::budgetOff(){ conflict_budget = propagation_budget = -1; }
+inline void     Solver::setTimeBudget(double x){ time_budget = wallTime() + x; time_budget_exceeded = false; }
+inline void     Solver::budgetOff(){ conflict_budget = propagation_budget = -1; time_budget = -1; }
 inline bool     Solver::withinBudget() const {
     return !asynch_interrupt &&
            (conflict_budget    < 0 || conflicts < (uint64_t)conflict_budget) &&
-           (propagation_budget < 0 || propagations < (uint64_t)propagation_budget); }
+           (propagation_budget < 0 || propagations < (uint64_t)propagation_budget) &&
+           (time_budget        < 0 || withinTimeBudget()); }
 
 // FIXME: after the introduction of asynchronous interrruptions the solve-versions that return a
 // pure bool do not give a safe interface. Either interrupts must be possible to turn off here, or
@@ -26,7 +26,7 @@ std::map<std::string, RTLIL::Design*> saved_designs;
 std::vector<RTLIL::Design*> pushed_designs;
 
 struct DesignPass : public Pass {
-	DesignPass() : Pass("design", "save, restore and reset current design") { }
+	DesignPass() : Pass("design", "save, restore and reset current design") { readonly_modules = true; }
 	virtual ~DesignPass() {
 		for (auto &it : saved_designs)
 			delete it.second;
@@ -48,6 +48,11 @@ struct DesignPass : public Pass {
 		log("\n");
 		log("Save the current design under the given name.\n");
 		log("\n");
+		log("Saved designs share their modules with the current design. A module is only\n");
+		log("copied when a command that may modify the current design accesses it, so\n");
+		log("saving, stashing, loading and copying whole modules (without -as) is cheap, and\n");
+		log("a command that works on a selection only copies the selected modules.\n");
+		log("\n");
 		log("\n");
 		log("    design -stash <name>\n");
 		log("\n");
@@ -158,8 +163,10 @@ struct DesignPass : public Pass {
 			}
 			if (!got_mode && args[argidx] == "-copy-to" && argidx+1 < args.size()) {
 				got_mode = true;
-				if (saved_designs.count(args[++argidx]) == 0)
+				if (saved_designs.count(args[++argidx]) == 0) {
 					saved_designs[args[argidx]] = new RTLIL::Design;
+					saved_designs[args[argidx]]->readonly_modules_ = true;
+				}
 				copy_to_design = saved_designs.at(args[argidx]);
 				copy_from_design = design;
 				continue;
@@ -231,7 +238,7 @@ struct DesignPass : public Pass {
 			dict<IdString, IdString> done;
 
 			if (copy_to_design->modules_.count(prefix))
-				delete copy_to_design->modules_.at(prefix);
+				copy_to_design->release(copy_to_design->modules_.at(prefix));
 
 			if (GetSize(copy_src_modules) != 1)
 				log_cmd_error("No top module found in source design.\n");
@@ -240,7 +247,7 @@ struct DesignPass : public Pass {
 			{
 				log("Importing %s as %s.\n", log_id(mod), log_id(prefix));
 
-				copy_to_design->modules_[prefix] = mod->clone();
+				copy_to_design->modules_[prefix] = mod->clone_ordered();
 				copy_to_design->modules_[prefix]->name = prefix;
 				copy_to_design->modules_[prefix]->design = copy_to_design;
 				copy_to_design->modules_[prefix]->attributes.erase("\\top");
@@ -269,9 +276,9 @@ struct DesignPass : public Pass {
 						log("Importing %s as %s.\n", log_id(fmod), log_id(trg_name));
 
 						if (copy_to_design->modules_.count(trg_name))
-							delete copy_to_design->modules_.at(trg_name);
+							copy_to_design->release(copy_to_design->modules_.at(trg_name));
 
-						copy_to_design->modules_[trg_name] = fmod->clone();
+						copy_to_design->modules_[trg_name] = fmod->clone_ordered();
 						copy_to_design->modules_[trg_name]->name = trg_name;
 						copy_to_design->modules_[trg_name]->design = copy_to_design;
 						copy_to_design->modules_[trg_name]->attributes.erase("\\top");
@@ -294,10 +301,20 @@ struct DesignPass : public Pass {
 			{
 				std::string trg_name = as_name.empty() ? mod->name.str() : RTLIL::escape_id(as_name);
 
-				if (copy_to_design->modules_.count(trg_name))
-					delete copy_to_design->modules_.at(trg_name);
+				if (copy_to_design->modules_.count(trg_name)) {
+					RTLIL::Module *old_mod = copy_to_design->modules_.at(trg_name);
+					copy_to_design->modules_.erase(trg_name);
+					copy_to_design->release(old_mod);
+				}
+
+				if (trg_name == mod->name.str()) {
+					if (copy_to_design == design)
+						mod->design = design;
+					copy_to_design->share(mod);
+					continue;
+				}
 
-				copy_to_design->modules_[trg_name] = mod->clone();
+				copy_to_design->modules_[trg_name] = mod->clone_ordered();
 				copy_to_design->modules_[trg_name]->name = trg_name;
 				copy_to_design->modules_[trg_name]->design = copy_to_design;
 			}
@@ -306,9 +323,10 @@ struct DesignPass : public Pass {
 		if (!save_name.empty() || push_mode)
 		{
 			RTLIL::Design *design_copy = new RTLIL::Design;
+			design_copy->readonly_modules_ = true;
 
 			for (auto &it : design->modules_)
-				design_copy->add(it.second->clone());
+				design_copy->share(it.second);
 
 			design_copy->selection_stack = design->selection_stack;
 			design_copy->selection_vars = design->selection_vars;
@@ -326,7 +344,7 @@ struct DesignPass : public Pass {
 		if (reset_mode || !load_name.empty() || push_mode || pop_mode)
 		{
 			for (auto &it : design->modules_)
-				delete it.second;
+				design->release(it.second);
 			design->modules_.clear();
 
 			design->selection_stack.clear();
@@ -353,8 +371,10 @@ struct DesignPass : public Pass {
 		{
 			RTLIL::Design *saved_design = pop_mode ? pushed_designs.back() : saved_designs.at(load_name);
 
-			for (auto &it : saved_design->modules_)
-				design->add(it.second->clone());
+			for (auto &it : saved_design->modules_) {
+				it.second->design = design;
+				design->share(it.second);
+			}
 
 			design->selection_stack = saved_design->selection_stack;
 			design->selection_vars = saved_design->selection_vars;
@@ -0,0 +1,104 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/register.h"
+#include "kernel/rtlil.h"
+#include "kernel/log.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct ProfilePass : public Pass {
+	ProfilePass() : Pass("profile", "print a hierarchical profile of a command") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    profile [-o file.json] cmd\n");
+		log("\n");
+		log("Execute the specified command and print a profile of all the commands that\n");
+		log("have been called by it, e.g. the individual steps of a 'synth' script. For\n");
+		log("each command the following values are reported:\n");
+		log("\n");
+		log("  - number of calls (calls from the same parent command are merged)\n");
+		log("  - wall time and CPU time (all threads) in seconds\n");
+		log("  - the increase of the peak resident set size in MB\n");
+		log("  - number of cells and wires in the design before the first call and\n");
+		log("    after the last call\n");
+		log("\n");
+		log("    -o file.json\n");
+		log("        also write the profile to the specified file in JSON format.\n");
+		log("\n");
+		log("Use 'yosys -P file.json' to write a profile of the entire run.\n");
+		log("\n");
+	}
+	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
+	{
+		std::string json_file;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-o" && argidx+1 < args.size()) {
+				json_file = args[++argidx];
+				continue;
+			}
+			break;
+		}
+
+		if (argidx == args.size())
+			cmd_error(args, argidx, "Missing command.");
+
+		// if the entire run is profiled (yosys -P) we just report the subtree for this command
+		bool own_profile = pass_profile == nullptr;
+		if (own_profile)
+			pass_profile = new PassProfile;
+		int node = pass_profile->current_node;
+
+		try {
+			std::vector<std::string> new_args(args.begin() + argidx, args.end());
+			Pass::call(design, new_args);
+		} catch (...) {
+			if (own_profile) {
+				delete pass_profile;
+				pass_profile = nullptr;
+			}
+			throw;
+		}
+
+		log_header(design, "Profile of command `%s'.\n", args[argidx].c_str());
+		log("\n");
+		pass_profile->log_report(node);
+
+		if (!json_file.empty()) {
+			FILE *f = fopen(json_file.c_str(), "w");
+			if (f == nullptr)
+				log_error("Can't open file `%s' for writing: %s\n", json_file.c_str(), strerror(errno));
+			pass_profile->write_json(f, node);
+			fclose(f);
+		}
+
+		if (own_profile) {
+			delete pass_profile;
+			pass_profile = nullptr;
+		}
+	}
+} ProfilePass;
+
+PRIVATE_NAMESPACE_END
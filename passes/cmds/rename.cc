@@ -137,6 +137,7 @@ struct RenamePass : public Pass {
 					new_wires[it.second->name] = it.second;
 				}
 				module->wires_.swap(new_wires);
+				module->notify_rename_wires();
 				module->fixup_ports();
 
 				dict<RTLIL::IdString, RTLIL::Cell*> new_cells;
@@ -168,6 +169,7 @@ struct RenamePass : public Pass {
 					new_wires[it.second->name] = it.second;
 				}
 				module->wires_.swap(new_wires);
+				module->notify_rename_wires();
 				module->fixup_ports();
 
 				dict<RTLIL::IdString, RTLIL::Cell*> new_cells;
@@ -42,9 +42,14 @@ struct EquivInductWorker
 	pool<Cell*> cell_warn_cache;
 	SigPool undriven_signals;
 
-	EquivInductWorker(Module *module, const pool<Cell*> &unproven_equiv_cells, bool model_undef, int max_seq) : module(module), sigmap(module),
-			cells(module->selected_cells()), workset(unproven_equiv_cells),
-			satgen(ez.get(), &sigmap), max_seq(max_seq), success_counter(0)
+	int last_num_clauses;
+	PerformanceTimer solve_timer;
+	SatBudget budget;
+	bool out_of_budget;
+
+	EquivInductWorker(Module *module, const pool<Cell*> &unproven_equiv_cells, bool model_undef, int max_seq, const SatBudget &budget) : module(module),
+			sigmap(module), cells(module->selected_cells()), workset(unproven_equiv_cells), satgen(ez.get(), &sigmap), max_seq(max_seq),
+			success_counter(0), last_num_clauses(0), budget(budget), out_of_budget(false)
 	{
 		satgen.model_undef = model_undef;
 	}
@@ -81,6 +86,29 @@ struct EquivInductWorker
 		ez_step_is_consistent[step] = ez->expression(ez->OpAnd, ez_equal_terms);
 	}
 
+	// the solver is kept between time steps (incl. learned clauses), only the
+	// clauses for the new time step are added before each call. the result is
+	// false when the solver runs out of budget, check out_of_budget for that.
+	bool solve(const char *what, int step, int assumption = 0)
+	{
+		log("  %s %d. (%d clauses over %d variables, %d new clauses)\n", what, step,
+				ez->numCnfClauses(), ez->numCnfVariables(), ez->numCnfClauses() - last_num_clauses);
+		last_num_clauses = ez->numCnfClauses();
+
+		PerformanceTimer timer;
+		timer.begin();
+		budget.setup(ez.get());
+		bool result = assumption ? ez->solve(assumption) : ez->solve();
+		out_of_budget = budget.out_of_budget(ez.get());
+		timer.end();
+
+		solve_timer.total_ns += timer.total_ns;
+		log("    %s in %.2f sec.\n", out_of_budget ? "Out of budget" : result ? "SAT" : "UNSAT", timer.sec());
+		if (budget.limited())
+			log("    SAT solver used %s.\n", budget.usage(ez.get()).c_str());
+		return result;
+	}
+
 	void run()
 	{
 		log("Found %d unproven $equiv cells in module %s:\n", GetSize(workset), log_id(module));
@@ -111,9 +139,11 @@ struct EquivInductWorker
 		{
 			ez->assume(ez_step_is_consistent[step]);
 
-			log("  Proving existence of base case for step %d. (%d clauses over %d variables)\n", step, ez->numCnfClauses(), ez->numCnfVariables());
-			if (!ez->solve()) {
-				log("  Proof for base case failed. Circuit inherently diverges!\n");
+			if (!solve("Proving existence of base case for step", step)) {
+				if (out_of_budget)
+					log("  Giving up on the base case.\n");
+				else
+					log("  Proof for base case failed. Circuit inherently diverges!\n");
 				return;
 			}
 
@@ -121,8 +151,7 @@ struct EquivInductWorker
 			int new_step_not_consistent = ez->NOT(ez_step_is_consistent[step+1]);
 			ez->bind(new_step_not_consistent);
 
-			log("  Proving induction step %d. (%d clauses over %d variables)\n", step, ez->numCnfClauses(), ez->numCnfVariables());
-			if (!ez->solve(new_step_not_consistent)) {
+			if (!solve("Proving induction step", step, new_step_not_consistent) && !out_of_budget) {
 				log("  Proof for induction step holds. Entire workset of %d cells proven!\n", GetSize(workset));
 				for (auto cell : workset)
 					cell->setPort("\\B", cell->getPort("\\A"));
@@ -149,7 +178,15 @@ struct EquivInductWorker
 			if (satgen.model_undef)
 				cond = ez->AND(cond, ez->NOT(satgen.importUndefSigBit(bit_a, max_seq+1)));
 
-			if (!ez->solve(cond)) {
+			solve_timer.begin();
+			budget.setup(ez.get());
+			bool result = ez->solve(cond);
+			out_of_budget = budget.out_of_budget(ez.get());
+			solve_timer.end();
+
+			if (out_of_budget) {
+				log(" out of budget.\n");
+			} else if (!result) {
 				log(" success!\n");
 				cell->setPort("\\B", cell->getPort("\\A"));
 				success_counter++;
@@ -179,6 +216,12 @@ struct EquivInductPass : public Pass {
 		log("    -seq <N>\n");
 		log("        the max. number of time steps to be considered (default = 4)\n");
 		log("\n");
+		log("    -timeout <N>\n");
+		log("    -conflict-limit <N>\n");
+		log("    -propagation-limit <N>\n");
+		log("        limit the seconds, conflicts or propagations of each SAT solver call.\n");
+		log("        a proof for which the solver runs out of budget is treated as failed.\n");
+		log("\n");
 		log("This command is very effective in proving complex sequential circuits, when\n");
 		log("the internal state of the circuit quickly propagates to $equiv cells.\n");
 		log("\n");
@@ -197,6 +240,7 @@ struct EquivInductPass : public Pass {
 		int success_counter = 0;
 		bool model_undef = false;
 		int max_seq = 4;
+		SatBudget budget;
 
 		log_header(design, "Executing EQUIV_INDUCT pass.\n");
 
@@ -210,6 +254,8 @@ struct EquivInductPass : public Pass {
 				max_seq = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (budget.parse_arg(args, argidx))
+				continue;
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -229,9 +275,13 @@ struct EquivInductPass : public Pass {
 				continue;
 			}
 
-			EquivInductWorker worker(module, unproven_equiv_cells, model_undef, max_seq);
+			EquivInductWorker worker(module, unproven_equiv_cells, model_undef, max_seq, budget);
 			worker.run();
 			success_counter += worker.success_counter;
+
+			log("  Total SAT solver time for module %s: %.2f sec.\n", log_id(module), worker.solve_timer.sec());
+			if (budget.limited())
+				worker.budget.log_stats("  SAT solver: ");
 		}
 
 		log("Proved %d previously unproven $equiv cells.\n", success_counter);
@@ -19,6 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/satgen.h"
+#include "kernel/randsim.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -39,10 +40,21 @@ struct EquivSimpleWorker
 	bool verbose;
 
 	pool<pair<Cell*, int>> imported_cells_cache;
-
-	EquivSimpleWorker(const vector<Cell*> &equiv_cells, SigMap &sigmap, dict<SigBit, Cell*> &bit2driver, int max_seq, bool short_cones, bool verbose, bool model_undef) :
+	vector<Cell*> proven_cells;
+	int sat_calls;
+	SatBudget &budget;
+
+	// cells with a known counterexample from the random simulation, and the
+	// values of the simulation inputs in the models of failed proofs
+	const RandomSim *sim;
+	const pool<Cell*> &disproved_cells;
+	vector<dict<pair<SigBit, int>, bool>> &counterexamples;
+
+	EquivSimpleWorker(const vector<Cell*> &equiv_cells, SigMap &sigmap, dict<SigBit, Cell*> &bit2driver, int max_seq, bool short_cones, bool verbose, bool model_undef,
+			SatBudget &budget, const RandomSim *sim, const pool<Cell*> &disproved_cells, vector<dict<pair<SigBit, int>, bool>> &counterexamples) :
 			module(equiv_cells.front()->module), equiv_cells(equiv_cells), equiv_cell(nullptr),
-			sigmap(sigmap), bit2driver(bit2driver), satgen(ez.get(), &sigmap), max_seq(max_seq), short_cones(short_cones), verbose(verbose)
+			sigmap(sigmap), bit2driver(bit2driver), satgen(ez.get(), &sigmap), max_seq(max_seq), short_cones(short_cones), verbose(verbose),
+			sat_calls(0), budget(budget), sim(sim), disproved_cells(disproved_cells), counterexamples(counterexamples)
 	{
 		satgen.model_undef = model_undef;
 	}
@@ -120,6 +132,24 @@ struct EquivSimpleWorker
 			log("  Trying to prove $equiv for %s:", log_signal(equiv_cell->getPort("\\Y")));
 		}
 
+		// a counterexample from the simulation is a model for the SAT problems in
+		// all time steps. the cells are still imported so that the solver state
+		// for the remaining cells in this group does not change.
+		bool disproved = disproved_cells.count(equiv_cell) != 0;
+		bool out_of_budget = false;
+		if (disproved && verbose)
+			log("    Random simulation found a counterexample, not calling the SAT solver.\n");
+
+		vector<pair<SigBit, int>> ce_bits;
+		vector<int> ce_vars;
+		vector<bool> ce_model;
+		if (sim != nullptr && !disproved)
+			for (auto bit : { bit_a, bit_b })
+				if (sim->is_input(bit, max_seq)) {
+					ce_bits.push_back(pair<SigBit, int>(bit, max_seq));
+					ce_vars.push_back(satgen.importSigBit(bit, max_seq+1));
+				}
+
 		int step = max_seq;
 		while (1)
 		{
@@ -189,6 +219,16 @@ struct EquivSimpleWorker
 				imported_cells_cache.insert(key);
 			}
 
+			if (sim != nullptr && !disproved)
+				for (auto cell : problem_cells)
+					for (auto &conn : cell->connections())
+						if (yosys_celltypes.cell_input(cell->type, conn.first))
+							for (auto bit : sigmap(conn.second))
+								if (sim->is_input(bit, step)) {
+									ce_bits.push_back(pair<SigBit, int>(bit, step));
+									ce_vars.push_back(satgen.importSigBit(bit, step+1));
+								}
+
 			if (satgen.model_undef) {
 				for (auto bit : input_bits)
 					ez->assume(ez->NOT(satgen.importUndefSigBit(bit, step+1)));
@@ -197,9 +237,25 @@ struct EquivSimpleWorker
 			if (verbose)
 				log("    Problem size at t=%d: %d literals, %d clauses\n", step, ez->numCnfVariables(), ez->numCnfClauses());
 
-			if (!ez->solve(ez_context)) {
+			bool found_model = disproved;
+			if (!disproved) {
+				sat_calls++;
+				budget.setup(ez.get());
+				found_model = ez->solve(ce_vars, ce_model, ez_context);
+				out_of_budget = budget.out_of_budget(ez.get());
+				if (verbose)
+					log("    SAT solver used %s.\n", budget.usage(ez.get()).c_str());
+			}
+
+			if (out_of_budget) {
+				if (verbose)
+					log("    SAT solver ran out of budget, giving up.\n");
+				break;
+			}
+
+			if (!found_model) {
 				log(verbose ? "    Proved equivalence! Marking $equiv cell as proven.\n" : " success!\n");
-				equiv_cell->setPort("\\B", equiv_cell->getPort("\\A"));
+				proven_cells.push_back(equiv_cell);
 				ez->assume(ez->NOT(ez_context));
 				return true;
 			}
@@ -245,7 +301,14 @@ struct EquivSimpleWorker
 		}
 
 		if (!verbose)
-			log(" failed.\n");
+			log(out_of_budget ? " out of budget.\n" : " failed.\n");
+
+		if (sim != nullptr && !disproved && !out_of_budget) {
+			dict<pair<SigBit, int>, bool> ce;
+			for (int i = 0; i < GetSize(ce_bits); i++)
+				ce[ce_bits[i]] = ce_model[i];
+			counterexamples.push_back(ce);
+		}
 
 		ez->assume(ez->NOT(ez_context));
 		return false;
@@ -297,12 +360,33 @@ struct EquivSimplePass : public Pass {
 		log("    -seq <N>\n");
 		log("        the max. number of time steps to be considered (default = 1)\n");
 		log("\n");
+		log("    -nosim\n");
+		log("        do not use random simulation to find counterexamples for $equiv cells\n");
+		log("        before calling the SAT solver for them.\n");
+		log("\n");
+		log("    -timeout <N>\n");
+		log("    -conflict-limit <N>\n");
+		log("    -propagation-limit <N>\n");
+		log("        limit the seconds, conflicts or propagations of each SAT solver call.\n");
+		log("        $equiv cells for which the solver runs out of budget stay unproven.\n");
+		log("        the resources used by each call are printed in verbose mode.\n");
+		log("\n");
+		log("    -j <threads>\n");
+		log("        prove groups of $equiv cells on up to <threads> threads, each with\n");
+		log("        its own SAT solver. (default: value of 'yosys -j')\n");
+		log("\n");
+		log("The $equiv cells are only marked as proven after all proofs in a module are\n");
+		log("done, i.e. all proofs see the module as it was before equiv_simple. Therefore\n");
+		log("the result does not depend on the number of threads.\n");
+		log("\n");
 	}
 	virtual void execute(std::vector<std::string> args, Design *design)
 	{
-		bool verbose = false, short_cones = false, model_undef = false, nogroup = false;
+		bool verbose = false, short_cones = false, model_undef = false, nogroup = false, sim_mode = true;
 		int success_counter = 0;
 		int max_seq = 1;
+		int num_threads = 0;
+		SatBudget budget;
 
 		log_header(design, "Executing EQUIV_SIMPLE pass.\n");
 
@@ -324,14 +408,31 @@ struct EquivSimplePass : public Pass {
 				nogroup = true;
 				continue;
 			}
+			if (args[argidx] == "-nosim") {
+				sim_mode = false;
+				continue;
+			}
 			if (args[argidx] == "-seq" && argidx+1 < args.size()) {
 				max_seq = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				num_threads = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (budget.parse_arg(args, argidx))
+				continue;
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		if (num_threads <= 0)
+			num_threads = yosys_threads;
+
+		// design monitors would be called from several threads at once
+		if (!design->monitors.empty())
+			num_threads = 1;
+
 		CellTypes ct;
 		ct.setup_internals();
 		ct.setup_stdcells();
@@ -368,6 +469,8 @@ struct EquivSimplePass : public Pass {
 							bit2driver[bit] = cell;
 			}
 
+			vector<vector<Cell*>> groups;
+
 			unproven_equiv_cells.sort();
 			for (auto it : unproven_equiv_cells)
 			{
@@ -376,12 +479,141 @@ struct EquivSimplePass : public Pass {
 				vector<Cell*> cells;
 				for (auto it2 : it.second)
 					cells.push_back(it2.second);
+				groups.push_back(cells);
+			}
+
+			// random simulation of the unrolled module: a lane in which A and B
+			// have different defined values in the last time step is a model for
+			// the SAT problems of the $equiv cell, so the solver is not called for
+			// it. the models of the failed proofs are collected and simulated in
+			// batches (of up to 64) to find more differences in the remaining groups.
+
+			RandomSim *sim = nullptr;
+			pool<Cell*> disproved_cells;
+
+			if (sim_mode)
+			{
+				sim = new RandomSim(module, sigmap, max_seq+1, model_undef);
+				RandomSim::State state;
+
+				for (int round = 0; round < 4; round++) {
+					sim->init(state, round);
+					sim->run(state);
+					for (auto &cells : groups)
+						for (auto cell : cells)
+							if (sim->diff(state, sigmap(cell->getPort("\\A")).as_bit(), sigmap(cell->getPort("\\B")).as_bit(), max_seq))
+								disproved_cells.insert(cell);
+				}
 
-				EquivSimpleWorker worker(cells, sigmap, bit2driver, max_seq, short_cones, verbose, model_undef);
-				success_counter += worker.run();
+				log("Random simulation with 256 patterns found counterexamples for %d $equiv cells.\n", GetSize(disproved_cells));
 			}
+
+			// each job proves a range of neighbouring groups, which usually have
+			// overlapping input cones. the jobs only read the module: SigSpec
+			// switches between its packed and unpacked representation even in
+			// const methods, so pack everything up front, and each job gets its
+			// own copy of the SigMap because SigMap lookups compress paths.
+
+			int num_jobs = num_threads > 1 ? min(GetSize(groups), 4*num_threads) : 1;
+			vector<vector<Cell*>> job_proven_cells(num_jobs);
+			vector<int> job_cells(num_jobs), job_sat_calls(num_jobs), job_disproved(num_jobs);
+			vector<double> job_sec(num_jobs);
+			vector<SatBudget> job_budget(num_jobs);
+			for (auto &b : job_budget)
+				b.limits = budget.limits;
+
+			if (num_jobs > 1)
+				for (auto cell : module->cells())
+					for (auto &conn : cell->connections())
+						conn.second.chunks();
+
+			parallel_for(num_jobs, [&](int job)
+			{
+				PerformanceTimer timer;
+				timer.begin();
+
+				SigMap job_sigmap;
+				if (num_jobs > 1)
+					job_sigmap = sigmap;
+
+				SigMap &worker_sigmap = num_jobs > 1 ? job_sigmap : sigmap;
+				int begin = job * GetSize(groups) / num_jobs, end = (job+1) * GetSize(groups) / num_jobs;
+
+				pool<Cell*> job_disproved_cells;
+				for (int i = begin; i < end; i++)
+					for (auto cell : groups[i])
+						if (disproved_cells.count(cell))
+							job_disproved_cells.insert(cell);
+				job_disproved[job] = GetSize(job_disproved_cells);
+
+				vector<dict<pair<SigBit, int>, bool>> counterexamples;
+				uint64_t seed = 4 + job;
+				int batch_size = 1;
+
+				for (int i = begin; i < end; i++)
+				{
+					EquivSimpleWorker worker(groups[i], worker_sigmap, bit2driver, max_seq, short_cones, verbose, model_undef,
+							job_budget[job], sim, job_disproved_cells, counterexamples);
+					worker.run();
+					job_proven_cells[job].insert(job_proven_cells[job].end(), worker.proven_cells.begin(), worker.proven_cells.end());
+					job_cells[job] += GetSize(groups[i]);
+					job_sat_calls[job] += worker.sat_calls;
+
+					if (sim == nullptr || GetSize(counterexamples) < batch_size || i+1 == end)
+						continue;
+
+					for (int offset = 0; offset < GetSize(counterexamples); offset += 64)
+					{
+						// the inputs that are not in a model keep their random values
+						RandomSim::State state;
+						sim->init(state, seed);
+						seed += num_jobs;
+
+						for (int lane = 0; lane < 64 && offset + lane < GetSize(counterexamples); lane++)
+							for (auto &it : counterexamples[offset + lane])
+								sim->set(state, it.first.first, it.first.second, lane, it.second);
+						sim->run(state);
+
+						for (int k = i+1; k < end; k++)
+							for (auto cell : groups[k])
+								if (!job_disproved_cells.count(cell) && sim->diff(state, worker_sigmap(cell->getPort("\\A")).as_bit(),
+										worker_sigmap(cell->getPort("\\B")).as_bit(), max_seq))
+									job_disproved_cells.insert(cell);
+					}
+
+					counterexamples.clear();
+					batch_size = min(2*batch_size, 64);
+				}
+
+				job_disproved[job] = GetSize(job_disproved_cells) - job_disproved[job];
+
+				timer.end();
+				job_sec[job] = timer.sec();
+			}, num_threads);
+
+			if (num_jobs > 1) {
+				log("Proved $equiv cells using %d jobs on up to %d threads:\n", num_jobs, num_threads);
+				for (int job = 0; job < num_jobs; job++)
+					log("  job %3d: %5d cells, %5d proven, %6d SAT calls, %5d disproved by counterexamples, %8.2f sec (%.1f cells/sec)\n",
+							job, job_cells[job], GetSize(job_proven_cells[job]), job_sat_calls[job], job_disproved[job],
+							job_sec[job], job_sec[job] > 0 ? job_cells[job] / job_sec[job] : 0.0);
+			} else if (sim_mode)
+				log("Simulating the models of failed proofs found counterexamples for %d more $equiv cells.\n", job_disproved[0]);
+
+			delete sim;
+
+			for (auto &b : job_budget)
+				budget.merge(b);
+
+			for (auto &proven_cells : job_proven_cells)
+				for (auto cell : proven_cells) {
+					cell->setPort("\\B", cell->getPort("\\A"));
+					success_counter++;
+				}
 		}
 
+		if (budget.limited() || verbose)
+			budget.log_stats("SAT solver: ");
 		log("Proved %d previously unproven $equiv cells.\n", success_counter);
 	}
 } EquivSimplePass;
@@ -23,7 +23,7 @@ USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 struct EquivStatusPass : public Pass {
-	EquivStatusPass() : Pass("equiv_status", "print status of equivalent checking module") { }
+	EquivStatusPass() : Pass("equiv_status", "print status of equivalent checking module") { readonly_modules = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -381,6 +381,7 @@ static void extract_fsm(RTLIL::Wire *wire)
 
 	// rename original state wire
 
+	module->notify_rename_wires();
 	module->wires_.erase(wire->name);
 	wire->attributes.erase("\\fsm_encoding");
 	wire->name = stringf("$fsm$oldstate%s", wire->name.c_str());
@@ -138,7 +138,49 @@ void generate(RTLIL::Design *design, const std::vector<std::string> &celltypes,
 	}
 }
 
-bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check, std::vector<std::string> &libdirs)
+void check_cell(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Cell *cell)
+{
+	RTLIL::Module *mod = design->module(cell->type);
+	for (auto &conn : cell->connections())
+		if (conn.first[0] == '$' && '0' <= conn.first[1] && conn.first[1] <= '9') {
+			int id = atoi(conn.first.c_str()+1);
+			if (id <= 0 || id > GetSize(mod->ports))
+				log_error("Module `%s' referenced in module `%s' in cell `%s' has only %d ports, requested port %d.\n",
+						log_id(cell->type), log_id(module), log_id(cell), GetSize(mod->ports), id);
+		} else if (mod->wire(conn.first) == nullptr || mod->wire(conn.first)->port_id == 0)
+			log_error("Module `%s' referenced in module `%s' in cell `%s' does not have a port named '%s'.\n",
+					log_id(cell->type), log_id(module), log_id(cell), log_id(conn.first));
+	for (auto &param : cell->parameters)
+		if (mod->avail_parameters.count(param.first) == 0 && param.first[0] != '$' && strchr(param.first.c_str(), '.') == NULL)
+			log_error("Module `%s' referenced in module `%s' in cell `%s' does not have a parameter named '%s'.\n",
+					log_id(cell->type), log_id(module), log_id(cell), log_id(param.first));
+}
+
+// many cells usually share the same module and parameters. derive every such
+// pair only once per run of the hierarchy pass.
+RTLIL::IdString derive_module(RTLIL::Design *design, RTLIL::Module *mod, const dict<RTLIL::IdString, RTLIL::Const> &parameters,
+		dict<std::string, RTLIL::IdString> &derive_cache)
+{
+	std::vector<std::string> items;
+	for (auto &it : parameters)
+		items.push_back(stringf("%s=%d:%s", it.first.c_str(), it.second.flags, it.second.as_string().c_str()));
+	std::sort(items.begin(), items.end());
+
+	std::string key = mod->name.str();
+	for (auto &item : items)
+		key += " " + item;
+
+	auto it = derive_cache.find(key);
+	if (it != derive_cache.end() && design->module(it->second) != nullptr)
+		return it->second;
+
+	RTLIL::IdString derived_name = mod->derive(design, parameters);
+	derive_cache[key] = derived_name;
+	return derived_name;
+}
+
+bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check, std::vector<std::string> &libdirs,
+		dict<std::string, RTLIL::IdString> &derive_cache)
 {
 	bool did_something = false;
 	std::map<RTLIL::Cell*, std::pair<int, int>> array_cells;
@@ -162,8 +204,10 @@ bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check
 		{
 			if (design->modules_.count("$abstract" + cell->type.str()))
 			{
-				cell->type = design->modules_.at("$abstract" + cell->type.str())->derive(design, cell->parameters);
+				cell->type = derive_module(design, design->modules_.at("$abstract" + cell->type.str()), cell->parameters, derive_cache);
 				cell->parameters.clear();
+				if (flag_check)
+					check_cell(design, module, cell);
 				did_something = true;
 				continue;
 			}
@@ -194,25 +238,12 @@ bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check
 		loaded_module:
 			if (design->modules_.count(cell->type) == 0)
 				log_error("File `%s' from libdir does not declare module `%s'.\n", filename.c_str(), cell->type.c_str());
+			if (flag_check)
+				check_cell(design, module, cell);
 			did_something = true;
 		} else
 		if (flag_check)
-		{
-			RTLIL::Module *mod = design->module(cell->type);
-			for (auto &conn : cell->connections())
-				if (conn.first[0] == '$' && '0' <= conn.first[1] && conn.first[1] <= '9') {
-					int id = atoi(conn.first.c_str()+1);
-					if (id <= 0 || id > GetSize(mod->ports))
-						log_error("Module `%s' referenced in module `%s' in cell `%s' has only %d ports, requested port %d.\n",
-								log_id(cell->type), log_id(module), log_id(cell), GetSize(mod->ports), id);
-				} else if (mod->wire(conn.first) == nullptr || mod->wire(conn.first)->port_id == 0)
-					log_error("Module `%s' referenced in module `%s' in cell `%s' does not have a port named '%s'.\n",
-							log_id(cell->type), log_id(module), log_id(cell), log_id(conn.first));
-			for (auto &param : cell->parameters)
-				if (mod->avail_parameters.count(param.first) == 0 && param.first[0] != '$' && strchr(param.first.c_str(), '.') == NULL)
-					log_error("Module `%s' referenced in module `%s' in cell `%s' does not have a parameter named '%s'.\n",
-							log_id(cell->type), log_id(module), log_id(cell), log_id(param.first));
-		}
+			check_cell(design, module, cell);
 
 		if (cell->parameters.size() == 0)
 			continue;
@@ -221,7 +252,7 @@ bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check
 			continue;
 
 		RTLIL::Module *mod = design->modules_[cell->type];
-		cell->type = mod->derive(design, cell->parameters);
+		cell->type = derive_module(design, mod, cell->parameters, derive_cache);
 		cell->parameters.clear();
 		did_something = true;
 	}
@@ -285,6 +316,20 @@ void hierarchy_worker(RTLIL::Design *design, std::set<RTLIL::Module*, IdString::
 	}
 }
 
+// like hierarchy_worker(), but without logging and without descending into
+// modules that have already been expanded
+void add_used_modules(RTLIL::Design *design, const pool<RTLIL::Module*> &expanded, std::set<RTLIL::Module*, IdString::compare_ptr_by_name<Module>> &used, RTLIL::Module *mod)
+{
+	if (expanded.count(mod) > 0 || used.count(mod) > 0)
+		return;
+
+	used.insert(mod);
+
+	for (auto cell : mod->cells())
+		if (design->module(cell->type))
+			add_used_modules(design, expanded, used, design->module(cell->type));
+}
+
 void hierarchy_clean(RTLIL::Design *design, RTLIL::Module *top, bool purge_lib)
 {
 	std::set<RTLIL::Module*, IdString::compare_ptr_by_name<Module>> used;
@@ -530,24 +575,54 @@ struct HierarchyPass : public Pass {
 				log("Automatically selected %s as design top module.\n", log_id(top_mod));
 		}
 
-		bool did_something = true;
-		while (did_something)
-		{
-			did_something = false;
+		// every module is only expanded once. the modules that are derived or
+		// loaded while expanding one round of modules form the next round.
+		// modules with cells of unknown type are expanded again whenever new
+		// modules have been added to the design.
+		std::set<RTLIL::Module*, IdString::compare_ptr_by_name<Module>> used_modules;
+		if (top_mod != NULL) {
+			log_header(design, "Analyzing design hierarchy..\n");
+			hierarchy_worker(design, used_modules, top_mod, 0);
+		} else {
+			for (auto mod : design->modules())
+				used_modules.insert(mod);
+		}
 
-			std::set<RTLIL::Module*, IdString::compare_ptr_by_name<Module>> used_modules;
-			if (top_mod != NULL) {
-				log_header(design, "Analyzing design hierarchy..\n");
-				hierarchy_worker(design, used_modules, top_mod, 0);
-			} else {
-				for (auto mod : design->modules())
-					used_modules.insert(mod);
-			}
+		dict<std::string, RTLIL::IdString> derive_cache;
+		pool<RTLIL::Module*> expanded, incomplete;
+
+		while (!used_modules.empty())
+		{
+			int num_modules = GetSize(design->modules_);
 
 			for (auto module : used_modules) {
-				if (expand_module(design, module, flag_check, libdirs))
-					did_something = true;
+				expand_module(design, module, flag_check, libdirs, derive_cache);
+				expanded.insert(module);
+				incomplete.erase(module);
 			}
+
+			std::set<RTLIL::Module*, IdString::compare_ptr_by_name<Module>> next_used_modules;
+
+			for (auto module : used_modules)
+				for (auto cell : module->cells()) {
+					RTLIL::Module *mod = design->module(cell->type);
+					if (mod == nullptr) {
+						if (cell->type[0] != '$')
+							incomplete.insert(module);
+					} else if (top_mod != NULL)
+						add_used_modules(design, expanded, next_used_modules, mod);
+				}
+
+			if (top_mod == NULL)
+				for (auto mod : design->modules())
+					if (expanded.count(mod) == 0)
+						next_used_modules.insert(mod);
+
+			if (GetSize(design->modules_) != num_modules)
+				for (auto mod : incomplete)
+					next_used_modules.insert(mod);
+
+			used_modules.swap(next_used_modules);
 		}
 
 		if (top_mod != NULL) {
@@ -41,6 +41,7 @@ struct MemoryShareWorker
 	SigMap sigmap, sigmap_xmux;
 	ModWalker modwalker;
 	CellTypes cone_ct;
+	SatBudget &budget;
 
 	std::map<RTLIL::SigBit, std::pair<RTLIL::Cell*, int>> sig_to_mux;
 	std::map<pair<std::set<std::map<SigBit, bool>>, SigBit>, SigBit> conditions_logic_cache;
@@ -601,7 +602,19 @@ struct MemoryShareWorker
 			if (!considered_port_pairs.count(i))
 				continue;
 
-			if (ez->solve(port_to_sat_variable.at(i-1), port_to_sat_variable.at(i))) {
+			budget.setup(ez.get());
+			bool found_model = ez->solve(port_to_sat_variable.at(i-1), port_to_sat_variable.at(i));
+			bool out_of_budget = budget.out_of_budget(ez.get());
+
+			if (budget.limited())
+				log("  SAT solver used %s.\n", budget.usage(ez.get()).c_str());
+
+			if (out_of_budget) {
+				log("  SAT solver ran out of budget, not merging port %d with port %d.\n", i-1, i);
+				continue;
+			}
+
+			if (found_model) {
 				log("  According to SAT solver sharing of port %d with port %d is not possible.\n", i-1, i);
 				continue;
 			}
@@ -665,8 +678,8 @@ struct MemoryShareWorker
 	// Setup and run
 	// -------------
 
-	MemoryShareWorker(RTLIL::Design *design, RTLIL::Module *module) :
-			design(design), module(module), sigmap(module)
+	MemoryShareWorker(RTLIL::Design *design, RTLIL::Module *module, SatBudget &budget) :
+			design(design), module(module), sigmap(module), budget(budget)
 	{
 		std::map<std::string, std::pair<std::vector<RTLIL::Cell*>, std::vector<RTLIL::Cell*>>> memindex;
 
@@ -730,10 +743,16 @@ struct MemorySharePass : public Pass {
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
 		log("\n");
-		log("    memory_share [selection]\n");
+		log("    memory_share [options] [selection]\n");
 		log("\n");
 		log("This pass merges share-able memory ports into single memory ports.\n");
 		log("\n");
+		log("    -timeout <N>\n");
+		log("    -conflict-limit <N>\n");
+		log("    -propagation-limit <N>\n");
+		log("        limit the seconds, conflicts or propagations of each SAT solver call.\n");
+		log("        write ports are not merged when the solver runs out of budget.\n");
+		log("\n");
 		log("The following methods are used to consolidate the number of memory ports:\n");
 		log("\n");
 		log("  - When write ports are connected to async read ports accessing the same\n");
@@ -753,10 +772,19 @@ struct MemorySharePass : public Pass {
 		log("\n");
 	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design) {
+		SatBudget budget;
 		log_header(design, "Executing MEMORY_SHARE pass (consolidating $memrd/$memwr cells).\n");
-		extra_args(args, 1, design);
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (budget.parse_arg(args, argidx))
+				continue;
+			break;
+		}
+		extra_args(args, argidx, design);
 		for (auto module : design->selected_modules())
-			MemoryShareWorker(design, module);
+			MemoryShareWorker(design, module, budget);
+		if (budget.limited())
+			budget.log_stats("SAT solver: ");
 	}
 } MemorySharePass;
 
@@ -19,12 +19,64 @@
 
 #include "kernel/register.h"
 #include "kernel/log.h"
+#include "passes/opt/opt_dirty.h"
 #include <stdlib.h>
 #include <stdio.h>
 
 USING_YOSYS_NAMESPACE
+
+YOSYS_NAMESPACE_BEGIN
+dict<RTLIL::Module*, OptDirtyMonitor*> opt_dirty_monitors;
+YOSYS_NAMESPACE_END
+
 PRIVATE_NAMESPACE_BEGIN
 
+struct OptDirtyTracker
+{
+	dict<RTLIL::Module*, int> iteration_epochs;
+
+	OptDirtyTracker(RTLIL::Design *design)
+	{
+		for (auto module : design->selected_modules())
+			opt_dirty_monitors[module] = new OptDirtyMonitor(module);
+	}
+
+	~OptDirtyTracker()
+	{
+		for (auto &it : opt_dirty_monitors)
+			delete it.second;
+		opt_dirty_monitors.clear();
+	}
+
+	void begin_iteration()
+	{
+		for (auto &it : opt_dirty_monitors) {
+			it.second->begin("opt");
+			iteration_epochs[it.first] = it.second->epoch;
+		}
+	}
+
+	void end_iteration()
+	{
+		int total_cells = 0, total_wires = 0;
+		int dirty_cells = 0, dirty_wires = 0, dirty_modules = 0;
+
+		for (auto &it : opt_dirty_monitors) {
+			int num_cells, num_wires;
+			it.second->count(iteration_epochs.at(it.first), num_cells, num_wires);
+			total_cells += GetSize(it.first->cells_);
+			total_wires += GetSize(it.first->wires_);
+			dirty_cells += num_cells;
+			dirty_wires += num_wires;
+			if (num_cells || num_wires)
+				dirty_modules++;
+		}
+
+		log("\nChanged in this iteration: %d cells and %d wires in %d modules (now %d cells and %d wires).\n",
+				dirty_cells, dirty_wires, dirty_modules, total_cells, total_wires);
+	}
+};
+
 struct OptPass : public Pass {
 	OptPass() : Pass("opt", "perform simple optimizations") { }
 	virtual void help()
@@ -58,8 +110,17 @@ struct OptPass : public Pass {
 		log("        opt_clean [-purge]\n");
 		log("    while <changed design in opt_rmdff>\n");
 		log("\n");
+		log("After the first iteration the opt_expr, opt_reduce and opt_rmdff passes only\n");
+		log("try to rewrite the cells that changed in the meantime and their immediate\n");
+		log("neighbours. They still scan all cells to collect drivers, inverters and init\n");
+		log("values, so this only saves the per-cell work. opt_muxtree, opt_merge and\n");
+		log("opt_clean always process the complete design. The number of changed cells and\n");
+		log("wires is reported after each iteration. Call 'opt' with -noincr to run all\n");
+		log("passes on the complete design every time.\n");
+		log("\n");
 		log("Note: Options in square brackets (such as [-keepdc]) are passed through to\n");
-		log("the opt_* commands when given to 'opt'.\n");
+		log("the opt_* commands when given to 'opt'. The option -j <threads> is passed\n");
+		log("through to opt_expr, opt_merge and opt_clean.\n");
 		log("\n");
 		log("\n");
 	}
@@ -71,6 +132,7 @@ struct OptPass : public Pass {
 		std::string opt_merge_args;
 		std::string opt_rmdff_args;
 		bool fast_mode = false;
+		bool noincr = false;
 
 		log_header(design, "Executing OPT pass (performing simple optimizations).\n");
 		log_push();
@@ -120,13 +182,30 @@ struct OptPass : public Pass {
 				fast_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-noincr") {
+				noincr = true;
+				continue;
+			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				std::string arg = " -j " + args[++argidx];
+				opt_expr_args += arg;
+				opt_merge_args += arg;
+				opt_clean_args += arg;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		std::unique_ptr<OptDirtyTracker> tracker;
+		if (!noincr && opt_dirty_monitors.empty())
+			tracker.reset(new OptDirtyTracker(design));
+
 		if (fast_mode)
 		{
 			while (1) {
+				if (tracker)
+					tracker->begin_iteration();
 				Pass::call(design, "opt_expr" + opt_expr_args);
 				Pass::call(design, "opt_merge" + opt_merge_args);
 				design->scratchpad_unset("opt.did_something");
@@ -134,6 +213,8 @@ struct OptPass : public Pass {
 				if (design->scratchpad_get_bool("opt.did_something") == false)
 					break;
 				Pass::call(design, "opt_clean" + opt_clean_args);
+				if (tracker)
+					tracker->end_iteration();
 				log_header(design, "Rerunning OPT passes. (Removed registers in this run.)\n");
 			}
 			Pass::call(design, "opt_clean" + opt_clean_args);
@@ -143,6 +224,8 @@ struct OptPass : public Pass {
 			Pass::call(design, "opt_expr" + opt_expr_args);
 			Pass::call(design, "opt_merge -nomux" + opt_merge_args);
 			while (1) {
+				if (tracker)
+					tracker->begin_iteration();
 				design->scratchpad_unset("opt.did_something");
 				Pass::call(design, "opt_muxtree");
 				Pass::call(design, "opt_reduce" + opt_reduce_args);
@@ -150,12 +233,16 @@ struct OptPass : public Pass {
 				Pass::call(design, "opt_rmdff" + opt_rmdff_args);
 				Pass::call(design, "opt_clean" + opt_clean_args);
 				Pass::call(design, "opt_expr" + opt_expr_args);
+				if (tracker)
+					tracker->end_iteration();
 				if (design->scratchpad_get_bool("opt.did_something") == false)
 					break;
 				log_header(design, "Rerunning OPT passes. (Maybe there is more to do..)\n");
 			}
 		}
 
+		tracker.reset();
+
 		design->optimize();
 		design->sort();
 		design->check();
@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <set>
+#include <atomic>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -39,6 +40,12 @@ struct keep_cache_t
 	{
 		this->design = design;
 		cache.clear();
+
+		// fill the cache for all modules right away so that it is read-only
+		// while rmunused_module() is running on several modules in parallel
+		if (design != nullptr)
+			for (auto module : design->modules())
+				query(module);
 	}
 
 	bool query(Module *module)
@@ -79,7 +86,8 @@ struct keep_cache_t
 
 keep_cache_t keep_cache;
 CellTypes ct_reg, ct_all;
-int count_rm_cells, count_rm_wires;
+std::atomic<int> count_rm_cells, count_rm_wires;
+std::atomic<bool> did_something;
 
 void rmunused_module_cells(Module *module, bool verbose)
 {
@@ -138,7 +146,7 @@ void rmunused_module_cells(Module *module, bool verbose)
 	for (auto cell : unused) {
 		if (verbose)
 			log("  removing unused `%s' cell `%s'.\n", cell->type.c_str(), cell->name.c_str());
-		module->design->scratchpad_set_bool("opt.did_something", true);
+		did_something = true;
 		module->remove(cell);
 		count_rm_cells++;
 	}
@@ -242,14 +250,16 @@ void rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 		}
 	}
 
-	module->connections_.clear();
+	// use setPort() and new_connections() so that module monitors (such as
+	// the ones installed by the 'opt' pass) see the rewritten signals
+	std::vector<RTLIL::SigSig> new_connections;
 
 	SigPool used_signals;
 	SigPool used_signals_nodrivers;
 	for (auto &it : module->cells_) {
 		RTLIL::Cell *cell = it.second;
 		for (auto &it2 : cell->connections_) {
-			assign_map.apply(it2.second);
+			cell->setPort(it2.first, assign_map(it2.second));
 			used_signals.add(it2.second);
 			if (!ct_all.cell_output(cell->type, it2.first))
 				used_signals_nodrivers.add(it2.second);
@@ -290,7 +300,7 @@ void rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 				if (new_conn.first.size() > 0) {
 					used_signals.add(new_conn.first);
 					used_signals.add(new_conn.second);
-					module->connect(new_conn);
+					new_connections.push_back(new_conn);
 				}
 			}
 		} else {
@@ -320,6 +330,8 @@ void rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 	}
 
 
+	module->new_connections(new_connections);
+
 	pool<RTLIL::Wire*> del_wires;
 
 	int del_wires_count = 0;
@@ -333,7 +345,7 @@ void rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 		}
 
 	module->remove(del_wires);
-	count_rm_wires += del_wires.size();
+	count_rm_wires += GetSize(del_wires);
 
 	if (verbose && del_wires_count > 0)
 		log("  removed %d unused temporary wires.\n", del_wires_count);
@@ -431,7 +443,7 @@ void rmunused_module(RTLIL::Module *module, bool purge_mode, bool verbose, bool
 		module->remove(cell);
 	}
 	if (!delcells.empty())
-		module->design->scratchpad_set_bool("opt.did_something", true);
+		did_something = true;
 
 	rmunused_module_cells(module, verbose);
 	rmunused_module_signals(module, purge_mode, verbose);
@@ -440,6 +452,22 @@ void rmunused_module(RTLIL::Module *module, bool purge_mode, bool verbose, bool
 		rmunused_module_signals(module, purge_mode, verbose);
 }
 
+void rmunused_modules(RTLIL::Design *design, const std::vector<RTLIL::Module*> &modules, bool purge_mode, bool verbose, bool rminit, int num_threads)
+{
+	// design monitors would be called from several threads at once
+	if (!design->monitors.empty())
+		num_threads = 1;
+
+	did_something = false;
+
+	parallel_for(GetSize(modules), [&](int i) {
+		rmunused_module(modules[i], purge_mode, verbose, rminit);
+	}, num_threads);
+
+	if (did_something)
+		design->scratchpad_set_bool("opt.did_something", true);
+}
+
 struct OptCleanPass : public Pass {
 	OptCleanPass() : Pass("opt_clean", "remove unused cells and wires") { }
 	virtual void help()
@@ -458,10 +486,16 @@ struct OptCleanPass : public Pass {
 		log("    -purge\n");
 		log("        also remove internal nets if they have a public name\n");
 		log("\n");
+		log("    -j <threads>\n");
+		log("        process up to <threads> modules in parallel. the default is set with\n");
+		log("        'yosys -j'. the log output and the result are the same as for a\n");
+		log("        serial run.\n");
+		log("\n");
 	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
 		bool purge_mode = false;
+		int num_threads = 0;
 
 		log_header(design, "Executing OPT_CLEAN pass (remove unused cells and wires).\n");
 		log_push();
@@ -472,6 +506,10 @@ struct OptCleanPass : public Pass {
 				purge_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				num_threads = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -483,14 +521,17 @@ struct OptCleanPass : public Pass {
 
 		ct_all.setup(design);
 
+		std::vector<RTLIL::Module*> modules;
 		for (auto module : design->selected_whole_modules_warn()) {
 			if (module->has_processes_warn())
 				continue;
-			rmunused_module(module, purge_mode, true, true);
+			modules.push_back(module);
 		}
 
+		rmunused_modules(design, modules, purge_mode, true, true, num_threads);
+
 		if (count_rm_cells > 0 || count_rm_wires > 0)
-			log("Removed %d unused cells and %d unused wires.\n", count_rm_cells, count_rm_wires);
+			log("Removed %d unused cells and %d unused wires.\n", count_rm_cells.load(), count_rm_wires.load());
 
 		design->optimize();
 		design->sort();
@@ -523,6 +564,7 @@ struct CleanPass : public Pass {
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
 		bool purge_mode = false;
+		int num_threads = 0;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
@@ -530,6 +572,10 @@ struct CleanPass : public Pass {
 				purge_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				num_threads = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		if (argidx < args.size())
@@ -545,14 +591,17 @@ struct CleanPass : public Pass {
 		count_rm_cells = 0;
 		count_rm_wires = 0;
 
+		std::vector<RTLIL::Module*> modules;
 		for (auto module : design->selected_whole_modules()) {
 			if (module->has_processes())
 				continue;
-			rmunused_module(module, purge_mode, false, false);
+			modules.push_back(module);
 		}
 
+		rmunused_modules(design, modules, purge_mode, false, false, num_threads);
+
 		if (count_rm_cells > 0 || count_rm_wires > 0)
-			log("Removed %d unused cells and %d unused wires.\n", count_rm_cells, count_rm_wires);
+			log("Removed %d unused cells and %d unused wires.\n", count_rm_cells.load(), count_rm_wires.load());
 
 		design->optimize();
 		design->sort();
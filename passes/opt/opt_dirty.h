@@ -0,0 +1,232 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef OPT_DIRTY_H
+#define OPT_DIRTY_H
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// The 'opt' pass installs an OptDirtyMonitor on each selected module. The
+// monitor records the cells and wires touched by any change to the module,
+// tagged with the epoch in which the change happened. A new epoch is started
+// each time one of the opt_* passes begins work on the module, so a pass can
+// restrict itself to the part of the module that changed since its last run.
+//
+// Only opt_expr, opt_reduce and opt_rmdff use this, and only for their
+// per-cell rewrites. They still walk all cells and build a full SigMap to
+// collect the context for these rewrites (inverters, drivers, init values,
+// memory write enables). opt_muxtree, opt_merge and opt_clean always process
+// the complete module.
+//
+// Cells and wires are stored by name because they may be deleted while the
+// monitor is active.
+
+struct OptDirtyMonitor : public RTLIL::Monitor
+{
+	RTLIL::Module *module;
+	int epoch, blackout_epoch;
+	dict<RTLIL::IdString, int> cell_epochs, wire_epochs;
+	dict<std::string, int> pass_epochs;
+
+	OptDirtyMonitor(RTLIL::Module *module) : module(module), epoch(0), blackout_epoch(-1)
+	{
+		module->monitors.insert(this);
+	}
+
+	~OptDirtyMonitor()
+	{
+		module->monitors.erase(this);
+	}
+
+	void mark(const RTLIL::SigSpec &sig)
+	{
+		for (auto &chunk : sig.chunks())
+			if (chunk.wire != nullptr)
+				wire_epochs[chunk.wire->name] = epoch;
+	}
+
+	virtual void notify_connect(RTLIL::Cell *cell, const RTLIL::IdString&, const RTLIL::SigSpec &old_sig, RTLIL::SigSpec &sig) YS_OVERRIDE
+	{
+		// mark all ports of the cell so that its immediate neighbours on
+		// the other ports are revisited as well
+		cell_epochs[cell->name] = epoch;
+		for (auto &conn : cell->connections())
+			mark(conn.second);
+		mark(old_sig);
+		mark(sig);
+	}
+
+	virtual void notify_connect(RTLIL::Module*, const RTLIL::SigSig &sigsig) YS_OVERRIDE
+	{
+		mark(sigsig.first);
+		mark(sigsig.second);
+	}
+
+	virtual void notify_connect(RTLIL::Module*, const std::vector<RTLIL::SigSig> &new_conns) YS_OVERRIDE
+	{
+		pool<std::pair<RTLIL::SigBit, RTLIL::SigBit>> old_bits, new_bits;
+
+		for (auto &conn : module->connections())
+			for (int i = 0; i < GetSize(conn.first); i++)
+				old_bits.insert(std::make_pair(conn.first[i], conn.second[i]));
+
+		for (auto &conn : new_conns)
+			for (int i = 0; i < GetSize(conn.first); i++) {
+				auto bits = std::make_pair(conn.first[i], conn.second[i]);
+				if (old_bits.count(bits) == 0) {
+					mark(bits.first);
+					mark(bits.second);
+				}
+				new_bits.insert(bits);
+			}
+
+		for (auto &bits : old_bits)
+			if (new_bits.count(bits) == 0) {
+				mark(bits.first);
+				mark(bits.second);
+			}
+	}
+
+	virtual void notify_blackout(RTLIL::Module*) YS_OVERRIDE
+	{
+		blackout_epoch = epoch;
+	}
+
+	// start a new epoch for the given pass and return the epoch in which the
+	// pass was last started (or -1 if this is the first run of the pass)
+	int begin(const std::string &pass)
+	{
+		int since = pass_epochs.count(pass) ? pass_epochs.at(pass) : -1;
+		pass_epochs[pass] = ++epoch;
+		prune();
+		return since;
+	}
+
+	// forget changes that are older than the last start of every pass, so
+	// that setting up a filter only looks at the recent changes
+	void prune()
+	{
+		int min_epoch = epoch;
+		for (auto &it : pass_epochs)
+			min_epoch = std::min(min_epoch, it.second);
+
+		std::vector<RTLIL::IdString> old_cells, old_wires;
+		for (auto &it : cell_epochs)
+			if (it.second < min_epoch)
+				old_cells.push_back(it.first);
+		for (auto &it : wire_epochs)
+			if (it.second < min_epoch)
+				old_wires.push_back(it.first);
+
+		for (auto &name : old_cells)
+			cell_epochs.erase(name);
+		for (auto &name : old_wires)
+			wire_epochs.erase(name);
+	}
+
+	// number of cells and wires (including removed ones) changed since the given epoch
+	void count(int since, int &num_cells, int &num_wires) const
+	{
+		num_cells = 0, num_wires = 0;
+		for (auto &it : cell_epochs)
+			if (it.second >= since)
+				num_cells++;
+		for (auto &it : wire_epochs)
+			if (it.second >= since)
+				num_wires++;
+	}
+};
+
+extern dict<RTLIL::Module*, OptDirtyMonitor*> opt_dirty_monitors;
+
+// The set of cells a pass has to revisit: all cells that changed since the
+// given epoch, all cells connected to a signal that changed since then and
+// all cells with a port that is connected to a constant through a connection.
+// A default-constructed filter (or one set up without a monitor) selects all
+// cells. Setting up the filter only costs time in the number of changes, but
+// check() must still be called for each cell the pass looks at.
+
+struct OptDirtyFilter
+{
+	bool all;
+	pool<RTLIL::Cell*> cells;
+	pool<RTLIL::SigBit> bits;
+
+	OptDirtyFilter() : all(true) { }
+
+	OptDirtyFilter(RTLIL::Module *module, OptDirtyMonitor *monitor, int since, const SigMap &sigmap) : all(true)
+	{
+		if (monitor == nullptr || since < 0 || monitor->blackout_epoch >= since)
+			return;
+
+		all = false;
+
+		for (auto &it : monitor->cell_epochs)
+			if (it.second >= since) {
+				RTLIL::Cell *cell = module->cell(it.first);
+				if (cell != nullptr)
+					cells.insert(cell);
+			}
+
+		for (auto &it : monitor->wire_epochs)
+			if (it.second >= since) {
+				RTLIL::Wire *wire = module->wire(it.first);
+				if (wire != nullptr)
+					for (auto bit : sigmap(wire))
+						if (bit.wire != nullptr)
+							bits.insert(bit);
+			}
+	}
+
+	bool check(RTLIL::Cell *cell, const SigMap &sigmap) const
+	{
+		if (all || cells.count(cell))
+			return true;
+		for (auto &conn : cell->connections())
+			for (auto bit : conn.second) {
+				if (bit.wire == nullptr)
+					continue;
+				// a wire that is (maybe indirectly) connected to a constant
+				// is not rewritten in the cell until the next opt_clean
+				RTLIL::SigBit mapped_bit = sigmap(bit);
+				if (mapped_bit.wire == nullptr || bits.count(mapped_bit))
+					return true;
+			}
+		return false;
+	}
+};
+
+// look up the monitor for a module and start a new epoch for the pass
+static inline OptDirtyMonitor *opt_dirty_begin(RTLIL::Module *module, const std::string &pass, int &since)
+{
+	auto it = opt_dirty_monitors.find(module);
+	if (it == opt_dirty_monitors.end()) {
+		since = -1;
+		return nullptr;
+	}
+	since = it->second->begin(pass);
+	return it->second;
+}
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -22,6 +22,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/utils.h"
 #include "kernel/log.h"
+#include "passes/opt/opt_dirty.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <algorithm>
@@ -29,11 +30,10 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-bool did_something;
+thread_local bool did_something;
 
-void replace_undriven(RTLIL::Design *design, RTLIL::Module *module)
+void replace_undriven(CellTypes &ct, RTLIL::Module *module)
 {
-	CellTypes ct(design);
 	SigMap sigmap(module);
 	SigPool driven_signals;
 	SigPool used_signals;
@@ -282,7 +282,8 @@ int get_onehot_bit_index(RTLIL::SigSpec signal)
 	return bit_index;
 }
 
-void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, bool consume_x, bool mux_undef, bool mux_bool, bool do_fine, bool keepdc, bool clkinv)
+void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, bool consume_x, bool mux_undef, bool mux_bool, bool do_fine, bool keepdc, bool clkinv,
+		OptDirtyMonitor *dirty, int dirty_since)
 {
 	if (!design->selected(module))
 		return;
@@ -292,6 +293,7 @@ void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, bool cons
 	ct_combinational.setup_stdcells();
 
 	SigMap assign_map(module);
+	OptDirtyFilter dirty_filter(module, dirty, dirty_since, assign_map);
 	dict<RTLIL::SigSpec, RTLIL::SigSpec> invert_map;
 
 	TopoSort<RTLIL::Cell*, RTLIL::IdString::compare_ptr_by_name<RTLIL::Cell>> cells;
@@ -305,6 +307,8 @@ void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, bool cons
 				invert_map[assign_map(cell->getPort("\\Y"))] = assign_map(cell->getPort("\\A"));
 			if ((cell->type == "$mux" || cell->type == "$_MUX_") && cell->getPort("\\A") == SigSpec(State::S1) && cell->getPort("\\B") == SigSpec(State::S0))
 				invert_map[assign_map(cell->getPort("\\Y"))] = assign_map(cell->getPort("\\S"));
+			if (!dirty_filter.check(cell, assign_map))
+				continue;
 			if (ct_combinational.cell_known(cell->type))
 				for (auto &conn : cell->connections()) {
 					RTLIL::SigSpec sig = assign_map(conn.second);
@@ -1486,6 +1490,11 @@ struct OptExprPass : public Pass {
 		log("        all result bits to be set to x. this behavior changes when 'a+0' is\n");
 		log("        replaced by 'a'. the -keepdc option disables all such optimizations.\n");
 		log("\n");
+		log("    -j <threads>\n");
+		log("        process up to <threads> modules in parallel. the default is set with\n");
+		log("        'yosys -j'. the log output and the result are the same as for a\n");
+		log("        serial run.\n");
+		log("\n");
 	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
@@ -1495,6 +1504,7 @@ struct OptExprPass : public Pass {
 		bool clkinv = false;
 		bool do_fine = false;
 		bool keepdc = false;
+		int num_threads = 0;
 
 		log_header(design, "Executing OPT_EXPR pass (perform const folding).\n");
 		log_push();
@@ -1532,25 +1542,49 @@ struct OptExprPass : public Pass {
 				keepdc = true;
 				continue;
 			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				num_threads = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
-		for (auto module : design->selected_modules())
+		// design monitors would be called from several threads at once
+		if (!design->monitors.empty())
+			num_threads = 1;
+
+		CellTypes ct;
+		if (undriven)
+			ct.setup(design);
+
+		std::vector<RTLIL::Module*> modules = design->selected_modules();
+		std::vector<char> module_did_something(GetSize(modules));
+
+		parallel_for(GetSize(modules), [&](int i)
 		{
+			RTLIL::Module *module = modules[i];
+
+			int dirty_since;
+			OptDirtyMonitor *dirty = opt_dirty_begin(module, "opt_expr", dirty_since);
+
 			if (undriven)
-				replace_undriven(design, module);
+				replace_undriven(ct, module);
 
 			do {
 				do {
 					did_something = false;
-					replace_const_cells(design, module, false, mux_undef, mux_bool, do_fine, keepdc, clkinv);
+					replace_const_cells(design, module, false, mux_undef, mux_bool, do_fine, keepdc, clkinv, dirty, dirty_since);
 					if (did_something)
-						design->scratchpad_set_bool("opt.did_something", true);
+						module_did_something[i] = true;
 				} while (did_something);
-				replace_const_cells(design, module, true, mux_undef, mux_bool, do_fine, keepdc, clkinv);
+				replace_const_cells(design, module, true, mux_undef, mux_bool, do_fine, keepdc, clkinv, dirty, dirty_since);
 			} while (did_something);
-		}
+		}, num_threads);
+
+		for (auto flag : module_did_something)
+			if (flag)
+				design->scratchpad_set_bool("opt.did_something", true);
 
 		log_pop();
 	}
@@ -21,13 +21,10 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/celltypes.h"
-#include "libs/sha1/sha1.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <set>
 
-#define USE_CELL_HASH_CACHE
-
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
@@ -38,12 +35,20 @@ struct OptMergeWorker
 	SigMap assign_map;
 	SigMap dff_init_map;
 	bool mode_share_all;
+	uint64_t key_mask;
 
 	CellTypes ct;
 	int total_count;
-#ifdef USE_CELL_HASH_CACHE
-	dict<const RTLIL::Cell*, std::string> cell_hash_cache;
-#endif
+
+	// cells in the hash table, by key
+	dict<uint64_t, std::vector<RTLIL::Cell*>> known_cells;
+	dict<RTLIL::Cell*, uint64_t> cell_keys;
+
+	// cells reading a (sigmapped) signal bit
+	dict<RTLIL::SigBit, pool<RTLIL::Cell*>> bit_readers;
+
+	std::vector<RTLIL::Cell*> worklist;
+	pool<RTLIL::Cell*> queued_cells, removed_cells;
 
 	static void sort_pmux_conn(dict<RTLIL::IdString, RTLIL::SigSpec> &conn)
 	{
@@ -68,103 +73,69 @@ struct OptMergeWorker
 		}
 	}
 
-#ifdef USE_CELL_HASH_CACHE
-	std::string int_to_hash_string(unsigned int v)
+	static inline uint64_t mkhash64(uint64_t h, uint64_t v)
 	{
-		if (v == 0)
-			return "0";
-		std::string str = "";
-		while (v > 0) {
-			str += 'a' + (v & 15);
-			v = v >> 4;
-		}
-		return str;
+		h = (h ^ v) * 0x100000001b3ULL;
+		return h ^ (h >> 29);
 	}
 
-	std::string hash_cell_parameters_and_connections(const RTLIL::Cell *cell)
+	static uint64_t hash_sig(const RTLIL::SigSpec &sig)
 	{
-		if (cell_hash_cache.count(cell) > 0)
-			return cell_hash_cache[cell];
-
-		std::string hash_string = cell->type.str() + "\n";
+		uint64_t h = 0xcbf29ce484222325ULL;
+		for (auto &bit : sig.bits()) {
+			if (bit.wire)
+				h = mkhash64(h, (uint64_t(bit.wire->name.index_) << 32) | uint32_t(bit.offset));
+			else
+				h = mkhash64(h, bit.data);
+		}
+		return mkhash64(h, GetSize(sig));
+	}
 
-		for (auto &it : cell->parameters)
-			hash_string += "P " + it.first.str() + "=" + it.second.as_string() + "\n";
+	// canonical 64-bit key over type, parameters and (sigmapped) inputs. cells
+	// with identical keys are compared with compare_cell_parameters_and_connections().
+	uint64_t hash_cell_parameters_and_connections(const RTLIL::Cell *cell)
+	{
+		uint64_t h = mkhash64(0xcbf29ce484222325ULL, cell->type.index_);
+
+		// parameters and ports are combined in an order-independent way
+		uint64_t param_hash = 0;
+		for (auto &it : cell->parameters) {
+			uint64_t ph = mkhash64(0xcbf29ce484222325ULL, it.first.index_);
+			for (auto bit : it.second.bits)
+				ph = mkhash64(ph, bit);
+			param_hash += mkhash64(ph, GetSize(it.second));
+		}
+		h = mkhash64(h, param_hash);
 
-		const dict<RTLIL::IdString, RTLIL::SigSpec> *conn = &cell->connections();
-		dict<RTLIL::IdString, RTLIL::SigSpec> alt_conn;
+		dict<RTLIL::IdString, RTLIL::SigSpec> conn;
+		for (auto &it : cell->connections())
+			if (!cell->output(it.first))
+				conn[it.first] = assign_map(it.second);
 
 		if (cell->type == "$and" || cell->type == "$or" || cell->type == "$xor" || cell->type == "$xnor" || cell->type == "$add" || cell->type == "$mul" ||
 				cell->type == "$logic_and" || cell->type == "$logic_or" || cell->type == "$_AND_" || cell->type == "$_OR_" || cell->type == "$_XOR_") {
-			alt_conn = *conn;
-			if (assign_map(alt_conn.at("\\A")) < assign_map(alt_conn.at("\\B"))) {
-				alt_conn["\\A"] = conn->at("\\B");
-				alt_conn["\\B"] = conn->at("\\A");
-			}
-			conn = &alt_conn;
+			if (conn.at("\\A") < conn.at("\\B"))
+				std::swap(conn.at("\\A"), conn.at("\\B"));
 		} else
 		if (cell->type == "$reduce_xor" || cell->type == "$reduce_xnor") {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at("\\A"));
-			alt_conn.at("\\A").sort();
-			conn = &alt_conn;
+			conn.at("\\A").sort();
 		} else
 		if (cell->type == "$reduce_and" || cell->type == "$reduce_or" || cell->type == "$reduce_bool") {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at("\\A"));
-			alt_conn.at("\\A").sort_and_unify();
-			conn = &alt_conn;
+			conn.at("\\A").sort_and_unify();
 		} else
 		if (cell->type == "$pmux") {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at("\\A"));
-			assign_map.apply(alt_conn.at("\\B"));
-			assign_map.apply(alt_conn.at("\\S"));
-			sort_pmux_conn(alt_conn);
-			conn = &alt_conn;
+			sort_pmux_conn(conn);
 		}
 
-		vector<string> hash_conn_strings;
-
-		for (auto &it : *conn) {
-			if (cell->output(it.first))
-				continue;
-			RTLIL::SigSpec sig = it.second;
-			assign_map.apply(sig);
-			string s = "C " + it.first.str() + "=";
-			for (auto &chunk : sig.chunks()) {
-				if (chunk.wire)
-					s += "{" + chunk.wire->name.str() + " " +
-							int_to_hash_string(chunk.offset) + " " +
-							int_to_hash_string(chunk.width) + "}";
-				else
-					s += RTLIL::Const(chunk.data).as_string();
-			}
-			hash_conn_strings.push_back(s + "\n");
-		}
-
-		std::sort(hash_conn_strings.begin(), hash_conn_strings.end());
-
-		for (auto it : hash_conn_strings)
-			hash_string += it;
+		uint64_t conn_hash = 0;
+		for (auto &it : conn)
+			conn_hash += mkhash64(hash_sig(it.second), it.first.index_);
 
-		cell_hash_cache[cell] = sha1(hash_string);
-		return cell_hash_cache[cell];
+		return mkhash64(h, conn_hash) & key_mask;
 	}
-#endif
 
 	bool compare_cell_parameters_and_connections(const RTLIL::Cell *cell1, const RTLIL::Cell *cell2, bool &lt)
 	{
-#ifdef USE_CELL_HASH_CACHE
-		std::string hash1 = hash_cell_parameters_and_connections(cell1);
-		std::string hash2 = hash_cell_parameters_and_connections(cell2);
-
-		if (hash1 != hash2) {
-			lt = hash1 < hash2;
-			return true;
-		}
-#endif
-
 		if (cell1->parameters != cell2->parameters) {
 			std::map<RTLIL::IdString, RTLIL::Const> p1(cell1->parameters.begin(), cell1->parameters.end());
 			std::map<RTLIL::IdString, RTLIL::Const> p2(cell2->parameters.begin(), cell2->parameters.end());
@@ -235,35 +206,94 @@ struct OptMergeWorker
 		return false;
 	}
 
-	bool compare_cells(const RTLIL::Cell *cell1, const RTLIL::Cell *cell2)
+	bool mergeable(const RTLIL::Cell *cell)
 	{
-		if (cell1->type != cell2->type)
-			return cell1->type < cell2->type;
+		if ((!mode_share_all && !ct.cell_known(cell->type)) || !cell->known())
+			return false;
+
+		return !cell->has_keep_attr();
+	}
+
+	void queue_cell(RTLIL::Cell *cell)
+	{
+		if (removed_cells.count(cell) || queued_cells.count(cell))
+			return;
+
+		if (cell_keys.count(cell)) {
+			auto &bucket = known_cells.at(cell_keys.at(cell));
+			bucket.erase(std::find(bucket.begin(), bucket.end(), cell));
+			cell_keys.erase(cell);
+		}
 
-		if ((!mode_share_all && !ct.cell_known(cell1->type)) || !cell1->known())
-			return cell1 < cell2;
+		queued_cells.insert(cell);
+		worklist.push_back(cell);
+	}
 
-		if (cell1->has_keep_attr() || cell2->has_keep_attr())
-			return cell1 < cell2;
+	RTLIL::Cell *find_identical_cell(RTLIL::Cell *cell, uint64_t key)
+	{
+		auto it = known_cells.find(key);
+		if (it == known_cells.end())
+			return nullptr;
 
 		bool lt;
-		if (compare_cell_parameters_and_connections(cell1, cell2, lt))
-			return lt;
+		for (auto other : it->second)
+			if (other->type == cell->type && !compare_cell_parameters_and_connections(cell, other, lt))
+				return other;
 
-		return false;
+		return nullptr;
 	}
 
-	struct CompareCells {
-		OptMergeWorker *that;
-		CompareCells(OptMergeWorker *that) : that(that) {}
-		bool operator()(const RTLIL::Cell *cell1, const RTLIL::Cell *cell2) const {
-			return that->compare_cells(cell1, cell2);
+	void merge_cell(RTLIL::Cell *cell, RTLIL::Cell *other)
+	{
+		log("  Cell `%s' is identical to cell `%s'.\n", cell->name.c_str(), other->name.c_str());
+
+		for (auto &it : cell->connections())
+		{
+			if (!cell->output(it.first))
+				continue;
+
+			RTLIL::SigSpec other_sig = other->getPort(it.first);
+			log("    Redirecting output %s: %s = %s\n", it.first.c_str(),
+					log_signal(it.second), log_signal(other_sig));
+
+			// the representatives of both signals may change, so the readers of
+			// both of them need to be re-hashed
+			RTLIL::SigSpec old_sig = assign_map(it.second);
+			RTLIL::SigSpec old_other_sig = assign_map(other_sig);
+
+			module->connect(RTLIL::SigSig(it.second, other_sig));
+			assign_map.add(it.second, other_sig);
+
+			for (int i = 0; i < GetSize(old_sig); i++)
+			{
+				RTLIL::SigBit new_bit = assign_map(old_sig[i]);
+				pool<RTLIL::Cell*> readers;
+
+				for (auto bit : {old_sig[i], old_other_sig[i]})
+					if (bit.wire != nullptr && bit_readers.count(bit)) {
+						for (auto reader : bit_readers.at(bit))
+							readers.insert(reader);
+						if (bit != new_bit)
+							bit_readers.erase(bit);
+					}
+
+				for (auto reader : readers)
+					queue_cell(reader);
+
+				if (new_bit.wire != nullptr && !readers.empty())
+					bit_readers[new_bit] = readers;
+			}
 		}
-	};
 
-	OptMergeWorker(RTLIL::Design *design, RTLIL::Module *module, bool mode_nomux, bool mode_share_all) :
+		log("    Removing %s cell `%s' from module `%s'.\n", cell->type.c_str(), cell->name.c_str(), module->name.c_str());
+		removed_cells.insert(cell);
+		total_count++;
+	}
+
+	OptMergeWorker(RTLIL::Design *design, RTLIL::Module *module, bool mode_nomux, bool mode_share_all, int hash_bits) :
 		design(design), module(module), assign_map(module), mode_share_all(mode_share_all)
 	{
+		key_mask = hash_bits < 64 ? (uint64_t(1) << hash_bits) - 1 : ~uint64_t(0);
 		total_count = 0;
 		ct.setup_internals();
 		ct.setup_internals_mem();
@@ -294,48 +324,45 @@ struct OptMergeWorker
 						dff_init_map.add(SigBit(it.second, i), initval[i]);
 			}
 
-		bool did_something = true;
-		while (did_something)
+		for (auto &it : module->cells_)
 		{
-#ifdef USE_CELL_HASH_CACHE
-			cell_hash_cache.clear();
-#endif
-			std::vector<RTLIL::Cell*> cells;
-			cells.reserve(module->cells_.size());
-			for (auto &it : module->cells_) {
-				if (!design->selected(module, it.second))
-					continue;
-				if (ct.cell_known(it.second->type) || (mode_share_all && it.second->known()))
-					cells.push_back(it.second);
-			}
+			RTLIL::Cell *cell = it.second;
 
-			did_something = false;
-			std::map<RTLIL::Cell*, RTLIL::Cell*, CompareCells> sharemap(CompareCells(this));
-			for (auto cell : cells)
-			{
-				if (sharemap.count(cell) > 0) {
-					did_something = true;
-					log("  Cell `%s' is identical to cell `%s'.\n", cell->name.c_str(), sharemap[cell]->name.c_str());
-					for (auto &it : cell->connections()) {
-						if (cell->output(it.first)) {
-							RTLIL::SigSpec other_sig = sharemap[cell]->getPort(it.first);
-							log("    Redirecting output %s: %s = %s\n", it.first.c_str(),
-									log_signal(it.second), log_signal(other_sig));
-							module->connect(RTLIL::SigSig(it.second, other_sig));
-							assign_map.add(it.second, other_sig);
-						}
-					}
-					log("    Removing %s cell `%s' from module `%s'.\n", cell->type.c_str(), cell->name.c_str(), module->name.c_str());
-#ifdef USE_CELL_HASH_CACHE
-					cell_hash_cache.erase(cell);
-#endif
-					module->remove(cell);
-					total_count++;
-				} else {
-					sharemap[cell] = cell;
-				}
+			if (!design->selected(module, cell) || !mergeable(cell))
+				continue;
+
+			for (auto &conn : cell->connections())
+				if (!cell->output(conn.first))
+					for (auto bit : assign_map(conn.second))
+						if (bit.wire != nullptr)
+							bit_readers[bit].insert(cell);
+
+			queue_cell(cell);
+		}
+
+		// only the readers of merged cells are revisited
+		for (int i = 0; i < GetSize(worklist); i++)
+		{
+			RTLIL::Cell *cell = worklist[i];
+
+			if (removed_cells.count(cell))
+				continue;
+
+			queued_cells.erase(cell);
+
+			uint64_t key = hash_cell_parameters_and_connections(cell);
+			RTLIL::Cell *other = find_identical_cell(cell, key);
+
+			if (other != nullptr) {
+				merge_cell(cell, other);
+			} else {
+				known_cells[key].push_back(cell);
+				cell_keys[cell] = key;
 			}
 		}
+
+		for (auto cell : removed_cells)
+			module->remove(cell);
 	}
 };
 
@@ -356,6 +383,15 @@ struct OptMergePass : public Pass {
 		log("    -share_all\n");
 		log("        Operate on all cell types, not just built-in types.\n");
 		log("\n");
+		log("    -hashbits <N>\n");
+		log("        Only use N bits of the hash key of each cell (default: 64). This makes\n");
+		log("        hash collisions likely and is only useful for testing.\n");
+		log("\n");
+		log("    -j <threads>\n");
+		log("        Process up to <threads> modules in parallel. The default is set with\n");
+		log("        'yosys -j'. The log output and the result are the same as for a\n");
+		log("        serial run.\n");
+		log("\n");
 	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
@@ -363,6 +399,8 @@ struct OptMergePass : public Pass {
 
 		bool mode_nomux = false;
 		bool mode_share_all = false;
+		int hash_bits = 64;
+		int num_threads = 0;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
@@ -375,15 +413,35 @@ struct OptMergePass : public Pass {
 				mode_share_all = true;
 				continue;
 			}
+			if (arg == "-hashbits" && argidx+1 < args.size()) {
+				hash_bits = atoi(args[++argidx].c_str());
+				if (hash_bits < 0 || hash_bits > 64)
+					log_cmd_error("Invalid argument for -hashbits: %d\n", hash_bits);
+				continue;
+			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				num_threads = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		// design monitors would be called from several threads at once
+		if (!design->monitors.empty())
+			num_threads = 1;
+
+		std::vector<RTLIL::Module*> modules = design->selected_modules();
+		std::vector<int> module_count(GetSize(modules));
+
+		parallel_for(GetSize(modules), [&](int i) {
+			OptMergeWorker worker(design, modules[i], mode_nomux, mode_share_all, hash_bits);
+			module_count[i] = worker.total_count;
+		}, num_threads);
+
 		int total_count = 0;
-		for (auto module : design->selected_modules()) {
-			OptMergeWorker worker(design, module, mode_nomux, mode_share_all);
-			total_count += worker.total_count;
-		}
+		for (int count : module_count)
+			total_count += count;
 
 		if (total_count)
 			design->scratchpad_set_bool("opt.did_something", true);
@@ -21,6 +21,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/celltypes.h"
+#include "passes/opt/opt_dirty.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <set>
@@ -242,11 +243,13 @@ struct OptReduceWorker
 		}
 	}
 
-	OptReduceWorker(RTLIL::Design *design, RTLIL::Module *module, bool do_fine) :
+	OptReduceWorker(RTLIL::Design *design, RTLIL::Module *module, bool do_fine, OptDirtyMonitor *dirty, int dirty_since) :
 			design(design), module(module), assign_map(module)
 	{
 		log("  Optimizing cells in module %s.\n", module->name.c_str());
 
+		OptDirtyFilter dirty_filter(module, dirty, dirty_since, assign_map);
+
 		total_count = 0;
 		did_something = true;
 
@@ -297,7 +300,8 @@ struct OptReduceWorker
 					if (cell->type != type || !design->selected(module, cell))
 						continue;
 					drivers.insert(assign_map(cell->getPort("\\Y")), cell);
-					cells.insert(cell);
+					if (dirty_filter.check(cell, assign_map))
+						cells.insert(cell);
 				}
 
 				while (cells.size() > 0) {
@@ -311,7 +315,8 @@ struct OptReduceWorker
 			std::vector<RTLIL::Cell*> cells;
 
 			for (auto &it : module->cells_)
-				if ((it.second->type == "$mux" || it.second->type == "$pmux") && design->selected(module, it.second))
+				if ((it.second->type == "$mux" || it.second->type == "$pmux") && design->selected(module, it.second) &&
+						dirty_filter.check(it.second, assign_map))
 					cells.push_back(it.second);
 
 			for (auto cell : cells)
@@ -372,12 +377,17 @@ struct OptReducePass : public Pass {
 
 		int total_count = 0;
 		for (auto module : design->selected_modules())
+		{
+			int dirty_since;
+			OptDirtyMonitor *dirty = opt_dirty_begin(module, "opt_reduce", dirty_since);
+
 			while (1) {
-				OptReduceWorker worker(design, module, do_fine);
+				OptReduceWorker worker(design, module, do_fine, dirty, dirty_since);
 				total_count += worker.total_count;
 				if (worker.total_count == 0)
 					break;
 			}
+		}
 
 		if (total_count)
 			design->scratchpad_set_bool("opt.did_something", true);
@@ -20,6 +20,7 @@
 #include "kernel/register.h"
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
+#include "passes/opt/opt_dirty.h"
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -436,6 +437,10 @@ struct OptRmdffPass : public Pass {
 			mux_drivers.clear();
 			init_attributes.clear();
 
+			int dirty_since;
+			OptDirtyMonitor *dirty = opt_dirty_begin(module, "opt_rmdff", dirty_since);
+			OptDirtyFilter dirty_filter(module, dirty, dirty_since, assign_map);
+
 			for (auto wire : module->wires())
 			{
 				if (wire->attributes.count("\\init") != 0) {
@@ -476,7 +481,7 @@ struct OptRmdffPass : public Pass {
 					continue;
 				}
 
-				if (!design->selected(module, cell))
+				if (!design->selected(module, cell) || !dirty_filter.check(cell, assign_map))
 					continue;
 
 				if (cell->type.in("$_DFFSR_NNN_", "$_DFFSR_NNP_", "$_DFFSR_NPN_", "$_DFFSR_NPP_",
@@ -322,6 +322,9 @@ struct WreduceWorker
 		for (auto w : module->wires())
 			complete_wires.insert(mi.sigmap(w));
 
+		// rename the wires after the loop, renaming invalidates the ModIndex
+		std::vector<std::pair<Wire*, Wire*>> swap_wires;
+
 		for (auto w : module->selected_wires())
 		{
 			int unused_top_bits = 0;
@@ -346,8 +349,11 @@ struct WreduceWorker
 			log("Removed top %d bits (of %d) from wire %s.%s.\n", unused_top_bits, GetSize(w), log_id(module), log_id(w));
 			Wire *nw = module->addWire(NEW_ID, GetSize(w) - unused_top_bits);
 			module->connect(nw, SigSpec(w).extract(0, GetSize(nw)));
-			module->swap_names(w, nw);
+			swap_wires.push_back(std::make_pair(w, nw));
 		}
+
+		for (auto &it : swap_wires)
+			module->swap_names(it.first, it.second);
 	}
 };
 
@@ -488,6 +488,7 @@ struct ExposePass : public Pass {
 
 				for (auto &conn : module->connections_)
 					conn.second = out_to_in_map(sigmap(conn.second));
+				module->invalidate_sigmap();
 			}
 
 			std::set<RTLIL::SigBit> set_q_bits;
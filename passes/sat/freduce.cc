@@ -23,6 +23,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/satgen.h"
+#include "kernel/randsim.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -31,10 +32,12 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-bool inv_mode;
-int verbose_level, reduce_counter, reduce_stop_at;
+bool inv_mode, sim_mode;
+int verbose_level, reduce_counter, reduce_stop_at, num_threads;
 typedef std::map<RTLIL::SigBit, std::pair<RTLIL::Cell*, std::set<RTLIL::SigBit>>> drivers_t;
+typedef std::map<std::vector<RTLIL::SigBit>, std::vector<RTLIL::SigBit>> buckets_t;
 std::string dump_prefix;
+SatBudget sat_budget;
 
 struct equiv_bit_t
 {
@@ -76,14 +79,16 @@ struct FindReducedInputs
 	ezSatPtr ez;
 	std::set<RTLIL::Cell*> ez_cells;
 	SatGen satgen;
+	SatBudget &budget;
 
 	std::map<RTLIL::SigBit, int> sat_pi;
 	std::vector<int> sat_pi_uniq_bitvec;
 
-	FindReducedInputs(SigMap &sigmap, drivers_t &drivers) :
-			sigmap(sigmap), drivers(drivers), satgen(ez.get(), &sigmap)
+	FindReducedInputs(SigMap &sigmap, drivers_t &drivers, SatBudget &budget) :
+			sigmap(sigmap), drivers(drivers), satgen(ez.get(), &sigmap), budget(budget)
 	{
 		satgen.model_undef = true;
+		budget.setup(ez.get());
 	}
 
 	int get_bits(int val)
@@ -201,7 +206,20 @@ struct FindReducedInputs
 					model_expr.push_back(sat_pi.at(pi[i]));
 				}
 
-			if (!ez->solve(model_expr, model, ez->expression(ezSAT::OpOr, model_expr), ez->XOR(output_a, output_b), ez->NOT(output_undef_a), ez->NOT(output_undef_b)))
+			bool found_model = ez->solve(model_expr, model, ez->expression(ezSAT::OpOr, model_expr), ez->XOR(output_a, output_b), ez->NOT(output_undef_a), ez->NOT(output_undef_b));
+
+			if (verbose_level >= 2 && budget.limited())
+				log("         SAT solver used %s.\n", budget.usage(ez.get()).c_str());
+
+			// the full input cone is a valid (but less useful) bucket key
+			if (budget.out_of_budget(ez.get())) {
+				if (verbose_level >= 1)
+					log("         SAT solver ran out of budget, using the full input cone.\n");
+				unused_pi_idx.clear();
+				break;
+			}
+
+			if (!found_model)
 				break;
 
 			int found_count = 0;
@@ -240,6 +258,24 @@ struct PerformReduction
 	std::vector<int> out_depth;
 	int cone_size;
 
+	// once a query runs out of budget, all further queries fail and the
+	// results for this bucket are discarded by the caller
+	SatBudget &budget;
+	bool out_of_budget;
+
+	template<typename... Args>
+	bool solve(Args&&... args)
+	{
+		if (out_of_budget)
+			return false;
+		bool result = ez->solve(std::forward<Args>(args)...);
+		if (verbose_level >= 2 && budget.limited())
+			log("      SAT solver used %s.\n", budget.usage(ez.get()).c_str());
+		if (budget.out_of_budget(ez.get()))
+			out_of_budget = true;
+		return result;
+	}
+
 	int register_cone_worker(std::set<RTLIL::Cell*> &celldone, std::map<RTLIL::SigBit, int> &sigdepth, RTLIL::SigBit out)
 	{
 		if (out.wire == NULL)
@@ -278,10 +314,12 @@ struct PerformReduction
 		return sigdepth.at(out);
 	}
 
-	PerformReduction(SigMap &sigmap, drivers_t &drivers, std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs, std::vector<RTLIL::SigBit> &bits, int cone_size) :
-			sigmap(sigmap), drivers(drivers), inv_pairs(inv_pairs), satgen(ez.get(), &sigmap), out_bits(bits), cone_size(cone_size)
+	PerformReduction(SigMap &sigmap, drivers_t &drivers, std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs, std::vector<RTLIL::SigBit> &bits, int cone_size,
+			SatBudget &budget) : sigmap(sigmap), drivers(drivers), inv_pairs(inv_pairs), satgen(ez.get(), &sigmap), out_bits(bits), cone_size(cone_size),
+			budget(budget), out_of_budget(false)
 	{
 		satgen.model_undef = true;
+		budget.setup(ez.get());
 
 		std::set<RTLIL::Cell*> celldone;
 		std::map<RTLIL::SigBit, int> sigdepth;
@@ -293,8 +331,11 @@ struct PerformReduction
 		}
 
 		if (inv_mode && cone_size > 0) {
-			if (!ez->solve(sat_out, out_inverted, ez->expression(ezSAT::OpAnd, sat_def)))
-				log_error("Solving for initial model failed!\n");
+			if (!solve(sat_out, out_inverted, ez->expression(ezSAT::OpAnd, sat_def))) {
+				if (!out_of_budget)
+					log_error("Solving for initial model failed!\n");
+				out_inverted = std::vector<bool>(sat_out.size(), false);
+			}
 			for (size_t i = 0; i < sat_out.size(); i++)
 				if (out_inverted.at(i))
 					sat_out[i] = ez->NOT(sat_out[i]);
@@ -307,8 +348,8 @@ struct PerformReduction
 		if (verbose_level == 1)
 			log("    Finding const value for %s.\n", log_signal(out_bits[idx]));
 
-		bool can_be_set = ez->solve(ez->AND(sat_out[idx], sat_def[idx]));
-		bool can_be_clr = ez->solve(ez->AND(ez->NOT(sat_out[idx]), sat_def[idx]));
+		bool can_be_set = solve(ez->AND(sat_out[idx], sat_def[idx]));
+		bool can_be_clr = solve(ez->AND(ez->NOT(sat_out[idx]), sat_def[idx]));
 		log_assert(!can_be_set || !can_be_clr);
 
 		RTLIL::SigBit value(RTLIL::State::Sx);
@@ -377,7 +418,7 @@ struct PerformReduction
 		if (verbose_level >= 2)
 			modelVars.insert(modelVars.end(), sat_pi.begin(), sat_pi.end());
 
-		if (ez->solve(modelVars, model, ez->expression(ezSAT::OpOr, sat_set_list), ez->expression(ezSAT::OpOr, sat_clr_list)))
+		if (solve(modelVars, model, ez->expression(ezSAT::OpOr, sat_set_list), ez->expression(ezSAT::OpOr, sat_clr_list)))
 		{
 			int iter_count = 1;
 
@@ -396,7 +437,7 @@ struct PerformReduction
 						sat_def_list.push_back(sat_def[idx]);
 					}
 
-				if (!ez->solve(modelVars, model, ez->expression(ezSAT::OpOr, sat_set_list), ez->expression(ezSAT::OpOr, sat_clr_list), ez->expression(ezSAT::OpAnd, sat_def_list)))
+				if (!solve(modelVars, model, ez->expression(ezSAT::OpOr, sat_set_list), ez->expression(ezSAT::OpOr, sat_clr_list), ez->expression(ezSAT::OpAnd, sat_def_list)))
 					break;
 				iter_count++;
 			}
@@ -442,7 +483,7 @@ struct PerformReduction
 				for (int idx2 : bucket)
 					if (idx != idx2)
 						sat_def_list.push_back(sat_def[idx2]);
-				if (ez->solve(ez->NOT(sat_def[idx]), ez->expression(ezSAT::OpOr, sat_def_list)))
+				if (solve(ez->NOT(sat_def[idx]), ez->expression(ezSAT::OpOr, sat_def_list)))
 					undef_slaves.push_back(idx);
 			}
 
@@ -516,7 +557,7 @@ struct PerformReduction
 				for (int idx2 : r)
 					if (idx != idx2)
 						sat_def_list.push_back(sat_def[idx2]);
-				if (ez->solve(ez->NOT(sat_def[idx]), ez->expression(ezSAT::OpOr, sat_def_list)))
+				if (solve(ez->NOT(sat_def[idx]), ez->expression(ezSAT::OpOr, sat_def_list)))
 					undef_slaves.push_back(idx);
 			}
 
@@ -597,6 +638,48 @@ struct FreduceWorker
 		return find_bit_in_cone(celldone, needle, haystack);
 	}
 
+	// job_worker(sigmap, budget, idx) solves item idx and returns the number of
+	// signal bits it has processed. the SigMap and the SatBudget (which collects
+	// the solver statistics) are private to the calling thread.
+	void run_jobs(const char *what, int num_items, const std::function<int(SigMap&, SatBudget&, int)> &job_worker)
+	{
+		int num_jobs = num_threads > 1 ? min(num_items, 4*num_threads) : 1;
+		std::vector<int> job_items(num_jobs), job_bits(num_jobs);
+		std::vector<double> job_sec(num_jobs);
+		std::vector<SatBudget> job_budget(num_jobs);
+
+		for (auto &b : job_budget)
+			b.limits = sat_budget.limits;
+
+		parallel_for(num_jobs, [&](int job)
+		{
+			PerformanceTimer timer;
+			timer.begin();
+
+			SigMap job_sigmap;
+			if (num_jobs > 1)
+				job_sigmap = sigmap;
+
+			for (int i = job * num_items / num_jobs; i < (job+1) * num_items / num_jobs; i++) {
+				job_bits[job] += job_worker(num_jobs > 1 ? job_sigmap : sigmap, job_budget[job], i);
+				job_items[job]++;
+			}
+
+			timer.end();
+			job_sec[job] = timer.sec();
+		}, num_threads);
+
+		for (auto &b : job_budget)
+			sat_budget.merge(b);
+
+		if (num_jobs > 1) {
+			log("  %s using %d jobs on up to %d threads:\n", what, num_jobs, num_threads);
+			for (int job = 0; job < num_jobs; job++)
+				log("    job %3d: %5d SAT problems, %6d signal bits, %8.2f sec (%.1f bits/sec)\n", job, job_items[job], job_bits[job],
+						job_sec[job], job_sec[job] > 0 ? job_bits[job] / job_sec[job] : 0.0);
+		}
+	}
+
 	void dump()
 	{
 		std::string filename = stringf("%s_%s_%05d.il", dump_prefix.c_str(), RTLIL::id2cstr(module->name), reduce_counter);
@@ -639,34 +722,100 @@ struct FreduceWorker
 				inv_pairs.insert(std::pair<RTLIL::SigBit, RTLIL::SigBit>(sigmap(it.second->getPort("\\A")), sigmap(it.second->getPort("\\Y"))));
 		}
 
+		// the SAT problems for the batches and buckets below are independent of
+		// each other and only read the module, so they are solved in parallel jobs
+		// with one solver per batch/bucket. each job works on a contiguous range of
+		// batches/buckets and the results are merged in the original order.
+
+		if (num_threads > 1)
+			for (auto &it : module->cells_)
+				for (auto &conn : it.second->connections())
+					conn.second.chunks();
+
 		int bits_count = 0;
 		int bits_full_count = 0;
-		std::map<std::vector<RTLIL::SigBit>, std::vector<RTLIL::SigBit>> buckets;
+		std::vector<std::set<RTLIL::SigBit>*> selected_batches;
+		std::vector<int> selected_batches_progress;
 		for (auto &batch : batches)
 		{
 			for (auto &bit : batch)
-				if (bit.wire != NULL && design->selected(module, bit.wire))
-					goto found_selected_wire;
+				if (bit.wire != NULL && design->selected(module, bit.wire)) {
+					selected_batches.push_back(&batch);
+					selected_batches_progress.push_back(bits_full_count);
+					break;
+				}
 			bits_full_count += batch.size();
-			continue;
+		}
+
+		std::vector<std::vector<std::pair<std::vector<RTLIL::SigBit>, RTLIL::SigBit>>> batch_results(selected_batches.size());
 
-		found_selected_wire:
+		run_jobs("Finding reduced input cones", GetSize(selected_batches), [&](SigMap &job_sigmap, SatBudget &job_budget, int i) {
+			std::set<RTLIL::SigBit> &batch = *selected_batches[i];
 			log("  Finding reduced input cone for signal batch %s%c\n",
 					log_signal(batch), verbose_level ? ':' : '.');
 
-			FindReducedInputs infinder(sigmap, drivers);
+			int progress = selected_batches_progress[i];
+			FindReducedInputs infinder(job_sigmap, drivers, job_budget);
 			for (auto &bit : batch) {
 				std::vector<RTLIL::SigBit> inputs;
-				infinder.analyze(inputs, bit, 100 * bits_full_count / bits_full_total);
-				buckets[inputs].push_back(bit);
-				bits_full_count++;
+				infinder.analyze(inputs, bit, 100 * progress++ / bits_full_total);
+				batch_results[i].push_back(std::pair<std::vector<RTLIL::SigBit>, RTLIL::SigBit>(inputs, bit));
+			}
+			return GetSize(batch);
+		});
+
+		buckets_t buckets;
+		for (auto &results : batch_results)
+			for (auto &it : results) {
+				buckets[it.first].push_back(it.second);
 				bits_count++;
 			}
-		}
 		log("  Sorted %d signal bits into %d buckets.\n", bits_count, int(buckets.size()));
 
-		int bucket_count = 0;
-		std::vector<std::vector<equiv_bit_t>> equiv;
+		// random simulation: signals in the same bucket that have different
+		// (defined) values for one of the random input patterns can not be
+		// equivalent, so the buckets are split by their simulated values first.
+		// this is only done for buckets in which all signals are defined in all
+		// patterns, as undefined signals can be merged with any other signal.
+		dict<RTLIL::SigBit, std::vector<uint64_t>> signatures;
+		if (sim_mode)
+		{
+			pool<RTLIL::SigBit> sim_bits;
+			for (auto &bucket : buckets)
+				if (bucket.first.size() != 0 && bucket.second.size() > 1)
+					sim_bits.insert(bucket.second.begin(), bucket.second.end());
+
+			RandomSim sim(module, sigmap, 1, true);
+			RandomSim::State state;
+			pool<RTLIL::SigBit> undef_bits;
+
+			for (int round = 0; round < 4; round++) {
+				sim.init(state, round);
+				sim.run(state);
+				for (auto &bit : sim_bits) {
+					uint64_t val, def;
+					sim.get(state, bit, 0, val, def);
+					if (def != ~uint64_t(0))
+						undef_bits.insert(bit);
+					signatures[bit].push_back(val);
+				}
+			}
+
+			for (auto &bit : undef_bits)
+				signatures.erase(bit);
+
+			// with -inv a signal and its inverse must end up in the same bucket
+			if (inv_mode)
+				for (auto &it : signatures)
+					if (it.second.front() & 1)
+						for (auto &word : it.second)
+							word = ~word;
+		}
+
+		int bucket_count = 0, sim_split_count = 0;
+		std::vector<const std::vector<RTLIL::SigBit>*> reduce_inputs;
+		std::vector<std::vector<RTLIL::SigBit>> reduce_bits;
+		std::vector<int> reduce_progress;
 		for (auto &bucket : buckets)
 		{
 			bucket_count++;
@@ -674,18 +823,65 @@ struct FreduceWorker
 			if (bucket.second.size() == 1)
 				continue;
 
-			if (bucket.first.size() == 0) {
-				log("  Finding const values for bucket %s%c\n", log_signal(bucket.second), verbose_level ? ':' : '.');
-				PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
-				for (size_t idx = 0; idx < bucket.second.size(); idx++)
-					worker.analyze_const(equiv, idx);
-			} else {
-				log("  Trying to shatter bucket %s%c\n", log_signal(bucket.second), verbose_level ? ':' : '.');
-				PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
-				worker.analyze(equiv, 100 * bucket_count / (buckets.size() + 1));
+			std::vector<std::vector<RTLIL::SigBit>> parts;
+			std::map<std::vector<uint64_t>, int> part_index;
+
+			for (auto &bit : bucket.second)
+				if (signatures.count(bit) == 0) {
+					parts.clear();
+					break;
+				} else {
+					auto it = part_index.find(signatures.at(bit));
+					if (it == part_index.end()) {
+						it = part_index.insert(std::pair<std::vector<uint64_t>, int>(signatures.at(bit), GetSize(parts))).first;
+						parts.push_back(std::vector<RTLIL::SigBit>());
+					}
+					parts[it->second].push_back(bit);
+				}
+
+			if (parts.empty())
+				parts.push_back(bucket.second);
+			else if (parts.size() > 1)
+				sim_split_count++;
+
+			for (auto &part : parts) {
+				if (part.size() == 1)
+					continue;
+				reduce_inputs.push_back(&bucket.first);
+				reduce_bits.push_back(part);
+				reduce_progress.push_back(100 * bucket_count / (buckets.size() + 1));
 			}
 		}
 
+		if (sim_mode)
+			log("  Random simulation split %d buckets, %d buckets are left for SAT solving.\n", sim_split_count, GetSize(reduce_bits));
+
+		std::vector<std::vector<std::vector<equiv_bit_t>>> bucket_results(reduce_bits.size());
+
+		run_jobs("Reducing buckets", GetSize(reduce_bits), [&](SigMap &job_sigmap, SatBudget &job_budget, int i) {
+			const std::vector<RTLIL::SigBit> &inputs = *reduce_inputs[i];
+			std::vector<RTLIL::SigBit> &bits = reduce_bits[i];
+			if (inputs.size() == 0)
+				log("  Finding const values for bucket %s%c\n", log_signal(bits), verbose_level ? ':' : '.');
+			else
+				log("  Trying to shatter bucket %s%c\n", log_signal(bits), verbose_level ? ':' : '.');
+			PerformReduction worker(job_sigmap, drivers, inv_pairs, bits, inputs.size(), job_budget);
+			if (inputs.size() == 0) {
+				for (size_t idx = 0; idx < bits.size(); idx++)
+					worker.analyze_const(bucket_results[i], idx);
+			} else
+				worker.analyze(bucket_results[i], reduce_progress[i]);
+			if (worker.out_of_budget) {
+				log("  SAT solver ran out of budget for bucket %s, not reducing it.\n", log_signal(bits));
+				bucket_results[i].clear();
+			}
+			return GetSize(bits);
+		});
+
+		std::vector<std::vector<equiv_bit_t>> equiv;
+		for (auto &results : bucket_results)
+			equiv.insert(equiv.end(), results.begin(), results.end());
+
 		std::map<RTLIL::SigBit, int> bitusage;
 		CountBitUsage bitusage_worker(sigmap, bitusage);
 		module->rewrite_sigspecs(bitusage_worker);
@@ -784,6 +980,21 @@ struct FreducePass : public Pass {
 		log("        dump the design to <prefix>_<module>_<num>.il after each reduction\n");
 		log("        operation. this is mostly used for debugging the freduce command.\n");
 		log("\n");
+		log("    -j <threads>\n");
+		log("        solve the SAT problems for the signal batches and buckets of a module\n");
+		log("        on up to <threads> threads, each with its own SAT solver. The result\n");
+		log("        does not depend on the number of threads. (default: value of 'yosys -j')\n");
+		log("\n");
+		log("    -nosim\n");
+		log("        do not use random simulation to split the buckets of candidate signals\n");
+		log("        before solving SAT problems for them.\n");
+		log("\n");
+		log("    -timeout <N>\n");
+		log("    -conflict-limit <N>\n");
+		log("    -propagation-limit <N>\n");
+		log("        limit the seconds, conflicts or propagations of each SAT solver call.\n");
+		log("        buckets for which the solver runs out of budget are not reduced.\n");
+		log("\n");
 		log("This pass is undef-aware, i.e. it considers don't-care values for detecting\n");
 		log("equivalent nodes.\n");
 		log("\n");
@@ -797,7 +1008,10 @@ struct FreducePass : public Pass {
 		reduce_stop_at = 0;
 		verbose_level = 0;
 		inv_mode = false;
+		sim_mode = true;
+		num_threads = 0;
 		dump_prefix = std::string();
+		sat_budget = SatBudget();
 
 		log_header(design, "Executing FREDUCE pass (perform functional reduction).\n");
 
@@ -815,6 +1029,10 @@ struct FreducePass : public Pass {
 				inv_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-nosim") {
+				sim_mode = false;
+				continue;
+			}
 			if (args[argidx] == "-stop" && argidx+1 < args.size()) {
 				reduce_stop_at = atoi(args[++argidx].c_str());
 				continue;
@@ -823,10 +1041,23 @@ struct FreducePass : public Pass {
 				dump_prefix = args[++argidx];
 				continue;
 			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				num_threads = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (sat_budget.parse_arg(args, argidx))
+				continue;
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		if (num_threads <= 0)
+			num_threads = yosys_threads;
+
+		// design monitors would be called from several threads at once
+		if (!design->monitors.empty())
+			num_threads = 1;
+
 		int bitcount = 0;
 		for (auto &mod_it : design->modules_) {
 			RTLIL::Module *module = mod_it.second;
@@ -834,6 +1065,8 @@ struct FreducePass : public Pass {
 				bitcount += FreduceWorker(design, module).run();
 		}
 
+		if (sat_budget.limited())
+			sat_budget.log_stats("SAT solver: ");
 		log("Rewired a total of %d signal bits.\n", bitcount);
 	}
 } FreducePass;
@@ -62,11 +62,13 @@ struct SatHelper
 	std::vector<std::string> shows;
 	SigPool show_signal_pool;
 	SigSet<RTLIL::Cell*> show_drivers;
-	int max_timestep, timeout;
+	int max_timestep;
+	SatBudget budget;
 	bool gotTimeout;
+	float last_solve_sec;
 
-	SatHelper(RTLIL::Design *design, RTLIL::Module *module, bool enable_undef) :
-		design(design), module(module), sigmap(module), ct(design), satgen(ez.get(), &sigmap)
+	SatHelper(RTLIL::Design *design, RTLIL::Module *module, bool enable_undef, SatSolver *solver) :
+		design(design), module(module), sigmap(module), ct(design), ez(solver), satgen(ez.get(), &sigmap)
 	{
 		this->enable_undef = enable_undef;
 		satgen.model_undef = enable_undef;
@@ -75,8 +77,8 @@ struct SatHelper
 		set_init_zero = false;
 		ignore_unknown_cells = false;
 		max_timestep = -1;
-		timeout = 0;
 		gotTimeout = false;
+		last_solve_sec = 0;
 	}
 
 	void check_undef_enabled(const RTLIL::SigSpec &sig)
@@ -435,20 +437,32 @@ struct SatHelper
 	bool solve(const std::vector<int> &assumptions)
 	{
 		log_assert(gotTimeout == false);
-		ez->setSolverTimeout(timeout);
+		budget.setup(ez.get());
+		PerformanceTimer timer;
+		timer.begin();
 		bool success = ez->solve(modelExpressions, modelValues, assumptions);
-		if (ez->getSolverTimoutStatus())
+		timer.end();
+		last_solve_sec = timer.sec();
+		if (budget.out_of_budget(ez.get()))
 			gotTimeout = true;
+		if (budget.limited())
+			log("SAT solver used %s.\n", budget.usage(ez.get()).c_str());
 		return success;
 	}
 
 	bool solve(int a = 0, int b = 0, int c = 0, int d = 0, int e = 0, int f = 0)
 	{
 		log_assert(gotTimeout == false);
-		ez->setSolverTimeout(timeout);
+		budget.setup(ez.get());
+		PerformanceTimer timer;
+		timer.begin();
 		bool success = ez->solve(modelExpressions, modelValues, a, b, c, d, e, f);
-		if (ez->getSolverTimoutStatus())
+		timer.end();
+		last_solve_sec = timer.sec();
+		if (budget.out_of_budget(ez.get()))
 			gotTimeout = true;
+		if (budget.limited())
+			log("SAT solver used %s.\n", budget.usage(ez.get()).c_str());
 		return success;
 	}
 
@@ -953,7 +967,16 @@ struct SatPass : public Pass {
 		log("        be numbered from 1 to N.\n");
 		log("\n");
 		log("        note: for large <N> it can be significantly faster to use\n");
-		log("        -tempinduct-baseonly -maxsteps <N> instead of -seq <N>.\n");
+		log("        -incremental or -tempinduct-baseonly -maxsteps <N> instead of\n");
+		log("        just -seq <N>.\n");
+		log("\n");
+		log("    -incremental\n");
+		log("        when proving a property in a sequential problem, add one time step\n");
+		log("        at a time to the solver and check the property for this time step\n");
+		log("        only (using solver assumptions). The solver (and its learned clauses)\n");
+		log("        is reused for all time steps, and the property is assumed to hold\n");
+		log("        for all earlier time steps. The solve time and problem size is\n");
+		log("        reported for each time step.\n");
 		log("\n");
 		log("    -set-at <N> <signal> <value>\n");
 		log("    -unset-at <N> <signal>\n");
@@ -1045,6 +1068,16 @@ struct SatPass : public Pass {
 		log("    -timeout <N>\n");
 		log("        Maximum number of seconds a single SAT instance may take.\n");
 		log("\n");
+		log("    -conflict-limit <N>\n");
+		log("    -propagation-limit <N>\n");
+		log("        Maximum number of conflicts or propagations a single SAT instance\n");
+		log("        may take. Unlike -timeout this gives reproducible results. When any\n");
+		log("        limit is set, the resources used by each SAT instance are printed.\n");
+		log("\n");
+		log("    -solver <name>\n");
+		log("        Use the SAT solver <name> instead of the default solver. See 'help\n");
+		log("        satsolver' for the available solvers and how to add more.\n");
+		log("\n");
 		log("    -verify\n");
 		log("        Return an error and stop the synthesis script if the proof fails.\n");
 		log("\n");
@@ -1064,13 +1097,16 @@ struct SatPass : public Pass {
 		std::map<int, std::vector<std::pair<std::string, std::string>>> sets_at;
 		std::map<int, std::vector<std::string>> unsets_at, sets_def_at, sets_any_undef_at, sets_all_undef_at;
 		std::vector<std::string> shows, sets_def, sets_any_undef, sets_all_undef;
-		int loopcount = 0, seq_len = 0, maxsteps = 0, initsteps = 0, timeout = 0, prove_skip = 0;
+		int loopcount = 0, seq_len = 0, maxsteps = 0, initsteps = 0, prove_skip = 0;
 		bool verify = false, fail_on_timeout = false, enable_undef = false, set_def_inputs = false;
 		bool ignore_div_by_zero = false, set_init_undef = false, set_init_zero = false, max_undef = false;
 		bool tempinduct = false, prove_asserts = false, show_inputs = false, show_outputs = false;
 		bool show_regs = false, show_public = false, show_all = false;
 		bool ignore_unknown_cells = false, falsify = false, tempinduct_def = false, set_init_def = false;
 		bool tempinduct_baseonly = false, tempinduct_inductonly = false, set_assumes = false;
+		bool incremental = false;
+		SatBudget budget;
+		SatSolver *solver = yosys_satsolver;
 		int tempinduct_skip = 0, stepsize = 1;
 		std::string vcd_file_name, json_file_name, cnf_file_name;
 
@@ -1100,8 +1136,12 @@ struct SatPass : public Pass {
 				falsify = true;
 				continue;
 			}
-			if (args[argidx] == "-timeout" && argidx+1 < args.size()) {
-				timeout = atoi(args[++argidx].c_str());
+			if (budget.parse_arg(args, argidx))
+				continue;
+			if (args[argidx] == "-solver" && argidx+1 < args.size()) {
+				solver = find_satsolver(args[++argidx]);
+				if (solver == nullptr)
+					log_cmd_error("There is no SAT solver with the name `%s'.\n", args[argidx].c_str());
 				continue;
 			}
 			if (args[argidx] == "-max" && argidx+1 < args.size()) {
@@ -1211,6 +1251,10 @@ struct SatPass : public Pass {
 				seq_len = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-incremental") {
+				incremental = true;
+				continue;
+			}
 			if (args[argidx] == "-set-at" && argidx+3 < args.size()) {
 				int timestep = atoi(args[++argidx].c_str());
 				std::string lhs = args[++argidx];
@@ -1327,6 +1371,12 @@ struct SatPass : public Pass {
 		if (prove_skip >= seq_len && prove_skip > 0)
 			log_cmd_error("The value of -prove-skip must be smaller than the one of -seq.\n");
 
+		if (incremental && (tempinduct || seq_len == 0 || (!prove.size() && !prove_x.size() && !prove_asserts)))
+			log_cmd_error("Option -incremental requires -seq and something to prove, and can't be used with -tempinduct!\n");
+
+		if (incremental && (loopcount > 0 || max_undef || !cnf_file_name.empty()))
+			log_cmd_error("The options -max, -all, -max_undef, and -dump_cnf are not supported with -incremental!\n");
+
 		if (set_init_undef + set_init_zero + set_init_def > 1)
 			log_cmd_error("The options -set-init-undef, -set-init-def, and -set-init-zero are exclusive!\n");
 
@@ -1376,8 +1426,8 @@ struct SatPass : public Pass {
 			if (loopcount > 0 || max_undef)
 				log_cmd_error("The options -max, -all, and -max_undef are not supported for temporal induction proofs!\n");
 
-			SatHelper basecase(design, module, enable_undef);
-			SatHelper inductstep(design, module, enable_undef);
+			SatHelper basecase(design, module, enable_undef, solver);
+			SatHelper inductstep(design, module, enable_undef, solver);
 
 			basecase.sets = sets;
 			basecase.set_assumes = set_assumes;
@@ -1387,7 +1437,7 @@ struct SatPass : public Pass {
 			basecase.sets_at = sets_at;
 			basecase.unsets_at = unsets_at;
 			basecase.shows = shows;
-			basecase.timeout = timeout;
+			basecase.budget = budget;
 			basecase.sets_def = sets_def;
 			basecase.sets_any_undef = sets_any_undef;
 			basecase.sets_all_undef = sets_all_undef;
@@ -1411,7 +1461,7 @@ struct SatPass : public Pass {
 			inductstep.prove_x = prove_x;
 			inductstep.prove_asserts = prove_asserts;
 			inductstep.shows = shows;
-			inductstep.timeout = timeout;
+			inductstep.budget = budget;
 			inductstep.sets_def = sets_def;
 			inductstep.sets_any_undef = sets_any_undef;
 			inductstep.sets_all_undef = sets_all_undef;
@@ -1463,7 +1513,7 @@ struct SatPass : public Pass {
 						if (basecase.gotTimeout)
 							goto timeout;
 
-						log("Base case for induction length %d proven.\n", inductlen);
+						log("Base case for induction length %d proven (%.2f sec).\n", inductlen, basecase.last_solve_sec);
 					}
 					else
 					{
@@ -1523,12 +1573,12 @@ struct SatPass : public Pass {
 						if (!inductstep.solve(inductstep.ez->NOT(property))) {
 							if (inductstep.gotTimeout)
 								goto timeout;
-							log("Induction step proven: SUCCESS!\n");
+							log("Induction step proven (%.2f sec): SUCCESS!\n", inductstep.last_solve_sec);
 							print_qed();
 							goto tip_success;
 						}
 
-						log("Induction step failed. Incrementing induction length.\n");
+						log("Induction step failed (%.2f sec). Incrementing induction length.\n", inductstep.last_solve_sec);
 						inductstep.ez->assume(property);
 						inductstep.print_model();
 					}
@@ -1560,12 +1610,124 @@ struct SatPass : public Pass {
 				log_error("Called with -falsify and proof did succeed!\n");
 			}
 		}
+		else if (incremental)
+		{
+			if (maxsteps > 0)
+				log_cmd_error("The options -maxsteps is only supported for temporal induction proofs!\n");
+
+			SatHelper sathelper(design, module, enable_undef, solver);
+
+			sathelper.sets = sets;
+			sathelper.set_assumes = set_assumes;
+			sathelper.prove = prove;
+			sathelper.prove_x = prove_x;
+			sathelper.prove_asserts = prove_asserts;
+			sathelper.sets_at = sets_at;
+			sathelper.unsets_at = unsets_at;
+			sathelper.shows = shows;
+			sathelper.budget = budget;
+			sathelper.sets_def = sets_def;
+			sathelper.sets_any_undef = sets_any_undef;
+			sathelper.sets_all_undef = sets_all_undef;
+			sathelper.sets_def_at = sets_def_at;
+			sathelper.sets_any_undef_at = sets_any_undef_at;
+			sathelper.sets_all_undef_at = sets_all_undef_at;
+			sathelper.sets_init = sets_init;
+			sathelper.set_init_def = set_init_def;
+			sathelper.set_init_undef = set_init_undef;
+			sathelper.set_init_zero = set_init_zero;
+			sathelper.satgen.ignore_div_by_zero = ignore_div_by_zero;
+			sathelper.ignore_unknown_cells = ignore_unknown_cells;
+
+			int setup_steps = 0, failed_step = 0;
+			float total_solve_sec = 0;
+
+			for (int step = prove_skip + 1; step <= seq_len && failed_step == 0; step++)
+			{
+				int old_clauses = sathelper.ez->numCnfClauses();
+
+				while (setup_steps < step) {
+					setup_steps++;
+					sathelper.setup(setup_steps, setup_steps == 1);
+				}
+
+				int property = sathelper.setup_proof(step);
+
+				log("\n[step %d] Solving problem with %d variables and %d clauses (%d new)..\n", step,
+						sathelper.ez->numCnfVariables(), sathelper.ez->numCnfClauses(), sathelper.ez->numCnfClauses() - old_clauses);
+				log_flush();
+
+				bool found_model = sathelper.solve(sathelper.ez->NOT(property));
+				total_solve_sec += sathelper.last_solve_sec;
+
+				if (sathelper.gotTimeout)
+					goto timeout;
+
+				if (found_model)
+				{
+					log("[step %d] Property fails in this time step (%.2f sec).\n", step, sathelper.last_solve_sec);
+
+					// the model must be valid for all -seq time steps
+					while (setup_steps < seq_len) {
+						setup_steps++;
+						sathelper.setup(setup_steps);
+					}
+
+					sathelper.generate_model();
+
+					found_model = sathelper.solve(sathelper.ez->NOT(property));
+					total_solve_sec += sathelper.last_solve_sec;
+
+					if (sathelper.gotTimeout)
+						goto timeout;
+
+					if (found_model) {
+						failed_step = step;
+						break;
+					}
+
+					log("[step %d] Counter example does not extend to %d time steps.\n", step, seq_len);
+				}
+				else
+					log("[step %d] Property holds (%.2f sec).\n", step, sathelper.last_solve_sec);
+
+				sathelper.ez->assume(property);
+			}
+
+			log("\nTotal solve time for %d time steps: %.2f sec.\n", setup_steps, total_solve_sec);
+
+			if (failed_step)
+			{
+				log("SAT proof finished - model found for time step %d: FAIL!\n", failed_step);
+				print_proof_failed();
+				sathelper.print_model();
+
+				if(!vcd_file_name.empty())
+					sathelper.dump_model_to_vcd(vcd_file_name);
+				if(!json_file_name.empty())
+					sathelper.dump_model_to_json(json_file_name);
+
+				if (verify) {
+					log("\n");
+					log_error("Called with -verify and proof did fail!\n");
+				}
+			}
+			else
+			{
+				log("SAT proof finished - no model found: SUCCESS!\n");
+				print_qed();
+				if (falsify) {
+					log("\n");
+					log_error("Called with -falsify and proof did succeed!\n");
+				}
+			}
+		}
 		else
 		{
 			if (maxsteps > 0)
 				log_cmd_error("The options -maxsteps is only supported for temporal induction proofs!\n");
 
-			SatHelper sathelper(design, module, enable_undef);
+			SatHelper sathelper(design, module, enable_undef, solver);
 
 			sathelper.sets = sets;
 			sathelper.set_assumes = set_assumes;
@@ -1575,7 +1737,7 @@ struct SatPass : public Pass {
 			sathelper.sets_at = sets_at;
 			sathelper.unsets_at = unsets_at;
 			sathelper.shows = shows;
-			sathelper.timeout = timeout;
+			sathelper.budget = budget;
 			sathelper.sets_def = sets_def;
 			sathelper.sets_any_undef = sets_any_undef;
 			sathelper.sets_all_undef = sets_all_undef;
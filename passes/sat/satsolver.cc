@@ -0,0 +1,179 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/satgen.h"
+#include "libs/ezsat/ezcmdline.h"
+#include "libs/ezsat/ezipasir.h"
+
+#ifdef YOSYS_ENABLE_PLUGINS
+#  include <dlfcn.h>
+#endif
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct CmdlineSatSolver : public SatSolver
+{
+	string command;
+
+	CmdlineSatSolver(string name, string command) : SatSolver(name), command(command) { }
+
+	virtual ezSAT *create() YS_OVERRIDE {
+		return new ezCmdlineSAT(command);
+	}
+};
+
+struct IpasirSatSolver : public SatSolver
+{
+	ezIpasirFunctions ipasir;
+
+	IpasirSatSolver(string name, const ezIpasirFunctions &ipasir) : SatSolver(name), ipasir(ipasir) { }
+
+	virtual ezSAT *create() YS_OVERRIDE {
+		return new ezIpasirSAT(ipasir);
+	}
+};
+
+#ifdef YOSYS_ENABLE_IPASIR
+extern "C" {
+	const char *ipasir_signature();
+	void *ipasir_init();
+	void ipasir_release(void *solver);
+	void ipasir_add(void *solver, int32_t lit_or_zero);
+	void ipasir_assume(void *solver, int32_t lit);
+	int ipasir_solve(void *solver);
+	int32_t ipasir_val(void *solver, int32_t lit);
+	void ipasir_set_terminate(void *solver, void *data, int (*terminate)(void *data));
+}
+
+const ezIpasirFunctions linked_ipasir = {
+	ipasir_signature, ipasir_init, ipasir_release, ipasir_add,
+	ipasir_assume, ipasir_solve, ipasir_val, ipasir_set_terminate
+};
+
+// the IPASIR solver that is linked into yosys (see IPASIR_LIBS in the Makefile)
+IpasirSatSolver LinkedIpasirSatSolver("ipasir", linked_ipasir);
+#endif
+
+#ifdef YOSYS_ENABLE_PLUGINS
+ezIpasirFunctions load_ipasir(const string &filename)
+{
+	void *hdl = dlopen(filename.c_str(), RTLD_LAZY|RTLD_LOCAL);
+	if (hdl == NULL)
+		log_cmd_error("Can't load IPASIR library `%s': %s\n", filename.c_str(), dlerror());
+
+	auto lookup = [&](const char *symbol, bool optional) {
+		void *ptr = dlsym(hdl, symbol);
+		if (ptr == NULL && !optional)
+			log_cmd_error("Can't find `%s' in IPASIR library `%s'.\n", symbol, filename.c_str());
+		return ptr;
+	};
+
+	ezIpasirFunctions ipasir;
+	ipasir.signature = (const char *(*)())lookup("ipasir_signature", false);
+	ipasir.init = (void *(*)())lookup("ipasir_init", false);
+	ipasir.release = (void (*)(void*))lookup("ipasir_release", false);
+	ipasir.add = (void (*)(void*, int32_t))lookup("ipasir_add", false);
+	ipasir.assume = (void (*)(void*, int32_t))lookup("ipasir_assume", false);
+	ipasir.solve = (int (*)(void*))lookup("ipasir_solve", false);
+	ipasir.val = (int32_t (*)(void*, int32_t))lookup("ipasir_val", false);
+	ipasir.set_terminate = (void (*)(void*, void*, int (*)(void*)))lookup("ipasir_set_terminate", true);
+	return ipasir;
+}
+#else
+ezIpasirFunctions load_ipasir(const string&)
+{
+	log_cmd_error("This version of yosys is built without plugin support.\n");
+}
+#endif
+
+struct SatSolverPass : public Pass {
+	SatSolverPass() : Pass("satsolver", "select and register SAT solvers") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    satsolver [options] [<name>]\n");
+		log("\n");
+		log("List the available SAT solvers, register new ones, and select the solver <name>\n");
+		log("as default for all commands that use a SAT solver (sat, freduce, equiv_*, ...).\n");
+		log("The sat command can also use another solver with 'sat -solver <name>'.\n");
+		log("\n");
+		log("    -dimacs <name> <command>\n");
+		log("        register a solver that runs <command> (using /bin/sh) for each SAT\n");
+		log("        problem. The problem is passed to the command on stdin in DIMACS CNF\n");
+		log("        format and the result must be printed to stdout in the format used\n");
+		log("        by the SAT competition, e.g. \"kissat -q\" or \"cadical -q\" (use quotes\n");
+		log("        for commands with arguments). Incremental problems are passed in full\n");
+		log("        for each call.\n");
+		log("\n");
+		log("    -ipasir <name> <library>\n");
+		log("        register a solver from a shared library that implements the IPASIR\n");
+		log("        interface for incremental SAT solvers. (requires plugin support)\n");
+		log("\n");
+		log("The solver 'minisat' (the bundled MiniSat 2.2) is always available. A solver\n");
+		log("that implements IPASIR can also be linked into yosys as solver 'ipasir' by\n");
+		log("setting IPASIR_LIBS in the Makefile, and yosys plugins can register solvers\n");
+		log("by creating a SatSolver instance (see kernel/satgen.h).\n");
+		log("\n");
+		log("Solvers registered with -dimacs and -ipasir only support the -timeout\n");
+		log("resource limit, but not the conflict and propagation limits.\n");
+		log("\n");
+	}
+	virtual void execute(std::vector<std::string> args, RTLIL::Design*)
+	{
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if ((args[argidx] == "-dimacs" || args[argidx] == "-ipasir") && argidx+2 < args.size()) {
+				string name = args[argidx+1], arg = args[argidx+2];
+				if (GetSize(arg) >= 2 && arg.front() == '"' && arg.back() == '"')
+					arg = arg.substr(1, GetSize(arg)-2);
+				if (find_satsolver(name) != nullptr)
+					log_cmd_error("There already is a SAT solver with the name `%s'.\n", name.c_str());
+				// registered solvers are never deleted, like loaded plugins
+				if (args[argidx] == "-dimacs")
+					new CmdlineSatSolver(name, arg);
+				else
+					new IpasirSatSolver(name, load_ipasir(arg));
+				log("Registered SAT solver `%s'.\n", name.c_str());
+				argidx += 2;
+				continue;
+			}
+			break;
+		}
+
+		if (argidx+1 < args.size())
+			cmd_error(args, argidx+1, "Extra argument.");
+
+		if (argidx < args.size()) {
+			SatSolver *solver = find_satsolver(args[argidx]);
+			if (solver == nullptr)
+				log_cmd_error("There is no SAT solver with the name `%s'.\n", args[argidx].c_str());
+			yosys_satsolver = solver;
+		}
+
+		log("Available SAT solvers:\n");
+		for (auto solver = yosys_satsolver_list; solver != nullptr; solver = solver->next)
+			log("  %s%s\n", solver->name.c_str(), solver == yosys_satsolver ? " (default)" : "");
+	}
+} SatSolverPass;
+
+PRIVATE_NAMESPACE_END
@@ -20,6 +20,8 @@
 #include "kernel/yosys.h"
 #include "kernel/sigtools.h"
 #include "kernel/celltypes.h"
+#include "kernel/utils.h"
+#include <chrono>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -30,6 +32,7 @@ struct SimShared
 	bool hide_internal = true;
 	bool writeback = false;
 	bool zinit = false;
+	bool quiet = false;
 	int rstlen = 1;
 };
 
@@ -502,6 +505,9 @@ struct SimInstance
 
 		for (auto cell : formal_database)
 		{
+			if (shared->quiet)
+				break;
+
 			string label = log_id(cell);
 			if (cell->attributes.count("\\src"))
 				label = cell->attributes.at("\\src").decode_string();
@@ -569,7 +575,7 @@ struct SimInstance
 			it.second->writeback(wbmods);
 	}
 
-	void write_vcd_header(std::ofstream &f, int &id)
+	void write_vcd_header(std::ostream &f, int &id)
 	{
 		f << stringf("$scope module %s $end\n", log_id(name()));
 
@@ -588,7 +594,7 @@ struct SimInstance
 		f << stringf("$upscope $end\n");
 	}
 
-	void write_vcd_step(std::ofstream &f)
+	void write_vcd_step(std::ostream &f)
 	{
 		for (auto &it : vcd_database)
 		{
@@ -619,39 +625,791 @@ struct SimInstance
 	}
 };
 
+// Compiled simulation of a flat module: The combinational cells are levelized
+// once and lowered to a flat list of instructions over nets. Each net holds 64
+// independent simulation lanes in two bit-planes: 'def' is set for lanes with
+// value S0 or S1 and 'val' is set for S1. In undefined lanes 'val' tells Sz
+// (set) from Sx (clear), so that buffers and muxes pass Sz through like
+// CellTypes::eval() does.
+
+struct SimCompiled
+{
+	enum op_t {
+		OP_BUF, OP_NOT, OP_GATE_NOT, OP_AND, OP_NAND, OP_OR, OP_NOR, OP_XOR, OP_XNOR,
+		OP_ANDNOT, OP_ORNOT, OP_MUX, OP_GENERIC, OP_ACTIVATE
+	};
+
+	// constant nets
+	enum { NET_S0, NET_S1, NET_SX, NET_SZ, NET_FIRST };
+
+	struct insn_t {
+		op_t op;
+		int y, a, b, s;
+		int cell;
+	};
+
+	// cells without a lowering are evaluated lane by lane with CellTypes::eval()
+	struct generic_t {
+		Cell *cell;
+		SigSpec sig_a, sig_b, sig_c, sig_s, sig_y;
+		bool has_a, has_b, has_c, has_d, has_s, has_y;
+	};
+
+	struct ff_t {
+		Cell *cell;
+		bool clkpol;
+		int clk;
+		std::vector<int> d, q;
+		uint64_t past_clk_val, past_clk_def;
+		std::vector<uint64_t> past_d_val, past_d_def;
+	};
+
+	SimShared *shared;
+	Module *module;
+	SigMap sigmap;
+	int num_lanes;
+
+	idict<SigBit, NET_FIRST> net_index;
+	int num_nets;
+	std::vector<uint64_t> val, def;
+
+	// Like the default simulator, a cell is only evaluated once one of its
+	// inputs has changed (or was marked dirty at start-up): until then its
+	// outputs keep their initial value. 'touched' holds the lanes in which a
+	// net has changed, 'active' the lanes in which a cell is evaluated. Both
+	// only ever grow, as evaluating a cell again without a change of its
+	// inputs does not change its outputs.
+	uint64_t lane_mask;
+	std::vector<uint64_t> touched, active;
+	std::vector<std::vector<int>> cell_inputs;
+	int current_cell;
+
+	std::vector<insn_t> insns;
+	std::vector<generic_t> generics;
+	std::vector<ff_t> ffs;
+	std::vector<Cell*> formal_cells;
+
+	std::vector<dict<Wire*, pair<int, Const>>> vcd_database;
+
+	SimCompiled(SimShared *shared, Module *module, int num_lanes) :
+			shared(shared), module(module), sigmap(module), num_lanes(num_lanes), current_cell(-1)
+	{
+		log_assert(num_lanes >= 1 && num_lanes <= 64);
+
+		for (auto wire : module->wires())
+			for (auto bit : sigmap(wire))
+				if (bit.wire != nullptr)
+					net_index(bit);
+
+		num_nets = NET_FIRST + GetSize(net_index);
+
+		TopoSort<Cell*, IdString::compare_ptr_by_name<Cell>> toposort;
+		dict<SigBit, Cell*> driver_cells;
+
+		for (auto cell : module->cells())
+		{
+			if (module->design->module(cell->type) != nullptr)
+				log_cmd_error("Compiled simulation does not support hierarchical designs (cell %s of type %s). Run 'flatten' first.\n",
+						log_id(cell), log_id(cell->type));
+
+			if (cell->type == "$mem")
+				log_cmd_error("Compiled simulation does not support memories (cell %s). Run 'memory_map' first.\n", log_id(cell));
+
+			if (cell->type.in("$dff")) {
+				ff_t ff;
+				ff.cell = cell;
+				ff.clkpol = cell->getParam("\\CLK_POLARITY").as_bool();
+				ff.clk = net(cell->getPort("\\CLK"));
+				for (auto bit : cell->getPort("\\D"))
+					ff.d.push_back(net(bit));
+				for (auto bit : cell->getPort("\\Q"))
+					ff.q.push_back(out_net(bit));
+				ff.past_clk_val = 0;
+				ff.past_clk_def = 0;
+				ff.past_d_val.resize(GetSize(ff.d));
+				ff.past_d_def.resize(GetSize(ff.d));
+				ffs.push_back(ff);
+				continue;
+			}
+
+			if (cell->type.in("$assert", "$cover", "$assume")) {
+				formal_cells.push_back(cell);
+				continue;
+			}
+
+			if (!yosys_celltypes.cell_evaluable(cell->type))
+				log_error("Unsupported cell type: %s (%s.%s)\n", log_id(cell->type), log_id(module), log_id(cell));
+
+			toposort.node(cell);
+			for (auto &conn : cell->connections())
+				if (cell->output(conn.first))
+					for (auto bit : sigmap(conn.second))
+						if (bit.wire != nullptr)
+							driver_cells[bit] = cell;
+		}
+
+		for (auto cell : toposort.database)
+			for (auto &conn : cell.first->connections())
+				if (cell.first->input(conn.first))
+					for (auto bit : sigmap(conn.second))
+						if (driver_cells.count(bit))
+							toposort.edge(driver_cells.at(bit), cell.first);
+
+		toposort.analyze_loops = false;
+		toposort.sort();
+
+		if (toposort.found_loops)
+			log_cmd_error("Found combinational loops in module %s. Compiled simulation is not possible.\n", log_id(module));
+
+		for (auto cell : toposort.sorted)
+		{
+			current_cell = GetSize(cell_inputs);
+			cell_inputs.push_back(std::vector<int>());
+			for (auto &conn : cell->connections())
+				if (cell->input(conn.first))
+					for (auto bit : sigmap(conn.second))
+						if (bit.wire != nullptr)
+							cell_inputs.back().push_back(net_index.at(bit));
+			emit(OP_ACTIVATE, NET_SX, NET_SX);
+			lower_cell(cell);
+		}
+
+		lane_mask = num_lanes == 64 ? ~uint64_t(0) : (uint64_t(1) << num_lanes) - 1;
+		active.resize(GetSize(cell_inputs));
+
+		val.resize(num_nets);
+		def.resize(num_nets);
+		touched.resize(num_nets);
+
+		val[NET_S1] = val[NET_SZ] = ~uint64_t(0);
+		def[NET_S0] = def[NET_S1] = ~uint64_t(0);
+
+		// same initial dirty bits as in SimInstance: output ports and nets
+		// with an init value
+		for (auto wire : module->wires())
+		{
+			SigSpec sig = sigmap(wire);
+
+			if (wire->port_output)
+				for (auto bit : sig)
+					if (bit.wire != nullptr)
+						touched[net_index.at(bit)] = lane_mask;
+
+			if (wire->attributes.count("\\init") == 0)
+				continue;
+
+			Const initval = wire->attributes.at("\\init");
+			for (int i = 0; i < GetSize(sig) && i < GetSize(initval); i++)
+				if (sig[i].wire != nullptr && (initval[i] == State::S0 || initval[i] == State::S1)) {
+					int n = net_index.at(sig[i]);
+					val[n] = initval[i] == State::S1 ? ~uint64_t(0) : 0;
+					def[n] = ~uint64_t(0);
+					touched[n] = lane_mask;
+				}
+		}
+
+		if (shared->zinit)
+		{
+			for (auto &ff : ffs) {
+				for (auto &v : ff.past_d_def)
+					v = ~uint64_t(0);
+				for (int n : ff.q)
+					set_net(n, val[n] & def[n], ~uint64_t(0), lane_mask);
+			}
+		}
+
+		log("Compiled module %s to %d instructions (%d generic) over %d nets.\n", log_id(module),
+				GetSize(insns), GetSize(generics), num_nets);
+	}
+
+	int net(SigBit bit)
+	{
+		bit = sigmap(bit);
+		if (bit.wire != nullptr)
+			return net_index.at(bit);
+		switch (bit.data) {
+			case State::S0: return NET_S0;
+			case State::S1: return NET_S1;
+			case State::Sx: return NET_SX;
+			default: return NET_SZ;
+		}
+	}
+
+	// like net(), but returns a scratch net for constant bits
+	int out_net(SigBit bit)
+	{
+		if (sigmap(bit).wire == nullptr)
+			return num_nets++;
+		return net(bit);
+	}
+
+	// same as extend_u0() in kernel/calc.cc
+	std::vector<int> nets(const SigSpec &sig, int width, bool is_signed)
+	{
+		std::vector<int> result;
+		int padding = is_signed && GetSize(sig) > 0 ? net(sig[GetSize(sig)-1]) : NET_S0;
+		for (int i = 0; i < width; i++)
+			result.push_back(i < GetSize(sig) ? net(sig[i]) : padding);
+		return result;
+	}
+
+	void emit(op_t op, int y, int a, int b = NET_SX, int s = NET_SX)
+	{
+		insn_t insn;
+		insn.op = op;
+		insn.y = y;
+		insn.a = a;
+		insn.b = b;
+		insn.s = s;
+		insn.cell = current_cell;
+		insns.push_back(insn);
+	}
+
+	// set the given lanes of a net and remember the lanes that changed
+	void set_net(int n, uint64_t new_val, uint64_t new_def, uint64_t mask)
+	{
+		new_val = (new_val & mask) | (val[n] & ~mask);
+		new_def = (new_def & mask) | (def[n] & ~mask);
+		touched[n] |= (new_val ^ val[n]) | (new_def ^ def[n]);
+		val[n] = new_val, def[n] = new_def;
+	}
+
+	int emit_temp(op_t op, int a, int b = NET_SX)
+	{
+		int y = num_nets++;
+		emit(op, y, a, b);
+		return y;
+	}
+
+	int emit_reduce(op_t op, const std::vector<int> &bits, int initial)
+	{
+		int y = initial;
+		for (int bit : bits)
+			y = emit_temp(op, y, bit);
+		return y;
+	}
+
+	// single-bit result in Y[0], the other bits of Y are zero
+	void emit_bool(const SigSpec &sig_y, op_t op, int a, int b = NET_SX)
+	{
+		for (int i = 0; i < GetSize(sig_y); i++)
+			if (i == 0)
+				emit(op, out_net(sig_y[i]), a, b);
+			else
+				emit(OP_BUF, out_net(sig_y[i]), NET_S0);
+	}
+
+	void lower_cell(Cell *cell)
+	{
+		IdString type = cell->type;
+
+		if (type.in("$_BUF_", "$_NOT_", "$_AND_", "$_NAND_", "$_OR_", "$_NOR_", "$_XOR_", "$_XNOR_", "$_ANDNOT_", "$_ORNOT_", "$_MUX_"))
+		{
+			int y = out_net(cell->getPort("\\Y"));
+			int a = net(cell->getPort("\\A"));
+			int b = type.in("$_BUF_", "$_NOT_") ? NET_SX : net(cell->getPort("\\B"));
+
+			if (type == "$_BUF_") emit(OP_BUF, y, a);
+			if (type == "$_NOT_") emit(OP_GATE_NOT, y, a);
+			if (type == "$_AND_") emit(OP_AND, y, a, b);
+			if (type == "$_NAND_") emit(OP_NAND, y, a, b);
+			if (type == "$_OR_") emit(OP_OR, y, a, b);
+			if (type == "$_NOR_") emit(OP_NOR, y, a, b);
+			if (type == "$_XOR_") emit(OP_XOR, y, a, b);
+			if (type == "$_XNOR_") emit(OP_XNOR, y, a, b);
+			if (type == "$_ANDNOT_") emit(OP_ANDNOT, y, a, b);
+			if (type == "$_ORNOT_") emit(OP_ORNOT, y, a, b);
+			if (type == "$_MUX_") emit(OP_MUX, y, a, b, net(cell->getPort("\\S")));
+			return;
+		}
+
+		if (type.in("$_AOI3_", "$_OAI3_"))
+		{
+			int y = out_net(cell->getPort("\\Y"));
+			int a = net(cell->getPort("\\A"));
+			int b = net(cell->getPort("\\B"));
+			int c = net(cell->getPort("\\C"));
+
+			if (type == "$_AOI3_")
+				emit(OP_NOR, y, emit_temp(OP_AND, a, b), c);
+			else
+				emit(OP_NAND, y, emit_temp(OP_OR, a, b), c);
+			return;
+		}
+
+		bool signed_a = cell->parameters.count("\\A_SIGNED") > 0 && cell->parameters.at("\\A_SIGNED").as_bool();
+		bool signed_b = cell->parameters.count("\\B_SIGNED") > 0 && cell->parameters.at("\\B_SIGNED").as_bool();
+
+		if (type.in("$not", "$pos"))
+		{
+			SigSpec sig_y = cell->getPort("\\Y");
+			std::vector<int> a = nets(cell->getPort("\\A"), GetSize(sig_y), signed_a);
+			for (int i = 0; i < GetSize(sig_y); i++)
+				emit(type == "$not" ? OP_NOT : OP_BUF, out_net(sig_y[i]), a[i]);
+			return;
+		}
+
+		// see CellTypes::eval()
+		if (!signed_a || !signed_b)
+			signed_a = false, signed_b = false;
+
+		if (type.in("$and", "$or", "$xor", "$xnor"))
+		{
+			op_t op = type == "$and" ? OP_AND : type == "$or" ? OP_OR : type == "$xor" ? OP_XOR : OP_XNOR;
+			SigSpec sig_y = cell->getPort("\\Y");
+			std::vector<int> a = nets(cell->getPort("\\A"), GetSize(sig_y), signed_a);
+			std::vector<int> b = nets(cell->getPort("\\B"), GetSize(sig_y), signed_b);
+			for (int i = 0; i < GetSize(sig_y); i++)
+				emit(op, out_net(sig_y[i]), a[i], b[i]);
+			return;
+		}
+
+		if (type.in("$reduce_and", "$reduce_or", "$reduce_xor", "$reduce_xnor", "$reduce_bool", "$logic_not"))
+		{
+			SigSpec sig_a = cell->getPort("\\A");
+			std::vector<int> a = nets(sig_a, GetSize(sig_a), false);
+
+			if (type == "$reduce_and")
+				emit_bool(cell->getPort("\\Y"), OP_BUF, emit_reduce(OP_AND, a, NET_S1));
+			if (type.in("$reduce_or", "$reduce_bool"))
+				emit_bool(cell->getPort("\\Y"), OP_BUF, emit_reduce(OP_OR, a, NET_S0));
+			if (type == "$reduce_xor")
+				emit_bool(cell->getPort("\\Y"), OP_BUF, emit_reduce(OP_XOR, a, NET_S0));
+			if (type == "$reduce_xnor")
+				emit_bool(cell->getPort("\\Y"), OP_NOT, emit_reduce(OP_XOR, a, NET_S0));
+			if (type == "$logic_not")
+				emit_bool(cell->getPort("\\Y"), OP_NOT, emit_reduce(OP_OR, a, NET_S0));
+			return;
+		}
+
+		if (type.in("$logic_and", "$logic_or"))
+		{
+			SigSpec sig_a = cell->getPort("\\A");
+			SigSpec sig_b = cell->getPort("\\B");
+			int a = emit_reduce(OP_OR, nets(sig_a, GetSize(sig_a), false), NET_S0);
+			int b = emit_reduce(OP_OR, nets(sig_b, GetSize(sig_b), false), NET_S0);
+			emit_bool(cell->getPort("\\Y"), type == "$logic_and" ? OP_AND : OP_OR, a, b);
+			return;
+		}
+
+		if (type.in("$eq", "$ne"))
+		{
+			SigSpec sig_a = cell->getPort("\\A");
+			SigSpec sig_b = cell->getPort("\\B");
+			int width = max(GetSize(sig_a), GetSize(sig_b));
+			std::vector<int> a = nets(sig_a, width, signed_a);
+			std::vector<int> b = nets(sig_b, width, signed_b);
+
+			std::vector<int> eq_bits;
+			for (int i = 0; i < width; i++)
+				eq_bits.push_back(emit_temp(OP_XNOR, a[i], b[i]));
+
+			emit_bool(cell->getPort("\\Y"), type == "$eq" ? OP_BUF : OP_NOT, emit_reduce(OP_AND, eq_bits, NET_S1));
+			return;
+		}
+
+		if (type.in("$mux", "$pmux"))
+		{
+			SigSpec sig_a = cell->getPort("\\A");
+			SigSpec sig_b = cell->getPort("\\B");
+			SigSpec sig_s = cell->getPort("\\S");
+			SigSpec sig_y = cell->getPort("\\Y");
+
+			// the last selected input wins, undefined select bits are ignored
+			for (int i = 0; i < GetSize(sig_y); i++) {
+				int y = net(sig_a[i]);
+				for (int j = 0; j < GetSize(sig_s); j++) {
+					int next_y = j+1 < GetSize(sig_s) ? num_nets++ : out_net(sig_y[i]);
+					emit(OP_MUX, next_y, y, net(sig_b[j*GetSize(sig_y) + i]), net(sig_s[j]));
+					y = next_y;
+				}
+				if (GetSize(sig_s) == 0)
+					emit(OP_BUF, out_net(sig_y[i]), y);
+			}
+			return;
+		}
+
+		generic_t g;
+		g.cell = cell;
+		g.has_a = cell->hasPort("\\A");
+		g.has_b = cell->hasPort("\\B");
+		g.has_c = cell->hasPort("\\C");
+		g.has_d = cell->hasPort("\\D");
+		g.has_s = cell->hasPort("\\S");
+		g.has_y = cell->hasPort("\\Y");
+		if (g.has_a) g.sig_a = cell->getPort("\\A");
+		if (g.has_b) g.sig_b = cell->getPort("\\B");
+		if (g.has_c) g.sig_c = cell->getPort("\\C");
+		if (g.has_s) g.sig_s = cell->getPort("\\S");
+		if (g.has_y) g.sig_y = cell->getPort("\\Y");
+		emit(OP_GENERIC, NET_SX, NET_SX, NET_SX, GetSize(generics));
+		generics.push_back(g);
+	}
+
+	void eval_generic(const generic_t &g, uint64_t mask)
+	{
+		for (int lane = 0; lane < num_lanes; lane++)
+		{
+			if (((mask >> lane) & 1) == 0)
+				continue;
+
+			// same as SimInstance::update_cell()
+			if (g.has_a && !g.has_c && !g.has_d && !g.has_s && g.has_y) {
+				set_state(g.sig_y, CellTypes::eval(g.cell, get_state(g.sig_a, lane), get_state(g.sig_b, lane)), lane);
+				continue;
+			}
+
+			if (g.has_a && g.has_b && g.has_c && !g.has_d && !g.has_s && g.has_y) {
+				set_state(g.sig_y, CellTypes::eval(g.cell, get_state(g.sig_a, lane), get_state(g.sig_b, lane), get_state(g.sig_c, lane)), lane);
+				continue;
+			}
+
+			if (g.has_a && g.has_b && !g.has_c && !g.has_d && g.has_s && g.has_y) {
+				set_state(g.sig_y, CellTypes::eval(g.cell, get_state(g.sig_a, lane), get_state(g.sig_b, lane), get_state(g.sig_s, lane)), lane);
+				continue;
+			}
+
+			log_warning("Unsupported evaluable cell type: %s (%s.%s)\n", log_id(g.cell->type), log_id(module), log_id(g.cell));
+		}
+	}
+
+	void eval()
+	{
+		uint64_t *v = val.data(), *d = def.data();
+
+		for (auto &insn : insns)
+		{
+			if (insn.op == OP_ACTIVATE) {
+				uint64_t &mask = active[insn.cell];
+				if (mask != lane_mask)
+					for (int n : cell_inputs[insn.cell])
+						mask |= touched[n];
+				continue;
+			}
+
+			uint64_t mask = active[insn.cell];
+			if (mask == 0)
+				continue;
+
+			uint64_t av = v[insn.a], ad = d[insn.a];
+			uint64_t bv = v[insn.b], bd = d[insn.b];
+			uint64_t yv = 0, yd = 0;
+
+			// lanes with a defined 0 or 1 in each argument
+			uint64_t a0 = ad & ~av, a1 = ad & av;
+			uint64_t b0 = bd & ~bv, b1 = bd & bv;
+
+			switch (insn.op)
+			{
+			case OP_BUF:
+				yv = av, yd = ad;
+				break;
+			case OP_NOT:
+				yv = a0, yd = ad;
+				break;
+			case OP_GATE_NOT:
+				// eval_not() keeps Sz
+				yv = a0 | (av & ~ad), yd = ad;
+				break;
+			case OP_AND:
+				yv = a1 & b1, yd = (a1 & b1) | a0 | b0;
+				break;
+			case OP_NAND:
+				yv = a0 | b0, yd = (a1 & b1) | a0 | b0;
+				break;
+			case OP_OR:
+				yv = a1 | b1, yd = a1 | b1 | (a0 & b0);
+				break;
+			case OP_NOR:
+				yv = a0 & b0, yd = a1 | b1 | (a0 & b0);
+				break;
+			case OP_XOR:
+				yd = ad & bd, yv = (av ^ bv) & ad & bd;
+				break;
+			case OP_XNOR:
+				yd = ad & bd, yv = ~(av ^ bv) & ad & bd;
+				break;
+			case OP_ANDNOT:
+				yv = a1 & b0, yd = (a1 & b0) | a0 | b1;
+				break;
+			case OP_ORNOT:
+				yv = a1 | b0, yd = a1 | b0 | (a0 & b1);
+				break;
+			case OP_MUX: {
+				uint64_t sel = v[insn.s] & d[insn.s];
+				yv = (av & ~sel) | (bv & sel);
+				yd = (ad & ~sel) | (bd & sel);
+				break;
+			}
+			case OP_GENERIC:
+				eval_generic(generics[insn.s], mask);
+				continue;
+			case OP_ACTIVATE:
+				log_abort();
+			}
+
+			if (mask == lane_mask && touched[insn.y] == lane_mask)
+				v[insn.y] = yv, d[insn.y] = yd;
+			else
+				set_net(insn.y, yv, yd, mask);
+		}
+	}
+
+	bool update_ph2()
+	{
+		bool did_something = false;
+
+		for (auto &ff : ffs)
+		{
+			uint64_t clk_val = val[ff.clk], clk_def = def[ff.clk];
+			uint64_t edge;
+
+			if (ff.clkpol)
+				edge = ~(ff.past_clk_def & ff.past_clk_val) & (clk_def & clk_val);
+			else
+				edge = ~(ff.past_clk_def & ~ff.past_clk_val) & (clk_def & ~clk_val);
+
+			if (edge == 0)
+				continue;
+
+			for (int i = 0; i < GetSize(ff.q); i++) {
+				int n = ff.q[i];
+				uint64_t new_val = (val[n] & ~edge) | (ff.past_d_val[i] & edge);
+				uint64_t new_def = (def[n] & ~edge) | (ff.past_d_def[i] & edge);
+				if (new_val != val[n] || new_def != def[n]) {
+					set_net(n, new_val, new_def, ~uint64_t(0));
+					did_something = true;
+				}
+			}
+		}
+
+		return did_something;
+	}
+
+	void update_ph3()
+	{
+		for (auto &ff : ffs) {
+			ff.past_clk_val = val[ff.clk];
+			ff.past_clk_def = def[ff.clk];
+			for (int i = 0; i < GetSize(ff.d); i++) {
+				ff.past_d_val[i] = val[ff.d[i]];
+				ff.past_d_def[i] = def[ff.d[i]];
+			}
+		}
+
+		if (shared->quiet)
+			return;
+
+		// assertions are only checked for the first lane
+		for (auto cell : formal_cells)
+		{
+			string label = log_id(cell);
+			if (cell->attributes.count("\\src"))
+				label = cell->attributes.at("\\src").decode_string();
+
+			State a = get_state(cell->getPort("\\A"), 0)[0];
+			State en = get_state(cell->getPort("\\EN"), 0)[0];
+
+			if (cell->type == "$cover" && en == State::S1 && a != State::S1)
+				log("Cover %s.%s (%s) reached.\n", log_id(module), log_id(cell), label.c_str());
+
+			if (cell->type == "$assume" && en == State::S1 && a != State::S1)
+				log("Assumption %s.%s (%s) failed.\n", log_id(module), log_id(cell), label.c_str());
+
+			if (cell->type == "$assert" && en == State::S1 && a != State::S1)
+				log_warning("Assert %s.%s (%s) failed.\n", log_id(module), log_id(cell), label.c_str());
+		}
+	}
+
+	void update()
+	{
+		while (1) {
+			eval();
+			if (!update_ph2())
+				break;
+		}
+
+		update_ph3();
+	}
+
+	Const get_state(const SigSpec &sig, int lane)
+	{
+		Const value;
+
+		for (auto bit : sigmap(sig))
+			if (bit.wire == nullptr)
+				value.bits.push_back(bit.data);
+			else {
+				int n = net_index.at(bit);
+				bool v = (val[n] >> lane) & 1, d = (def[n] >> lane) & 1;
+				value.bits.push_back(d ? (v ? State::S1 : State::S0) : (v ? State::Sz : State::Sx));
+			}
+
+		return value;
+	}
+
+	void set_state(const SigSpec &sig, const Const &value, int lane)
+	{
+		log_assert(GetSize(sig) == GetSize(value));
+		uint64_t mask = uint64_t(1) << lane;
+
+		for (int i = 0; i < GetSize(sig); i++)
+		{
+			SigBit bit = sigmap(sig[i]);
+			if (bit.wire == nullptr)
+				continue;
+
+			int n = net_index.at(bit);
+			bool v = value[i] != State::S0 && value[i] != State::Sx;
+			bool d = value[i] == State::S0 || value[i] == State::S1;
+			set_net(n, v ? mask : 0, d ? mask : 0, mask);
+		}
+	}
+
+	void writeback()
+	{
+		for (auto wire : module->wires())
+			wire->attributes.erase("\\init");
+
+		for (auto &ff : ffs)
+		{
+			SigSpec sig_q = ff.cell->getPort("\\Q");
+			Const initval = get_state(sig_q, 0);
+
+			for (int i = 0; i < GetSize(sig_q); i++)
+			{
+				Wire *w = sig_q[i].wire;
+
+				if (w->attributes.count("\\init") == 0)
+					w->attributes["\\init"] = Const(State::Sx, GetSize(w));
+
+				w->attributes["\\init"][sig_q[i].offset] = initval[i];
+			}
+		}
+	}
+
+	void write_vcd_header(std::ostream &f, int &id, int lane)
+	{
+		if (GetSize(vcd_database) <= lane)
+			vcd_database.resize(lane+1);
+
+		f << stringf("$scope module %s $end\n", log_id(module));
+
+		for (auto wire : module->wires())
+		{
+			if (shared->hide_internal && wire->name[0] == '$')
+				continue;
+
+			f << stringf("$var wire %d n%d %s%s $end\n", GetSize(wire), id, wire->name[0] == '$' ? "\\" : "", log_id(wire));
+			vcd_database[lane][wire] = make_pair(id++, Const());
+		}
+
+		f << stringf("$upscope $end\n");
+	}
+
+	void write_vcd_step(std::ostream &f, int lane)
+	{
+		for (auto &it : vcd_database[lane])
+		{
+			Wire *wire = it.first;
+			Const value = get_state(wire, lane);
+			int id = it.second.first;
+
+			if (it.second.second == value)
+				continue;
+
+			it.second.second = value;
+
+			f << "b";
+			for (int i = GetSize(value)-1; i >= 0; i--) {
+				switch (value[i]) {
+					case State::S0: f << "0"; break;
+					case State::S1: f << "1"; break;
+					case State::Sx: f << "x"; break;
+					default: f << "z";
+				}
+			}
+
+			f << stringf(" n%d\n", id);
+		}
+	}
+};
+
 struct SimWorker : SimShared
 {
 	SimInstance *top = nullptr;
+	SimCompiled *compiled_top = nullptr;
 	std::ofstream vcdfile;
+	std::vector<std::ostream*> vcd_streams;
 	pool<IdString> clock, clockn, reset, resetn;
 
+	bool compiled = false;
+	int num_lanes = 1;
+
+	bool random_inputs = false;
+	uint32_t random_seed = 1;
+	std::vector<uint32_t> rng_state;
+	std::vector<Wire*> random_wires;
+
 	~SimWorker()
 	{
 		delete top;
+		delete compiled_top;
+	}
+
+	void copy_options(const SimWorker &other)
+	{
+		*static_cast<SimShared*>(this) = other;
+		clock = other.clock;
+		clockn = other.clockn;
+		reset = other.reset;
+		resetn = other.resetn;
+		random_inputs = other.random_inputs;
+		random_seed = other.random_seed;
+	}
+
+	Module *module()
+	{
+		return compiled ? compiled_top->module : top->module;
 	}
 
 	void write_vcd_header()
 	{
-		if (!vcdfile.is_open())
-			return;
+		for (int lane = 0; lane < GetSize(vcd_streams); lane++)
+		{
+			std::ostream &f = *vcd_streams[lane];
+			int id = 1;
 
-		int id = 1;
-		top->write_vcd_header(vcdfile, id);
+			if (compiled)
+				compiled_top->write_vcd_header(f, id, lane);
+			else
+				top->write_vcd_header(f, id);
 
-		vcdfile << stringf("$enddefinitions $end\n");
+			f << stringf("$enddefinitions $end\n");
+		}
 	}
 
 	void write_vcd_step(int t)
 	{
-		if (!vcdfile.is_open())
-			return;
+		for (int lane = 0; lane < GetSize(vcd_streams); lane++)
+		{
+			std::ostream &f = *vcd_streams[lane];
+			f << stringf("#%d\n", t);
 
-		vcdfile << stringf("#%d\n", t);
-		top->write_vcd_step(vcdfile);
+			if (compiled)
+				compiled_top->write_vcd_step(f, lane);
+			else
+				top->write_vcd_step(f);
+		}
 	}
 
 	void update()
 	{
+		if (compiled) {
+			compiled_top->update();
+			return;
+		}
+
 		while (1)
 		{
 			if (debug)
@@ -672,27 +1430,82 @@ struct SimWorker : SimShared
 		top->update_ph3();
 	}
 
+	void set_state(Wire *w, const Const &value, int lane)
+	{
+		if (compiled)
+			compiled_top->set_state(w, value, lane);
+		else
+			top->set_state(w, value);
+	}
+
 	void set_inports(pool<IdString> ports, State value)
 	{
 		for (auto portname : ports)
 		{
-			Wire *w = top->module->wire(portname);
+			Wire *w = module()->wire(portname);
 
 			if (w == nullptr)
-				log_error("Can't find port %s on module %s.\n", log_id(portname), log_id(top->module));
+				log_error("Can't find port %s on module %s.\n", log_id(portname), log_id(module()));
 
-			top->set_state(w, value);
+			for (int lane = 0; lane < num_lanes; lane++)
+				set_state(w, Const(value, GetSize(w)), lane);
+		}
+	}
+
+	void init_random_inputs()
+	{
+		for (auto wire : module()->wires())
+			if (wire->port_input && !clock.count(wire->name) && !clockn.count(wire->name) &&
+					!reset.count(wire->name) && !resetn.count(wire->name))
+				random_wires.push_back(wire);
+
+		std::sort(random_wires.begin(), random_wires.end(), RTLIL::sort_by_name_str<RTLIL::Wire>());
+
+		// lane N of a compiled simulation sees the same stimulus as an
+		// interpreted simulation with random_seed+N
+		for (int lane = 0; lane < num_lanes; lane++) {
+			uint32_t seed = random_seed + lane;
+			rng_state.push_back(seed ? seed : 1);
+		}
+	}
+
+	void set_random_inputs()
+	{
+		for (int lane = 0; lane < num_lanes; lane++)
+		{
+			uint32_t &x = rng_state[lane];
+
+			for (auto wire : random_wires)
+			{
+				Const value(State::S0, GetSize(wire));
+
+				for (int i = 0; i < GetSize(wire); i++) {
+					x ^= x << 13;
+					x ^= x >> 17;
+					x ^= x << 5;
+					value[i] = (x & 1) ? State::S1 : State::S0;
+				}
+
+				set_state(wire, value, lane);
+			}
 		}
 	}
 
 	void run(Module *topmod, int numcycles)
 	{
-		log_assert(top == nullptr);
-		top = new SimInstance(this, topmod);
+		log_assert(top == nullptr && compiled_top == nullptr);
+
+		if (compiled)
+			compiled_top = new SimCompiled(this, topmod, num_lanes);
+		else
+			top = new SimInstance(this, topmod);
+
+		if (vcdfile.is_open())
+			vcd_streams.push_back(&vcdfile);
 
 		if (debug)
 			log("\n===== 0 =====\n");
-		else
+		else if (!quiet)
 			log("Simulating cycle 0.\n");
 
 		set_inports(reset, State::S1);
@@ -701,6 +1514,11 @@ struct SimWorker : SimShared
 		set_inports(clock, State::Sx);
 		set_inports(clockn, State::Sx);
 
+		if (random_inputs) {
+			init_random_inputs();
+			set_random_inputs();
+		}
+
 		update();
 
 		write_vcd_header();
@@ -714,12 +1532,15 @@ struct SimWorker : SimShared
 			set_inports(clock, State::S0);
 			set_inports(clockn, State::S1);
 
+			if (random_inputs)
+				set_random_inputs();
+
 			update();
 			write_vcd_step(10*cycle + 5);
 
 			if (debug)
 				log("\n===== %d =====\n", 10*cycle + 10);
-			else
+			else if (!quiet)
 				log("Simulating cycle %d.\n", cycle+1);
 
 			set_inports(clock, State::S1);
@@ -737,12 +1558,64 @@ struct SimWorker : SimShared
 		write_vcd_step(10*numcycles + 2);
 
 		if (writeback) {
-			pool<Module*> wbmods;
-			top->writeback(wbmods);
+			if (compiled) {
+				compiled_top->writeback();
+			} else {
+				pool<Module*> wbmods;
+				top->writeback(wbmods);
+			}
 		}
 	}
 };
 
+static void run_bench(const SimWorker &options, Module *topmod, int numcycles)
+{
+	int num_lanes = 64;
+	std::vector<std::ostringstream> interp_vcd(num_lanes), compiled_vcd(num_lanes);
+
+	log("Running interpreted simulation %d times.\n", num_lanes);
+	auto start = std::chrono::steady_clock::now();
+
+	for (int lane = 0; lane < num_lanes; lane++) {
+		SimWorker worker;
+		worker.copy_options(options);
+		worker.quiet = true;
+		worker.writeback = false;
+		worker.random_inputs = true;
+		worker.random_seed = options.random_seed + lane;
+		worker.vcd_streams.push_back(&interp_vcd[lane]);
+		worker.run(topmod, numcycles);
+	}
+
+	double interp_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	log("Running compiled simulation with %d lanes.\n", num_lanes);
+	start = std::chrono::steady_clock::now();
+
+	{
+		SimWorker worker;
+		worker.copy_options(options);
+		worker.quiet = true;
+		worker.writeback = false;
+		worker.random_inputs = true;
+		worker.compiled = true;
+		worker.num_lanes = num_lanes;
+		for (auto &s : compiled_vcd)
+			worker.vcd_streams.push_back(&s);
+		worker.run(topmod, numcycles);
+	}
+
+	double compiled_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (int lane = 0; lane < num_lanes; lane++)
+		if (interp_vcd[lane].str() != compiled_vcd[lane].str())
+			log_error("Compiled simulation of lane %d does not match interpreted simulation.\n", lane);
+
+	log("All %d lanes match the interpreted simulation.\n", num_lanes);
+	log("Interpreted: %.3f s, compiled: %.3f s, speedup: %.1fx\n", interp_sec, compiled_sec,
+			compiled_sec > 0 ? interp_sec / compiled_sec : 0.0);
+}
+
 struct SimPass : public Pass {
 	SimPass() : Pass("sim", "simulate the circuit") { }
 	virtual void help()
@@ -786,11 +1659,28 @@ struct SimPass : public Pass {
 		log("    -d\n");
 		log("        enable debug output\n");
 		log("\n");
+		log("    -compiled\n");
+		log("        use the compiled simulator: the module is levelized once and simulated\n");
+		log("        as a flat list of bit-parallel instructions. This only supports flat\n");
+		log("        designs without $mem cells (run 'flatten' and 'memory_map' first).\n");
+		log("        The generated VCD file is identical to the one written by the default\n");
+		log("        simulator. Assertions are checked in the same way.\n");
+		log("\n");
+		log("    -bench\n");
+		log("        drive all top-level inputs other than clocks and resets with random\n");
+		log("        values, run the default simulator 64 times (with a different seed each\n");
+		log("        time) and the compiled simulator once with 64 parallel lanes, check\n");
+		log("        that the results are identical and print the runtimes\n");
+		log("\n");
+		log("    -seed <integer>\n");
+		log("        seed for the random values used by -bench (default: 1)\n");
+		log("\n");
 	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
 		SimWorker worker;
 		int numcycles = 20;
+		bool bench = false;
 
 		log_header(design, "Executing SIM pass (simulate the circuit).\n");
 
@@ -840,6 +1730,18 @@ struct SimPass : public Pass {
 				worker.zinit = true;
 				continue;
 			}
+			if (args[argidx] == "-compiled") {
+				worker.compiled = true;
+				continue;
+			}
+			if (args[argidx] == "-bench") {
+				bench = true;
+				continue;
+			}
+			if (args[argidx] == "-seed" && argidx+1 < args.size()) {
+				worker.random_seed = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -855,7 +1757,10 @@ struct SimPass : public Pass {
 			top_mod = mods.front();
 		}
 
-		worker.run(top_mod, numcycles);
+		if (bench)
+			run_bench(worker, top_mod, numcycles);
+		else
+			worker.run(top_mod, numcycles);
 	}
 } SimPass;
 
@@ -100,6 +100,7 @@ bool map_mux8;
 bool map_mux16;
 
 bool markgroups;
+bool aiger_mode;
 int map_autoidx;
 SigMap assign_map;
 RTLIL::Module *module;
@@ -113,6 +114,86 @@ bool clk_polarity, en_polarity;
 RTLIL::SigSpec clk_sig, en_sig;
 dict<int, std::string> pi_map, po_map;
 
+// bits that are used by netlists that have been extracted from the current module
+// but not re-integrated yet (abc -j). they are treated like ports of the module.
+pool<RTLIL::SigBit> pending_port_bits;
+
+// the netlist in the ABC output file. net_names are the wire names without the
+// leading '\\' or '$', connections are (net, net or -1, constant value).
+
+struct abc_netlist_t
+{
+	struct cell_t {
+		RTLIL::IdString type;
+		std::vector<std::pair<RTLIL::IdString, std::vector<int>>> ports;
+		dict<RTLIL::IdString, RTLIL::Const> parameters;
+	};
+
+	std::vector<std::string> net_names;
+	dict<int, RTLIL::Const> net_init;
+	std::vector<cell_t> cells;
+	std::vector<std::tuple<int, int, RTLIL::State>> connections;
+};
+
+// abc_module() extracts a netlist and writes the ABC input files, abc_run_job()
+// runs ABC and reads its output file, and abc_finish_job() re-integrates the ABC
+// results. abc_job_t holds the state of the global variables above between these
+// steps, so that several ABC processes can run at the same time.
+
+struct abc_job_t
+{
+	RTLIL::Module *module;
+	int map_autoidx;
+	std::vector<gate_t> signal_list;
+	dict<int, std::string> pi_map, po_map;
+	bool recover_init;
+	bool clk_polarity, en_polarity;
+	RTLIL::SigSpec clk_sig, en_sig;
+
+	std::string tempdir_name, abc_command;
+	bool show_tempdir, cleanup, builtin_lib, sop_mode;
+	int abc_retcode;
+
+	abc_netlist_t netlist;
+	bool netlist_ok;
+
+	abc_job_t() : module(nullptr), map_autoidx(0), recover_init(false), clk_polarity(true), en_polarity(true),
+			show_tempdir(false), cleanup(true), builtin_lib(true), sop_mode(false), abc_retcode(0), netlist_ok(false) { }
+};
+
+void save_abc_job(abc_job_t &job)
+{
+	job.module = module;
+	job.map_autoidx = map_autoidx;
+	job.signal_list.swap(signal_list);
+	job.pi_map.swap(pi_map);
+	job.po_map.swap(po_map);
+	job.recover_init = recover_init;
+	job.clk_polarity = clk_polarity;
+	job.en_polarity = en_polarity;
+	job.clk_sig = clk_sig;
+	job.en_sig = en_sig;
+
+	signal_list.clear();
+	signal_map.clear();
+	pi_map.clear();
+	po_map.clear();
+}
+
+void restore_abc_job(abc_job_t &job)
+{
+	module = job.module;
+	map_autoidx = job.map_autoidx;
+	signal_list.swap(job.signal_list);
+	pi_map.swap(job.pi_map);
+	po_map.swap(job.po_map);
+	recover_init = job.recover_init;
+	clk_polarity = job.clk_polarity;
+	en_polarity = job.en_polarity;
+	clk_sig = job.clk_sig;
+	en_sig = job.en_sig;
+}
+
 int map_signal(RTLIL::SigBit bit, gate_type_t gate_type = G(NONE), int in1 = -1, int in2 = -1, int in3 = -1, int in4 = -1)
 {
 	assign_map.apply(bit);
@@ -323,11 +404,9 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 	}
 }
 
-std::string remap_name(RTLIL::IdString abc_name)
+std::string remap_name(const std::string &abc_name)
 {
-	std::stringstream sstr;
-	sstr << "$abc$" << map_autoidx << "$" << abc_name.substr(1);
-	return sstr.str();
+	return stringf("$abc$%d$%s", map_autoidx, abc_name.c_str());
 }
 
 void dump_loop_graph(FILE *f, int &nr, std::map<int, std::set<int>> &edges, std::set<int> &workpool, std::vector<int> &in_counts)
@@ -563,8 +642,10 @@ struct abc_output_filter
 	std::string linebuf;
 	std::string tempdir_name;
 	bool show_tempdir;
+	const dict<int, std::string> &pi_map, &po_map;
 
-	abc_output_filter(std::string tempdir_name, bool show_tempdir) : tempdir_name(tempdir_name), show_tempdir(show_tempdir)
+	abc_output_filter(std::string tempdir_name, bool show_tempdir, const dict<int, std::string> &pi_map, const dict<int, std::string> &po_map) :
+			tempdir_name(tempdir_name), show_tempdir(show_tempdir), pi_map(pi_map), po_map(po_map)
 	{
 		got_cr = false;
 		escape_seq_state = 0;
@@ -615,10 +696,545 @@ struct abc_output_filter
 	}
 };
 
+void write_blif_netlist(FILE *f, int &count_input, int &count_output, int &count_gates)
+{
+	fprintf(f, ".model netlist\n");
+
+	fprintf(f, ".inputs");
+	for (auto &si : signal_list) {
+		if (!si.is_port || si.type != G(NONE))
+			continue;
+		fprintf(f, " n%d", si.id);
+		pi_map[count_input++] = log_signal(si.bit);
+	}
+	if (count_input == 0)
+		fprintf(f, " dummy_input\n");
+	fprintf(f, "\n");
+
+	fprintf(f, ".outputs");
+	for (auto &si : signal_list) {
+		if (!si.is_port || si.type == G(NONE))
+			continue;
+		fprintf(f, " n%d", si.id);
+		po_map[count_output++] = log_signal(si.bit);
+	}
+	fprintf(f, "\n");
+
+	for (auto &si : signal_list)
+		fprintf(f, "# n%-5d %s\n", si.id, log_signal(si.bit));
+
+	for (auto &si : signal_list) {
+		if (si.bit.wire == NULL) {
+			fprintf(f, ".names n%d\n", si.id);
+			if (si.bit == RTLIL::State::S1)
+				fprintf(f, "1\n");
+		}
+	}
+
+	for (auto &si : signal_list) {
+		if (si.type == G(BUF)) {
+			fprintf(f, ".names n%d n%d\n", si.in1, si.id);
+			fprintf(f, "1 1\n");
+		} else if (si.type == G(NOT)) {
+			fprintf(f, ".names n%d n%d\n", si.in1, si.id);
+			fprintf(f, "0 1\n");
+		} else if (si.type == G(AND)) {
+			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
+			fprintf(f, "11 1\n");
+		} else if (si.type == G(NAND)) {
+			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
+			fprintf(f, "0- 1\n");
+			fprintf(f, "-0 1\n");
+		} else if (si.type == G(OR)) {
+			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
+			fprintf(f, "-1 1\n");
+			fprintf(f, "1- 1\n");
+		} else if (si.type == G(NOR)) {
+			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
+			fprintf(f, "00 1\n");
+		} else if (si.type == G(XOR)) {
+			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
+			fprintf(f, "01 1\n");
+			fprintf(f, "10 1\n");
+		} else if (si.type == G(XNOR)) {
+			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
+			fprintf(f, "00 1\n");
+			fprintf(f, "11 1\n");
+		} else if (si.type == G(ANDNOT)) {
+			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
+			fprintf(f, "10 1\n");
+		} else if (si.type == G(ORNOT)) {
+			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
+			fprintf(f, "1- 1\n");
+			fprintf(f, "-0 1\n");
+		} else if (si.type == G(MUX)) {
+			fprintf(f, ".names n%d n%d n%d n%d\n", si.in1, si.in2, si.in3, si.id);
+			fprintf(f, "1-0 1\n");
+			fprintf(f, "-11 1\n");
+		} else if (si.type == G(AOI3)) {
+			fprintf(f, ".names n%d n%d n%d n%d\n", si.in1, si.in2, si.in3, si.id);
+			fprintf(f, "-00 1\n");
+			fprintf(f, "0-0 1\n");
+		} else if (si.type == G(OAI3)) {
+			fprintf(f, ".names n%d n%d n%d n%d\n", si.in1, si.in2, si.in3, si.id);
+			fprintf(f, "00- 1\n");
+			fprintf(f, "--0 1\n");
+		} else if (si.type == G(AOI4)) {
+			fprintf(f, ".names n%d n%d n%d n%d n%d\n", si.in1, si.in2, si.in3, si.in4, si.id);
+			fprintf(f, "-0-0 1\n");
+			fprintf(f, "-00- 1\n");
+			fprintf(f, "0--0 1\n");
+			fprintf(f, "0-0- 1\n");
+		} else if (si.type == G(OAI4)) {
+			fprintf(f, ".names n%d n%d n%d n%d n%d\n", si.in1, si.in2, si.in3, si.in4, si.id);
+			fprintf(f, "00-- 1\n");
+			fprintf(f, "--00 1\n");
+		} else if (si.type == G(FF)) {
+			if (si.init == State::S0 || si.init == State::S1) {
+				fprintf(f, ".latch n%d n%d %d\n", si.in1, si.id, si.init == State::S1 ? 1 : 0);
+				recover_init = true;
+			} else
+				fprintf(f, ".latch n%d n%d 2\n", si.in1, si.id);
+		} else if (si.type != G(NONE))
+			log_abort();
+		if (si.type != G(NONE))
+			count_gates++;
+	}
+
+	fprintf(f, ".end\n");
+}
+
+// binary AIGER (http://fmv.jku.at/aiger/) is much more compact than BLIF and
+// can be read by ABC without going through its generic logic network parser
+void write_aiger_netlist(FILE *f, int &count_input, int &count_output, int &count_gates)
+{
+	std::vector<int> lits(GetSize(signal_list), -1);
+	std::vector<int> input_ids, latch_ids, output_ids;
+	std::vector<std::pair<int, int>> and_gates;
+	int num_vars = 0;
+
+	for (auto &si : signal_list) {
+		if (si.bit.wire == NULL)
+			lits[si.id] = si.bit == RTLIL::State::S1 ? 1 : 0;
+		else if (si.type == G(NONE) && si.is_port)
+			input_ids.push_back(si.id);
+		else if (si.type == G(FF))
+			latch_ids.push_back(si.id);
+		if (si.is_port && si.type != G(NONE))
+			output_ids.push_back(si.id);
+		if (si.type != G(NONE))
+			count_gates++;
+	}
+
+	for (int id : input_ids) {
+		lits[id] = 2 * ++num_vars;
+		pi_map[count_input++] = log_signal(signal_list[id].bit);
+	}
+
+	for (int id : latch_ids)
+		lits[id] = 2 * ++num_vars;
+
+	// ABC ties undriven nets to constant 0
+	for (auto &si : signal_list)
+		if (si.type == G(NONE) && lits[si.id] < 0)
+			lits[si.id] = 0;
+
+	auto make_and = [&](int a, int b) {
+		and_gates.push_back(std::pair<int, int>(max(a, b), min(a, b)));
+		return 2 * (num_vars + GetSize(and_gates));
+	};
+
+	auto make_or = [&](int a, int b) {
+		return make_and(a ^ 1, b ^ 1) ^ 1;
+	};
+
+	auto make_gate = [&](const gate_t &si) {
+		int a = si.in1 >= 0 ? lits[si.in1] : -1;
+		int b = si.in2 >= 0 ? lits[si.in2] : -1;
+		int c = si.in3 >= 0 ? lits[si.in3] : -1;
+		int d = si.in4 >= 0 ? lits[si.in4] : -1;
+		int x, y;
+		switch (si.type) {
+			case G(BUF):    return a;
+			case G(NOT):    return a ^ 1;
+			case G(AND):    return make_and(a, b);
+			case G(NAND):   return make_and(a, b) ^ 1;
+			case G(OR):     return make_or(a, b);
+			case G(NOR):    return make_or(a, b) ^ 1;
+			case G(ANDNOT): return make_and(a, b ^ 1);
+			case G(ORNOT):  return make_or(a, b ^ 1);
+			case G(AOI3):   return make_or(make_and(a, b), c) ^ 1;
+			case G(OAI3):   return make_and(make_or(a, b), c) ^ 1;
+			case G(XOR):    x = make_and(a, b ^ 1), y = make_and(a ^ 1, b); return make_or(x, y);
+			case G(XNOR):   x = make_and(a, b ^ 1), y = make_and(a ^ 1, b); return make_or(x, y) ^ 1;
+			case G(MUX):    x = make_and(a, c ^ 1), y = make_and(b, c); return make_or(x, y);
+			case G(AOI4):   x = make_and(a, b), y = make_and(c, d); return make_or(x, y) ^ 1;
+			case G(OAI4):   x = make_or(a, b), y = make_or(c, d); return make_and(x, y) ^ 1;
+			default:        log_abort();
+		}
+	};
+
+	// AND gates must be written in topological order
+	std::vector<bool> visiting(GetSize(signal_list));
+	std::vector<int> stack;
+
+	for (auto &root : signal_list)
+	{
+		stack.push_back(root.id);
+
+		while (!stack.empty())
+		{
+			int id = stack.back();
+			if (lits[id] >= 0) {
+				stack.pop_back();
+				continue;
+			}
+
+			const gate_t &si = signal_list[id];
+			if (!visiting[id]) {
+				visiting[id] = true;
+				for (int in : {si.in1, si.in2, si.in3, si.in4})
+					if (in >= 0 && lits[in] < 0) {
+						if (visiting[in])
+							log_error("Found combinational loop in netlist for ABC.\n");
+						stack.push_back(in);
+					}
+				continue;
+			}
+
+			lits[id] = make_gate(si);
+			stack.pop_back();
+		}
+	}
+
+	fprintf(f, "aig %d %d %d %d %d\n", num_vars + GetSize(and_gates), GetSize(input_ids),
+			GetSize(latch_ids), GetSize(output_ids), GetSize(and_gates));
+
+	for (int id : latch_ids) {
+		const gate_t &si = signal_list[id];
+		if (si.init == State::S0 || si.init == State::S1) {
+			fprintf(f, "%d %d\n", lits[si.in1], si.init == State::S1 ? 1 : 0);
+			recover_init = true;
+		} else
+			fprintf(f, "%d %d\n", lits[si.in1], lits[id]);
+	}
+
+	for (int id : output_ids) {
+		fprintf(f, "%d\n", lits[id]);
+		po_map[count_output++] = log_signal(signal_list[id].bit);
+	}
+
+	for (int i = 0; i < GetSize(and_gates); i++) {
+		unsigned int lhs = 2 * (num_vars + i + 1);
+		for (unsigned int delta : {lhs - and_gates[i].first, unsigned(and_gates[i].first - and_gates[i].second)}) {
+			while (delta & ~0x7f) {
+				fputc((delta & 0x7f) | 0x80, f);
+				delta >>= 7;
+			}
+			fputc(delta, f);
+		}
+	}
+
+	for (int i = 0; i < GetSize(input_ids); i++)
+		fprintf(f, "i%d n%d\n", i, input_ids[i]);
+
+	for (int i = 0; i < GetSize(output_ids); i++)
+		fprintf(f, "o%d n%d\n", i, output_ids[i]);
+
+	fprintf(f, "c\n");
+	for (auto &si : signal_list)
+		fprintf(f, "n%-5d %s\n", si.id, log_signal(si.bit));
+}
+
+// ABC writes the mapped netlist as BLIF, but it only uses a small part of it: one
+// model with .inputs, .outputs, .names (with their covers), .gate, .subckt and
+// .latch lines. read_abc_netlist() reads the whole file at once, splits it in
+// place and fills an abc_netlist_t with the same cells as parse_blif() would
+// create. It does not create RTLIL objects, so it can run in the ABC worker
+// threads. It returns false for anything else, then the caller reads the file
+// with parse_blif() instead.
+
+bool read_abc_netlist(abc_netlist_t &netlist, const std::string &filename, RTLIL::IdString dff_name, bool sop_mode)
+{
+	netlist = abc_netlist_t();
+
+	FILE *f = fopen(filename.c_str(), "rb");
+	if (f == NULL)
+		return false;
+
+	std::vector<char> buffer;
+	char chunk[65536];
+	for (size_t n; (n = fread(chunk, 1, sizeof(chunk), f)) > 0;)
+		buffer.insert(buffer.end(), chunk, chunk + n);
+	buffer.push_back(0);
+	fclose(f);
+
+	char *p = buffer.data();
+	std::vector<char*> tokens;
+
+	// split the next non-empty line (joining lines that end with a backslash)
+	// into null-terminated tokens
+	auto next_line = [&]() -> bool
+	{
+		tokens.clear();
+		while (*p != 0)
+		{
+			while (*p != 0 && *p != '\n') {
+				if (*p == ' ' || *p == '\t' || *p == '\r') {
+					*(p++) = 0;
+					continue;
+				}
+				if (*p == '#') {
+					while (*p != 0 && *p != '\n')
+						*(p++) = 0;
+					break;
+				}
+				tokens.push_back(p);
+				while (*p != 0 && *p != '\n' && *p != ' ' && *p != '\t' && *p != '\r')
+					p++;
+			}
+			if (*p == '\n')
+				*(p++) = 0;
+
+			if (!tokens.empty()) {
+				char *last = tokens.back();
+				int len = strlen(last);
+				if (last[len-1] != '\\')
+					return true;
+				last[len-1] = 0;
+				if (len == 1)
+					tokens.pop_back();
+			}
+		}
+		return !tokens.empty();
+	};
+
+	// nets are keyed by the wire names parse_blif() would use, and numbered in
+	// the order in which it would create the wires
+	dict<std::string, int> net_index;
+
+	auto net = [&](const std::string &name) -> int
+	{
+		auto it = net_index.find(name);
+		if (it != net_index.end())
+			return it->second;
+		int index = GetSize(netlist.net_names);
+		netlist.net_names.push_back(name.substr(1));
+		net_index[name] = index;
+		return index;
+	};
+
+	auto add_cell = [&](RTLIL::IdString type) -> abc_netlist_t::cell_t&
+	{
+		netlist.cells.push_back(abc_netlist_t::cell_t());
+		netlist.cells.back().type = type;
+		return netlist.cells.back();
+	};
+
+	bool have_line = next_line();
+	if (!have_line || strcmp(tokens[0], ".model") || GetSize(tokens) != 2 || strcmp(tokens[1], "netlist"))
+		return false;
+
+	have_line = next_line();
+	while (have_line)
+	{
+		const char *cmd = tokens[0];
+
+		if (!strcmp(cmd, ".end"))
+			return !next_line();
+
+		if (!strcmp(cmd, ".inputs") || !strcmp(cmd, ".outputs"))
+		{
+			for (int i = 1; i < GetSize(tokens); i++)
+				net(std::string("\\") + tokens[i]);
+			have_line = next_line();
+			continue;
+		}
+
+		if (!strcmp(cmd, ".gate") || !strcmp(cmd, ".subckt"))
+		{
+			if (GetSize(tokens) < 2)
+				return false;
+
+			abc_netlist_t::cell_t &cell = add_cell(RTLIL::escape_id(tokens[1]));
+			for (int i = 2; i < GetSize(tokens); i++) {
+				char *q = strchr(tokens[i], '=');
+				if (q == NULL)
+					return false;
+				*(q++) = 0;
+				cell.ports.push_back(std::make_pair(RTLIL::escape_id(tokens[i]), std::vector<int>()));
+				if (*q)
+					cell.ports.back().second.push_back(net(RTLIL::escape_id(q)));
+			}
+			have_line = next_line();
+			continue;
+		}
+
+		if (!strcmp(cmd, ".latch"))
+		{
+			if (GetSize(tokens) != 3 && GetSize(tokens) != 4)
+				return false;
+
+			if (GetSize(tokens) == 4 && (tokens[3][0] == '0' || tokens[3][0] == '1'))
+				netlist.net_init[net(RTLIL::escape_id(tokens[2]))] = RTLIL::Const(tokens[3][0] == '1' ? 1 : 0, 1);
+			int d = net(RTLIL::escape_id(tokens[1])), q = net(RTLIL::escape_id(tokens[2]));
+
+			abc_netlist_t::cell_t &cell = add_cell(dff_name);
+			cell.ports.push_back(std::make_pair(RTLIL::IdString("\\D"), std::vector<int>{d}));
+			cell.ports.push_back(std::make_pair(RTLIL::IdString("\\Q"), std::vector<int>{q}));
+			have_line = next_line();
+			continue;
+		}
+
+		if (!strcmp(cmd, ".names"))
+		{
+			if (GetSize(tokens) < 2)
+				return false;
+
+			std::vector<int> inputs;
+			for (int i = 1; i+1 < GetSize(tokens); i++)
+				inputs.push_back(net(RTLIL::escape_id(tokens[i])));
+			std::string output_name = RTLIL::escape_id(tokens.back());
+			int output = net(output_name);
+			int width = GetSize(inputs);
+
+			if (width == 0)
+			{
+				RTLIL::State state = RTLIL::State::Sa;
+				while ((have_line = next_line()) && tokens[0][0] != '.') {
+					if (GetSize(tokens) != 1 || (strcmp(tokens[0], "0") && strcmp(tokens[0], "1")))
+						return false;
+					RTLIL::State value = tokens[0][0] == '1' ? RTLIL::State::S1 : RTLIL::State::S0;
+					if (state != RTLIL::State::Sa && state != value)
+						return false;
+					state = value;
+				}
+				if (state == RTLIL::State::Sa)
+					state = RTLIL::State::S0;
+				if (output_name == "$undef")
+					state = RTLIL::State::Sx;
+				netlist.connections.push_back(std::make_tuple(output, -1, state));
+				continue;
+			}
+
+			if (width > 12 && !sop_mode)
+				return false;
+
+			int cell_index = GetSize(netlist.cells);
+			add_cell(sop_mode ? "$sop" : "$lut");
+
+			RTLIL::Const table;
+			int depth = 0, polarity = -1;
+			if (!sop_mode)
+				table.bits.resize(1 << width, RTLIL::State::Sx);
+
+			while ((have_line = next_line()) && tokens[0][0] != '.')
+			{
+				const char *input = tokens[0];
+				if (GetSize(tokens) != 2 || (strcmp(tokens[1], "0") && strcmp(tokens[1], "1")) || int(strlen(input)) != width)
+					return false;
+
+				int value = tokens[1][0] == '1';
+				if (polarity >= 0 && polarity != value)
+					return false;
+				polarity = value;
+
+				if (sop_mode) {
+					for (int i = 0; i < width; i++) {
+						table.bits.push_back(input[i] == '0' ? RTLIL::State::S1 : RTLIL::State::S0);
+						table.bits.push_back(input[i] == '1' ? RTLIL::State::S1 : RTLIL::State::S0);
+					}
+					depth++;
+					continue;
+				}
+
+				for (int i = 0; i < (1 << width); i++) {
+					for (int j = 0; j < width; j++)
+						if (input[j] != '-' && (input[j] == '1') != ((i & (1 << j)) != 0))
+							goto next_value;
+					table.bits[i] = value ? RTLIL::State::S1 : RTLIL::State::S0;
+				next_value:;
+				}
+			}
+
+			abc_netlist_t::cell_t &cell = netlist.cells[cell_index];
+			cell.ports.push_back(std::make_pair(RTLIL::IdString("\\A"), inputs));
+			cell.ports.push_back(std::make_pair(RTLIL::IdString("\\Y"), std::vector<int>{output}));
+			cell.parameters["\\WIDTH"] = width;
+
+			if (sop_mode) {
+				cell.parameters["\\DEPTH"] = depth;
+				cell.parameters["\\TABLE"] = table;
+				if (polarity == 0) {
+					int inverted = net(output_name + "$not");
+					cell.ports.back().second[0] = inverted;
+					abc_netlist_t::cell_t &not_cell = add_cell("$_NOT_");
+					not_cell.ports.push_back(std::make_pair(RTLIL::IdString("\\A"), std::vector<int>{inverted}));
+					not_cell.ports.push_back(std::make_pair(RTLIL::IdString("\\Y"), std::vector<int>{output}));
+				}
+			} else {
+				for (auto &bit : table.bits)
+					if (bit == RTLIL::State::Sx)
+						bit = polarity == 0 ? RTLIL::State::S1 : polarity == 1 ? RTLIL::State::S0 : RTLIL::State::Sx;
+				cell.parameters["\\LUT"] = table;
+			}
+			continue;
+		}
+
+		return false;
+	}
+
+	return false;
+}
+
+// fill the netlist from the module created by parse_blif()
+void import_abc_netlist(abc_netlist_t &netlist, RTLIL::Module *mapped_mod)
+{
+	netlist = abc_netlist_t();
+
+	// wires() and cells() iterate in reverse order of creation
+	std::vector<RTLIL::Wire*> wires = mapped_mod->wires();
+	std::vector<RTLIL::Cell*> cells = mapped_mod->cells();
+	std::reverse(wires.begin(), wires.end());
+	std::reverse(cells.begin(), cells.end());
+
+	dict<RTLIL::Wire*, int> net_index;
+	for (auto wire : wires) {
+		net_index[wire] = GetSize(netlist.net_names);
+		if (wire->attributes.count("\\init"))
+			netlist.net_init[GetSize(netlist.net_names)] = wire->attributes.at("\\init");
+		netlist.net_names.push_back(wire->name.substr(1));
+	}
+
+	for (auto c : cells) {
+		netlist.cells.push_back(abc_netlist_t::cell_t());
+		abc_netlist_t::cell_t &cell = netlist.cells.back();
+		cell.type = c->type;
+		cell.parameters = c->parameters;
+		for (auto &conn : c->connections()) {
+			cell.ports.push_back(std::make_pair(conn.first, std::vector<int>()));
+			for (auto &chunk : conn.second.chunks()) {
+				if (chunk.width == 0)
+					continue;
+				log_assert(chunk.width == 1 && chunk.wire != nullptr);
+				cell.ports.back().second.push_back(net_index.at(chunk.wire));
+			}
+		}
+	}
+
+	for (auto &conn : mapped_mod->connections()) {
+		log_assert(GetSize(conn.first) == 1 && conn.first[0].wire != nullptr);
+		if (conn.second.is_fully_const())
+			netlist.connections.push_back(std::make_tuple(net_index.at(conn.first[0].wire), -1, conn.second[0].data));
+		else
+			netlist.connections.push_back(std::make_tuple(net_index.at(conn.first[0].wire), net_index.at(conn.second[0].wire), RTLIL::State::Sx));
+	}
+}
+
 void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
 		std::string liberty_file, std::string constr_file, bool cleanup, vector<int> lut_costs, bool dff_mode, std::string clk_str,
 		bool keepff, std::string delay_target, std::string sop_inputs, std::string sop_products, std::string lutin_shared, bool fast_mode,
-		const std::vector<RTLIL::Cell*> &cells, bool show_tempdir, bool sop_mode)
+		const std::vector<RTLIL::Cell*> &cells, bool show_tempdir, bool sop_mode, abc_job_t &job)
 {
 	module = current_module;
 	map_autoidx = autoidx++;
@@ -665,11 +1281,16 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 	std::string tempdir_name = "/tmp/yosys-abc-XXXXXX";
 	if (!cleanup)
 		tempdir_name[0] = tempdir_name[4] = '_';
+#ifdef __linux__
+	else if (access("/dev/shm", W_OK) == 0)
+		tempdir_name = "/dev/shm/yosys-abc-XXXXXX";
+#endif
 	tempdir_name = make_temp_dir(tempdir_name);
-	log_header(design, "Extracting gate netlist of module `%s' to `%s/input.blif'..\n",
-			module->name.c_str(), replace_tempdir(tempdir_name, tempdir_name, show_tempdir).c_str());
+	log_header(design, "Extracting gate netlist of module `%s' to `%s/input.%s'..\n",
+			module->name.c_str(), replace_tempdir(tempdir_name, tempdir_name, show_tempdir).c_str(), aiger_mode ? "aig" : "blif");
 
-	std::string abc_script = stringf("read_blif %s/input.blif; ", tempdir_name.c_str());
+	std::string abc_script = aiger_mode ? stringf("read_aiger %s/input.aig; ", tempdir_name.c_str()) :
+			stringf("read_blif %s/input.blif; ", tempdir_name.c_str());
 
 	if (!liberty_file.empty()) {
 		abc_script += stringf("read_lib -w %s; ", liberty_file.c_str());
@@ -764,120 +1385,21 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 	if (en_sig.size() != 0)
 		mark_port(en_sig);
 
+	for (auto bit : pending_port_bits)
+		mark_port(bit);
+
 	handle_loops();
 
-	std::string buffer = stringf("%s/input.blif", tempdir_name.c_str());
-	f = fopen(buffer.c_str(), "wt");
+	std::string buffer = stringf("%s/input.%s", tempdir_name.c_str(), aiger_mode ? "aig" : "blif");
+	f = fopen(buffer.c_str(), aiger_mode ? "wb" : "wt");
 	if (f == NULL)
 		log_error("Opening %s for writing failed: %s\n", buffer.c_str(), strerror(errno));
 
-	fprintf(f, ".model netlist\n");
-
-	int count_input = 0;
-	fprintf(f, ".inputs");
-	for (auto &si : signal_list) {
-		if (!si.is_port || si.type != G(NONE))
-			continue;
-		fprintf(f, " n%d", si.id);
-		pi_map[count_input++] = log_signal(si.bit);
-	}
-	if (count_input == 0)
-		fprintf(f, " dummy_input\n");
-	fprintf(f, "\n");
-
-	int count_output = 0;
-	fprintf(f, ".outputs");
-	for (auto &si : signal_list) {
-		if (!si.is_port || si.type == G(NONE))
-			continue;
-		fprintf(f, " n%d", si.id);
-		po_map[count_output++] = log_signal(si.bit);
-	}
-	fprintf(f, "\n");
-
-	for (auto &si : signal_list)
-		fprintf(f, "# n%-5d %s\n", si.id, log_signal(si.bit));
-
-	for (auto &si : signal_list) {
-		if (si.bit.wire == NULL) {
-			fprintf(f, ".names n%d\n", si.id);
-			if (si.bit == RTLIL::State::S1)
-				fprintf(f, "1\n");
-		}
-	}
-
-	int count_gates = 0;
-	for (auto &si : signal_list) {
-		if (si.type == G(BUF)) {
-			fprintf(f, ".names n%d n%d\n", si.in1, si.id);
-			fprintf(f, "1 1\n");
-		} else if (si.type == G(NOT)) {
-			fprintf(f, ".names n%d n%d\n", si.in1, si.id);
-			fprintf(f, "0 1\n");
-		} else if (si.type == G(AND)) {
-			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "11 1\n");
-		} else if (si.type == G(NAND)) {
-			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "0- 1\n");
-			fprintf(f, "-0 1\n");
-		} else if (si.type == G(OR)) {
-			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "-1 1\n");
-			fprintf(f, "1- 1\n");
-		} else if (si.type == G(NOR)) {
-			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "00 1\n");
-		} else if (si.type == G(XOR)) {
-			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "01 1\n");
-			fprintf(f, "10 1\n");
-		} else if (si.type == G(XNOR)) {
-			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "00 1\n");
-			fprintf(f, "11 1\n");
-		} else if (si.type == G(ANDNOT)) {
-			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "10 1\n");
-		} else if (si.type == G(ORNOT)) {
-			fprintf(f, ".names n%d n%d n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "1- 1\n");
-			fprintf(f, "-0 1\n");
-		} else if (si.type == G(MUX)) {
-			fprintf(f, ".names n%d n%d n%d n%d\n", si.in1, si.in2, si.in3, si.id);
-			fprintf(f, "1-0 1\n");
-			fprintf(f, "-11 1\n");
-		} else if (si.type == G(AOI3)) {
-			fprintf(f, ".names n%d n%d n%d n%d\n", si.in1, si.in2, si.in3, si.id);
-			fprintf(f, "-00 1\n");
-			fprintf(f, "0-0 1\n");
-		} else if (si.type == G(OAI3)) {
-			fprintf(f, ".names n%d n%d n%d n%d\n", si.in1, si.in2, si.in3, si.id);
-			fprintf(f, "00- 1\n");
-			fprintf(f, "--0 1\n");
-		} else if (si.type == G(AOI4)) {
-			fprintf(f, ".names n%d n%d n%d n%d n%d\n", si.in1, si.in2, si.in3, si.in4, si.id);
-			fprintf(f, "-0-0 1\n");
-			fprintf(f, "-00- 1\n");
-			fprintf(f, "0--0 1\n");
-			fprintf(f, "0-0- 1\n");
-		} else if (si.type == G(OAI4)) {
-			fprintf(f, ".names n%d n%d n%d n%d n%d\n", si.in1, si.in2, si.in3, si.in4, si.id);
-			fprintf(f, "00-- 1\n");
-			fprintf(f, "--00 1\n");
-		} else if (si.type == G(FF)) {
-			if (si.init == State::S0 || si.init == State::S1) {
-				fprintf(f, ".latch n%d n%d %d\n", si.in1, si.id, si.init == State::S1 ? 1 : 0);
-				recover_init = true;
-			} else
-				fprintf(f, ".latch n%d n%d 2\n", si.in1, si.id);
-		} else if (si.type != G(NONE))
-			log_abort();
-		if (si.type != G(NONE))
-			count_gates++;
-	}
-
-	fprintf(f, ".end\n");
+	int count_input = 0, count_output = 0, count_gates = 0;
+	if (aiger_mode)
+		write_aiger_netlist(f, count_input, count_output, count_gates);
+	else
+		write_blif_netlist(f, count_input, count_output, count_gates);
 	fclose(f);
 
 	log("Extracted %d gates and %d wires to a netlist network with %d inputs and %d outputs.\n",
@@ -940,249 +1462,181 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 			fclose(f);
 		}
 
-		buffer = stringf("%s -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
-		log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
+		job.abc_command = stringf("%s -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
+	}
 
-		abc_output_filter filt(tempdir_name, show_tempdir);
-		int ret = run_command(buffer, std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
-		if (ret != 0)
-			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
+	job.tempdir_name = tempdir_name;
+	job.show_tempdir = show_tempdir;
+	job.cleanup = cleanup;
+	job.builtin_lib = liberty_file.empty();
+	job.sop_mode = sop_mode;
+	save_abc_job(job);
+}
 
-		buffer = stringf("%s/%s", tempdir_name.c_str(), "output.blif");
-		std::ifstream ifs;
-		ifs.open(buffer);
-		if (ifs.fail())
-			log_error("Can't open ABC output file `%s'.\n", buffer.c_str());
+void abc_run_job(abc_job_t &job)
+{
+	if (job.abc_command.empty())
+		return;
 
-		bool builtin_lib = liberty_file.empty();
-		RTLIL::Design *mapped_design = new RTLIL::Design;
-		parse_blif(mapped_design, ifs, builtin_lib ? "\\DFF" : "\\_dff_", false, sop_mode);
+	log("Running ABC command: %s\n", replace_tempdir(job.abc_command, job.tempdir_name, job.show_tempdir).c_str());
 
-		ifs.close();
+	abc_output_filter filt(job.tempdir_name, job.show_tempdir, job.pi_map, job.po_map);
+	job.abc_retcode = run_command(job.abc_command, std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
+
+	if (job.abc_retcode == 0)
+		job.netlist_ok = read_abc_netlist(job.netlist, job.tempdir_name + "/output.blif", job.builtin_lib ? "\\DFF" : "\\_dff_", job.sop_mode);
+}
+
+void abc_finish_job(RTLIL::Design *design, abc_job_t &job)
+{
+	restore_abc_job(job);
+
+	std::string tempdir_name = job.tempdir_name;
+	std::string buffer;
+
+	if (!job.abc_command.empty())
+	{
+		if (job.abc_retcode != 0)
+			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", job.abc_command.c_str(), job.abc_retcode);
+
+		bool builtin_lib = job.builtin_lib;
+		abc_netlist_t &netlist = job.netlist;
+
+		if (!job.netlist_ok)
+		{
+			log("Unexpected contents in ABC output file, reading it with the BLIF frontend.\n");
+
+			buffer = stringf("%s/%s", tempdir_name.c_str(), "output.blif");
+			std::ifstream ifs;
+			ifs.open(buffer);
+			if (ifs.fail())
+				log_error("Can't open ABC output file `%s'.\n", buffer.c_str());
+
+			RTLIL::Design *mapped_design = new RTLIL::Design;
+			parse_blif(mapped_design, ifs, builtin_lib ? "\\DFF" : "\\_dff_", false, job.sop_mode);
+			ifs.close();
+
+			RTLIL::Module *mapped_mod = mapped_design->modules_["\\netlist"];
+			if (mapped_mod == NULL)
+				log_error("ABC output file does not contain a module `netlist'.\n");
+			import_abc_netlist(netlist, mapped_mod);
+			delete mapped_design;
+		}
 
 		log_header(design, "Re-integrating ABC results.\n");
-		RTLIL::Module *mapped_mod = mapped_design->modules_["\\netlist"];
-		if (mapped_mod == NULL)
-			log_error("ABC output file does not contain a module `netlist'.\n");
-		for (auto &it : mapped_mod->wires_) {
-			RTLIL::Wire *w = it.second;
-			RTLIL::Wire *wire = module->addWire(remap_name(w->name));
+
+		std::vector<RTLIL::Wire*> wires;
+		for (auto &name : netlist.net_names) {
+			RTLIL::Wire *wire = module->addWire(remap_name(name));
 			if (markgroups) wire->attributes["\\abcgroup"] = map_autoidx;
 			design->select(module, wire);
+			wires.push_back(wire);
 		}
 
+		auto port_sig = [&](const std::vector<int> &nets) -> RTLIL::SigSpec {
+			RTLIL::SigSpec sig;
+			for (int n : nets)
+				sig.append(wires[n]);
+			return sig;
+		};
+
+		auto get_port = [&](const abc_netlist_t::cell_t &c, RTLIL::IdString port) -> RTLIL::SigSpec {
+			for (auto &it : c.ports)
+				if (it.first == port)
+					return port_sig(it.second);
+			return RTLIL::SigSpec();
+		};
+
+		auto add_dff = [&](const abc_netlist_t::cell_t &c, RTLIL::IdString name) {
+			log_assert(clk_sig.size() == 1);
+			RTLIL::Cell *cell;
+			if (en_sig.size() == 0) {
+				cell = module->addCell(name, clk_polarity ? "$_DFF_P_" : "$_DFF_N_");
+			} else {
+				log_assert(en_sig.size() == 1);
+				cell = module->addCell(name, stringf("$_DFFE_%c%c_", clk_polarity ? 'P' : 'N', en_polarity ? 'P' : 'N'));
+				cell->setPort("\\E", en_sig);
+			}
+			if (markgroups) cell->attributes["\\abcgroup"] = map_autoidx;
+			cell->setPort("\\D", get_port(c, "\\D"));
+			cell->setPort("\\Q", get_port(c, "\\Q"));
+			cell->setPort("\\C", clk_sig);
+			design->select(module, cell);
+		};
+
+		// the gates of the built-in library that are mapped to the $_<name>_ cell
+		// with the same ports
+		pool<RTLIL::IdString> builtin_gates = {
+			"\\NOT", "\\AND", "\\OR", "\\XOR", "\\NAND", "\\NOR", "\\XNOR", "\\ANDNOT", "\\ORNOT",
+			"\\MUX", "\\MUX4", "\\MUX8", "\\MUX16", "\\AOI3", "\\OAI3", "\\AOI4", "\\OAI4"
+		};
+
 		std::map<std::string, int> cell_stats;
-		for (auto c : mapped_mod->cells())
+		for (int i = 0; i < GetSize(netlist.cells); i++)
 		{
+			const abc_netlist_t::cell_t &c = netlist.cells[i];
+			RTLIL::IdString cell_name = remap_name(stringf("cell%d", i));
+
 			if (builtin_lib)
 			{
-				cell_stats[RTLIL::unescape_id(c->type)]++;
-				if (c->type == "\\ZERO" || c->type == "\\ONE") {
-					RTLIL::SigSig conn;
-					conn.first = RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\Y").as_wire()->name)]);
-					conn.second = RTLIL::SigSpec(c->type == "\\ZERO" ? 0 : 1, 1);
-					module->connect(conn);
-					continue;
-				}
-				if (c->type == "\\BUF") {
-					RTLIL::SigSig conn;
-					conn.first = RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\Y").as_wire()->name)]);
-					conn.second = RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\A").as_wire()->name)]);
-					module->connect(conn);
-					continue;
-				}
-				if (c->type == "\\NOT") {
-					RTLIL::Cell *cell = module->addCell(remap_name(c->name), "$_NOT_");
-					if (markgroups) cell->attributes["\\abcgroup"] = map_autoidx;
-					cell->setPort("\\A", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\A").as_wire()->name)]));
-					cell->setPort("\\Y", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\Y").as_wire()->name)]));
-					design->select(module, cell);
-					continue;
-				}
-				if (c->type == "\\AND" || c->type == "\\OR" || c->type == "\\XOR" || c->type == "\\NAND" || c->type == "\\NOR" ||
-						c->type == "\\XNOR" || c->type == "\\ANDNOT" || c->type == "\\ORNOT") {
-					RTLIL::Cell *cell = module->addCell(remap_name(c->name), "$_" + c->type.substr(1) + "_");
-					if (markgroups) cell->attributes["\\abcgroup"] = map_autoidx;
-					cell->setPort("\\A", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\A").as_wire()->name)]));
-					cell->setPort("\\B", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\B").as_wire()->name)]));
-					cell->setPort("\\Y", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\Y").as_wire()->name)]));
-					design->select(module, cell);
-					continue;
-				}
-				if (c->type == "\\MUX") {
-					RTLIL::Cell *cell = module->addCell(remap_name(c->name), "$_MUX_");
-					if (markgroups) cell->attributes["\\abcgroup"] = map_autoidx;
-					cell->setPort("\\A", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\A").as_wire()->name)]));
-					cell->setPort("\\B", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\B").as_wire()->name)]));
-					cell->setPort("\\S", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\S").as_wire()->name)]));
-					cell->setPort("\\Y", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\Y").as_wire()->name)]));
-					design->select(module, cell);
-					continue;
-				}
-				if (c->type == "\\MUX4") {
-					RTLIL::Cell *cell = module->addCell(remap_name(c->name), "$_MUX4_");
-					if (markgroups) cell->attributes["\\abcgroup"] = map_autoidx;
-					cell->setPort("\\A", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\A").as_wire()->name)]));
-					cell->setPort("\\B", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\B").as_wire()->name)]));
-					cell->setPort("\\C", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\C").as_wire()->name)]));
-					cell->setPort("\\D", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\D").as_wire()->name)]));
-					cell->setPort("\\S", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\S").as_wire()->name)]));
-					cell->setPort("\\T", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\T").as_wire()->name)]));
-					cell->setPort("\\Y", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\Y").as_wire()->name)]));
-					design->select(module, cell);
-					continue;
-				}
-				if (c->type == "\\MUX8") {
-					RTLIL::Cell *cell = module->addCell(remap_name(c->name), "$_MUX8_");
-					if (markgroups) cell->attributes["\\abcgroup"] = map_autoidx;
-					cell->setPort("\\A", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\A").as_wire()->name)]));
-					cell->setPort("\\B", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\B").as_wire()->name)]));
-					cell->setPort("\\C", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\C").as_wire()->name)]));
-					cell->setPort("\\D", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\D").as_wire()->name)]));
-					cell->setPort("\\E", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\E").as_wire()->name)]));
-					cell->setPort("\\F", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\F").as_wire()->name)]));
-					cell->setPort("\\G", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\G").as_wire()->name)]));
-					cell->setPort("\\H", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\H").as_wire()->name)]));
-					cell->setPort("\\S", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\S").as_wire()->name)]));
-					cell->setPort("\\T", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\T").as_wire()->name)]));
-					cell->setPort("\\U", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\U").as_wire()->name)]));
-					cell->setPort("\\Y", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\Y").as_wire()->name)]));
-					design->select(module, cell);
-					continue;
-				}
-				if (c->type == "\\MUX16") {
-					RTLIL::Cell *cell = module->addCell(remap_name(c->name), "$_MUX16_");
-					if (markgroups) cell->attributes["\\abcgroup"] = map_autoidx;
-					cell->setPort("\\A", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\A").as_wire()->name)]));
-					cell->setPort("\\B", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\B").as_wire()->name)]));
-					cell->setPort("\\C", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\C").as_wire()->name)]));
-					cell->setPort("\\D", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\D").as_wire()->name)]));
-					cell->setPort("\\E", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\E").as_wire()->name)]));
-					cell->setPort("\\F", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\F").as_wire()->name)]));
-					cell->setPort("\\G", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\G").as_wire()->name)]));
-					cell->setPort("\\H", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\H").as_wire()->name)]));
-					cell->setPort("\\I", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\I").as_wire()->name)]));
-					cell->setPort("\\J", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\J").as_wire()->name)]));
-					cell->setPort("\\K", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\K").as_wire()->name)]));
-					cell->setPort("\\L", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\L").as_wire()->name)]));
-					cell->setPort("\\M", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\M").as_wire()->name)]));
-					cell->setPort("\\N", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\N").as_wire()->name)]));
-					cell->setPort("\\O", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\O").as_wire()->name)]));
-					cell->setPort("\\P", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\P").as_wire()->name)]));
-					cell->setPort("\\S", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\S").as_wire()->name)]));
-					cell->setPort("\\T", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\T").as_wire()->name)]));
-					cell->setPort("\\U", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\U").as_wire()->name)]));
-					cell->setPort("\\V", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\V").as_wire()->name)]));
-					cell->setPort("\\Y", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\Y").as_wire()->name)]));
-					design->select(module, cell);
+				cell_stats[RTLIL::unescape_id(c.type)]++;
+				if (c.type == "\\ZERO" || c.type == "\\ONE") {
+					module->connect(get_port(c, "\\Y"), RTLIL::SigSpec(c.type == "\\ZERO" ? 0 : 1, 1));
 					continue;
 				}
-				if (c->type == "\\AOI3" || c->type == "\\OAI3") {
-					RTLIL::Cell *cell = module->addCell(remap_name(c->name), "$_" + c->type.substr(1) + "_");
-					if (markgroups) cell->attributes["\\abcgroup"] = map_autoidx;
-					cell->setPort("\\A", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\A").as_wire()->name)]));
-					cell->setPort("\\B", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\B").as_wire()->name)]));
-					cell->setPort("\\C", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\C").as_wire()->name)]));
-					cell->setPort("\\Y", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\Y").as_wire()->name)]));
-					design->select(module, cell);
+				if (c.type == "\\BUF") {
+					module->connect(get_port(c, "\\Y"), get_port(c, "\\A"));
 					continue;
 				}
-				if (c->type == "\\AOI4" || c->type == "\\OAI4") {
-					RTLIL::Cell *cell = module->addCell(remap_name(c->name), "$_" + c->type.substr(1) + "_");
+				if (builtin_gates.count(c.type)) {
+					RTLIL::Cell *cell = module->addCell(cell_name, "$_" + c.type.substr(1) + "_");
 					if (markgroups) cell->attributes["\\abcgroup"] = map_autoidx;
-					cell->setPort("\\A", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\A").as_wire()->name)]));
-					cell->setPort("\\B", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\B").as_wire()->name)]));
-					cell->setPort("\\C", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\C").as_wire()->name)]));
-					cell->setPort("\\D", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\D").as_wire()->name)]));
-					cell->setPort("\\Y", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\Y").as_wire()->name)]));
+					for (auto &it : c.ports)
+						cell->setPort(it.first, port_sig(it.second));
 					design->select(module, cell);
 					continue;
 				}
-				if (c->type == "\\DFF") {
-					log_assert(clk_sig.size() == 1);
-					RTLIL::Cell *cell;
-					if (en_sig.size() == 0) {
-						cell = module->addCell(remap_name(c->name), clk_polarity ? "$_DFF_P_" : "$_DFF_N_");
-					} else {
-						log_assert(en_sig.size() == 1);
-						cell = module->addCell(remap_name(c->name), stringf("$_DFFE_%c%c_", clk_polarity ? 'P' : 'N', en_polarity ? 'P' : 'N'));
-						cell->setPort("\\E", en_sig);
-					}
-					if (markgroups) cell->attributes["\\abcgroup"] = map_autoidx;
-					cell->setPort("\\D", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\D").as_wire()->name)]));
-					cell->setPort("\\Q", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\Q").as_wire()->name)]));
-					cell->setPort("\\C", clk_sig);
-					design->select(module, cell);
+				if (c.type == "\\DFF") {
+					add_dff(c, cell_name);
 					continue;
 				}
 			}
 
-			cell_stats[RTLIL::unescape_id(c->type)]++;
+			cell_stats[RTLIL::unescape_id(c.type)]++;
 
-			if (c->type == "\\_const0_" || c->type == "\\_const1_") {
-				RTLIL::SigSig conn;
-				conn.first = RTLIL::SigSpec(module->wires_[remap_name(c->connections().begin()->second.as_wire()->name)]);
-				conn.second = RTLIL::SigSpec(c->type == "\\_const0_" ? 0 : 1, 1);
-				module->connect(conn);
+			if (c.type == "\\_const0_" || c.type == "\\_const1_") {
+				module->connect(port_sig(c.ports.front().second), RTLIL::SigSpec(c.type == "\\_const0_" ? 0 : 1, 1));
 				continue;
 			}
 
-			if (c->type == "\\_dff_") {
-				log_assert(clk_sig.size() == 1);
-				RTLIL::Cell *cell;
-				if (en_sig.size() == 0) {
-					cell = module->addCell(remap_name(c->name), clk_polarity ? "$_DFF_P_" : "$_DFF_N_");
-				} else {
-					log_assert(en_sig.size() == 1);
-					cell = module->addCell(remap_name(c->name), stringf("$_DFFE_%c%c_", clk_polarity ? 'P' : 'N', en_polarity ? 'P' : 'N'));
-					cell->setPort("\\E", en_sig);
-				}
-				if (markgroups) cell->attributes["\\abcgroup"] = map_autoidx;
-				cell->setPort("\\D", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\D").as_wire()->name)]));
-				cell->setPort("\\Q", RTLIL::SigSpec(module->wires_[remap_name(c->getPort("\\Q").as_wire()->name)]));
-				cell->setPort("\\C", clk_sig);
-				design->select(module, cell);
+			if (c.type == "\\_dff_") {
+				add_dff(c, cell_name);
 				continue;
 			}
 
-			if (c->type == "$lut" && GetSize(c->getPort("\\A")) == 1 && c->getParam("\\LUT").as_int() == 2) {
-				SigSpec my_a = module->wires_[remap_name(c->getPort("\\A").as_wire()->name)];
-				SigSpec my_y = module->wires_[remap_name(c->getPort("\\Y").as_wire()->name)];
-				module->connect(my_y, my_a);
+			if (c.type == "$lut" && GetSize(get_port(c, "\\A")) == 1 && c.parameters.at("\\LUT").as_int() == 2) {
+				module->connect(get_port(c, "\\Y"), get_port(c, "\\A"));
 				continue;
 			}
 
-			RTLIL::Cell *cell = module->addCell(remap_name(c->name), c->type);
+			RTLIL::Cell *cell = module->addCell(cell_name, c.type);
 			if (markgroups) cell->attributes["\\abcgroup"] = map_autoidx;
-			cell->parameters = c->parameters;
-			for (auto &conn : c->connections()) {
-				RTLIL::SigSpec newsig;
-				for (auto &c : conn.second.chunks()) {
-					if (c.width == 0)
-						continue;
-					log_assert(c.width == 1);
-					newsig.append(module->wires_[remap_name(c.wire->name)]);
-				}
-				cell->setPort(conn.first, newsig);
-			}
+			cell->parameters = c.parameters;
+			for (auto &it : c.ports)
+				cell->setPort(it.first, port_sig(it.second));
 			design->select(module, cell);
 		}
 
-		for (auto conn : mapped_mod->connections()) {
-			if (!conn.first.is_fully_const())
-				conn.first = RTLIL::SigSpec(module->wires_[remap_name(conn.first.as_wire()->name)]);
-			if (!conn.second.is_fully_const())
-				conn.second = RTLIL::SigSpec(module->wires_[remap_name(conn.second.as_wire()->name)]);
-			module->connect(conn);
+		for (auto &conn : netlist.connections) {
+			int lhs = std::get<0>(conn), rhs = std::get<1>(conn);
+			module->connect(wires[lhs], rhs < 0 ? RTLIL::SigSpec(std::get<2>(conn)) : RTLIL::SigSpec(wires[rhs]));
 		}
 
 		if (recover_init)
-			for (auto wire : mapped_mod->wires()) {
-				if (wire->attributes.count("\\init")) {
-					Wire *w = module->wires_[remap_name(wire->name)];
-					log_assert(w->attributes.count("\\init") == 0);
-					w->attributes["\\init"] = wire->attributes.at("\\init");
-				}
+			for (auto &it : netlist.net_init) {
+				Wire *w = wires[it.first];
+				log_assert(w->attributes.count("\\init") == 0);
+				w->attributes["\\init"] = it.second;
 			}
 
 		for (auto &it : cell_stats)
@@ -1191,7 +1645,7 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		for (auto &si : signal_list)
 			if (si.is_port) {
 				char buffer[100];
-				snprintf(buffer, 100, "\\n%d", si.id);
+				snprintf(buffer, 100, "n%d", si.id);
 				RTLIL::SigSig conn;
 				if (si.type != G(NONE)) {
 					conn.first = si.bit;
@@ -1208,14 +1662,14 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		log("ABC RESULTS:           input signals: %8d\n", in_wires);
 		log("ABC RESULTS:          output signals: %8d\n", out_wires);
 
-		delete mapped_design;
+		netlist = abc_netlist_t();
 	}
 	else
 	{
 		log("Don't call ABC as there is nothing to map.\n");
 	}
 
-	if (cleanup)
+	if (job.cleanup)
 	{
 		log("Removing temp directory.\n");
 		remove_directory(tempdir_name);
@@ -1385,6 +1839,20 @@ struct AbcPass : public Pass {
 		log("        this attribute is a unique integer for each ABC process started. This\n");
 		log("        is useful for debugging the partitioning of clock domains.\n");
 		log("\n");
+		log("    -aiger, -blif\n");
+		log("        pass the extracted netlist to ABC as binary AIGER file or as BLIF file.\n");
+		log("        AIGER is much faster to write and to read for large netlists. it is\n");
+		log("        used by default, as all default scripts start with 'strash'. with\n");
+		log("        -script the default is BLIF, because ABC then starts with a logic\n");
+		log("        network instead of an AIG, which custom scripts may rely on.\n");
+		log("\n");
+		log("    -j <threads>\n");
+		log("        run up to this number of ABC processes at the same time. the netlists\n");
+		log("        of all selected modules and clock domains are always extracted first\n");
+		log("        and the results are re-integrated in the same order after all ABC\n");
+		log("        processes have finished, so the result is the same for any number of\n");
+		log("        threads. (default: value of 'yosys -j')\n");
+		log("\n");
 		log("When neither -liberty nor -lut is used, the Yosys standard cell library is\n");
 		log("loaded into ABC before the ABC script is executed.\n");
 		log("\n");
@@ -1415,8 +1883,10 @@ struct AbcPass : public Pass {
 		std::string delay_target, sop_inputs, sop_products, lutin_shared = "-S 1";
 		bool fast_mode = false, dff_mode = false, keepff = false, cleanup = true;
 		bool show_tempdir = false, sop_mode = false;
+		int num_threads = 0;
 		vector<int> lut_costs;
 		markgroups = false;
+		int input_format = -1;
 
 		map_mux4 = false;
 		map_mux8 = false;
@@ -1640,6 +2110,18 @@ struct AbcPass : public Pass {
 				markgroups = true;
 				continue;
 			}
+			if (arg == "-aiger") {
+				input_format = 1;
+				continue;
+			}
+			if (arg == "-blif") {
+				input_format = 0;
+				continue;
+			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				num_threads = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -1649,6 +2131,25 @@ struct AbcPass : public Pass {
 		if (!constr_file.empty() && liberty_file.empty())
 			log_cmd_error("Got -constr but no -liberty!\n");
 
+		aiger_mode = input_format >= 0 ? input_format == 1 : script_file.empty();
+
+		if (num_threads <= 0)
+			num_threads = yosys_threads;
+
+		std::vector<abc_job_t> jobs;
+		pending_port_bits.clear();
+
+		// the ABC results are always re-integrated after all netlists have been
+		// extracted (also with -j 1), so that the result does not depend on the
+		// number of threads
+		auto process_job = [&]()
+		{
+			for (auto &si : jobs.back().signal_list)
+				if (si.is_port && si.bit.wire != nullptr)
+					pending_port_bits.insert(si.bit);
+			log_pop();
+		};
+
 		for (auto mod : design->selected_modules())
 		{
 			if (mod->processes.size() > 0) {
@@ -1658,6 +2159,7 @@ struct AbcPass : public Pass {
 
 			assign_map.set(mod);
 			signal_init.clear();
+			pending_port_bits.clear();
 
 			for (Wire *wire : mod->wires())
 				if (wire->attributes.count("\\init")) {
@@ -1677,26 +2179,32 @@ struct AbcPass : public Pass {
 				}
 
 			if (!dff_mode || !clk_str.empty()) {
+				jobs.push_back(abc_job_t());
 				abc_module(design, mod, script_file, exe_file, liberty_file, constr_file, cleanup, lut_costs, dff_mode, clk_str, keepff,
-						delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, mod->selected_cells(), show_tempdir, sop_mode);
+						delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, mod->selected_cells(), show_tempdir, sop_mode, jobs.back());
+				process_job();
 				continue;
 			}
 
 			CellTypes ct(design);
 
+			// the cell sets are ordered by name (and not by pointer), so that the
+			// partitioning is the same in every run
+			typedef std::set<RTLIL::Cell*, RTLIL::IdString::compare_ptr_by_name<RTLIL::Cell>> cell_set_t;
+
 			std::vector<RTLIL::Cell*> all_cells = mod->selected_cells();
-			std::set<RTLIL::Cell*> unassigned_cells(all_cells.begin(), all_cells.end());
+			cell_set_t unassigned_cells(all_cells.begin(), all_cells.end());
 
-			std::set<RTLIL::Cell*> expand_queue, next_expand_queue;
-			std::set<RTLIL::Cell*> expand_queue_up, next_expand_queue_up;
-			std::set<RTLIL::Cell*> expand_queue_down, next_expand_queue_down;
+			cell_set_t expand_queue, next_expand_queue;
+			cell_set_t expand_queue_up, next_expand_queue_up;
+			cell_set_t expand_queue_down, next_expand_queue_down;
 
 			typedef tuple<bool, RTLIL::SigSpec, bool, RTLIL::SigSpec> clkdomain_t;
 			std::map<clkdomain_t, std::vector<RTLIL::Cell*>> assigned_cells;
 			std::map<RTLIL::Cell*, clkdomain_t> assigned_cells_reverse;
 
 			std::map<RTLIL::Cell*, std::set<RTLIL::SigBit>> cell_to_bit, cell_to_bit_up, cell_to_bit_down;
-			std::map<RTLIL::SigBit, std::set<RTLIL::Cell*>> bit_to_cell, bit_to_cell_up, bit_to_cell_down;
+			std::map<RTLIL::SigBit, cell_set_t> bit_to_cell, bit_to_cell_up, bit_to_cell_down;
 
 			for (auto cell : all_cells)
 			{
@@ -1822,12 +2330,44 @@ struct AbcPass : public Pass {
 				clk_sig = assign_map(std::get<1>(it.first));
 				en_polarity = std::get<2>(it.first);
 				en_sig = assign_map(std::get<3>(it.first));
+				jobs.push_back(abc_job_t());
 				abc_module(design, mod, script_file, exe_file, liberty_file, constr_file, cleanup, lut_costs, !clk_sig.empty(), "$",
-						keepff, delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, it.second, show_tempdir, sop_mode);
+						keepff, delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, it.second, show_tempdir, sop_mode, jobs.back());
+				process_job();
 				assign_map.set(mod);
 			}
 		}
 
+		if (!jobs.empty())
+		{
+			log_header(design, "Running %d ABC processes using up to %d threads.\n", GetSize(jobs), num_threads);
+
+			parallel_for(GetSize(jobs), [&](int i) {
+				abc_run_job(jobs[i]);
+			}, num_threads);
+
+			int failed_jobs = 0;
+			for (auto &job : jobs)
+				if (!job.abc_command.empty() && job.abc_retcode != 0) {
+					log("ABC: execution of command \"%s\" failed: return code %d.\n", job.abc_command.c_str(), job.abc_retcode);
+					failed_jobs++;
+				}
+
+			if (failed_jobs != 0) {
+				for (auto &job : jobs)
+					if (job.cleanup)
+						remove_directory(job.tempdir_name);
+				log_error("ABC: %d of %d ABC processes failed.\n", failed_jobs, GetSize(jobs));
+			}
+
+			for (auto &job : jobs) {
+				log_push();
+				abc_finish_job(design, job);
+			}
+		}
+
+		pending_port_bits.clear();
+
 		assign_map.clear();
 		signal_list.clear();
 		signal_map.clear();
@@ -21,6 +21,7 @@
 #include "kernel/utils.h"
 #include "kernel/sigtools.h"
 #include "libs/sha1/sha1.h"
+#include "backends/ilang/ilang_backend.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -34,6 +35,9 @@ YOSYS_NAMESPACE_BEGIN
 // see maccmap.cc
 extern void maccmap(RTLIL::Module *module, RTLIL::Cell *cell, bool unmap = false);
 
+// see verilog_frontend.cc
+extern std::vector<std::string> verilog_defaults;
+
 YOSYS_NAMESPACE_END
 
 USING_YOSYS_NAMESPACE
@@ -894,8 +898,54 @@ struct TechmapWorker
 	}
 };
 
+static bool sha1_file(const std::string &filename, std::string &hash)
+{
+	std::ifstream f(filename.c_str());
+	if (f.fail())
+		return false;
+	std::stringstream buffer;
+	buffer << f.rdbuf();
+	hash = sha1(buffer.str());
+	return true;
+}
+
+// Parsed map libraries are kept for the lifetime of the process, together with
+// the templates that have been derived from them, keyed by a hash over the
+// contents of the map files, the frontend options (including the options set
+// with 'verilog_defaults') and the techmap options that change the templates
+// in place (-autoproc, -recursive, ..). The files included by the map files
+// are recorded with their hashes and checked each time a library is reused.
+struct TechmapLibrary
+{
+	RTLIL::Design *map;
+	std::vector<RTLIL::IdString> lib_modules;
+	std::vector<std::pair<std::string, std::string>> includes;
+	std::map<std::pair<RTLIL::IdString, std::map<RTLIL::IdString, RTLIL::Const>>, RTLIL::Module*> techmap_cache;
+	std::map<RTLIL::Module*, bool> techmap_do_cache;
+
+	TechmapLibrary() : map(new RTLIL::Design) { }
+	~TechmapLibrary() { delete map; }
+
+	bool includes_unchanged() const
+	{
+		for (auto &it : includes) {
+			std::string hash;
+			if (!sha1_file(it.first, hash) || hash != it.second)
+				return false;
+		}
+		return true;
+	}
+};
+
+dict<std::string, TechmapLibrary*> techmap_libraries;
+
 struct TechmapPass : public Pass {
 	TechmapPass() : Pass("techmap", "generic technology mapper") { }
+	virtual ~TechmapPass() {
+		for (auto &it : techmap_libraries)
+			delete it.second;
+		techmap_libraries.clear();
+	}
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -940,6 +990,23 @@ struct TechmapPass : public Pass {
 		log("        map file. Note that the Verilog frontend is also called with the\n");
 		log("        '-ignore_redef' option set.\n");
 		log("\n");
+		log("    -nocache\n");
+		log("        do not use the cache of map libraries (see below).\n");
+		log("\n");
+		log("    -cachedir <directory>\n");
+		log("        also store map libraries in the given directory (in RTLIL format) and\n");
+		log("        load them from there in later runs. This is only done for libraries\n");
+		log("        without parametric modules, as parametric modules can only be derived\n");
+		log("        from the Verilog frontend's AST.\n");
+		log("\n");
+		log("The map libraries (the parsed map files and all templates derived from them)\n");
+		log("are kept in memory for the lifetime of the process and reused by later techmap\n");
+		log("calls with the same map files (by content), the same -D and -I options, the\n");
+		log("same 'verilog_defaults' and the same -extern, -recursive, -autoproc and -assert\n");
+		log("options. A library is parsed again when one of the files included via `include\n");
+		log("has changed. Libraries that contain designs saved with 'design -save'\n");
+		log("(-map %%<name>) are not cached.\n");
+		log("\n");
 		log("When a module in the map file has the 'techmap_celltype' attribute set, it will\n");
 		log("match cells with a type that match the text value of this attribute. Otherwise\n");
 		log("the module name will be used to match the cell.\n");
@@ -1037,6 +1104,8 @@ struct TechmapPass : public Pass {
 
 		std::vector<std::string> map_files;
 		std::string verilog_frontend = "verilog -ignore_redef";
+		std::string cache_dir;
+		bool use_cache = true;
 		int max_iter = -1;
 
 		size_t argidx;
@@ -1073,24 +1142,35 @@ struct TechmapPass : public Pass {
 				worker.autoproc_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-nocache") {
+				use_cache = false;
+				continue;
+			}
+			if (args[argidx] == "-cachedir" && argidx+1 < args.size()) {
+				cache_dir = args[++argidx];
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
-		RTLIL::Design *map = new RTLIL::Design;
+		// read all map files first, so that their contents can be hashed
+		std::vector<std::pair<std::string, std::string>> map_file_contents;
+		std::string cache_key = verilog_frontend + "\n";
+
+		for (auto &arg : verilog_defaults)
+			cache_key += arg + "\n";
+
 		if (map_files.empty()) {
-			std::istringstream f(stdcells_code);
-			Frontend::frontend_call(map, &f, "<techmap.v>", verilog_frontend);
+			map_file_contents.push_back(std::pair<std::string, std::string>("<techmap.v>", stdcells_code));
+			cache_key += "<techmap.v>\n";
 		} else
-			for (auto &fn : map_files)
+			for (auto fn : map_files)
 				if (fn.substr(0, 1) == "%") {
-					if (!saved_designs.count(fn.substr(1))) {
-						delete map;
+					if (!saved_designs.count(fn.substr(1)))
 						log_cmd_error("Can't saved design `%s'.\n", fn.c_str()+1);
-					}
-					for (auto mod : saved_designs.at(fn.substr(1))->modules())
-						if (!map->has(mod->name))
-							map->add(mod->clone());
+					map_file_contents.push_back(std::pair<std::string, std::string>(fn, std::string()));
+					use_cache = false;
 				} else {
 					std::ifstream f;
 					rewrite_filename(fn);
@@ -1098,21 +1178,150 @@ struct TechmapPass : public Pass {
 					yosys_input_files.insert(fn);
 					if (f.fail())
 						log_cmd_error("Can't open map file `%s'\n", fn.c_str());
-					Frontend::frontend_call(map, &f, fn, (fn.size() > 3 && fn.substr(fn.size()-3) == ".il") ? "ilang" : verilog_frontend);
+					std::stringstream buffer;
+					buffer << f.rdbuf();
+					map_file_contents.push_back(std::pair<std::string, std::string>(fn, buffer.str()));
+					cache_key += fn + "\n" + sha1(buffer.str()) + "\n";
 				}
 
+		// the cache file holds the map design as parsed, before any template is
+		// changed by a techmap run, so it only depends on the files and the
+		// frontend options. the in-memory libraries also depend on the techmap
+		// options that change the templates in place.
+		std::string file_key = sha1(cache_key);
+		cache_key += stringf("%d %d %d %d\n", worker.extern_mode, worker.recursive_mode, worker.autoproc_mode, worker.assert_mode);
+		cache_key = sha1(cache_key);
+
+		TechmapLibrary *library = nullptr;
+
+		// the library is taken out of the cache while it is in use and only put
+		// back if the techmap run completes
+		if (use_cache && techmap_libraries.count(cache_key)) {
+			library = techmap_libraries.at(cache_key);
+			techmap_libraries.erase(cache_key);
+			if (library->includes_unchanged()) {
+				log("Using cached map library %s.\n", cache_key.c_str());
+			} else {
+				log("Not using cached map library %s as an included file has changed.\n", cache_key.c_str());
+				delete library;
+				library = nullptr;
+			}
+		}
+
+		std::string cache_file = cache_dir.empty() ? std::string() : cache_dir + "/techmap_" + file_key + ".il";
+
+		// the cache file starts with one "# techmap_include <sha1> <filename>"
+		// comment for each file included by the map files
+		if (library == nullptr && use_cache && !cache_file.empty()) {
+			std::ifstream f(cache_file.c_str());
+			if (!f.fail()) {
+				std::stringstream buffer;
+				buffer << f.rdbuf();
+				std::string content = buffer.str();
+
+				library = new TechmapLibrary;
+				for (size_t pos = 0; content.compare(pos, 18, "# techmap_include ") == 0; ) {
+					size_t eol = content.find('\n', pos);
+					if (eol == std::string::npos)
+						break;
+					std::string line = content.substr(pos+18, eol-pos-18);
+					size_t sep = line.find(' ');
+					if (sep != std::string::npos)
+						library->includes.push_back(std::pair<std::string, std::string>(line.substr(sep+1), line.substr(0, sep)));
+					pos = eol+1;
+				}
+
+				if (library->includes_unchanged()) {
+					log("Loading map library from cache file `%s'.\n", cache_file.c_str());
+					std::istringstream ff(content);
+					Frontend::frontend_call(library->map, &ff, cache_file, "ilang");
+				} else {
+					log("Not using cache file `%s' as an included file has changed.\n", cache_file.c_str());
+					delete library;
+					library = nullptr;
+				}
+			}
+		}
+
+		if (library == nullptr)
+		{
+			library = new TechmapLibrary;
+			RTLIL::Design *map = library->map;
+
+			// the frontends add all files they read to yosys_input_files. collect
+			// the files that are read for this library to find the included files.
+			std::set<std::string> saved_input_files;
+			saved_input_files.swap(yosys_input_files);
+
+			for (auto &it : map_file_contents)
+				if (it.first.substr(0, 1) == "%") {
+					for (auto mod : saved_designs.at(it.first.substr(1))->modules())
+						if (!map->has(mod->name))
+							map->add(mod->clone_ordered());
+				} else {
+					std::istringstream f(it.second);
+					Frontend::frontend_call(map, &f, it.first, (it.first.size() > 3 && it.first.substr(it.first.size()-3) == ".il") ? "ilang" : verilog_frontend);
+				}
+
+			yosys_input_files.swap(saved_input_files);
+			for (auto &it : map_file_contents)
+				saved_input_files.erase(it.first);
+			for (auto &fn : saved_input_files) {
+				std::string hash;
+				if (!sha1_file(fn, hash))
+					use_cache = false;
+				library->includes.push_back(std::pair<std::string, std::string>(fn, hash));
+				yosys_input_files.insert(fn);
+			}
+
+			bool parametric = false;
+			for (auto mod : map->modules())
+				if (!mod->avail_parameters.empty())
+					parametric = true;
+
+			// write to a temporary file first, so that concurrent yosys processes
+			// never read a partially written cache file
+			if (use_cache && !cache_file.empty() && !parametric) {
+				std::string temp_file = make_temp_file(cache_file + ".XXXXXX");
+				std::ofstream f(temp_file.c_str());
+				if (f.fail()) {
+					log_warning("Can't open cache file `%s' for writing: %s\n", temp_file.c_str(), strerror(errno));
+				} else {
+					log("Writing map library to cache file `%s'.\n", cache_file.c_str());
+					for (auto &it : library->includes)
+						f << "# techmap_include " << it.second << " " << it.first << "\n";
+					ILANG_BACKEND::dump_design(f, map, false);
+					f.close();
+					if (f.fail() || rename(temp_file.c_str(), cache_file.c_str()) != 0)
+						log_warning("Can't write cache file `%s': %s\n", cache_file.c_str(), strerror(errno));
+				}
+				remove(temp_file.c_str());
+			}
+		}
+
+		// only the modules of the map files are templates, not the derived and
+		// constmapped modules that were added to the map design by earlier runs
+		if (library->lib_modules.empty())
+			for (auto &it : library->map->modules_)
+				library->lib_modules.push_back(it.first);
+
+		RTLIL::Design *map = library->map;
+		worker.techmap_cache.swap(library->techmap_cache);
+		worker.techmap_do_cache.swap(library->techmap_do_cache);
+
 		std::map<RTLIL::IdString, std::set<RTLIL::IdString, RTLIL::sort_by_id_str>> celltypeMap;
-		for (auto &it : map->modules_) {
-			if (it.second->attributes.count("\\techmap_celltype") && !it.second->attributes.at("\\techmap_celltype").bits.empty()) {
-				char *p = strdup(it.second->attributes.at("\\techmap_celltype").decode_string().c_str());
+		for (auto &mod_name : library->lib_modules) {
+			RTLIL::Module *mod = map->module(mod_name);
+			if (mod->attributes.count("\\techmap_celltype") && !mod->attributes.at("\\techmap_celltype").bits.empty()) {
+				char *p = strdup(mod->attributes.at("\\techmap_celltype").decode_string().c_str());
 				for (char *q = strtok(p, " \t\r\n"); q; q = strtok(NULL, " \t\r\n"))
-					celltypeMap[RTLIL::escape_id(q)].insert(it.first);
+					celltypeMap[RTLIL::escape_id(q)].insert(mod_name);
 				free(p);
 			} else {
-				string module_name = it.first.str();
+				string module_name = mod_name.str();
 				if (module_name.substr(0, 2) == "\\$")
 					module_name = module_name.substr(1);
-				celltypeMap[module_name].insert(it.first);
+				celltypeMap[module_name].insert(mod_name);
 			}
 		}
 
@@ -1138,7 +1347,13 @@ struct TechmapPass : public Pass {
 		}
 
 		log("No more expansions possible.\n");
-		delete map;
+
+		if (use_cache) {
+			worker.techmap_cache.swap(library->techmap_cache);
+			worker.techmap_do_cache.swap(library->techmap_do_cache);
+			techmap_libraries[cache_key] = library;
+		} else
+			delete library;
 
 		log_pop();
 	}
@@ -0,0 +1,255 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include <chrono>
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+// A copy of the single-threaded id table that RTLIL::IdString used before the
+// sharded storage was introduced. Only used as a reference for the benchmark.
+
+struct LegacyIdTable
+{
+	std::vector<int> refcount_storage;
+	std::vector<char*> id_storage;
+	dict<char*, int, hash_cstr_ops> id_index;
+	std::vector<int> free_idx_list;
+
+	~LegacyIdTable()
+	{
+		for (auto p : id_storage)
+			free(p);
+	}
+
+	int get_reference(int idx)
+	{
+		refcount_storage.at(idx)++;
+		return idx;
+	}
+
+	int get_reference(const char *p)
+	{
+		auto it = id_index.find((char*)p);
+		if (it != id_index.end()) {
+			refcount_storage.at(it->second)++;
+			return it->second;
+		}
+
+		if (free_idx_list.empty()) {
+			free_idx_list.push_back(id_storage.size());
+			id_storage.push_back(nullptr);
+			refcount_storage.push_back(0);
+		}
+
+		int idx = free_idx_list.back();
+		free_idx_list.pop_back();
+		id_storage.at(idx) = strdup(p);
+		id_index[id_storage.at(idx)] = idx;
+		refcount_storage.at(idx)++;
+		return idx;
+	}
+
+	void put_reference(int idx)
+	{
+		log_assert(refcount_storage.at(idx) > 0);
+
+		if (--refcount_storage.at(idx) != 0)
+			return;
+
+		id_index.erase(id_storage.at(idx));
+		free(id_storage.at(idx));
+		id_storage.at(idx) = nullptr;
+		free_idx_list.push_back(idx);
+	}
+};
+
+struct LegacyIdString
+{
+	static LegacyIdTable *table;
+	int index_;
+
+	LegacyIdString(const char *str) : index_(table->get_reference(str)) { }
+	LegacyIdString(const LegacyIdString &str) : index_(table->get_reference(str.index_)) { }
+	~LegacyIdString() { table->put_reference(index_); }
+
+	void operator=(const LegacyIdString &rhs) {
+		table->put_reference(index_);
+		index_ = table->get_reference(rhs.index_);
+	}
+};
+
+LegacyIdTable *LegacyIdString::table = nullptr;
+
+struct BenchResult
+{
+	double construct_sec = 0, lookup_sec = 0, copy_sec = 0, destroy_sec = 0;
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename T>
+static void bench_worker(BenchResult &result, const std::vector<std::string> &names, int num_copies)
+{
+	auto start = std::chrono::steady_clock::now();
+	std::vector<T> ids;
+	ids.reserve(GetSize(names));
+	for (auto &name : names)
+		ids.push_back(T(name.c_str()));
+	result.construct_sec += seconds_since(start);
+
+	start = std::chrono::steady_clock::now();
+	for (auto &name : names) {
+		T id(name.c_str());
+		(void)id;
+	}
+	result.lookup_sec += seconds_since(start);
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < num_copies; i++) {
+		std::vector<T> copies(ids);
+		std::swap(copies.front(), copies.back());
+	}
+	result.copy_sec += seconds_since(start);
+
+	start = std::chrono::steady_clock::now();
+	ids.clear();
+	result.destroy_sec += seconds_since(start);
+}
+
+static void report(const char *label, const BenchResult &result, int num_ids, int num_copies)
+{
+	auto rate = [](double num, double sec) { return sec > 0 ? num / sec / 1e6 : 0.0; };
+	log("%-24s construct %8.2f  lookup %8.2f  copy+destroy %8.2f  destroy %8.2f  (M ops/s)\n", label,
+			rate(num_ids, result.construct_sec), rate(num_ids, result.lookup_sec),
+			rate(double(num_ids) * num_copies, result.copy_sec), rate(num_ids, result.destroy_sec));
+}
+
+struct TestIdstringPass : public Pass {
+	TestIdstringPass() : Pass("test_idstring", "benchmark the IdString interning table") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    test_idstring [options]\n");
+		log("\n");
+		log("Measure the throughput of creating, looking up, copying and destroying\n");
+		log("RTLIL::IdString objects and compare it with a single-threaded reference\n");
+		log("implementation of the id table.\n");
+		log("\n");
+		log("    -n {integer}\n");
+		log("        number of distinct ids per thread (default = 100000).\n");
+		log("\n");
+		log("    -c {integer}\n");
+		log("        number of times the ids are copied (default = 20).\n");
+		log("\n");
+		log("    -j {integer}\n");
+		log("        also run the benchmark for the IdString table with this number of\n");
+		log("        threads, each working on its own set of ids (default = 1).\n");
+		log("\n");
+	}
+	virtual void execute(std::vector<std::string> args, RTLIL::Design*)
+	{
+		int num_ids = 100000;
+		int num_copies = 20;
+		int num_threads = 1;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-n" && argidx+1 < args.size()) {
+				num_ids = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-c" && argidx+1 < args.size()) {
+				num_copies = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				num_threads = atoi(args[++argidx].c_str());
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, nullptr);
+
+		if (num_ids < 1 || num_copies < 1 || num_threads < 1)
+			log_cmd_error("Invalid benchmark parameters.\n");
+
+		log_header(nullptr, "Executing TEST_IDSTRING pass.\n");
+
+		auto make_names = [&](std::string prefix) {
+			std::vector<std::string> names;
+			for (int i = 0; i < num_ids; i++)
+				names.push_back(stringf("\\test_idstring_%s_%d", prefix.c_str(), i));
+			return names;
+		};
+
+		std::vector<std::string> names = make_names("serial");
+		std::vector<std::string> immortal_names = make_names("immortal");
+
+		BenchResult legacy_result;
+		LegacyIdString::table = new LegacyIdTable;
+		bench_worker<LegacyIdString>(legacy_result, names, num_copies);
+		delete LegacyIdString::table;
+		LegacyIdString::table = nullptr;
+		report("reference:", legacy_result, num_ids, num_copies);
+
+		BenchResult result;
+		bench_worker<RTLIL::IdString>(result, names, num_copies);
+		report("IdString:", result, num_ids, num_copies);
+
+		{
+			RTLIL::IdString::immortal_scope_t immortal_scope;
+			BenchResult immortal_result;
+			bench_worker<RTLIL::IdString>(immortal_result, immortal_names, num_copies);
+			report("IdString (immortal):", immortal_result, num_ids, num_copies);
+		}
+
+		if (num_threads > 1)
+		{
+			std::vector<std::vector<std::string>> thread_names;
+			for (int t = 0; t < num_threads; t++)
+				thread_names.push_back(make_names(stringf("thread%d", t)));
+
+			std::vector<BenchResult> thread_results(num_threads);
+			auto start = std::chrono::steady_clock::now();
+			parallel_for(num_threads, [&](int t) {
+				bench_worker<RTLIL::IdString>(thread_results[t], thread_names[t], num_copies);
+			}, num_threads);
+			double total_sec = seconds_since(start);
+
+			BenchResult sum;
+			for (auto &r : thread_results) {
+				sum.construct_sec += r.construct_sec / num_threads;
+				sum.lookup_sec += r.lookup_sec / num_threads;
+				sum.copy_sec += r.copy_sec / num_threads;
+				sum.destroy_sec += r.destroy_sec / num_threads;
+			}
+			report(stringf("IdString (%d threads):", num_threads).c_str(), sum, num_ids * num_threads, num_copies);
+			log("Wall time with %d threads: %.3f seconds.\n", num_threads, total_sec);
+		}
+	}
+} TestIdstringPass;
+
+PRIVATE_NAMESPACE_END
@@ -0,0 +1,447 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/modtools.h"
+#include <chrono>
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+// A copy of the std::map based ModIndex that reloads the entire module after
+// new_connections(). Only used as a reference for the benchmark.
+
+struct LegacyModIndex : public RTLIL::Monitor
+{
+	typedef ModIndex::PortInfo PortInfo;
+
+	struct SigBitInfo
+	{
+		bool is_input, is_output;
+		pool<PortInfo> ports;
+
+		SigBitInfo() : is_input(false), is_output(false) { }
+
+		void merge(const SigBitInfo &other)
+		{
+			is_input = is_input || other.is_input;
+			is_output = is_output || other.is_output;
+			ports.insert(other.ports.begin(), other.ports.end());
+		}
+	};
+
+	SigMap sigmap;
+	RTLIL::Module *module;
+	std::map<RTLIL::SigBit, SigBitInfo> database;
+	bool auto_reload_module;
+
+	void port_add(RTLIL::Cell *cell, RTLIL::IdString port, const RTLIL::SigSpec &sig)
+	{
+		for (int i = 0; i < GetSize(sig); i++) {
+			RTLIL::SigBit bit = sigmap(sig[i]);
+			if (bit.wire)
+				database[bit].ports.insert(PortInfo(cell, port, i));
+		}
+	}
+
+	void port_del(RTLIL::Cell *cell, RTLIL::IdString port, const RTLIL::SigSpec &sig)
+	{
+		for (int i = 0; i < GetSize(sig); i++) {
+			RTLIL::SigBit bit = sigmap(sig[i]);
+			if (bit.wire)
+				database[bit].ports.erase(PortInfo(cell, port, i));
+		}
+	}
+
+	void reload_module()
+	{
+		sigmap.clear();
+		sigmap.set(module);
+
+		database.clear();
+		for (auto wire : module->wires())
+			if (wire->port_input || wire->port_output)
+				for (int i = 0; i < GetSize(wire); i++) {
+					RTLIL::SigBit bit = sigmap(RTLIL::SigBit(wire, i));
+					if (bit.wire && wire->port_input)
+						database[bit].is_input = true;
+					if (bit.wire && wire->port_output)
+						database[bit].is_output = true;
+				}
+		for (auto cell : module->cells())
+			for (auto &conn : cell->connections())
+				port_add(cell, conn.first, conn.second);
+
+		auto_reload_module = false;
+	}
+
+	virtual void notify_connect(RTLIL::Cell *cell, const RTLIL::IdString &port, const RTLIL::SigSpec &old_sig, RTLIL::SigSpec &sig) YS_OVERRIDE
+	{
+		if (auto_reload_module)
+			return;
+
+		port_del(cell, port, old_sig);
+		port_add(cell, port, sig);
+	}
+
+	virtual void notify_connect(RTLIL::Module*, const RTLIL::SigSig &sigsig) YS_OVERRIDE
+	{
+		if (auto_reload_module)
+			return;
+
+		for (int i = 0; i < GetSize(sigsig.first); i++)
+		{
+			RTLIL::SigBit lhs = sigmap(sigsig.first[i]);
+			RTLIL::SigBit rhs = sigmap(sigsig.second[i]);
+			bool has_lhs = database.count(lhs) != 0;
+			bool has_rhs = database.count(rhs) != 0;
+
+			if (!has_lhs && !has_rhs) {
+				sigmap.add(lhs, rhs);
+			} else
+			if (!has_rhs) {
+				SigBitInfo new_info = database.at(lhs);
+				database.erase(lhs);
+				sigmap.add(lhs, rhs);
+				lhs = sigmap(lhs);
+				if (lhs.wire)
+					database[lhs] = new_info;
+			} else
+			if (!has_lhs) {
+				SigBitInfo new_info = database.at(rhs);
+				database.erase(rhs);
+				sigmap.add(lhs, rhs);
+				rhs = sigmap(rhs);
+				if (rhs.wire)
+					database[rhs] = new_info;
+			} else {
+				SigBitInfo new_info = database.at(lhs);
+				new_info.merge(database.at(rhs));
+				database.erase(lhs);
+				database.erase(rhs);
+				sigmap.add(lhs, rhs);
+				rhs = sigmap(rhs);
+				if (rhs.wire)
+					database[rhs] = new_info;
+			}
+		}
+	}
+
+	virtual void notify_connect(RTLIL::Module*, const std::vector<RTLIL::SigSig>&) YS_OVERRIDE
+	{
+		auto_reload_module = true;
+	}
+
+	virtual void notify_blackout(RTLIL::Module*) YS_OVERRIDE
+	{
+		auto_reload_module = true;
+	}
+
+	LegacyModIndex(RTLIL::Module *_m) : sigmap(_m), module(_m)
+	{
+		auto_reload_module = true;
+		module->monitors.insert(this);
+	}
+
+	~LegacyModIndex()
+	{
+		module->monitors.erase(this);
+	}
+
+	pool<PortInfo> &query_ports(RTLIL::SigBit bit)
+	{
+		static pool<PortInfo> empty_result_set;
+
+		if (auto_reload_module)
+			reload_module();
+
+		auto it = database.find(sigmap(bit));
+		if (it == database.end())
+			return empty_result_set;
+		return it->second.ports;
+	}
+
+	bool query_is_input(RTLIL::SigBit bit)
+	{
+		if (auto_reload_module)
+			reload_module();
+
+		auto it = database.find(sigmap(bit));
+		return it != database.end() && it->second.is_input;
+	}
+
+	bool query_is_output(RTLIL::SigBit bit)
+	{
+		if (auto_reload_module)
+			reload_module();
+
+		auto it = database.find(sigmap(bit));
+		return it != database.end() && it->second.is_output;
+	}
+};
+
+struct BenchNetlist
+{
+	RTLIL::Module *module;
+	std::vector<RTLIL::SigBit> bits;
+	std::vector<RTLIL::Cell*> cells;
+	uint32_t rng_state;
+	int cell_counter, wire_counter, rename_counter;
+
+	BenchNetlist(RTLIL::Design *design, int num_cells, uint32_t seed) : rng_state(seed), cell_counter(0), wire_counter(0), rename_counter(0)
+	{
+		module = design->addModule("\\test_modindex");
+
+		RTLIL::Wire *in = module->addWire("\\in", 32);
+		in->port_id = 1;
+		in->port_input = true;
+
+		RTLIL::Wire *out = module->addWire("\\out", 32);
+		out->port_id = 2;
+		out->port_output = true;
+		module->fixup_ports();
+
+		for (int i = 0; i < GetSize(in); i++)
+			bits.push_back(RTLIL::SigBit(in, i));
+
+		for (int i = 0; i < num_cells; i++) {
+			add_cell();
+			if (rng(10) == 0)
+				add_alias();
+		}
+
+		for (int i = 0; i < GetSize(out); i++)
+			module->connect(RTLIL::SigBit(out, i), random_bit());
+	}
+
+	int rng(int n)
+	{
+		rng_state ^= rng_state << 13;
+		rng_state ^= rng_state >> 17;
+		rng_state ^= rng_state << 5;
+		return rng_state % n;
+	}
+
+	RTLIL::SigBit random_bit()
+	{
+		return bits[rng(GetSize(bits))];
+	}
+
+	RTLIL::SigBit new_bit()
+	{
+		RTLIL::Wire *wire = module->addWire(stringf("\\w%d", wire_counter++));
+		bits.push_back(wire);
+		return wire;
+	}
+
+	void add_cell()
+	{
+		RTLIL::IdString name = stringf("\\c%d", cell_counter++);
+		RTLIL::SigBit a = random_bit(), b = random_bit();
+		RTLIL::Cell *cell;
+
+		switch (rng(4)) {
+			case 0:  cell = module->addAndGate(name, a, b, new_bit()); break;
+			case 1:  cell = module->addOrGate(name, a, b, new_bit()); break;
+			case 2:  cell = module->addXorGate(name, a, b, new_bit()); break;
+			default: cell = module->addNotGate(name, a, new_bit()); break;
+		}
+
+		cells.push_back(cell);
+	}
+
+	void add_alias()
+	{
+		RTLIL::SigBit bit = rng(20) == 0 ? RTLIL::SigBit(rng(2) ? RTLIL::State::S1 : RTLIL::State::S0) : random_bit();
+		module->connect(new_bit(), bit);
+	}
+
+	void remove_cell()
+	{
+		int idx = rng(GetSize(cells));
+		module->remove(cells[idx]);
+		cells[idx] = cells.back();
+		cells.pop_back();
+	}
+
+	void remove_connection()
+	{
+		std::vector<RTLIL::SigSig> new_conns = module->connections();
+		int idx = rng(GetSize(new_conns));
+		new_conns.erase(new_conns.begin() + idx);
+		module->new_connections(new_conns);
+	}
+
+	// replace a connection in the middle of the list, so that the new
+	// list is not just the old list with connections appended
+	void replace_connection()
+	{
+		std::vector<RTLIL::SigSig> new_conns = module->connections();
+		int idx = rng(GetSize(new_conns));
+		new_conns[idx].second = random_bit();
+		module->new_connections(new_conns);
+	}
+
+	void rename_wire()
+	{
+		RTLIL::Wire *wire = random_bit().wire;
+		if (wire != nullptr && wire->port_id == 0)
+			module->rename(wire, stringf("\\r%d", rename_counter++));
+	}
+
+	// a random modification of the netlist, followed by a query
+	template<typename T>
+	void update(T &index)
+	{
+		int k = rng(100);
+
+		if (k < 50)
+			cells[rng(GetSize(cells))]->setPort("\\A", random_bit());
+		else if (k < 70 && GetSize(cells) > 1)
+			remove_cell();
+		else if (k < 90)
+			add_cell();
+		else if (k < 96)
+			add_alias();
+		else if (k < 97)
+			replace_connection();
+		else if (k < 98)
+			rename_wire();
+		else
+			remove_connection();
+
+		index.query_ports(random_bit());
+	}
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename T>
+static void bench_index(const char *label, int num_cells, int num_updates, uint32_t seed, bool compare)
+{
+	RTLIL::Design *design = new RTLIL::Design;
+	BenchNetlist netlist(design, num_cells, seed);
+
+	auto start = std::chrono::steady_clock::now();
+	T *index = new T(netlist.module);
+	index->query_ports(netlist.bits.front());
+	double build_sec = seconds_since(start);
+
+	start = std::chrono::steady_clock::now();
+	int num_ports = 0;
+	for (auto bit : netlist.bits)
+		num_ports += GetSize(index->query_ports(bit));
+	double query_sec = seconds_since(start);
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < num_updates; i++)
+		netlist.update(*index);
+	double update_sec = seconds_since(start);
+
+	log("%-12s build %8.3f s  query %8.3f s  %d updates %8.3f s  (%d port bits)\n", label,
+			build_sec, query_sec, num_updates, update_sec, num_ports);
+
+	if (compare)
+	{
+		// compare the incrementally updated index with a freshly built reference
+		LegacyModIndex reference(netlist.module);
+		int mismatches = 0;
+
+		for (auto bit : netlist.bits) {
+			pool<ModIndex::PortInfo> ports = index->query_ports(bit);
+			if (ports != reference.query_ports(bit) || index->query_is_input(bit) != reference.query_is_input(bit) ||
+					index->query_is_output(bit) != reference.query_is_output(bit)) {
+				log("Mismatch for bit %s.\n", log_signal(bit));
+				mismatches++;
+			}
+		}
+
+		if (mismatches)
+			log_error("Found %d mismatches between ModIndex and reference implementation.\n", mismatches);
+		log("Incrementally updated index matches reference for all %d bits.\n", GetSize(netlist.bits));
+	}
+
+	delete index;
+	delete design;
+}
+
+struct TestModindexPass : public Pass {
+	TestModindexPass() : Pass("test_modindex", "benchmark and check ModIndex") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    test_modindex [options]\n");
+		log("\n");
+		log("Generate a random gate-level netlist, apply a sequence of random changes to it\n");
+		log("(reconnecting, adding and removing cells and connections, renaming wires)\n");
+		log("and query the ModIndex after each change. The runtime is compared with a\n");
+		log("reference implementation of the old std::map based index that reloads the\n");
+		log("module after Module::new_connections() and wire renames, and the final state\n");
+		log("of the incrementally updated index is checked against the reference.\n");
+		log("\n");
+		log("    -n {integer}\n");
+		log("        number of cells in the generated netlist (default = 10000).\n");
+		log("\n");
+		log("    -u {integer}\n");
+		log("        number of changes to the netlist (default = 10000).\n");
+		log("\n");
+		log("    -s {positive_integer}\n");
+		log("        use this value as rng seed value (default = 42).\n");
+		log("\n");
+	}
+	virtual void execute(std::vector<std::string> args, RTLIL::Design*)
+	{
+		int num_cells = 10000;
+		int num_updates = 10000;
+		uint32_t seed = 42;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-n" && argidx+1 < args.size()) {
+				num_cells = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-u" && argidx+1 < args.size()) {
+				num_updates = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-s" && argidx+1 < args.size()) {
+				seed = atoi(args[++argidx].c_str());
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, nullptr);
+
+		if (num_cells < 1 || num_updates < 0 || seed == 0)
+			log_cmd_error("Invalid benchmark parameters.\n");
+
+		log_header(nullptr, "Executing TEST_MODINDEX pass.\n");
+
+		bench_index<LegacyModIndex>("reference:", num_cells, num_updates, seed, false);
+		bench_index<ModIndex>("ModIndex:", num_cells, num_updates, seed, true);
+	}
+} TestModindexPass;
+
+PRIVATE_NAMESPACE_END
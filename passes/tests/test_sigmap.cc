@@ -0,0 +1,167 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+static void reset_stats()
+{
+	SigMapStats::set_count = 0;
+	SigMapStats::set_ns = 0;
+	SigMapStats::set_bits = 0;
+	SigMapStats::cache_builds = 0;
+	SigMapStats::cache_updates = 0;
+	SigMapStats::cache_invalidations = 0;
+}
+
+static void log_stats()
+{
+	int64_t set_count = SigMapStats::set_count;
+	int64_t set_ns = SigMapStats::set_ns;
+	int64_t set_bits = SigMapStats::set_bits;
+
+	if (!SigMapStats::enabled)
+		log_warning("SigMap counters are disabled, use 'test_sigmap -enable' to enable them.\n");
+
+	log("SigMap counters (module cache %s):\n", SigMapStats::cache_enabled ? "enabled" : "disabled");
+	log("  SigMap::set() calls:     %12lld\n", (long long)set_count);
+	log("  bits in created maps:    %12lld\n", (long long)set_bits);
+	log("  time in SigMap::set():   %12.3f s\n", set_ns * 1e-9);
+	log("  module cache builds:     %12lld\n", (long long)SigMapStats::cache_builds);
+	log("  module cache updates:    %12lld\n", (long long)SigMapStats::cache_updates);
+	log("  module cache drops:      %12lld\n", (long long)SigMapStats::cache_invalidations);
+}
+
+static int check_module(RTLIL::Module *module)
+{
+	SigMap fresh;
+	fresh.build(module);
+	const SigMap &cached = module->sigmap();
+
+	int errors = 0;
+	for (auto wire : module->wires())
+		for (auto bit : SigSpec(wire))
+			if (fresh(bit) != cached(bit)) {
+				log("  %s: %s maps to %s in the cached SigMap but to %s in a new SigMap.\n", log_id(module),
+						log_signal(bit), log_signal(cached(bit)), log_signal(fresh(bit)));
+				errors++;
+			}
+	return errors;
+}
+
+struct TestSigMapPass : public Pass {
+	TestSigMapPass() : Pass("test_sigmap", "SigMap cache counters and checks") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    test_sigmap -cache | -nocache | -enable | -disable | -reset | -stats\n");
+		log("\n");
+		log("Enable or disable the per-module SigMap cache (used by 'SigMap sigmap(module)'\n");
+		log("in all passes), enable or disable the SigMap counters, reset them, or print\n");
+		log("them. The counters are disabled by default. Comparing the time spent in\n");
+		log("SigMap::set() with and without the cache shows the time saved by the cache\n");
+		log("for a script. Example (see also tests/tools/sigmap-bench.sh):\n");
+		log("\n");
+		log("    test_sigmap -nocache -enable -reset; synth; test_sigmap -stats\n");
+		log("\n");
+		log("\n");
+		log("    test_sigmap -check [selection]\n");
+		log("\n");
+		log("Compare the cached SigMap of each selected module with a newly built one and\n");
+		log("fail if they map any wire bit differently.\n");
+		log("\n");
+	}
+	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
+	{
+		bool cache = false, nocache = false, enable = false, disable = false;
+		bool reset = false, stats = false, check = false;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-cache") {
+				cache = true;
+				continue;
+			}
+			if (args[argidx] == "-nocache") {
+				nocache = true;
+				continue;
+			}
+			if (args[argidx] == "-enable") {
+				enable = true;
+				continue;
+			}
+			if (args[argidx] == "-disable") {
+				disable = true;
+				continue;
+			}
+			if (args[argidx] == "-reset") {
+				reset = true;
+				continue;
+			}
+			if (args[argidx] == "-stats") {
+				stats = true;
+				continue;
+			}
+			if (args[argidx] == "-check") {
+				check = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design, check);
+
+		if (cache)
+			SigMapStats::cache_enabled = true;
+
+		if (nocache) {
+			SigMapStats::cache_enabled = false;
+			for (auto module : design->modules())
+				module->invalidate_sigmap();
+		}
+
+		if (enable)
+			SigMapStats::enabled = true;
+
+		if (disable)
+			SigMapStats::enabled = false;
+
+		if (reset)
+			reset_stats();
+
+		if (check) {
+			log_header(design, "Checking cached SigMaps.\n");
+			int errors = 0;
+			for (auto module : design->selected_modules())
+				errors += check_module(module);
+			if (errors)
+				log_error("Found %d bits with a wrong mapping in the cached SigMaps.\n", errors);
+			log("Cached SigMaps are consistent.\n");
+		}
+
+		if (stats)
+			log_stats();
+	}
+} TestSigMapPass;
+
+PRIVATE_NAMESPACE_END
@@ -0,0 +1,108 @@
+#!/bin/bash
+
+set -ev
+
+rm -rf techmap_cache.tmp
+mkdir techmap_cache.tmp
+
+cat > techmap_cache.tmp/uut.v <<EOT
+module top(input [7:0] a, b, output [7:0] y, output [3:0] z);
+assign y = a + b;
+assign z = a[3:0] - b[3:0];
+endmodule
+EOT
+
+cat > techmap_cache.tmp/map.v <<EOT
+module \\\$_AND_ (input A, B, output Y);
+wire t;
+\\\$_NAND_ n (.A(A), .B(B), .Y(t));
+\\\$_NOT_ i (.A(t), .Y(Y));
+endmodule
+EOT
+
+# run techmap twice on the same design: the second run must use the cached
+# library and the cached derived templates, and must give the same result
+../../yosys -l techmap_cache.tmp/run1.log -p '
+	read_verilog techmap_cache.tmp/uut.v; proc; design -save orig
+	techmap; design -save first
+	design -load orig; techmap; select -assert-none t:$add t:$sub t:$alu
+	design -copy-from first -as gold top; rename top gate
+	miter -equiv -flatten -make_assert gold gate miter
+	sat -verify -prove-asserts miter
+	design -load orig; techmap -map techmap_cache.tmp/map.v -cachedir techmap_cache.tmp t:$and
+'
+test $(grep -c 'Using cached map library' techmap_cache.tmp/run1.log) = 1
+sed -n '/Using cached map library/,$p' techmap_cache.tmp/run1.log > techmap_cache.tmp/run1_cached.log
+grep -q 'Mapping .* using \$paramod\\_90_alu' techmap_cache.tmp/run1_cached.log
+! grep -q 'Derived module' techmap_cache.tmp/run1_cached.log
+! grep -q 'paramod\$paramod' techmap_cache.tmp/run1.log
+
+# the non-parametric map library is loaded from the cache directory
+../../yosys -l techmap_cache.tmp/run2.log -p '
+	read_verilog techmap_cache.tmp/uut.v; proc; design -save orig
+	techmap -map techmap_cache.tmp/map.v -cachedir techmap_cache.tmp t:$and; techmap
+	design -copy-from orig -as gold top; rename top gate
+	miter -equiv -flatten -make_assert gold gate miter
+	sat -verify -prove-asserts miter
+'
+grep -q 'Loading map library from cache file' techmap_cache.tmp/run2.log
+test -z "$(ls techmap_cache.tmp | grep '\.il\.')"
+
+# the verilog_defaults options and the contents of included files are part of
+# the cache key, also for the cache directory
+cat > techmap_cache.tmp/and.v <<EOT
+module top(input a, b, output y);
+assign y = a & b;
+endmodule
+EOT
+
+cat > techmap_cache.tmp/map_inc.v <<EOT
+module \\\$_AND_ (input A, B, output Y);
+\`ifdef USE_OR
+assign Y = A | B;
+\`else
+\`include "map_inc.vh"
+\`endif
+endmodule
+EOT
+
+echo 'assign Y = A ^ B;' > techmap_cache.tmp/map_inc.vh
+
+cat > techmap_cache.tmp/run3.ys <<EOT
+read_verilog techmap_cache.tmp/and.v; proc; techmap; design -save orig
+techmap -map techmap_cache.tmp/map_inc.v -cachedir techmap_cache.tmp; select -assert-count 1 t:\$xor
+design -load orig; verilog_defaults -add -DUSE_OR
+techmap -map techmap_cache.tmp/map_inc.v -cachedir techmap_cache.tmp; select -assert-count 1 t:\$or
+design -load orig; verilog_defaults -clear
+techmap -map techmap_cache.tmp/map_inc.v -cachedir techmap_cache.tmp; select -assert-count 1 t:\$xor
+!echo 'assign Y = A - B;' > techmap_cache.tmp/map_inc.vh
+design -load orig; techmap -map techmap_cache.tmp/map_inc.v -cachedir techmap_cache.tmp; select -assert-count 1 t:\$sub
+EOT
+
+../../yosys -l techmap_cache.tmp/run3.log techmap_cache.tmp/run3.ys
+test $(grep -c 'Using cached map library' techmap_cache.tmp/run3.log) = 1
+grep -q 'as an included file has changed' techmap_cache.tmp/run3.log
+
+echo 'assign Y = A ^ B;' > techmap_cache.tmp/map_inc.vh
+../../yosys -l techmap_cache.tmp/run4.log -p '
+	read_verilog techmap_cache.tmp/and.v; proc; techmap
+	techmap -map techmap_cache.tmp/map_inc.v -cachedir techmap_cache.tmp; select -assert-count 1 t:$xor
+'
+grep -q 'Not using cache file .* as an included file has changed' techmap_cache.tmp/run4.log
+
+# templates changed in place by -autoproc must not be used without -autoproc
+cat > techmap_cache.tmp/map_proc.v <<EOT
+module \\\$_AND_ (input A, B, output reg Y);
+always @* Y = A & B;
+endmodule
+EOT
+
+! ../../yosys -l techmap_cache.tmp/run5.log -p '
+	read_verilog techmap_cache.tmp/and.v; proc; techmap; design -save orig
+	techmap -autoproc -map techmap_cache.tmp/map_proc.v
+	design -load orig; techmap -map techmap_cache.tmp/map_proc.v
+'
+grep -q 'Technology map yielded processes -> this is not supported' techmap_cache.tmp/run5.log
+
+rm -rf techmap_cache.tmp
+: OK
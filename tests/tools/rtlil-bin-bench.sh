@@ -0,0 +1,44 @@
+#!/bin/bash
+#
+# Check that a design survives a round trip through write_rtlil_bin and
+# read_rtlil_bin unchanged (compared using the ilang backend) and print the
+# load and save times for the ilang and binary RTLIL formats.
+#
+# Usage: bash rtlil-bin-bench.sh <design_file> [script]
+#        (the default script is "hierarchy -auto-top")
+
+set -e
+yosys="$(dirname "$0")/../../yosys"
+design=$1
+script=${2:-"hierarchy -auto-top"}
+
+tmp=$(mktemp -d)
+trap "rm -rf $tmp" EXIT
+
+cputime() {
+	grep -h 'CPU: user' $1 | sed -e 's/.*CPU: //' -e 's/, MEM.*//'
+}
+
+$yosys -ql $tmp/prep.log -p "$script; write_ilang $tmp/ref.il; write_rtlil_bin $tmp/ref.bin" $design
+
+$yosys -ql $tmp/il_load.log $tmp/ref.il
+$yosys -ql $tmp/bin_load.log -p "read_rtlil_bin $tmp/ref.bin"
+$yosys -ql $tmp/il_save.log -p "read_rtlil_bin $tmp/ref.bin; write_ilang $tmp/out.il; write_ilang $tmp/out.il; write_ilang $tmp/out.il"
+$yosys -ql $tmp/bin_save.log -p "read_rtlil_bin $tmp/ref.bin; write_rtlil_bin $tmp/out.bin; write_rtlil_bin $tmp/out.bin; write_rtlil_bin $tmp/out.bin"
+
+if ! cmp -s $tmp/ref.il $tmp/out.il; then
+	echo "ERROR: design changed in binary RTLIL round trip:"
+	diff -u $tmp/ref.il $tmp/out.il | head -n 20
+	exit 1
+fi
+
+if ! cmp -s $tmp/ref.bin $tmp/out.bin; then
+	echo "ERROR: binary RTLIL file changed in round trip."
+	exit 1
+fi
+
+echo "round trip ok, ilang $(stat -c %s $tmp/ref.il) bytes, binary $(stat -c %s $tmp/ref.bin) bytes"
+echo "load ilang:        CPU $(cputime $tmp/il_load.log)"
+echo "load binary:       CPU $(cputime $tmp/bin_load.log)"
+echo "load binary + 3x save ilang:  CPU $(cputime $tmp/il_save.log)"
+echo "load binary + 3x save binary: CPU $(cputime $tmp/bin_save.log)"
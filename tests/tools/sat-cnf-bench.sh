@@ -0,0 +1,47 @@
+#!/bin/bash
+#
+# Measure the time it takes to import a large design into ezSAT and generate
+# the CNF for it. The design is a chain of registered adder/xor stages that is
+# unrolled with 'sat -seq'. The SAT problem itself is trivial (there are no
+# constraints), so nearly all of the time is spent in SatGen and ezSAT.
+#
+# Usage: bash sat-cnf-bench.sh [number_of_stages] [number_of_steps] [yosys_binary]
+#        (the default is 200 stages and 10 steps)
+
+set -e
+n=${1:-200}
+steps=${2:-10}
+yosys=${3:-"$(dirname "$0")/../../yosys"}
+
+tmp=$(mktemp -d)
+trap "rm -rf $tmp" EXIT
+
+cputime() {
+	grep -h 'CPU: user' $1 | sed -e 's/.*CPU: user //' -e 's/s .*//'
+}
+
+awk -v n=$n 'BEGIN {
+	print "module top (input clk, input [15:0] a, b, output [15:0] y);"
+	print "\treg [15:0] r0;"
+	print "\talways @(posedge clk) r0 <= a;"
+	for (i = 1; i <= n; i++) {
+		print "\treg [15:0] r" i ";"
+		print "\talways @(posedge clk) r" i " <= (r" i-1 " + b) ^ (r" i-1 " >> " i % 7 + 1 ");"
+	}
+	print "\tassign y = r" n ";"
+	print "endmodule"
+}' > $tmp/input.v
+
+$yosys -ql $tmp/prep.log -p "read_verilog $tmp/input.v; proc; opt; stat; write_ilang $tmp/prep.il"
+$yosys -ql $tmp/base.log $tmp/prep.il
+$yosys -ql $tmp/sat.log -p "read_ilang $tmp/prep.il; sat -seq $steps -set-init-zero"
+
+if ! grep -q 'SAT solving finished - model found' $tmp/sat.log; then
+	echo "ERROR: unexpected result from sat"
+	exit 1
+fi
+
+t_base=$(cputime $tmp/base.log)
+t_sat=$(cputime $tmp/sat.log)
+echo "$(grep -h 'Number of cells' $tmp/prep.log | head -n1 | awk '{print $NF}') cells, $steps time steps"
+awk -v a=$t_sat -v b=$t_base 'BEGIN { printf "sat: CPU %.2fs\n", a - b }'
@@ -0,0 +1,62 @@
+#!/bin/bash
+#
+# Run the scripts in tests/sat with different SAT solvers and print the wall
+# clock time for each script and solver. All commands in the scripts use the
+# solver that is selected with the 'satsolver' command. The wall clock time
+# includes the time spent in external solver processes.
+#
+# Usage: bash sat-solver-bench.sh [solver ...]
+#
+# Each solver is one of
+#   <name>                     a solver that is built into yosys (e.g. minisat)
+#   <name>=dimacs:<command>    a solver binary that reads DIMACS from stdin
+#   <name>=ipasir:<library>    a shared library that implements IPASIR
+#
+# Example: bash sat-solver-bench.sh minisat "kissat=dimacs:kissat -q"
+#
+# The default is to only run the built-in minisat.
+
+set -e
+yosys=$(cd "$(dirname "$0")/../.." && pwd)/yosys
+[ $# -gt 0 ] || set -- minisat
+
+tmp=$(mktemp -d)
+trap "rm -rf $tmp" EXIT
+cp "$(dirname "$0")"/../sat/*.{v,sv,ys} $tmp/
+cd $tmp
+
+names=()
+setup=()
+for spec in "$@"; do
+	name=${spec%%=*}
+	case "$spec" in
+		*=dimacs:*) setup+=("satsolver -dimacs $name \"${spec#*=dimacs:}\" $name") ;;
+		*=ipasir:*) setup+=("satsolver -ipasir $name \"${spec#*=ipasir:}\" $name") ;;
+		*) setup+=("satsolver $name") ;;
+	esac
+	names+=("$name")
+done
+
+printf "%-20s" "script"
+for name in "${names[@]}"; do printf " %12s" "$name"; done
+echo
+
+declare -a total
+for x in *.ys; do
+	printf "%-20s" "$x"
+	for i in "${!names[@]}"; do
+		start=$(date +%s%N)
+		if $yosys -ql ${x%.ys}.log -p "${setup[$i]}; script $x" > /dev/null 2>&1; then
+			ms=$(( ($(date +%s%N) - start) / 1000000 ))
+			total[$i]=$(( ${total[$i]:-0} + ms ))
+			printf " %10d ms" $ms
+		else
+			printf " %12s" "FAILED"
+		fi
+	done
+	echo
+done
+
+printf "%-20s" "total"
+for i in "${!names[@]}"; do printf " %10d ms" ${total[$i]:-0}; done
+echo
@@ -0,0 +1,21 @@
+#!/bin/bash
+#
+# Run a synthesis script with and without the per-module SigMap cache and
+# print the total runtime and the time spent in SigMap::set().
+#
+# Usage: bash sigmap-bench.sh <design_file> [script]
+#        (the default script is "hierarchy -auto-top; synth")
+
+set -e
+yosys="$(dirname "$0")/../../yosys"
+design=$1
+script=${2:-"hierarchy -auto-top; synth"}
+
+for mode in -nocache -cache; do
+	log=$(mktemp)
+	$yosys -ql $log -p "test_sigmap $mode -enable -reset; $script; test_sigmap -stats" $design
+	echo "$mode: CPU $(grep -h 'CPU: user' $log | sed -e 's/.*CPU: //' -e 's/, MEM.*//')," \
+			"$(grep -h 'SigMap::set() calls' $log | awk '{print $NF}') SigMaps," \
+			"$(grep -h 'time in SigMap::set()' $log | awk '{print $(NF-1)}') s in SigMap::set()"
+	rm -f $log
+done
@@ -0,0 +1,21 @@
+#!/bin/bash
+#
+# Compare the compiled simulator ('sim -compiled') with the default
+# simulator on the designs in tests/simple and print the runtimes.
+#
+# Usage: bash sim-bench.sh [number_of_cycles]
+
+set -e
+cd "$(dirname "$0")/../simple"
+n=${1:-100}
+
+for f in *.v; do
+	opts=""
+	grep -qw clk $f && opts="$opts -clock clk"
+	if ../../yosys -ql ../../sim-bench-${f%.v}.log -p "read_verilog $f; hierarchy -auto-top; proc; flatten; memory -nomap; memory_map; opt_clean; sim -bench -n $n$opts" 2> /dev/null; then
+		echo "$f: $(grep -h '^Interpreted:' ../../sim-bench-${f%.v}.log)"
+	else
+		echo "$f: skipped ($(grep -h 'ERROR:' ../../sim-bench-${f%.v}.log | head -n1))"
+	fi
+	rm -f ../../sim-bench-${f%.v}.log
+done
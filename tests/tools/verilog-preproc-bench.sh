@@ -0,0 +1,65 @@
+#!/bin/bash
+#
+# Measure the throughput of the Verilog pre-processor on a large synthetic
+# input with heavy macro use. The pre-processor time is the difference between
+# reading the input and reading the already pre-processed code with -nopp.
+#
+# Usage: bash verilog-preproc-bench.sh [number_of_modules] [yosys_binary]
+#        (the default is 2000 modules, about 3 MB of input)
+
+set -e
+yosys=${2:-"$(dirname "$0")/../../yosys"}
+n=${1:-2000}
+
+tmp=$(mktemp -d)
+trap "rm -rf $tmp" EXIT
+
+cputime() {
+	grep -h 'CPU: user' $1 | sed -e 's/.*CPU: user //' -e 's/s .*//'
+}
+
+awk -v n=$n 'BEGIN {
+	print "`define WIDTH 16"
+	print "`define MSB (`WIDTH-1)"
+	print "`define ADD3(a, b, c) ((a) + (b) + (c))"
+	print "`define MUX(s, a, b) ((s) ? (a) : (b))"
+	print "`define DECL(name) wire [`MSB:0] name;"
+	print "`define STAGE(q, s, a, b, c) `DECL(q) assign q = `MUX(s, `ADD3(a, b, c), a ^ b);"
+	for (i = 0; i < n; i++) {
+		print "// module " i " of " n
+		print "module m" i " (input clk, input [`MSB:0] a, b, output reg [`MSB:0] y);"
+		print "\t/* " n - i " stages follow */"
+		print "\t`DECL(t0)"
+		print "\tassign t0 = a;"
+		for (j = 1; j < 40; j++)
+			print "\t`STAGE(t" j ", a[" j % 16 "], t" j-1 ", b, " j ")"
+		print "`ifdef SYNTHESIS"
+		print "\talways @(posedge clk) y <= t39;"
+		print "`else"
+		print "\talways @(posedge clk) y <= `WIDTH'\''bx;"
+		print "`endif"
+		print "endmodule"
+	}
+}' > $tmp/input.v
+
+$yosys -ql $tmp/pp.log -p "read_verilog -defer -ppdump $tmp/input.v"
+sed -n '/^-- Verilog code after preprocessor --$/,/^-- END OF DUMP --$/p' $tmp/pp.log | sed -e '1d' -e '$d' > $tmp/pp.v
+
+$yosys -ql $tmp/read.log -p "read_verilog -defer $tmp/input.v"
+$yosys -ql $tmp/nopp.log -p "read_verilog -defer -nopp $tmp/pp.v"
+
+in_size=$(stat -c %s $tmp/input.v)
+pp_size=$(stat -c %s $tmp/pp.v)
+t_read=$(cputime $tmp/read.log)
+t_nopp=$(cputime $tmp/nopp.log)
+
+echo "input $in_size bytes, pre-processed $pp_size bytes"
+echo "read_verilog:       CPU ${t_read}s"
+echo "read_verilog -nopp: CPU ${t_nopp}s (pre-processed input)"
+awk -v a=$t_read -v b=$t_nopp -v s=$in_size 'BEGIN {
+	t = a - b
+	if (t > 0)
+		printf "pre-processor:      CPU %.2fs, %.1f MB/s\n", t, s * 1e-6 / t
+	else
+		printf "pre-processor:      CPU %.2fs\n", t
+}'
@@ -0,0 +1,151 @@
+module m0 (input clk, input [3:0] a, b, input [2:0] s, output reg [3:0] q, output [3:0] x, y, f, output z, c, d, e);
+	wire [3:0] t = s[0] ? a & 4'd15 : b | 4'd0;
+	assign x = (a == 4'd1) ? t : (a ^ 4'd0) + 4'd0;
+	assign y = {|{a, b}, |{b, a}, a[3:2]} << 1;
+	assign z = &{a[0], 1'b1, b[1]} | (s != 3'd0 && s == 3'd0);
+	assign c = $signed(a) >= 0;
+	assign d = a < 4'd4;
+	assign e = b >= 4'd2;
+	assign f = (a & {b[3:2], 2'b10}) | (b ^ {2'b01, a[1:0]});
+	always @(posedge clk)
+		case (s)
+			3'd0: q <= a;
+			3'd1: q <= a;
+			3'd2: q <= 4'bx;
+			3'd3: q <= ~b;
+			default: q <= t;
+		endcase
+endmodule
+
+module m1 (input clk, input [4:0] a, b, input [2:0] s, output reg [4:0] q, output [4:0] x, y, f, output z, c, d, e);
+	wire [4:0] t = s[0] ? a & 5'd31 : b | 5'd0;
+	assign x = (a == 5'd2) ? t : (a ^ 5'd0) + 5'd1;
+	assign y = {|{a, b}, |{b, a}, a[4:2]} << 1;
+	assign z = &{a[0], 1'b1, b[1]} | (s != 3'd0 && s == 3'd1);
+	assign c = $signed(a) >= 0;
+	assign d = a < 5'd4;
+	assign e = b >= 5'd4;
+	assign f = (a & {b[4:2], 2'b10}) | (b ^ {2'b01, a[2:0]});
+	always @(posedge clk)
+		case (s)
+			3'd0: q <= a;
+			3'd1: q <= a;
+			3'd2: q <= 5'bx;
+			3'd4: q <= ~b;
+			default: q <= t;
+		endcase
+endmodule
+
+module m2 (input clk, input [5:0] a, b, input [2:0] s, output reg [5:0] q, output [5:0] x, y, f, output z, c, d, e);
+	wire [5:0] t = s[0] ? a & 6'd63 : b | 6'd0;
+	assign x = (a == 6'd3) ? t : (a ^ 6'd0) + 6'd2;
+	assign y = {|{a, b}, |{b, a}, a[5:2]} << 1;
+	assign z = &{a[0], 1'b1, b[1]} | (s != 3'd0 && s == 3'd2);
+	assign c = $signed(a) >= 0;
+	assign d = a < 6'd4;
+	assign e = b >= 6'd8;
+	assign f = (a & {b[5:2], 2'b10}) | (b ^ {2'b01, a[3:0]});
+	always @(posedge clk)
+		case (s)
+			3'd0: q <= a;
+			3'd1: q <= a;
+			3'd2: q <= 6'bx;
+			3'd5: q <= ~b;
+			default: q <= t;
+		endcase
+endmodule
+
+module m3 (input clk, input [6:0] a, b, input [2:0] s, output reg [6:0] q, output [6:0] x, y, f, output z, c, d, e);
+	wire [6:0] t = s[0] ? a & 7'd127 : b | 7'd0;
+	assign x = (a == 7'd4) ? t : (a ^ 7'd0) + 7'd3;
+	assign y = {|{a, b}, |{b, a}, a[6:2]} << 1;
+	assign z = &{a[0], 1'b1, b[1]} | (s != 3'd0 && s == 3'd3);
+	assign c = $signed(a) >= 0;
+	assign d = a < 7'd4;
+	assign e = b >= 7'd2;
+	assign f = (a & {b[6:2], 2'b10}) | (b ^ {2'b01, a[4:0]});
+	always @(posedge clk)
+		case (s)
+			3'd0: q <= a;
+			3'd1: q <= a;
+			3'd2: q <= 7'bx;
+			3'd6: q <= ~b;
+			default: q <= t;
+		endcase
+endmodule
+
+module m4 (input clk, input [7:0] a, b, input [2:0] s, output reg [7:0] q, output [7:0] x, y, f, output z, c, d, e);
+	wire [7:0] t = s[0] ? a & 8'd255 : b | 8'd0;
+	assign x = (a == 8'd5) ? t : (a ^ 8'd0) + 8'd4;
+	assign y = {|{a, b}, |{b, a}, a[7:2]} << 1;
+	assign z = &{a[0], 1'b1, b[1]} | (s != 3'd0 && s == 3'd4);
+	assign c = $signed(a) >= 0;
+	assign d = a < 8'd4;
+	assign e = b >= 8'd4;
+	assign f = (a & {b[7:2], 2'b10}) | (b ^ {2'b01, a[5:0]});
+	always @(posedge clk)
+		case (s)
+			3'd0: q <= a;
+			3'd1: q <= a;
+			3'd2: q <= 8'bx;
+			3'd7: q <= ~b;
+			default: q <= t;
+		endcase
+endmodule
+
+module m5 (input clk, input [8:0] a, b, input [2:0] s, output reg [8:0] q, output [8:0] x, y, f, output z, c, d, e);
+	wire [8:0] t = s[0] ? a & 9'd511 : b | 9'd0;
+	assign x = (a == 9'd6) ? t : (a ^ 9'd0) + 9'd5;
+	assign y = {|{a, b}, |{b, a}, a[8:2]} << 1;
+	assign z = &{a[0], 1'b1, b[1]} | (s != 3'd0 && s == 3'd5);
+	assign c = $signed(a) >= 0;
+	assign d = a < 9'd4;
+	assign e = b >= 9'd8;
+	assign f = (a & {b[8:2], 2'b10}) | (b ^ {2'b01, a[6:0]});
+	always @(posedge clk)
+		case (s)
+			3'd0: q <= a;
+			3'd1: q <= a;
+			3'd2: q <= 9'bx;
+			3'd3: q <= ~b;
+			default: q <= t;
+		endcase
+endmodule
+
+module m6 (input clk, input [9:0] a, b, input [2:0] s, output reg [9:0] q, output [9:0] x, y, f, output z, c, d, e);
+	wire [9:0] t = s[0] ? a & 10'd1023 : b | 10'd0;
+	assign x = (a == 10'd7) ? t : (a ^ 10'd0) + 10'd6;
+	assign y = {|{a, b}, |{b, a}, a[9:2]} << 1;
+	assign z = &{a[0], 1'b1, b[1]} | (s != 3'd0 && s == 3'd6);
+	assign c = $signed(a) >= 0;
+	assign d = a < 10'd4;
+	assign e = b >= 10'd2;
+	assign f = (a & {b[9:2], 2'b10}) | (b ^ {2'b01, a[7:0]});
+	always @(posedge clk)
+		case (s)
+			3'd0: q <= a;
+			3'd1: q <= a;
+			3'd2: q <= 10'bx;
+			3'd4: q <= ~b;
+			default: q <= t;
+		endcase
+endmodule
+
+module m7 (input clk, input [10:0] a, b, input [2:0] s, output reg [10:0] q, output [10:0] x, y, f, output z, c, d, e);
+	wire [10:0] t = s[0] ? a & 11'd2047 : b | 11'd0;
+	assign x = (a == 11'd8) ? t : (a ^ 11'd0) + 11'd7;
+	assign y = {|{a, b}, |{b, a}, a[10:2]} << 1;
+	assign z = &{a[0], 1'b1, b[1]} | (s != 3'd0 && s == 3'd7);
+	assign c = $signed(a) >= 0;
+	assign d = a < 11'd4;
+	assign e = b >= 11'd4;
+	assign f = (a & {b[10:2], 2'b10}) | (b ^ {2'b01, a[8:0]});
+	always @(posedge clk)
+		case (s)
+			3'd0: q <= a;
+			3'd1: q <= a;
+			3'd2: q <= 11'bx;
+			3'd5: q <= ~b;
+			default: q <= t;
+		endcase
+endmodule